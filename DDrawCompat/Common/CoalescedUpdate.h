@@ -0,0 +1,27 @@
+#pragma once
+
+#include <atomic>
+
+namespace Compat
+{
+	// Collapses repeated change notifications into a single pending update. Only the request that makes the
+	// update pending needs to schedule it; later requests are absorbed until the consumer takes it.
+	class CoalescedUpdate
+	{
+	public:
+		CoalescedUpdate() : m_isPending(false) {}
+
+		bool isPending() const { return m_isPending; }
+
+		// Returns true if the caller has to schedule the update
+		bool request() { return !m_isPending.exchange(true); }
+
+		void reset() { m_isPending = false; }
+
+		// Returns true if an update was pending
+		bool take() { return m_isPending.exchange(false); }
+
+	private:
+		std::atomic<bool> m_isPending;
+	};
+}
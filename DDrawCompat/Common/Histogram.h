@@ -0,0 +1,83 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <ostream>
+
+#include <Windows.h>
+
+namespace Compat
+{
+	// Counts values in power of two buckets 0, 1, 2-3, 4-7, ..., the last bucket being open ended
+	template <UINT bucketCount>
+	class Histogram
+	{
+	public:
+		Histogram()
+		{
+			reset();
+		}
+
+		void add(UINT value)
+		{
+			++m_buckets[std::min<UINT>(getBucketIndex(value), bucketCount - 1)];
+			m_sum += value;
+			++m_count;
+			m_max = std::max<UINT>(m_max, value);
+		}
+
+		UINT getAverage() const { return 0 == m_count ? 0 : static_cast<UINT>(m_sum / m_count); }
+		UINT getBucket(UINT index) const { return m_buckets[index]; }
+		UINT getCount() const { return m_count; }
+		UINT getMax() const { return m_max; }
+
+		void reset()
+		{
+			m_buckets.fill(0);
+			m_sum = 0;
+			m_count = 0;
+			m_max = 0;
+		}
+
+		static UINT getBucketIndex(UINT value)
+		{
+			UINT index = 0;
+			for (; value > 0; value >>= 1)
+			{
+				++index;
+			}
+			return index;
+		}
+
+		friend std::ostream& operator<<(std::ostream& os, const Histogram& histogram)
+		{
+			os << '[';
+			bool isFirst = true;
+			for (UINT i = 0; i < bucketCount; ++i)
+			{
+				if (0 != histogram.m_buckets[i])
+				{
+					const UINT min = 0 == i ? 0 : 1U << (i - 1);
+					os << (isFirst ? "" : ", ") << min;
+					if (i + 1 == bucketCount)
+					{
+						os << '+';
+					}
+					else if (i > 1)
+					{
+						os << '-' << (1U << i) - 1;
+					}
+					os << ": " << histogram.m_buckets[i];
+					isFirst = false;
+				}
+			}
+			return os << ']';
+		}
+
+	private:
+		std::array<UINT, bucketCount> m_buckets;
+		ULONGLONG m_sum;
+		UINT m_count;
+		UINT m_max;
+	};
+}
@@ -0,0 +1,121 @@
+#include <string>
+
+#include <Windows.h>
+
+#include <Common/Log.h>
+#include <Common/SharedMetrics.h>
+#include <Common/Time.h>
+
+namespace
+{
+	Compat::SharedMetrics::Block* g_block = nullptr;
+	HANDLE g_mapping = nullptr;
+	HANDLE g_publishThread = nullptr;
+	HANDLE g_stopEvent = nullptr;
+
+	void publish()
+	{
+		using namespace Compat::SharedMetrics;
+
+		const std::uint32_t sequence = beginWrite(*g_block);
+
+		g_block->magic = MAGIC;
+		g_block->version = VERSION;
+		g_block->size = sizeof(Block);
+		g_block->counterCount = COUNTER_COUNT;
+		g_block->processId = GetCurrentProcessId();
+		g_block->qpcFrequency = Time::g_qpcFrequency;
+		g_block->qpcTimestamp = Time::queryPerformanceCounter();
+		for (std::uint32_t i = 0; i < COUNTER_COUNT; ++i)
+		{
+			g_block->counters[i] = g_counters[i].load(std::memory_order_relaxed);
+		}
+
+		endWrite(*g_block, sequence);
+	}
+
+	DWORD WINAPI publishThreadProc(LPVOID /*lpParameter*/)
+	{
+		do
+		{
+			publish();
+		} while (WAIT_TIMEOUT == WaitForSingleObject(g_stopEvent, Config::metricsPublishInterval));
+		return 0;
+	}
+}
+
+namespace Compat
+{
+	namespace SharedMetrics
+	{
+		std::atomic<unsigned long long> g_counters[COUNTER_COUNT] = {};
+
+		void init()
+		{
+			if (0 == Config::metricsPublishInterval)
+			{
+				return;
+			}
+
+			const std::string name(NAME_PREFIX + std::to_string(GetCurrentProcessId()));
+			g_mapping = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(Block),
+				name.c_str());
+			if (!g_mapping)
+			{
+				Compat::Log() << "ERROR: Failed to create the shared metrics block: " << GetLastError();
+				return;
+			}
+
+			g_block = static_cast<Block*>(MapViewOfFile(g_mapping, FILE_MAP_WRITE, 0, 0, sizeof(Block)));
+			if (!g_block)
+			{
+				Compat::Log() << "ERROR: Failed to map the shared metrics block: " << GetLastError();
+				uninit();
+				return;
+			}
+
+			g_stopEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+			g_publishThread = g_stopEvent ? CreateThread(nullptr, 0, &publishThreadProc, nullptr, 0, nullptr) : nullptr;
+			if (!g_publishThread)
+			{
+				Compat::Log() << "ERROR: Failed to start the metrics publishing thread: " << GetLastError();
+				uninit();
+				return;
+			}
+			Compat::Log() << "Publishing metrics to " << name;
+		}
+
+		void uninit()
+		{
+			if (g_publishThread)
+			{
+				SetEvent(g_stopEvent);
+				if (WAIT_OBJECT_0 != WaitForSingleObject(g_publishThread, 1000))
+				{
+					TerminateThread(g_publishThread, 0);
+					Compat::Log() << "The metrics publishing thread was terminated forcefully";
+				}
+				CloseHandle(g_publishThread);
+				g_publishThread = nullptr;
+			}
+
+			if (g_stopEvent)
+			{
+				CloseHandle(g_stopEvent);
+				g_stopEvent = nullptr;
+			}
+
+			if (g_block)
+			{
+				UnmapViewOfFile(g_block);
+				g_block = nullptr;
+			}
+
+			if (g_mapping)
+			{
+				CloseHandle(g_mapping);
+				g_mapping = nullptr;
+			}
+		}
+	}
+}
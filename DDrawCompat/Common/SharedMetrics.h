@@ -0,0 +1,25 @@
+#pragma once
+
+#include <atomic>
+
+#include <Common/SharedMetricsLayout.h>
+#include <Config/Config.h>
+
+namespace Compat
+{
+	namespace SharedMetrics
+	{
+		extern std::atomic<unsigned long long> g_counters[COUNTER_COUNT];
+
+		inline void add(Counter counter, unsigned long long value = 1)
+		{
+			if (0 != Config::metricsPublishInterval)
+			{
+				g_counters[counter].fetch_add(value, std::memory_order_relaxed);
+			}
+		}
+
+		void init();
+		void uninit();
+	}
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Compat
+{
+	namespace SharedMetrics
+	{
+		const std::uint32_t MAGIC = 0x4D434444; // "DDCM"
+		const std::uint32_t VERSION = 1;
+
+		enum Counter : std::uint32_t
+		{
+			BLT_COUNT,
+			BLT_PIXELS,
+			COLOR_FILL_COUNT,
+			RESOURCE_COPY_TO_SYSMEM,
+			RESOURCE_COPY_TO_VIDMEM,
+			DRAW_COUNT,
+			DRAW_FLUSH_COUNT,
+			DRAW_PRIMITIVE_COUNT,
+			FLIP_COUNT,
+			UPDATE_COUNT,
+			PRESENT_COUNT,
+			PRESENT_DROP_COUNT,
+			PALETTE_UPDATE_COUNT,
+			PALETTE_THROTTLE_COUNT,
+			COUNTER_COUNT
+		};
+
+		const char* const COUNTER_NAMES[] = {
+			"bltCount",
+			"bltPixels",
+			"colorFillCount",
+			"resourceCopyToSysMem",
+			"resourceCopyToVidMem",
+			"drawCount",
+			"drawFlushCount",
+			"drawPrimitiveCount",
+			"flipCount",
+			"updateCount",
+			"presentCount",
+			"presentDropCount",
+			"paletteUpdateCount",
+			"paletteThrottleCount"
+		};
+
+		static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == COUNTER_COUNT,
+			"COUNTER_NAMES does not match Counter");
+
+		// Writer: sequence is odd while the block is being updated and is advanced to the next even value after.
+		// Readers retry until they see the same even sequence before and after copying the block.
+		// New counters are only ever appended; readers must use counterCount instead of COUNTER_COUNT.
+		struct Block
+		{
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint32_t size;
+			std::uint32_t counterCount;
+			std::atomic<std::uint32_t> sequence;
+			std::uint32_t processId;
+			std::uint64_t qpcFrequency;
+			std::uint64_t qpcTimestamp;
+			std::uint64_t counters[COUNTER_COUNT];
+		};
+
+		static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "sequence must be address-free");
+		static_assert(sizeof(std::atomic<std::uint32_t>) == 4, "Unexpected atomic size");
+		static_assert(0 == offsetof(Block, qpcFrequency) % 8, "Unexpected Block alignment");
+		static_assert(sizeof(Block) == 40 + 8 * COUNTER_COUNT, "Unexpected Block size");
+
+		struct Snapshot
+		{
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint32_t counterCount;
+			std::uint32_t sequence;
+			std::uint32_t processId;
+			std::uint64_t qpcFrequency;
+			std::uint64_t qpcTimestamp;
+			std::uint64_t counters[COUNTER_COUNT];
+		};
+
+		inline std::uint32_t beginWrite(Block& block)
+		{
+			const std::uint32_t sequence = block.sequence.load(std::memory_order_relaxed);
+			block.sequence.store(sequence + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			return sequence;
+		}
+
+		inline void endWrite(Block& block, std::uint32_t sequence)
+		{
+			block.sequence.store(sequence + 2, std::memory_order_release);
+		}
+
+		// Returns false if nothing was published yet or the writer was active; the caller should retry
+		inline bool tryRead(const Block& block, Snapshot& snapshot)
+		{
+			const std::uint32_t sequence = block.sequence.load(std::memory_order_acquire);
+			if (0 == sequence || (sequence & 1))
+			{
+				return false;
+			}
+
+			snapshot.magic = block.magic;
+			snapshot.version = block.version;
+			snapshot.counterCount = block.counterCount;
+			snapshot.processId = block.processId;
+			snapshot.qpcFrequency = block.qpcFrequency;
+			snapshot.qpcTimestamp = block.qpcTimestamp;
+			std::memcpy(snapshot.counters, block.counters, sizeof(snapshot.counters));
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sequence != block.sequence.load(std::memory_order_relaxed))
+			{
+				return false;
+			}
+
+			snapshot.sequence = sequence;
+			return true;
+		}
+
+		const char* const NAME_PREFIX =
+#ifdef _WIN32
+			"Local\\DDrawCompatMetrics.";
+#else
+			"/DDrawCompatMetrics.";
+#endif
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Compat
+{
+	template <typename T, std::size_t N>
+	class SmallVector
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "SmallVector only supports trivially copyable types");
+
+	public:
+		SmallVector()
+			: m_data(m_buffer)
+			, m_size(0)
+			, m_capacity(N)
+		{
+		}
+
+		SmallVector(const SmallVector& other)
+			: SmallVector()
+		{
+			*this = other;
+		}
+
+		SmallVector(SmallVector&& other)
+			: SmallVector()
+		{
+			*this = std::move(other);
+		}
+
+		~SmallVector()
+		{
+			if (m_data != m_buffer)
+			{
+				std::free(m_data);
+			}
+		}
+
+		SmallVector& operator=(const SmallVector& other)
+		{
+			if (this != &other)
+			{
+				m_size = 0;
+				reserve(other.m_size);
+				std::memcpy(m_data, other.m_data, other.m_size * sizeof(T));
+				m_size = other.m_size;
+			}
+			return *this;
+		}
+
+		SmallVector& operator=(SmallVector&& other)
+		{
+			if (this == &other)
+			{
+				return *this;
+			}
+
+			if (other.m_data == other.m_buffer)
+			{
+				return *this = static_cast<const SmallVector&>(other);
+			}
+
+			if (m_data != m_buffer)
+			{
+				std::free(m_data);
+			}
+			m_data = other.m_data;
+			m_size = other.m_size;
+			m_capacity = other.m_capacity;
+			other.m_data = other.m_buffer;
+			other.m_size = 0;
+			other.m_capacity = N;
+			return *this;
+		}
+
+		T& operator[](std::size_t index) { return m_data[index]; }
+		const T& operator[](std::size_t index) const { return m_data[index]; }
+
+		T* begin() { return m_data; }
+		const T* begin() const { return m_data; }
+		T* end() { return m_data + m_size; }
+		const T* end() const { return m_data + m_size; }
+
+		T& back() { return m_data[m_size - 1]; }
+		const T& back() const { return m_data[m_size - 1]; }
+
+		void clear() { m_size = 0; }
+		T* data() { return m_data; }
+		const T* data() const { return m_data; }
+		bool empty() const { return 0 == m_size; }
+		std::size_t size() const { return m_size; }
+
+		void push_back(const T& value)
+		{
+			if (m_size == m_capacity)
+			{
+				T copy(value);
+				reserve(2 * m_capacity);
+				m_data[m_size++] = copy;
+			}
+			else
+			{
+				m_data[m_size++] = value;
+			}
+		}
+
+		void reserve(std::size_t capacity)
+		{
+			if (capacity <= m_capacity)
+			{
+				return;
+			}
+
+			T* data = static_cast<T*>(std::malloc(capacity * sizeof(T)));
+			if (!data)
+			{
+				throw std::bad_alloc();
+			}
+			std::memcpy(data, m_data, m_size * sizeof(T));
+			if (m_data != m_buffer)
+			{
+				std::free(m_data);
+			}
+			m_data = data;
+			m_capacity = capacity;
+		}
+
+		void resize(std::size_t size)
+		{
+			reserve(size);
+			m_size = size;
+		}
+
+	private:
+		T* m_data;
+		std::size_t m_size;
+		std::size_t m_capacity;
+		T m_buffer[N];
+	};
+}
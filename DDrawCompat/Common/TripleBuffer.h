@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+
+namespace Compat
+{
+	// Slot handoff between a single producer and a single consumer thread. Each side owns one slot and the third
+	// slot holds the latest published one. Both sides swap slots with a single atomic exchange and never wait.
+	class TripleBuffer
+	{
+	public:
+		static const unsigned SLOT_COUNT = 3;
+
+		TripleBuffer()
+			: m_writeSlot(0)
+			, m_readSlot(2)
+			, m_pendingSlot(1)
+		{
+		}
+
+		unsigned getReadSlot() const { return m_readSlot; }
+		unsigned getWriteSlot() const { return m_writeSlot; }
+		bool hasPublishedSlot() const { return 0 != (m_pendingSlot & NEW_SLOT_FLAG); }
+
+		// Consumer: returns false if nothing was published since the last acquire
+		bool acquire()
+		{
+			if (!hasPublishedSlot())
+			{
+				return false;
+			}
+			m_readSlot = m_pendingSlot.exchange(m_readSlot) & ~NEW_SLOT_FLAG;
+			return true;
+		}
+
+		// Producer: returns true if the previously published slot was never acquired. That slot becomes the new
+		// write slot with its contents unchanged.
+		bool publish()
+		{
+			const unsigned prevPendingSlot = m_pendingSlot.exchange(m_writeSlot | NEW_SLOT_FLAG);
+			m_writeSlot = prevPendingSlot & ~NEW_SLOT_FLAG;
+			return 0 != (prevPendingSlot & NEW_SLOT_FLAG);
+		}
+
+	private:
+		static const unsigned NEW_SLOT_FLAG = 0x80;
+
+		unsigned m_writeSlot;
+		unsigned m_readSlot;
+		std::atomic<unsigned> m_pendingSlot;
+	};
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+
+#include <Windows.h>
+
+namespace Compat
+{
+	// Monotonic counter that threads can wait on until it reaches a target value. Wait provides address-wait
+	// semantics: wait(value, expected) blocks while value == expected and may return spuriously, and
+	// wakeAll(value) releases all threads blocked on value. Targets are compared with wrap-around.
+	template <typename Wait>
+	class WaitableCounter
+	{
+	public:
+		WaitableCounter(UINT value = 0) : m_value(value) {}
+
+		UINT get() const { return m_value; }
+
+		void increment()
+		{
+			++m_value;
+			Wait::wakeAll(m_value);
+		}
+
+		// Returns false if the counter had already reached the target
+		bool waitFor(UINT counter)
+		{
+			UINT value = m_value;
+			if (isReached(value, counter))
+			{
+				return false;
+			}
+
+			do
+			{
+				Wait::wait(m_value, value);
+				value = m_value;
+			} while (!isReached(value, counter));
+			return true;
+		}
+
+		static bool isReached(UINT value, UINT counter)
+		{
+			return static_cast<INT>(value - counter) >= 0;
+		}
+
+	private:
+		static_assert(sizeof(std::atomic<UINT>) == sizeof(UINT), "Address waits require a plain UINT layout");
+
+		std::atomic<UINT> m_value;
+	};
+}
@@ -2,9 +2,16 @@
 
 namespace Config
 {
+	const unsigned batchStatsLogInterval = 0;
+	const unsigned damageFullRefreshInterval = 60;
 	const unsigned delayedFlipModeTimeout = 200;
 	const unsigned evictionTimeout = 200;
-	const unsigned maxPaletteUpdatesPerMs = 5;
+	const unsigned frameLimit = 0;
+	const bool frameLimitVsyncAligned = false;
+	const unsigned frameStatsLogInterval = 0;
 	const unsigned maxUserModeDisplayDrivers = 3;
+	const unsigned metricsPublishInterval = 0;
+	const unsigned presentDeadlineMargin = 2;
+	const bool softwareGammaRamp = false;
 	const unsigned threadSwitchCycleTime = 3 * 1000 * 1000;
 }
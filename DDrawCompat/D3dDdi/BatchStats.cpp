@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <vector>
+
+#include <D3dDdi/BatchStats.h>
+
+namespace
+{
+	void logCounts(std::ostream& os, const D3dDdi::BatchStats::Histogram& histogram)
+	{
+		if (0 == histogram.getCount())
+		{
+			os << "none";
+			return;
+		}
+		os << "avg " << histogram.getAverage() << ", max " << histogram.getMax() << ' ' << histogram;
+	}
+}
+
+namespace D3dDdi
+{
+	const char* const BatchStats::OUTSIDE_DDI_CALL = "outside DDI call";
+
+	BatchStats::BatchStats()
+		: m_drawCount(0)
+		, m_flushCount(0)
+	{
+	}
+
+	void BatchStats::addFlush(const char* reason, UINT vertexCount, UINT indexCount, UINT primitiveCount)
+	{
+		++m_flushCount;
+		m_vertexCounts.add(vertexCount);
+		m_indexCounts.add(indexCount);
+		m_primitiveCounts.add(primitiveCount);
+		++m_flushReasons[reason ? reason : OUTSIDE_DDI_CALL];
+	}
+
+	void BatchStats::reset()
+	{
+		m_drawCount = 0;
+		m_flushCount = 0;
+		m_vertexCounts.reset();
+		m_indexCounts.reset();
+		m_primitiveCounts.reset();
+		m_flushReasons.clear();
+	}
+
+	std::ostream& operator<<(std::ostream& os, const BatchStats& stats)
+	{
+		os << "draws: " << stats.m_drawCount << ", flushes: " << stats.m_flushCount;
+		if (0 != stats.m_flushCount)
+		{
+			os << " (" << static_cast<double>(stats.m_drawCount) / stats.m_flushCount << " draws/flush)";
+		}
+
+		os << "; vertices: ";
+		logCounts(os, stats.m_vertexCounts);
+		os << "; indices: ";
+		logCounts(os, stats.m_indexCounts);
+		os << "; primitives: ";
+		logCounts(os, stats.m_primitiveCounts);
+		os << "; flush reasons: ";
+
+		std::vector<std::pair<const char*, UINT>> reasons(stats.m_flushReasons.begin(), stats.m_flushReasons.end());
+		std::sort(reasons.begin(), reasons.end(),
+			[](const auto& lhs, const auto& rhs) { return lhs.second > rhs.second; });
+		for (const auto& reason : reasons)
+		{
+			os << (reason == reasons.front() ? "" : ", ") << reason.first << '=' << reason.second;
+		}
+		return os;
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <map>
+#include <ostream>
+
+#include <Windows.h>
+
+#include <Common/Histogram.h>
+
+namespace D3dDdi
+{
+	class BatchStats
+	{
+	public:
+		typedef Compat::Histogram<19> Histogram;
+
+		// Reason recorded for flushes passed a null reason, which happen outside of any DDI call
+		static const char* const OUTSIDE_DDI_CALL;
+
+		BatchStats();
+
+		void addDraw() { ++m_drawCount; }
+		void addFlush(const char* reason, UINT vertexCount, UINT indexCount, UINT primitiveCount);
+		bool isEmpty() const { return 0 == m_drawCount && 0 == m_flushCount; }
+		void reset();
+
+		friend std::ostream& operator<<(std::ostream& os, const BatchStats& stats);
+
+	private:
+		UINT m_drawCount;
+		UINT m_flushCount;
+		Histogram m_vertexCounts;
+		Histogram m_indexCounts;
+		Histogram m_primitiveCounts;
+		std::map<const char*, UINT> m_flushReasons;
+	};
+}
@@ -40,8 +40,10 @@ namespace D3dDdi
 		, m_renderTarget(nullptr)
 		, m_renderTargetSubResourceIndex(0)
 		, m_sharedPrimary(nullptr)
+		, m_presentCount(0)
 		, m_drawPrimitive(*this)
 		, m_state(*this)
+		, m_ddiFuncName(nullptr)
 	{
 	}
 
@@ -321,6 +323,7 @@ namespace D3dDdi
 	{
 		flushPrimitives();
 		prepareForRendering(data->hSrcResource, data->SrcSubResourceIndex, true);
+		++m_presentCount;
 		return m_origVtable.pfnPresent(m_device, data);
 	}
 
@@ -331,6 +334,7 @@ namespace D3dDdi
 		{
 			prepareForRendering(data->phSrcResources[i].hResource, data->phSrcResources[i].SubResourceIndex, true);
 		}
+		++m_presentCount;
 		return m_origVtable.pfnPresent1(m_device, data);
 	}
 
@@ -407,7 +411,12 @@ namespace D3dDdi
 
 	void Device::remove(HANDLE device)
 	{
-		s_devices.erase(device);
+		auto it = s_devices.find(device);
+		if (it != s_devices.end())
+		{
+			it->second.m_drawPrimitive.logBatchStats();
+			s_devices.erase(it);
+		}
 	}
 
 	Resource* Device::getResource(HANDLE resource)
@@ -18,6 +18,26 @@ namespace D3dDdi
 	class Device
 	{
 	public:
+		class ScopedDdiFunc
+		{
+		public:
+			ScopedDdiFunc(Device& device, const char* funcName)
+				: m_device(device)
+				, m_prevFuncName(device.m_ddiFuncName)
+			{
+				m_device.m_ddiFuncName = funcName;
+			}
+
+			~ScopedDdiFunc()
+			{
+				m_device.m_ddiFuncName = m_prevFuncName;
+			}
+
+		private:
+			Device& m_device;
+			const char* m_prevFuncName;
+		};
+
 		Device(HANDLE adapter, HANDLE device);
 
 		Device(const Device&) = delete;
@@ -48,9 +68,12 @@ namespace D3dDdi
 		HRESULT unlock(const D3DDDIARG_UNLOCK* data);
 
 		Adapter& getAdapter() const { return m_adapter; }
+		// Null when no DDI call of this device is in progress
+		const char* getDdiFuncName() const { return m_ddiFuncName; }
 		DrawPrimitive& getDrawPrimitive() { return m_drawPrimitive; }
 		const D3DDDI_DEVICEFUNCS& getOrigVtable() const { return m_origVtable; }
 		Resource* getResource(HANDLE resource);
+		UINT getPresentCount() const { return m_presentCount; }
 		DeviceState& getState() { return m_state; }
 
 		HRESULT createPrivateResource(D3DDDIARG_CREATERESOURCE2& data);
@@ -82,9 +105,11 @@ namespace D3dDdi
 		Resource* m_renderTarget;
 		UINT m_renderTargetSubResourceIndex;
 		HANDLE m_sharedPrimary;
+		UINT m_presentCount;
 		DrawPrimitive m_drawPrimitive;
 		DeviceState m_state;
 		bool m_isSrcColorKeySupported;
+		const char* m_ddiFuncName;
 
 		static std::map<HANDLE, Device> s_devices;
 		static bool s_isFlushEnabled;
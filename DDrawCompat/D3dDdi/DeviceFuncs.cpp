@@ -3,16 +3,39 @@
 
 namespace
 {
-	template <typename MethodPtr, MethodPtr deviceMethod, typename... Params>
+	template <typename MemberDataPtr, MemberDataPtr ptr>
+	struct DdiFuncName
+	{
+		static const char* s_name;
+	};
+
+	template <typename MemberDataPtr, MemberDataPtr ptr>
+	const char* DdiFuncName<MemberDataPtr, ptr>::s_name = "";
+
+	class DdiFuncNameVisitor
+	{
+	public:
+		template <typename MemberDataPtr, MemberDataPtr ptr>
+		void visit(const char* funcName)
+		{
+			DdiFuncName<MemberDataPtr, ptr>::s_name = funcName;
+		}
+	};
+
+	template <typename DdiFuncPtr, DdiFuncPtr ddiFunc, typename MethodPtr, MethodPtr deviceMethod, typename... Params>
 	HRESULT WINAPI deviceFunc(HANDLE device, Params... params)
 	{
-		return (D3dDdi::Device::get(device).*deviceMethod)(params...);
+		auto& dev = D3dDdi::Device::get(device);
+		D3dDdi::Device::ScopedDdiFunc scopedDdiFunc(dev, DdiFuncName<DdiFuncPtr, ddiFunc>::s_name);
+		return (dev.*deviceMethod)(params...);
 	}
 
-	template <typename MethodPtr, MethodPtr deviceStateMethod, typename... Params>
+	template <typename DdiFuncPtr, DdiFuncPtr ddiFunc, typename MethodPtr, MethodPtr deviceStateMethod, typename... Params>
 	HRESULT WINAPI deviceStateFunc(HANDLE device, Params... params)
 	{
-		return (D3dDdi::Device::get(device).getState().*deviceStateMethod)(params...);
+		auto& dev = D3dDdi::Device::get(device);
+		D3dDdi::Device::ScopedDdiFunc scopedDdiFunc(dev, DdiFuncName<DdiFuncPtr, ddiFunc>::s_name);
+		return (dev.getState().*deviceStateMethod)(params...);
 	}
 
 	HRESULT APIENTRY destroyDevice(HANDLE hDevice)
@@ -24,13 +47,17 @@ namespace
 	template <typename DeviceMethodPtr, DeviceMethodPtr deviceMethod, typename... Params>
 	HRESULT APIENTRY flushPrimitives(HANDLE hDevice, Params... params)
 	{
-		D3dDdi::Device::get(hDevice).flushPrimitives();
+		auto& dev = D3dDdi::Device::get(hDevice);
+		D3dDdi::Device::ScopedDdiFunc scopedDdiFunc(dev, DdiFuncName<DeviceMethodPtr, deviceMethod>::s_name);
+		dev.flushPrimitives();
 		return (D3dDdi::DeviceFuncs::s_origVtablePtr->*deviceMethod)(hDevice, params...);
 	}
 }
 
-#define DEVICE_FUNC(func) deviceFunc<decltype(&Device::func), &Device::func>
-#define SET_DEVICE_STATE_FUNC(func) vtable.func = &deviceStateFunc<decltype(&DeviceState::func), &DeviceState::func>
+#define SET_DEVICE_FUNC(func, method) vtable.func = &deviceFunc<decltype(&D3DDDI_DEVICEFUNCS::func), \
+	&D3DDDI_DEVICEFUNCS::func, decltype(&Device::method), &Device::method>
+#define SET_DEVICE_STATE_FUNC(func) vtable.func = &deviceStateFunc<decltype(&D3DDDI_DEVICEFUNCS::func), \
+	&D3DDDI_DEVICEFUNCS::func, decltype(&DeviceState::func), &DeviceState::func>
 
 namespace D3dDdi
 {
@@ -41,25 +68,28 @@ namespace D3dDdi
 	
 	void DeviceFuncs::setCompatVtable(D3DDDI_DEVICEFUNCS& vtable)
 	{
-		vtable.pfnBlt = &DEVICE_FUNC(blt);
-		vtable.pfnClear = &DEVICE_FUNC(clear);
-		vtable.pfnColorFill = &DEVICE_FUNC(colorFill);
-		vtable.pfnCreateResource = &DEVICE_FUNC(createResource);
-		vtable.pfnCreateResource2 = &DEVICE_FUNC(createResource2);
+		DdiFuncNameVisitor ddiFuncNameVisitor;
+		forEach<D3DDDI_DEVICEFUNCS>(ddiFuncNameVisitor);
+
+		SET_DEVICE_FUNC(pfnBlt, blt);
+		SET_DEVICE_FUNC(pfnClear, clear);
+		SET_DEVICE_FUNC(pfnColorFill, colorFill);
+		SET_DEVICE_FUNC(pfnCreateResource, createResource);
+		SET_DEVICE_FUNC(pfnCreateResource2, createResource2);
 		vtable.pfnDestroyDevice = &destroyDevice;
-		vtable.pfnDestroyResource = &DEVICE_FUNC(destroyResource);
-		vtable.pfnDrawIndexedPrimitive2 = &DEVICE_FUNC(drawIndexedPrimitive2);
-		vtable.pfnDrawPrimitive = &DEVICE_FUNC(drawPrimitive);
-		vtable.pfnFlush = &DEVICE_FUNC(flush);
-		vtable.pfnFlush1 = &DEVICE_FUNC(flush1);
-		vtable.pfnLock = &DEVICE_FUNC(lock);
-		vtable.pfnOpenResource = &DEVICE_FUNC(openResource);
-		vtable.pfnPresent = &DEVICE_FUNC(present);
-		vtable.pfnPresent1 = &DEVICE_FUNC(present1);
-		vtable.pfnSetRenderTarget = &DEVICE_FUNC(setRenderTarget);
-		vtable.pfnSetStreamSource = &DEVICE_FUNC(setStreamSource);
-		vtable.pfnSetStreamSourceUm = &DEVICE_FUNC(setStreamSourceUm);
-		vtable.pfnUnlock = &DEVICE_FUNC(unlock);
+		SET_DEVICE_FUNC(pfnDestroyResource, destroyResource);
+		SET_DEVICE_FUNC(pfnDrawIndexedPrimitive2, drawIndexedPrimitive2);
+		SET_DEVICE_FUNC(pfnDrawPrimitive, drawPrimitive);
+		SET_DEVICE_FUNC(pfnFlush, flush);
+		SET_DEVICE_FUNC(pfnFlush1, flush1);
+		SET_DEVICE_FUNC(pfnLock, lock);
+		SET_DEVICE_FUNC(pfnOpenResource, openResource);
+		SET_DEVICE_FUNC(pfnPresent, present);
+		SET_DEVICE_FUNC(pfnPresent1, present1);
+		SET_DEVICE_FUNC(pfnSetRenderTarget, setRenderTarget);
+		SET_DEVICE_FUNC(pfnSetStreamSource, setStreamSource);
+		SET_DEVICE_FUNC(pfnSetStreamSourceUm, setStreamSourceUm);
+		SET_DEVICE_FUNC(pfnUnlock, unlock);
 
 		SET_DEVICE_STATE_FUNC(pfnCreateVertexShaderDecl);
 		SET_DEVICE_STATE_FUNC(pfnDeletePixelShader);
@@ -78,6 +108,7 @@ namespace D3dDdi
 		SET_DEVICE_STATE_FUNC(pfnSetVertexShaderDecl);
 		SET_DEVICE_STATE_FUNC(pfnSetVertexShaderFunc);
 		SET_DEVICE_STATE_FUNC(pfnSetZRange);
+		SET_DEVICE_STATE_FUNC(pfnStateSet);
 		SET_DEVICE_STATE_FUNC(pfnUpdateWInfo);
 
 #define FLUSH_PRIMITIVES(func) vtable.func = &flushPrimitives<decltype(&D3DDDI_DEVICEFUNCS::func), &D3DDDI_DEVICEFUNCS::func>
@@ -91,7 +122,6 @@ namespace D3dDdi
 		FLUSH_PRIMITIVES(pfnSetPalette);
 		FLUSH_PRIMITIVES(pfnSetScissorRect);
 		FLUSH_PRIMITIVES(pfnSetViewport);
-		FLUSH_PRIMITIVES(pfnStateSet);
 		FLUSH_PRIMITIVES(pfnTexBlt);
 		FLUSH_PRIMITIVES(pfnTexBlt1);
 		FLUSH_PRIMITIVES(pfnUpdatePalette);
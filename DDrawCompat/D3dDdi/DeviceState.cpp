@@ -83,17 +83,17 @@ namespace D3dDdi
 
 	HRESULT DeviceState::pfnSetPixelShaderConst(const D3DDDIARG_SETPIXELSHADERCONST* data, const FLOAT* registers)
 	{
-		return setShaderConst(data, registers, m_pixelShaderConst, m_device.getOrigVtable().pfnSetPixelShaderConst);
+		return setShaderConst(data, registers, m_pixelShaderConst);
 	}
 
 	HRESULT DeviceState::pfnSetPixelShaderConstB(const D3DDDIARG_SETPIXELSHADERCONSTB* data, const BOOL* registers)
 	{
-		return setShaderConst(data, registers, m_pixelShaderConstB, m_device.getOrigVtable().pfnSetPixelShaderConstB);
+		return setShaderConst(data, registers, m_pixelShaderConstB);
 	}
 
 	HRESULT DeviceState::pfnSetPixelShaderConstI(const D3DDDIARG_SETPIXELSHADERCONSTI* data, const INT* registers)
 	{
-		return setShaderConst(data, registers, m_pixelShaderConstI, m_device.getOrigVtable().pfnSetPixelShaderConstI);
+		return setShaderConst(data, registers, m_pixelShaderConstI);
 	}
 
 	HRESULT DeviceState::pfnSetRenderState(const D3DDDIARG_RENDERSTATE* data)
@@ -149,17 +149,17 @@ namespace D3dDdi
 
 	HRESULT DeviceState::pfnSetVertexShaderConst(const D3DDDIARG_SETVERTEXSHADERCONST* data, const void* registers)
 	{
-		return setShaderConst(data, registers, m_vertexShaderConst, m_device.getOrigVtable().pfnSetVertexShaderConst);
+		return setShaderConst(data, registers, m_vertexShaderConst);
 	}
 
 	HRESULT DeviceState::pfnSetVertexShaderConstB(const D3DDDIARG_SETVERTEXSHADERCONSTB* data, const BOOL* registers)
 	{
-		return setShaderConst(data, registers, m_vertexShaderConstB, m_device.getOrigVtable().pfnSetVertexShaderConstB);
+		return setShaderConst(data, registers, m_vertexShaderConstB);
 	}
 
 	HRESULT DeviceState::pfnSetVertexShaderConstI(const D3DDDIARG_SETVERTEXSHADERCONSTI* data, const INT* registers)
 	{
-		return setShaderConst(data, registers, m_vertexShaderConstI, m_device.getOrigVtable().pfnSetVertexShaderConstI);
+		return setShaderConst(data, registers, m_vertexShaderConstI);
 	}
 
 	HRESULT DeviceState::pfnSetVertexShaderDecl(HANDLE shader)
@@ -190,6 +190,17 @@ namespace D3dDdi
 		return setState(data, m_zRange, m_device.getOrigVtable().pfnSetZRange);
 	}
 
+	HRESULT DeviceState::pfnStateSet(const D3DDDIARG_STATESET* data)
+	{
+		m_device.flushPrimitives();
+		HRESULT result = flushShaderConsts();
+		if (FAILED(result))
+		{
+			return result;
+		}
+		return m_device.getOrigVtable().pfnStateSet(m_device, data);
+	}
+
 	HRESULT DeviceState::pfnUpdateWInfo(const D3DDDIARG_WINFO* data)
 	{
 		D3DDDIARG_WINFO wInfo = *data;
@@ -216,6 +227,42 @@ namespace D3dDdi
 		return result;
 	}
 
+	HRESULT DeviceState::flushShaderConsts()
+	{
+		const auto& vtable = m_device.getOrigVtable();
+		const HRESULT results[] = {
+			flushShaderConst(m_pixelShaderConst, vtable.pfnSetPixelShaderConst),
+			flushShaderConst(m_pixelShaderConstB, vtable.pfnSetPixelShaderConstB),
+			flushShaderConst(m_pixelShaderConstI, vtable.pfnSetPixelShaderConstI),
+			flushShaderConst(m_vertexShaderConst, vtable.pfnSetVertexShaderConst),
+			flushShaderConst(m_vertexShaderConstB, vtable.pfnSetVertexShaderConstB),
+			flushShaderConst(m_vertexShaderConstI, vtable.pfnSetVertexShaderConstI)
+		};
+
+		for (HRESULT result : results)
+		{
+			if (FAILED(result))
+			{
+				LOG_ONCE("WARNING: Failed to set shader constants: " << Compat::hex(result));
+				return result;
+			}
+		}
+		return S_OK;
+	}
+
+	template <typename SetShaderConstData, typename ShaderConst, typename Registers>
+	HRESULT DeviceState::flushShaderConst(ShaderConstBank<ShaderConst>& shaderConst,
+		HRESULT(APIENTRY* origSetShaderConstFunc)(HANDLE, const SetShaderConstData*, const Registers*))
+	{
+		return shaderConst.flush([&](UINT reg, UINT count, const ShaderConst* registers)
+			{
+				SetShaderConstData data = {};
+				data.Register = reg;
+				data.Count = count;
+				return origSetShaderConstFunc(m_device, &data, reinterpret_cast<const Registers*>(registers));
+			});
+	}
+
 	void DeviceState::removeTexture(HANDLE texture)
 	{
 		for (UINT i = 0; i < m_textures.size(); ++i)
@@ -247,26 +294,11 @@ namespace D3dDdi
 
 	template <typename SetShaderConstData, typename ShaderConst, typename Registers>
 	HRESULT DeviceState::setShaderConst(const SetShaderConstData* data, const Registers* registers,
-		std::vector<ShaderConst>& shaderConst,
-		HRESULT(APIENTRY* origSetShaderConstFunc)(HANDLE, const SetShaderConstData*, const Registers*))
+		ShaderConstBank<ShaderConst>& shaderConst)
 	{
-		if (data->Register + data->Count > shaderConst.size())
-		{
-			shaderConst.resize(data->Register + data->Count);
-		}
-
-		if (0 == memcmp(&shaderConst[data->Register], registers, data->Count * sizeof(ShaderConst)))
-		{
-			return S_OK;
-		}
-
-		m_device.flushPrimitives();
-		HRESULT result = origSetShaderConstFunc(m_device, data, registers);
-		if (SUCCEEDED(result))
-		{
-			memcpy(&shaderConst[data->Register], registers, data->Count * sizeof(ShaderConst));
-		}
-		return result;
+		shaderConst.set(data->Register, data->Count, reinterpret_cast<const ShaderConst*>(registers),
+			[&]() { m_device.flushPrimitives(); });
+		return S_OK;
 	}
 
 	template <typename StateData>
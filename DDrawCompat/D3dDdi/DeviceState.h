@@ -2,8 +2,11 @@
 
 #include <array>
 #include <map>
+#include <tuple>
 #include <vector>
 
+#include <D3dDdi/ShaderConstBank.h>
+
 namespace D3dDdi
 {
 	class Device;
@@ -30,8 +33,10 @@ namespace D3dDdi
 		HRESULT pfnSetVertexShaderDecl(HANDLE shader);
 		HRESULT pfnSetVertexShaderFunc(HANDLE shader);
 		HRESULT pfnSetZRange(const D3DDDIARG_ZRANGE* data);
+		HRESULT pfnStateSet(const D3DDDIARG_STATESET* data);
 		HRESULT pfnUpdateWInfo(const D3DDDIARG_WINFO* data);
 
+		HRESULT flushShaderConsts();
 		void removeTexture(HANDLE texture);
 
 	private:
@@ -44,10 +49,13 @@ namespace D3dDdi
 			HRESULT(APIENTRY* origSetShaderFunc)(HANDLE, HANDLE));
 
 		template <typename SetShaderConstData, typename ShaderConst, typename Registers>
-		HRESULT setShaderConst(const SetShaderConstData* data, const Registers* registers,
-			std::vector<ShaderConst>& shaderConst,
+		HRESULT flushShaderConst(ShaderConstBank<ShaderConst>& shaderConst,
 			HRESULT(APIENTRY* origSetShaderConstFunc)(HANDLE, const SetShaderConstData*, const Registers*));
 
+		template <typename SetShaderConstData, typename ShaderConst, typename Registers>
+		HRESULT setShaderConst(const SetShaderConstData* data, const Registers* registers,
+			ShaderConstBank<ShaderConst>& shaderConst);
+
 		template <typename StateData>
 		HRESULT setState(const StateData* data, StateData& currentState,
 			HRESULT(APIENTRY* origSetState)(HANDLE, const StateData*));
@@ -58,15 +66,15 @@ namespace D3dDdi
 
 		Device& m_device;
 		HANDLE m_pixelShader;
-		std::vector<ShaderConstF> m_pixelShaderConst;
-		std::vector<BOOL> m_pixelShaderConstB;
-		std::vector<ShaderConstI> m_pixelShaderConstI;
+		ShaderConstBank<ShaderConstF> m_pixelShaderConst;
+		ShaderConstBank<BOOL> m_pixelShaderConstB;
+		ShaderConstBank<ShaderConstI> m_pixelShaderConstI;
 		std::array<UINT, D3DDDIRS_BLENDOPALPHA + 1> m_renderState;
 		std::array<HANDLE, 8> m_textures;
 		std::array<std::array<UINT, D3DDDITSS_TEXTURECOLORKEYVAL + 1>, 8> m_textureStageState;
-		std::vector<ShaderConstF> m_vertexShaderConst;
-		std::vector<BOOL> m_vertexShaderConstB;
-		std::vector<ShaderConstI> m_vertexShaderConstI;
+		ShaderConstBank<ShaderConstF> m_vertexShaderConst;
+		ShaderConstBank<BOOL> m_vertexShaderConstB;
+		ShaderConstBank<ShaderConstI> m_vertexShaderConstI;
 		std::map<HANDLE, std::vector<D3DDDIVERTEXELEMENT>> m_vertexShaderDecls;
 		HANDLE m_vertexShaderDecl;
 		HANDLE m_vertexShaderFunc;
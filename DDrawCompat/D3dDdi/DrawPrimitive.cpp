@@ -1,8 +1,10 @@
-#include <algorithm>
-
 #include <Common/Log.h>
+#include <Common/SharedMetrics.h>
+#include <Common/Time.h>
+#include <Config/Config.h>
 #include <D3dDdi/DrawPrimitive.h>
 #include <D3dDdi/Device.h>
+#include <D3dDdi/Indices.h>
 #include <D3dDdi/Resource.h>
 
 namespace
@@ -56,6 +58,7 @@ namespace D3dDdi
 		, m_streamSource{}
 		, m_batched{}
 		, m_isHwVertexProcessingUsed(false)
+		, m_batchStatsStartTime(Time::queryPerformanceCounter())
 	{
 		LOG_ONCE("Dynamic vertex buffers are " << (m_vertexBuffer ? "" : "not ") << "available");
 		LOG_ONCE("Dynamic index buffers are " << (m_indexBuffer ? "" : "not ") << "available");
@@ -84,51 +87,31 @@ namespace D3dDdi
 	void DrawPrimitive::appendIndexedVerticesWithoutRebase(const UINT16* indices, UINT count,
 		INT baseVertexIndex, UINT minIndex, UINT maxIndex)
 	{
-		UINT vertexCount = maxIndex - minIndex + 1;
-		if (vertexCount <= count)
+		const UINT vertexCount = maxIndex - minIndex + 1;
+		const UINT indexPos = m_batched.indices.size();
+		m_batched.indices.resize(indexPos + count);
+
+		if (VertexCompactor::isRangeCopyPreferred(count, vertexCount))
 		{
-			INT delta = getBatchedVertexCount() - minIndex;
-			for (UINT i = 0; i < count; ++i)
-			{
-				m_batched.indices.push_back(static_cast<UINT16>(indices[i] + delta));
-			}
+			Indices::rebase(m_batched.indices.data() + indexPos, indices, count, getBatchedVertexCount() - minIndex);
 			appendVertices(baseVertexIndex + minIndex, vertexCount);
 			return;
 		}
 
-		static UINT16 indexMap[D3DMAXNUMVERTICES] = {};
-		static BYTE indexCycles[D3DMAXNUMVERTICES] = {};
-		static BYTE currentCycle = 0;
-		static UINT maxVertexCount = 0;
+		m_vertexCompactor.compact(indices, count, minIndex, vertexCount,
+			static_cast<UINT16>(getBatchedVertexCount()), m_batched.indices.data() + indexPos);
 
-		++currentCycle;
-		if (0 == currentCycle)
-		{
-			memset(indexCycles, 0, maxVertexCount);
-			maxVertexCount = vertexCount;
-			++currentCycle;
-		}
-		else
-		{
-			updateMax(maxVertexCount, vertexCount);
-		}
+		const auto& uniqueIndices = m_vertexCompactor.getUniqueIndices();
+		const UINT stride = m_streamSource.stride;
+		const UINT vertexPos = m_batched.vertices.size();
+		m_batched.vertices.resize(vertexPos + uniqueIndices.size() * stride);
 
-		UINT16 newIndex = static_cast<UINT16>(getBatchedVertexCount());
-		for (UINT i = 0; i < count; ++i)
+		auto dst = m_batched.vertices.data() + vertexPos;
+		auto src = m_streamSource.vertices + baseVertexIndex * static_cast<INT>(stride);
+		for (auto index : uniqueIndices)
 		{
-			const UINT16 zeroBasedIndex = static_cast<UINT16>(indices[i] - minIndex);
-			if (currentCycle != indexCycles[zeroBasedIndex])
-			{
-				appendVertices(baseVertexIndex + indices[i], 1);
-				indexMap[zeroBasedIndex] = newIndex;
-				indexCycles[zeroBasedIndex] = currentCycle;
-				m_batched.indices.push_back(newIndex);
-				++newIndex;
-			}
-			else
-			{
-				m_batched.indices.push_back(indexMap[zeroBasedIndex]);
-			}
+			memcpy(dst, src + index * stride, stride);
+			dst += stride;
 		}
 	}
 
@@ -140,10 +123,9 @@ namespace D3dDdi
 
 	void DrawPrimitive::appendIndexRangeWithoutRebase(UINT base, UINT count)
 	{
-		for (UINT i = base; i < base + count; ++i)
-		{
-			m_batched.indices.push_back(static_cast<UINT16>(i));
-		}
+		const UINT indexPos = m_batched.indices.size();
+		m_batched.indices.resize(indexPos + count);
+		Indices::generateRange(m_batched.indices.data() + indexPos, base, count);
 		updateMin(m_batched.minIndex, base);
 		updateMax(m_batched.maxIndex, base + count - 1);
 	}
@@ -152,10 +134,9 @@ namespace D3dDdi
 		INT baseVertexIndex, UINT minIndex, UINT maxIndex)
 	{
 		rebaseIndices();
-		for (UINT i = 0; i < count; ++i)
-		{
-			m_batched.indices.push_back(static_cast<UINT16>(baseVertexIndex + indices[i]));
-		}
+		const UINT indexPos = m_batched.indices.size();
+		m_batched.indices.resize(indexPos + count);
+		Indices::rebase(m_batched.indices.data() + indexPos, indices, count, baseVertexIndex);
 		updateMin(m_batched.minIndex, baseVertexIndex + minIndex);
 		updateMax(m_batched.maxIndex, baseVertexIndex + maxIndex);
 	}
@@ -208,6 +189,13 @@ namespace D3dDdi
 			return false;
 		}
 
+		// Indexed vertices may be copied as a whole range, and joining triangle strips repeats up to 3 vertices
+		if (m_streamSource.vertices && indices &&
+			getBatchedVertexCount() + (maxIndex - minIndex + 1) + 3 > D3DMAXNUMVERTICES)
+		{
+			return false;
+		}
+
 		switch (primitiveType)
 		{
 		case D3DPT_POINTLIST:
@@ -335,56 +323,20 @@ namespace D3dDdi
 
 	void DrawPrimitive::convertIndexedTriangleFanToList(UINT startPrimitive, UINT primitiveCount)
 	{
-		const UINT totalPrimitiveCount = startPrimitive + primitiveCount;
-		m_batched.indices.resize(totalPrimitiveCount * 3);
-
-		INT startIndexPos = startPrimitive * 3;
-		INT oldIndexPos = startIndexPos + primitiveCount - 1;
-		INT newIndexPos = (totalPrimitiveCount - 1) * 3;
-		const UINT16 startIndex = m_batched.indices[startIndexPos];
-
-		while (newIndexPos > startIndexPos)
-		{
-			m_batched.indices[newIndexPos + 2] = startIndex;
-			m_batched.indices[newIndexPos + 1] = m_batched.indices[oldIndexPos + 2];
-			m_batched.indices[newIndexPos] = m_batched.indices[oldIndexPos + 1];
-			newIndexPos -= 3;
-			oldIndexPos--;
-		}
-
-		m_batched.indices[newIndexPos] = m_batched.indices[oldIndexPos + 1];
-		m_batched.indices[newIndexPos + 1] = m_batched.indices[oldIndexPos + 2];
-		m_batched.indices[newIndexPos + 2] = startIndex;
+		const UINT startIndexPos = startPrimitive * 3;
+		m_indexScratch.assign(m_batched.indices.begin() + startIndexPos,
+			m_batched.indices.begin() + startIndexPos + primitiveCount + 2);
+		m_batched.indices.resize((startPrimitive + primitiveCount) * 3);
+		Indices::convertTriangleFanToList(m_batched.indices.data() + startIndexPos, m_indexScratch.data(), primitiveCount);
 	}
 
 	void DrawPrimitive::convertIndexedTriangleStripToList(UINT startPrimitive, UINT primitiveCount)
 	{
-		const UINT totalPrimitiveCount = startPrimitive + primitiveCount;
-		m_batched.indices.resize(totalPrimitiveCount * 3);
-
-		INT oldIndexPos = startPrimitive * 3 + primitiveCount - 2;
-		INT newIndexPos = (totalPrimitiveCount - 2) * 3;
-
-		if (0 != primitiveCount % 2)
-		{
-			m_batched.indices[newIndexPos + 5] = m_batched.indices[oldIndexPos + 3];
-			m_batched.indices[newIndexPos + 4] = m_batched.indices[oldIndexPos + 2];
-			m_batched.indices[newIndexPos + 3] = m_batched.indices[oldIndexPos + 1];
-			newIndexPos -= 3;
-			oldIndexPos--;
-		}
-
-		while (newIndexPos >= oldIndexPos)
-		{
-			m_batched.indices[newIndexPos + 5] = m_batched.indices[oldIndexPos + 2];
-			m_batched.indices[newIndexPos + 4] = m_batched.indices[oldIndexPos + 3];
-			m_batched.indices[newIndexPos + 3] = m_batched.indices[oldIndexPos + 1];
-			m_batched.indices[newIndexPos + 2] = m_batched.indices[oldIndexPos + 2];
-			m_batched.indices[newIndexPos + 1] = m_batched.indices[oldIndexPos + 1];
-			m_batched.indices[newIndexPos] = m_batched.indices[oldIndexPos];
-			newIndexPos -= 6;
-			oldIndexPos -= 2;
-		}
+		const UINT startIndexPos = startPrimitive * 3;
+		m_indexScratch.assign(m_batched.indices.begin() + startIndexPos,
+			m_batched.indices.begin() + startIndexPos + primitiveCount + 2);
+		m_batched.indices.resize((startPrimitive + primitiveCount) * 3);
+		Indices::convertTriangleStripToList(m_batched.indices.data() + startIndexPos, m_indexScratch.data(), primitiveCount);
 	}
 
 	void DrawPrimitive::convertToTriangleList()
@@ -453,10 +405,13 @@ namespace D3dDdi
 
 	HRESULT DrawPrimitive::draw(D3DDDIARG_DRAWPRIMITIVE data, const UINT* flagBuffer)
 	{
+		m_batchStats.addDraw();
+		Compat::SharedMetrics::add(Compat::SharedMetrics::DRAW_COUNT);
+		HRESULT result = S_OK;
 		if (0 == m_batched.primitiveCount || flagBuffer ||
 			!appendPrimitives(data.PrimitiveType, data.VStart, data.PrimitiveCount, nullptr, 0, 0))
 		{
-			flushPrimitives();
+			result = flushPrimitives();
 			auto vertexCount = getVertexCount(data.PrimitiveType, data.PrimitiveCount);
 			if (m_streamSource.vertices)
 			{
@@ -474,48 +429,59 @@ namespace D3dDdi
 
 			if (flagBuffer)
 			{
-				flushPrimitives(flagBuffer);
+				const HRESULT flushResult = flushPrimitives(flagBuffer);
+				if (SUCCEEDED(result))
+				{
+					result = flushResult;
+				}
 			}
 		}
 
-		return S_OK;
+		return result;
 	}
 
 	HRESULT DrawPrimitive::drawIndexed(
 		D3DDDIARG_DRAWINDEXEDPRIMITIVE2 data, const UINT16* indices, const UINT* flagBuffer)
 	{
+		m_batchStats.addDraw();
+		Compat::SharedMetrics::add(Compat::SharedMetrics::DRAW_COUNT);
 		auto indexCount = getVertexCount(data.PrimitiveType, data.PrimitiveCount);
-		auto [min, max] = std::minmax_element(indices, indices + indexCount);
-		data.MinIndex = *min;
-		data.NumVertices = *max - *min + 1;
+		auto [min, max] = Indices::getMinMax(indices, indexCount);
+		data.MinIndex = min;
+		data.NumVertices = max - min + 1;
 
+		HRESULT result = S_OK;
 		if (0 == m_batched.primitiveCount || flagBuffer ||
 			!appendPrimitives(data.PrimitiveType, data.BaseVertexOffset / static_cast<INT>(m_streamSource.stride),
-				data.PrimitiveCount, indices, *min, *max))
+				data.PrimitiveCount, indices, min, max))
 		{
-			flushPrimitives();
+			result = flushPrimitives();
 			m_batched.baseVertexIndex = data.BaseVertexOffset / static_cast<INT>(m_streamSource.stride);
 			if (m_streamSource.vertices)
 			{
-				appendIndexedVerticesWithoutRebase(indices, indexCount, m_batched.baseVertexIndex, *min, *max);
+				appendIndexedVerticesWithoutRebase(indices, indexCount, m_batched.baseVertexIndex, min, max);
 				m_batched.baseVertexIndex = 0;
 			}
 			else
 			{
 				m_batched.indices.assign(indices, indices + indexCount);
-				m_batched.minIndex = *min;
-				m_batched.maxIndex = *max;
+				m_batched.minIndex = min;
+				m_batched.maxIndex = max;
 			}
 			m_batched.primitiveType = data.PrimitiveType;
 			m_batched.primitiveCount = data.PrimitiveCount;
 
 			if (flagBuffer)
 			{
-				flushPrimitives(flagBuffer);
+				const HRESULT flushResult = flushPrimitives(flagBuffer);
+				if (SUCCEEDED(result))
+				{
+					result = flushResult;
+				}
 			}
 		}
 
-		return S_OK;
+		return result;
 	}
 
 	HRESULT DrawPrimitive::flush(const UINT* flagBuffer)
@@ -592,7 +558,34 @@ namespace D3dDdi
 		}
 
 		LOG_DEBUG << "Flushing " << m_batched.primitiveCount << " primitives of type " << m_batched.primitiveType;
-		return m_batched.indices.empty() ? flush(flagBuffer) : flushIndexed(flagBuffer);
+
+		const UINT indexCount = m_batched.indices.size();
+		UINT vertexCount = 0;
+		if (m_streamSource.vertices)
+		{
+			vertexCount = getBatchedVertexCount();
+		}
+		else if (0 == indexCount)
+		{
+			vertexCount = getVertexCount(m_batched.primitiveType, m_batched.primitiveCount);
+		}
+		else
+		{
+			vertexCount = m_batched.maxIndex - m_batched.minIndex + 1;
+		}
+		m_batchStats.addFlush(m_device.getDdiFuncName(), vertexCount, indexCount, m_batched.primitiveCount);
+		Compat::SharedMetrics::add(Compat::SharedMetrics::DRAW_FLUSH_COUNT);
+		Compat::SharedMetrics::add(Compat::SharedMetrics::DRAW_PRIMITIVE_COUNT, m_batched.primitiveCount);
+
+		if (0 != Config::batchStatsLogInterval &&
+			Time::queryPerformanceCounter() - m_batchStatsStartTime >= Time::msToQpc(Config::batchStatsLogInterval))
+		{
+			logBatchStats();
+		}
+
+		const HRESULT shaderConstResult = m_device.getState().flushShaderConsts();
+		const HRESULT result = m_batched.indices.empty() ? flush(flagBuffer) : flushIndexed(flagBuffer);
+		return FAILED(shaderConstResult) ? shaderConstResult : result;
 	}
 
 	UINT DrawPrimitive::getBatchedVertexCount() const
@@ -602,9 +595,17 @@ namespace D3dDdi
 
 	INT DrawPrimitive::loadIndices(const void* indices, UINT count)
 	{
+		const HANDLE indexBuffer = m_indexBuffer;
 		INT startIndex = m_indexBuffer.load(indices, count);
 		if (startIndex >= 0)
 		{
+			if (m_indexBuffer != indexBuffer)
+			{
+				D3DDDIARG_SETINDICES si = {};
+				si.hIndexBuffer = m_indexBuffer;
+				si.Stride = 2;
+				m_origVtable.pfnSetIndices(m_device, &si);
+			}
 			return startIndex;
 		}
 
@@ -636,7 +637,7 @@ namespace D3dDdi
 			if (size > m_vertexBuffer.getSize())
 			{
 				m_vertexBuffer.resize((size + VERTEX_BUFFER_SIZE - 1) / VERTEX_BUFFER_SIZE * VERTEX_BUFFER_SIZE);
-				if (m_vertexBuffer)
+				if (size <= m_vertexBuffer.getSize())
 				{
 					D3DDDIARG_SETSTREAMSOURCE ss = {};
 					ss.hVertexBuffer = m_vertexBuffer;
@@ -649,11 +650,19 @@ namespace D3dDdi
 				}
 			}
 
-			if (m_vertexBuffer)
+			if (size <= m_vertexBuffer.getSize())
 			{
+				const HANDLE vertexBuffer = m_vertexBuffer;
 				INT baseVertexIndex = m_vertexBuffer.load(vertices, count);
 				if (baseVertexIndex >= 0)
 				{
+					if (m_vertexBuffer != vertexBuffer)
+					{
+						D3DDDIARG_SETSTREAMSOURCE ss = {};
+						ss.hVertexBuffer = m_vertexBuffer;
+						ss.Stride = m_streamSource.stride;
+						m_origVtable.pfnSetStreamSource(m_device, &ss);
+					}
 					return baseVertexIndex;
 				}
 				LOG_ONCE("WARN: Dynamic vertex buffer lock failed");
@@ -669,6 +678,16 @@ namespace D3dDdi
 		return 0;
 	}
 
+	void DrawPrimitive::logBatchStats()
+	{
+		if (!m_batchStats.isEmpty())
+		{
+			Compat::Log() << "Batch statistics for device " << static_cast<HANDLE>(m_device) << ": " << m_batchStats;
+			m_batchStats.reset();
+		}
+		m_batchStatsStartTime = Time::queryPerformanceCounter();
+	}
+
 	void DrawPrimitive::rebaseIndices()
 	{
 		if (0 != m_batched.baseVertexIndex || m_batched.indices.empty())
@@ -680,10 +699,8 @@ namespace D3dDdi
 			}
 			else
 			{
-				for (auto& index : m_batched.indices)
-				{
-					index = static_cast<UINT16>(m_batched.baseVertexIndex + index);
-				}
+				Indices::rebase(m_batched.indices.data(), m_batched.indices.data(), m_batched.indices.size(),
+					m_batched.baseVertexIndex);
 				m_batched.minIndex += m_batched.baseVertexIndex;
 				m_batched.maxIndex += m_batched.baseVertexIndex;
 			}
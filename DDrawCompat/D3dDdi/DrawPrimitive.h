@@ -6,7 +6,9 @@
 #include <d3d.h>
 #include <d3dumddi.h>
 
+#include <D3dDdi/BatchStats.h>
 #include <D3dDdi/DynamicBuffer.h>
+#include <D3dDdi/VertexCompactor.h>
 
 namespace D3dDdi
 {
@@ -21,6 +23,7 @@ namespace D3dDdi
 		void removeSysMemVertexBuffer(HANDLE resource);
 
 		HRESULT flushPrimitives(const UINT* flagBuffer = nullptr);
+		void logBatchStats();
 
 		HRESULT draw(D3DDDIARG_DRAWPRIMITIVE data, const UINT* flagBuffer);
 		HRESULT drawIndexed(D3DDDIARG_DRAWINDEXEDPRIMITIVE2 data, const UINT16* indices, const UINT* flagBuffer);
@@ -79,13 +82,17 @@ namespace D3dDdi
 
 		HRESULT setSysMemStreamSource(const BYTE* vertices, UINT stride);
 
-		HANDLE m_device;
+		Device& m_device;
 		const D3DDDI_DEVICEFUNCS& m_origVtable;
 		DynamicVertexBuffer m_vertexBuffer;
 		DynamicIndexBuffer m_indexBuffer;
 		StreamSource m_streamSource;
 		std::map<HANDLE, BYTE*> m_sysMemVertexBuffers;
 		BatchedPrimitives m_batched;
+		std::vector<UINT16> m_indexScratch;
+		VertexCompactor m_vertexCompactor;
 		bool m_isHwVertexProcessingUsed;
+		BatchStats m_batchStats;
+		long long m_batchStatsStartTime;
 	};
 }
@@ -21,73 +21,36 @@ namespace
 namespace D3dDdi
 {
 	DynamicBuffer::DynamicBuffer(Device& device, UINT size, D3DDDIFORMAT format, D3DDDI_RESOURCEFLAGS resourceFlag)
-		: m_device(device)
-		, m_resource(nullptr, [&](HANDLE vb) { device.getOrigVtable().pfnDestroyResource(device, vb); })
-		, m_size(size)
-		, m_format(format)
-		, m_resourceFlag(resourceFlag)
-		, m_stride(0)
-		, m_pos(0)
+		: m_ddi(device, format, resourceFlag)
+		, m_buffer(m_ddi, size)
 	{
-		resize(size);
 	}
 
-	void* DynamicBuffer::lock(UINT size)
+	INT DynamicBuffer::load(const void* src, UINT count)
 	{
-		D3DDDIARG_LOCK lock = {};
-		lock.hResource = m_resource.get();
-		lock.Range.Offset = m_pos;
-		lock.Range.Size = size;
-		lock.Flags.RangeValid = 1;
-
-		if (0 == m_pos)
-		{
-			lock.Flags.Discard = 1;
-		}
-		else
-		{
-			lock.Flags.WriteOnly = 1;
-			lock.Flags.NoOverwrite = 1;
-		}
-
-		HRESULT result = m_device.getOrigVtable().pfnLock(m_device, &lock);
-		if (FAILED(result))
-		{
-			return nullptr;
-		}
-		return lock.pSurfData;
+		return m_buffer.load(src, count);
 	}
 
-	INT DynamicBuffer::load(const void* src, UINT count)
+	void DynamicBuffer::resize(UINT size)
 	{
-		UINT size = count * m_stride;
-		if (m_pos + size > m_size)
-		{
-			m_pos = 0;
-		}
-
-		UINT pos = m_pos;
-		auto dst = lock(size);
-		if (!dst)
-		{
-			return -1;
-		}
+		m_buffer.resize(size);
+	}
 
-		memcpy(dst, src, size);
-		unlock();
-		m_pos += size;
-		return pos / m_stride;
+	void DynamicBuffer::setStride(UINT stride)
+	{
+		m_buffer.setStride(stride);
 	}
 
-	void DynamicBuffer::resize(UINT size)
+	DynamicBuffer::Ddi::Ddi(Device& device, D3DDDIFORMAT format, D3DDDI_RESOURCEFLAGS resourceFlag)
+		: m_device(device)
+		, m_resource(nullptr, [this](HANDLE vb) { m_device.getOrigVtable().pfnDestroyResource(m_device, vb); })
+		, m_format(format)
+		, m_resourceFlag(resourceFlag)
 	{
-		m_size = 0;
-		if (0 == size)
-		{
-			m_resource.reset();
-			return;
-		}
+	}
 
+	bool DynamicBuffer::Ddi::createBuffer(UINT size)
+	{
 		D3DDDI_SURFACEINFO surfaceInfo = {};
 		surfaceInfo.Width = size;
 		surfaceInfo.Height = 1;
@@ -102,21 +65,85 @@ namespace D3dDdi
 		cr.Flags.WriteOnly = 1;
 		cr.Rotation = D3DDDI_ROTATION_IDENTITY;
 
-		m_resource.reset();
-		if (SUCCEEDED(m_device.createPrivateResource(cr)))
+		if (FAILED(m_device.createPrivateResource(cr)))
 		{
-			m_resource.reset(cr.hResource);
-			m_size = size;
+			return false;
 		}
+
+		m_resource.reset(cr.hResource);
+		return true;
 	}
 
-	void DynamicBuffer::setStride(UINT stride)
+	HANDLE DynamicBuffer::Ddi::createFence()
+	{
+		D3DDDIARG_CREATEQUERY cq = {};
+		cq.QueryType = D3DDDIQUERYTYPE_EVENT;
+		if (FAILED(m_device.getOrigVtable().pfnCreateQuery(m_device, &cq)))
+		{
+			return nullptr;
+		}
+		return cq.hQuery;
+	}
+
+	void DynamicBuffer::Ddi::destroyBuffer()
+	{
+		m_resource.reset();
+	}
+
+	void DynamicBuffer::Ddi::destroyFence(HANDLE fence)
 	{
-		m_stride = stride;
-		m_pos = (m_pos + stride - 1) / stride * stride;
+		m_device.getOrigVtable().pfnDestroyQuery(m_device, fence);
+	}
+
+	UINT DynamicBuffer::Ddi::getPresentCount() const
+	{
+		return m_device.getPresentCount();
+	}
+
+	bool DynamicBuffer::Ddi::isFenceSignaled(HANDLE fence)
+	{
+		BOOL isSignaled = FALSE;
+		D3DDDIARG_GETQUERYDATA gqd = {};
+		gqd.hQuery = fence;
+		gqd.pData = &isSignaled;
+		return S_OK == m_device.getOrigVtable().pfnGetQueryData(m_device, &gqd);
+	}
+
+	bool DynamicBuffer::Ddi::issueFence(HANDLE fence)
+	{
+		D3DDDIARG_ISSUEQUERY iq = {};
+		iq.hQuery = fence;
+		iq.Flags.End = 1;
+		return SUCCEEDED(m_device.getOrigVtable().pfnIssueQuery(m_device, &iq));
+	}
+
+	void* DynamicBuffer::Ddi::lock(UINT offset, UINT size, bool discard)
+	{
+		D3DDDIARG_LOCK lock = {};
+		lock.hResource = m_resource.get();
+		lock.Range.Offset = offset;
+		lock.Range.Size = size;
+		lock.Flags.RangeValid = 1;
+
+		if (discard)
+		{
+			lock.Flags.Discard = 1;
+		}
+		else
+		{
+			lock.Flags.WriteOnly = 1;
+			lock.Flags.NoOverwrite = 1;
+		}
+
+		HRESULT result = m_device.getOrigVtable().pfnLock(m_device, &lock);
+		if (FAILED(result))
+		{
+			return nullptr;
+		}
+		return lock.pSurfData;
 	}
 
-	void DynamicBuffer::unlock()
+	void DynamicBuffer::Ddi::unlock()
 	{
 		D3DDDIARG_UNLOCK unlock = {};
 		unlock.hResource = m_resource.get();
@@ -126,7 +153,7 @@ namespace D3dDdi
 	DynamicIndexBuffer::DynamicIndexBuffer(Device& device, UINT size)
 		: DynamicBuffer(device, size, D3DDDIFMT_INDEX16, getIndexBufferFlag())
 	{
-		m_stride = 2;
+		setStride(2);
 	}
 
 	DynamicVertexBuffer::DynamicVertexBuffer(Device& device, UINT size)
@@ -6,6 +6,8 @@
 #include <d3d.h>
 #include <d3dumddi.h>
 
+#include <D3dDdi/SegmentedBuffer.h>
+
 namespace D3dDdi
 {
 	class Device;
@@ -13,26 +15,45 @@ namespace D3dDdi
 	class DynamicBuffer
 	{
 	public:
-		UINT getSize() const { return m_size; }
+		UINT getSize() const { return m_buffer.getSize(); }
 		INT load(const void* src, UINT count);
 		void resize(UINT size);
 
-		operator HANDLE() const { return m_resource.get(); }
+		operator HANDLE() const { return m_ddi.getResource(); }
 
 	protected:
 		DynamicBuffer(Device& device, UINT size, D3DDDIFORMAT format, D3DDDI_RESOURCEFLAGS resourceFlag);
 
-		void* lock(UINT size);
 		void setStride(UINT stride);
-		void unlock();
-
-		Device& m_device;
-		std::unique_ptr<void, std::function<void(HANDLE)>> m_resource;
-		UINT m_size;
-		D3DDDIFORMAT m_format;
-		D3DDDI_RESOURCEFLAGS m_resourceFlag;
-		UINT m_stride;
-		UINT m_pos;
+
+	private:
+		class Ddi
+		{
+		public:
+			Ddi(Device& device, D3DDDIFORMAT format, D3DDDI_RESOURCEFLAGS resourceFlag);
+
+			bool createBuffer(UINT size);
+			void destroyBuffer();
+			void* lock(UINT offset, UINT size, bool discard);
+			void unlock();
+
+			HANDLE createFence();
+			void destroyFence(HANDLE fence);
+			bool isFenceSignaled(HANDLE fence);
+			bool issueFence(HANDLE fence);
+
+			UINT getPresentCount() const;
+			HANDLE getResource() const { return m_resource.get(); }
+
+		private:
+			Device& m_device;
+			std::unique_ptr<void, std::function<void(HANDLE)>> m_resource;
+			D3DDDIFORMAT m_format;
+			D3DDDI_RESOURCEFLAGS m_resourceFlag;
+		};
+
+		Ddi m_ddi;
+		SegmentedBuffer<Ddi> m_buffer;
 	};
 
 	class DynamicIndexBuffer : public DynamicBuffer
@@ -0,0 +1,164 @@
+#include <algorithm>
+
+#include <emmintrin.h>
+
+#include <D3dDdi/Indices.h>
+
+namespace
+{
+	__m128i loadIndices(const UINT16* src)
+	{
+		return _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+	}
+
+	void storeIndices(UINT16* dst, __m128i indices)
+	{
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), indices);
+	}
+
+	void storeIndicesLow(UINT16* dst, __m128i indices)
+	{
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(dst), indices);
+	}
+}
+
+namespace D3dDdi
+{
+	namespace Indices
+	{
+		void convertTriangleFanToList(UINT16* dst, const UINT16* src, UINT primitiveCount)
+		{
+			const UINT16 startIndex = src[0];
+			UINT i = 0;
+			for (; i + 9 <= primitiveCount + 2; i += 4)
+			{
+				const __m128i v = loadIndices(src + i + 1);
+				const __m128i w = _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 1, 0, 0));
+				__m128i out = _mm_shufflehi_epi16(_mm_shufflelo_epi16(w, _MM_SHUFFLE(1, 1, 1, 0)), _MM_SHUFFLE(1, 0, 0, 0));
+				out = _mm_insert_epi16(out, startIndex, 2);
+				out = _mm_insert_epi16(out, startIndex, 5);
+				storeIndices(dst, out);
+
+				out = _mm_shufflelo_epi16(_mm_srli_si128(v, 6), _MM_SHUFFLE(1, 1, 0, 0));
+				out = _mm_insert_epi16(out, startIndex, 0);
+				out = _mm_insert_epi16(out, startIndex, 3);
+				storeIndicesLow(dst + 8, out);
+				dst += 12;
+			}
+
+			for (; i < primitiveCount; ++i)
+			{
+				dst[0] = src[i + 1];
+				dst[1] = src[i + 2];
+				dst[2] = startIndex;
+				dst += 3;
+			}
+		}
+
+		void convertTriangleStripToList(UINT16* dst, const UINT16* src, UINT primitiveCount)
+		{
+			UINT i = 0;
+			for (; i + 8 <= primitiveCount + 2; i += 4)
+			{
+				const __m128i v = loadIndices(src + i);
+				const __m128i w = _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 1, 0));
+				storeIndices(dst, _mm_shufflehi_epi16(
+					_mm_shufflelo_epi16(w, _MM_SHUFFLE(1, 2, 1, 0)), _MM_SHUFFLE(3, 2, 2, 3)));
+				storeIndicesLow(dst + 8, _mm_shufflelo_epi16(_mm_srli_si128(v, 6), _MM_SHUFFLE(1, 2, 0, 1)));
+				dst += 12;
+			}
+
+			for (; i < primitiveCount; ++i)
+			{
+				if (0 == i % 2)
+				{
+					dst[0] = src[i];
+					dst[1] = src[i + 1];
+					dst[2] = src[i + 2];
+				}
+				else
+				{
+					dst[0] = src[i];
+					dst[1] = src[i + 2];
+					dst[2] = src[i + 1];
+				}
+				dst += 3;
+			}
+		}
+
+		void generateRange(UINT16* dst, UINT base, UINT count)
+		{
+			UINT i = 0;
+			if (count >= 8)
+			{
+				__m128i v = _mm_add_epi16(_mm_set1_epi16(static_cast<short>(base)), _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7));
+				const __m128i step = _mm_set1_epi16(8);
+				for (; i + 8 <= count; i += 8)
+				{
+					storeIndices(dst + i, v);
+					v = _mm_add_epi16(v, step);
+				}
+			}
+
+			for (; i < count; ++i)
+			{
+				dst[i] = static_cast<UINT16>(base + i);
+			}
+		}
+
+		std::pair<UINT16, UINT16> getMinMax(const UINT16* indices, UINT count)
+		{
+			if (0 == count)
+			{
+				return { 0, 0 };
+			}
+
+			UINT16 min = indices[0];
+			UINT16 max = indices[0];
+			UINT i = 0;
+			if (count >= 8)
+			{
+				const __m128i signBit = _mm_set1_epi16(-0x8000);
+				__m128i vMin = _mm_xor_si128(loadIndices(indices), signBit);
+				__m128i vMax = vMin;
+				for (i = 8; i + 8 <= count; i += 8)
+				{
+					const __m128i v = _mm_xor_si128(loadIndices(indices + i), signBit);
+					vMin = _mm_min_epi16(vMin, v);
+					vMax = _mm_max_epi16(vMax, v);
+				}
+
+				vMin = _mm_min_epi16(vMin, _mm_shuffle_epi32(vMin, _MM_SHUFFLE(1, 0, 3, 2)));
+				vMin = _mm_min_epi16(vMin, _mm_shuffle_epi32(vMin, _MM_SHUFFLE(2, 3, 0, 1)));
+				vMin = _mm_min_epi16(vMin, _mm_shufflelo_epi16(vMin, _MM_SHUFFLE(2, 3, 0, 1)));
+				vMax = _mm_max_epi16(vMax, _mm_shuffle_epi32(vMax, _MM_SHUFFLE(1, 0, 3, 2)));
+				vMax = _mm_max_epi16(vMax, _mm_shuffle_epi32(vMax, _MM_SHUFFLE(2, 3, 0, 1)));
+				vMax = _mm_max_epi16(vMax, _mm_shufflelo_epi16(vMax, _MM_SHUFFLE(2, 3, 0, 1)));
+				min = static_cast<UINT16>(_mm_cvtsi128_si32(_mm_xor_si128(vMin, signBit)));
+				max = static_cast<UINT16>(_mm_cvtsi128_si32(_mm_xor_si128(vMax, signBit)));
+			}
+
+			for (; i < count; ++i)
+			{
+				min = std::min<UINT16>(min, indices[i]);
+				max = std::max<UINT16>(max, indices[i]);
+			}
+			return { min, max };
+		}
+
+		void rebase(UINT16* dst, const UINT16* src, UINT count, INT delta)
+		{
+			UINT i = 0;
+			const __m128i d = _mm_set1_epi16(static_cast<short>(delta));
+			for (; i + 8 <= count; i += 8)
+			{
+				storeIndices(dst + i, _mm_add_epi16(loadIndices(src + i), d));
+			}
+
+			for (; i < count; ++i)
+			{
+				dst[i] = static_cast<UINT16>(src[i] + delta);
+			}
+		}
+	}
+}
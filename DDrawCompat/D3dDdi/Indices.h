@@ -0,0 +1,17 @@
+#pragma once
+
+#include <utility>
+
+#include <Windows.h>
+
+namespace D3dDdi
+{
+	namespace Indices
+	{
+		void convertTriangleFanToList(UINT16* dst, const UINT16* src, UINT primitiveCount);
+		void convertTriangleStripToList(UINT16* dst, const UINT16* src, UINT primitiveCount);
+		void generateRange(UINT16* dst, UINT base, UINT count);
+		std::pair<UINT16, UINT16> getMinMax(const UINT16* indices, UINT count);
+		void rebase(UINT16* dst, const UINT16* src, UINT count, INT delta);
+	}
+}
@@ -1,15 +1,22 @@
+#include <atomic>
+#include <cmath>
 #include <string>
+#include <vector>
+
+#include <dwmapi.h>
 
 #include <Common/Log.h>
 #include <Common/Hook.h>
 #include <Common/ScopedSrwLock.h>
 #include <Common/Time.h>
+#include <Common/WaitableCounter.h>
 #include <D3dDdi/Device.h>
 #include <D3dDdi/Hooks.h>
 #include <D3dDdi/KernelModeThunks.h>
 #include <D3dDdi/Log/KernelModeThunksLog.h>
 #include <D3dDdi/Resource.h>
 #include <D3dDdi/ScopedCriticalSection.h>
+#include <D3dDdi/VblankEstimator.h>
 #include <DDraw/RealPrimarySurface.h>
 #include <DDraw/ScopedThreadLock.h>
 #include <DDraw/Surfaces/PrimarySurface.h>
@@ -32,13 +39,59 @@ namespace
 	Compat::SrwLock g_lastOpenAdapterInfoSrwLock;
 	std::string g_lastDDrawCreateDcDevice;
 
-	HANDLE g_vsyncThread = nullptr;
-	bool g_stopVsyncThread = false;
-	UINT g_vsyncCounter = 0;
+	typedef BOOL(WINAPI* WaitOnAddressFunc)(volatile VOID*, PVOID, SIZE_T, DWORD);
+	typedef VOID(WINAPI* WakeByAddressAllFunc)(PVOID);
+
+	WaitOnAddressFunc g_waitOnAddress = nullptr;
+	WakeByAddressAllFunc g_wakeByAddressAll = nullptr;
 	CONDITION_VARIABLE g_vsyncCounterCv = CONDITION_VARIABLE_INIT;
 	Compat::SrwLock g_vsyncCounterSrwLock;
 
-	void waitForVerticalBlank();
+	// Uses WaitOnAddress where available and falls back to a condition variable on older systems
+	struct VsyncCounterWait
+	{
+		static void wait(std::atomic<UINT>& value, UINT expected)
+		{
+			if (g_waitOnAddress)
+			{
+				g_waitOnAddress(&value, &expected, sizeof(expected), INFINITE);
+				return;
+			}
+
+			Compat::ScopedSrwLockShared lock(g_vsyncCounterSrwLock);
+			while (value == expected)
+			{
+				SleepConditionVariableSRW(&g_vsyncCounterCv, &g_vsyncCounterSrwLock, INFINITE,
+					CONDITION_VARIABLE_LOCKMODE_SHARED);
+			}
+		}
+
+		static void wakeAll(std::atomic<UINT>& value)
+		{
+			if (g_wakeByAddressAll)
+			{
+				g_wakeByAddressAll(&value);
+				return;
+			}
+
+			{
+				Compat::ScopedSrwLockExclusive lock(g_vsyncCounterSrwLock);
+			}
+			WakeAllConditionVariable(&g_vsyncCounterCv);
+		}
+	};
+
+	HANDLE g_vsyncThread = nullptr;
+	bool g_stopVsyncThread = false;
+	Compat::WaitableCounter<VsyncCounterWait> g_vsyncCounter;
+
+	D3dDdi::VblankEstimator g_vblankEstimator(0);
+	Compat::SrwLock g_vblankEstimatorSrwLock;
+	ULONG g_vblankDisplaySettingsUniqueness = 0;
+	long long g_qpcLastVblankSample = 0;
+
+	void updateVblankEstimator(long long qpc);
+	bool waitForVerticalBlank();
 
 	NTSTATUS APIENTRY closeAdapter(const D3DKMT_CLOSEADAPTER* pData)
 	{
@@ -61,14 +114,15 @@ namespace
 		}
 
 		std::vector<PALETTEENTRY> palette;
+		std::shared_ptr<const Gdi::Palette::Snapshot> paletteSnapshot;
 		auto origColorTable = pData->pColorTable;
 
 		if (D3DDDIFMT_P8 == pData->Format)
 		{
 			if (g_dcPaletteOverride)
 			{
-				palette = Gdi::Palette::getHardwarePalette();
-				pData->pColorTable = palette.data();
+				paletteSnapshot = Gdi::Palette::getHardwarePalette();
+				pData->pColorTable = const_cast<PALETTEENTRY*>(paletteSnapshot->entries);
 			}
 			else
 			{
@@ -88,15 +142,15 @@ namespace
 					{
 						if (palette[i].peFlags & PC_EXPLICIT)
 						{
-							palette[i] = sysPal[palette[i].peRed];
+							palette[i] = sysPal->entries[palette[i].peRed];
 						}
 					}
 					pData->pColorTable = palette.data();
 				}
 				else
 				{
-					palette = Gdi::Palette::getHardwarePalette();
-					pData->pColorTable = palette.data();
+					paletteSnapshot = Gdi::Palette::getHardwarePalette();
+					pData->pColorTable = const_cast<PALETTEENTRY*>(paletteSnapshot->entries);
 				}
 			}
 		}
@@ -127,6 +181,15 @@ namespace
 		return TRUE;
 	}
 
+	double getNominalVblankPeriod()
+	{
+		DEVMODE dm = {};
+		dm.dmSize = sizeof(dm);
+		EnumDisplaySettings(nullptr, ENUM_CURRENT_SETTINGS, &dm);
+		const DWORD refreshRate = dm.dmDisplayFrequency > 1 ? dm.dmDisplayFrequency : 60;
+		return static_cast<double>(Time::g_qpcFrequency) / refreshRate;
+	}
+
 	AdapterInfo getAdapterInfo(const D3DKMT_OPENADAPTERFROMHDC& data)
 	{
 		AdapterInfo adapterInfo = {};
@@ -244,39 +307,121 @@ namespace
 	{
 		while (!g_stopVsyncThread)
 		{
-			waitForVerticalBlank();
-
+			if (waitForVerticalBlank())
 			{
-				Compat::ScopedSrwLockExclusive lock(g_vsyncCounterSrwLock);
-				++g_vsyncCounter;
+				updateVblankEstimator(Time::queryPerformanceCounter());
 			}
-
-			WakeAllConditionVariable(&g_vsyncCounterCv);
+			g_vsyncCounter.increment();
 		}
 		return 0;
 	}
 
-	void waitForVerticalBlank()
+	void initAddressWait()
 	{
-		D3DKMT_WAITFORVERTICALBLANKEVENT data = {};
+		HMODULE synch = LoadLibrary("api-ms-win-core-synch-l1-2-0.dll");
+		if (!synch)
+		{
+			return;
+		}
+
+		auto waitOnAddress = reinterpret_cast<WaitOnAddressFunc>(GetProcAddress(synch, "WaitOnAddress"));
+		auto wakeByAddressAll = reinterpret_cast<WakeByAddressAllFunc>(GetProcAddress(synch, "WakeByAddressAll"));
+		if (waitOnAddress && wakeByAddressAll)
+		{
+			g_waitOnAddress = waitOnAddress;
+			g_wakeByAddressAll = wakeByAddressAll;
+		}
+	}
+
+	void updateVblankEstimator(long long qpc)
+	{
+		const auto displaySettingsUniqueness = Win32::DisplayMode::queryDisplaySettingsUniqueness();
+		Compat::ScopedSrwLockExclusive lock(g_vblankEstimatorSrwLock);
+		if (displaySettingsUniqueness != g_vblankDisplaySettingsUniqueness)
+		{
+			g_vblankDisplaySettingsUniqueness = displaySettingsUniqueness;
+			g_vblankEstimator.reset(getNominalVblankPeriod());
+		}
+		g_vblankEstimator.addVblank(qpc);
+	}
+
+	bool getLastVblank(const AdapterInfo& adapterInfo, long long& qpcVblank)
+	{
+		DWM_TIMING_INFO ti = {};
+		ti.cbSize = sizeof(ti);
+		if (SUCCEEDED(DwmGetCompositionTimingInfo(nullptr, &ti)) && 0 != ti.qpcVBlank)
+		{
+			qpcVblank = ti.qpcVBlank;
+			return true;
+		}
+
+		const LONG height = adapterInfo.monitorRect.bottom - adapterInfo.monitorRect.top;
+		if (!adapterInfo.adapter || height <= 0)
+		{
+			return false;
+		}
+
+		D3DKMT_GETSCANLINE data = {};
+		data.hAdapter = adapterInfo.adapter;
+		data.VidPnSourceId = adapterInfo.vidPnSourceId;
+		const long long qpcNow = Time::queryPerformanceCounter();
+		if (FAILED(D3DKMTGetScanLine(&data)))
+		{
+			return false;
+		}
+
+		qpcVblank = qpcNow;
+		if (!data.InVerticalBlank)
+		{
+			Compat::ScopedSrwLockShared lock(g_vblankEstimatorSrwLock);
+			qpcVblank -= std::llround(g_vblankEstimator.getPeriod() * std::min<UINT>(data.ScanLine, height) / height);
+		}
+		return true;
+	}
+
+	void waitForPredictedVerticalBlank(const AdapterInfo& adapterInfo)
+	{
+		long long qpcVblank = 0;
+		if (getLastVblank(adapterInfo, qpcVblank) && qpcVblank > g_qpcLastVblankSample)
+		{
+			g_qpcLastVblankSample = qpcVblank;
+			updateVblankEstimator(qpcVblank);
+		}
+
+		long long qpcNow = Time::queryPerformanceCounter();
+		const long long qpcNextVblank = D3dDdi::KernelModeThunks::getQpcNextVblank(qpcNow);
+		while (qpcNow < qpcNextVblank)
+		{
+			const long long qpcRemaining = qpcNextVblank - qpcNow;
+			Sleep(static_cast<DWORD>((qpcRemaining * 1000 + Time::g_qpcFrequency - 1) / Time::g_qpcFrequency));
+			qpcNow = Time::queryPerformanceCounter();
+		}
+	}
+
+	bool waitForVerticalBlank()
+	{
+		AdapterInfo adapterInfo = {};
 
 		{
 			Compat::ScopedSrwLockShared lock(g_lastOpenAdapterInfoSrwLock);
-			data.hAdapter = g_lastOpenAdapterInfo.adapter;
-			data.VidPnSourceId = g_lastOpenAdapterInfo.vidPnSourceId;
+			adapterInfo = g_lastOpenAdapterInfo;
 		}
 
-		if (!data.hAdapter)
+		if (!adapterInfo.adapter)
 		{
 			updateGdiAdapterInfo();
-			data.hAdapter = g_gdiAdapterInfo.adapter;
-			data.VidPnSourceId = g_gdiAdapterInfo.vidPnSourceId;
+			adapterInfo = g_gdiAdapterInfo;
 		}
 
+		D3DKMT_WAITFORVERTICALBLANKEVENT data = {};
+		data.hAdapter = adapterInfo.adapter;
+		data.VidPnSourceId = adapterInfo.vidPnSourceId;
 		if (!data.hAdapter || FAILED(D3DKMTWaitForVerticalBlankEvent(&data)))
 		{
-			Sleep(16);
+			waitForPredictedVerticalBlank(adapterInfo);
+			return false;
 		}
+		return true;
 	}
 }
 
@@ -308,10 +453,28 @@ namespace D3dDdi
 			return g_lastOpenAdapterInfo.monitorRect;
 		}
 
+		long long getQpcNextVblank(long long qpc)
+		{
+			Compat::ScopedSrwLockShared lock(g_vblankEstimatorSrwLock);
+			return g_vblankEstimator.getNextVblank(qpc);
+		}
+
+		long long getQpcUntilScanoutDeadline(long long qpcMargin)
+		{
+			const long long qpcNow = Time::queryPerformanceCounter();
+			Compat::ScopedSrwLockShared lock(g_vblankEstimatorSrwLock);
+			long long qpcDeadline = g_vblankEstimator.getNextVblank(qpcNow) - qpcMargin;
+			if (qpcDeadline < qpcNow)
+			{
+				qpcDeadline += std::llround(g_vblankEstimator.getPeriod() *
+					std::ceil(static_cast<double>(qpcNow - qpcDeadline) / g_vblankEstimator.getPeriod()));
+			}
+			return qpcDeadline - qpcNow;
+		}
+
 		UINT getVsyncCounter()
 		{
-			Compat::ScopedSrwLockShared lock(g_vsyncCounterSrwLock);
-			return g_vsyncCounter;
+			return g_vsyncCounter.get();
 		}
 
 		void installHooks(HMODULE origDDrawModule)
@@ -323,6 +486,9 @@ namespace D3dDdi
 			Compat::hookIatFunction(origDDrawModule, "gdi32.dll", "D3DKMTQueryAdapterInfo", queryAdapterInfo);
 			Compat::hookIatFunction(origDDrawModule, "gdi32.dll", "D3DKMTSetGammaRamp", setGammaRamp);
 
+			initAddressWait();
+			g_vblankDisplaySettingsUniqueness = Win32::DisplayMode::queryDisplaySettingsUniqueness();
+			g_vblankEstimator.reset(getNominalVblankPeriod());
 			g_vsyncThread = CreateThread(nullptr, 0, &vsyncThreadProc, nullptr, 0, nullptr);
 			SetThreadPriority(g_vsyncThread, THREAD_PRIORITY_TIME_CRITICAL);
 		}
@@ -355,15 +521,7 @@ namespace D3dDdi
 
 		bool waitForVsyncCounter(UINT counter)
 		{
-			bool waited = false;
-			Compat::ScopedSrwLockShared lock(g_vsyncCounterSrwLock);
-			while (static_cast<INT>(g_vsyncCounter - counter) < 0)
-			{
-				SleepConditionVariableSRW(&g_vsyncCounterCv, &g_vsyncCounterSrwLock, INFINITE,
-					CONDITION_VARIABLE_LOCKMODE_SHARED);
-				waited = true;
-			}
-			return waited;
+			return g_vsyncCounter.waitFor(counter);
 		}
 	}
 }
@@ -7,6 +7,8 @@ namespace D3dDdi
 	namespace KernelModeThunks
 	{
 		RECT getMonitorRect();
+		long long getQpcNextVblank(long long qpc);
+		long long getQpcUntilScanoutDeadline(long long qpcMargin);
 		UINT getVsyncCounter();
 		void installHooks(HMODULE origDDrawModule);
 		void setDcFormatOverride(UINT format);
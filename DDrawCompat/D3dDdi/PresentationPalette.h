@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <Gdi/Palette.h>
+
+namespace D3dDdi
+{
+	// X8R8G8B8 conversion of the last hardware palette snapshot used for presentation. Not synchronized: callers
+	// must serialize access, which presentation blits do by running under the driver lock.
+	class PresentationPalette
+	{
+	public:
+		const DWORD* get(const Gdi::Palette::Snapshot& snapshot)
+		{
+			if (!m_isValid || snapshot.version != m_version)
+			{
+				for (UINT i = 0; i < 256; ++i)
+				{
+					const auto& entry = snapshot.entries[i];
+					m_palette[i] = (entry.peRed << 16) | (entry.peGreen << 8) | entry.peBlue;
+				}
+				m_version = snapshot.version;
+				m_isValid = true;
+			}
+			return m_palette;
+		}
+
+	private:
+		DWORD m_palette[256] = {};
+		UINT m_version = 0;
+		bool m_isValid = false;
+	};
+}
@@ -2,12 +2,14 @@
 
 #include <Common/HResultException.h>
 #include <Common/Log.h>
+#include <Common/SharedMetrics.h>
 #include <Common/Time.h>
 #include <Config/Config.h>
 #include <D3dDdi/Adapter.h>
 #include <D3dDdi/Device.h>
 #include <D3dDdi/KernelModeThunks.h>
 #include <D3dDdi/Log/DeviceFuncsLog.h>
+#include <D3dDdi/PresentationPalette.h>
 #include <D3dDdi/Resource.h>
 #include <DDraw/Blitter.h>
 #include <Gdi/Palette.h>
@@ -19,6 +21,7 @@ namespace
 	void splitToTiles(D3DDDIARG_CREATERESOURCE& data, const UINT tileWidth, const UINT tileHeight);
 
 	const UINT g_resourceTypeFlags = getResourceTypeFlags().Value;
+	D3dDdi::PresentationPalette g_presentationPalette;
 
 	LONG divCeil(LONG n, LONG d)
 	{
@@ -343,12 +346,14 @@ namespace D3dDdi
 
 	void Resource::copyToSysMem(UINT subResourceIndex)
 	{
+		Compat::SharedMetrics::add(Compat::SharedMetrics::RESOURCE_COPY_TO_SYSMEM);
 		copySubResource(m_lockResource.get(), m_handle, subResourceIndex);
 		m_lockData[subResourceIndex].isSysMemUpToDate = true;
 	}
 
 	void Resource::copyToVidMem(UINT subResourceIndex)
 	{
+		Compat::SharedMetrics::add(Compat::SharedMetrics::RESOURCE_COPY_TO_VIDMEM);
 		copySubResource(m_handle, m_lockResource.get(), subResourceIndex);
 		m_lockData[subResourceIndex].isVidMemUpToDate = true;
 	}
@@ -538,12 +543,7 @@ namespace D3dDdi
 				return result;
 			}
 
-			auto entries(Gdi::Palette::getHardwarePalette());
-			DWORD pal[256] = {};
-			for (UINT i = 0; i < 256; ++i)
-			{
-				pal[i] = (entries[i].peRed << 16) | (entries[i].peGreen << 8) | entries[i].peBlue;
-			}
+			const DWORD* pal = g_presentationPalette.get(*Gdi::Palette::getHardwarePalette());
 
 			auto& srcLockData = srcResource.m_lockData[data.SrcSubResourceIndex];
 			for (UINT y = 0; y < srcResource.m_fixedData.surfaceData[data.SrcSubResourceIndex].Height; ++y)
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <Windows.h>
+
+#include <Common/Log.h>
+
+namespace D3dDdi
+{
+	// Dynamic buffer split into a ring of segments. Loads append with no-overwrite locks, and a filled segment is
+	// only reused once the driver has signaled its fence, otherwise the whole buffer is discarded. The segment layout
+	// is resized from the peak usage per frame sampled over the last frames.
+	//
+	// Ddi provides the driver calls:
+	//   bool createBuffer(UINT size), void destroyBuffer(), void* lock(UINT offset, UINT size, bool discard),
+	//   void unlock(), HANDLE createFence(), bool issueFence(HANDLE), bool isFenceSignaled(HANDLE),
+	//   void destroyFence(HANDLE) and UINT getPresentCount()
+	template <typename Ddi>
+	class SegmentedBuffer
+	{
+	public:
+		static const UINT INITIAL_SEGMENT_COUNT = 4;
+		static const UINT MIN_SEGMENT_COUNT = 2;
+		static const UINT MAX_SEGMENT_COUNT = 16;
+		static const UINT MAX_SEGMENT_SIZE = 4 * 1024 * 1024;
+		static const UINT MAX_BUFFER_SIZE = 8 * 1024 * 1024;
+		static const UINT MAX_FRAME_LATENCY = 3;
+		static const UINT USAGE_SAMPLE_FRAMES = 60;
+
+		SegmentedBuffer(Ddi& ddi, UINT size)
+			: m_ddi(ddi)
+			, m_size(0)
+			, m_stride(0)
+			, m_pos(0)
+			, m_minSegmentSize(size / INITIAL_SEGMENT_COUNT)
+			, m_segmentSize(0)
+			, m_segmentCount(INITIAL_SEGMENT_COUNT)
+			, m_segment(0)
+			, m_isDiscardNeeded(true)
+			, m_presentCount(ddi.getPresentCount())
+			, m_frameUsage(0)
+			, m_peakFrameUsage(0)
+			, m_usageSampleCount(0)
+			, m_discardCount(0)
+		{
+			resize(size);
+		}
+
+		~SegmentedBuffer()
+		{
+			for (const auto& segment : m_segments)
+			{
+				if (segment.query)
+				{
+					m_ddi.destroyFence(segment.query);
+				}
+			}
+		}
+
+		UINT getSegmentCount() const { return m_segmentCount; }
+		UINT getSegmentSize() const { return m_segmentSize; }
+		UINT getSize() const { return m_size; }
+
+		INT load(const void* src, UINT count)
+		{
+			if (0 == m_size)
+			{
+				return -1;
+			}
+
+			const UINT size = count * m_stride;
+			updateSegmentUsage(size);
+			if (size > m_size)
+			{
+				return -1;
+			}
+
+			if (m_pos + size > getSegmentEnd(m_segment))
+			{
+				selectNextSegment(size);
+			}
+
+			UINT pos = m_pos;
+			auto dst = m_ddi.lock(m_pos, size, m_isDiscardNeeded);
+			if (!dst)
+			{
+				return -1;
+			}
+
+			std::memcpy(dst, src, size);
+			m_ddi.unlock();
+			m_isDiscardNeeded = false;
+			m_pos += size;
+			m_frameUsage += size;
+
+			if (m_pos > pos)
+			{
+				m_segment = std::min<UINT>((m_pos - 1) / m_segmentSize, m_segmentCount - 1);
+				for (UINT i = pos / m_segmentSize; i <= m_segment; ++i)
+				{
+					m_segments[i].isUsed = true;
+				}
+			}
+			return pos / m_stride;
+		}
+
+		void resize(UINT size)
+		{
+			resize(size, m_segmentCount);
+		}
+
+		void setStride(UINT stride)
+		{
+			m_stride = stride;
+			m_pos = (m_pos + stride - 1) / stride * stride;
+		}
+
+	private:
+		struct Segment
+		{
+			HANDLE query;
+			UINT presentCount;
+			bool isUsed;
+			bool isFenced;
+		};
+
+		void fenceSegments()
+		{
+			for (auto& segment : m_segments)
+			{
+				if (!segment.isUsed)
+				{
+					continue;
+				}
+
+				if (!segment.query)
+				{
+					segment.query = m_ddi.createFence();
+				}
+
+				if (segment.query && !m_ddi.issueFence(segment.query))
+				{
+					m_ddi.destroyFence(segment.query);
+					segment.query = nullptr;
+				}
+
+				segment.presentCount = m_ddi.getPresentCount();
+				segment.isUsed = false;
+				segment.isFenced = true;
+			}
+		}
+
+		UINT getSegmentEnd(UINT segment) const
+		{
+			return segment + 1 < m_segmentCount ? (segment + 1) * m_segmentSize : m_size;
+		}
+
+		bool isSegmentIdle(UINT segment)
+		{
+			auto& s = m_segments[segment];
+			if (s.isUsed)
+			{
+				return false;
+			}
+
+			if (s.isFenced)
+			{
+				if (s.query)
+				{
+					s.isFenced = !m_ddi.isFenceSignaled(s.query);
+				}
+				else
+				{
+					s.isFenced = m_ddi.getPresentCount() - s.presentCount <= MAX_FRAME_LATENCY;
+				}
+			}
+			return !s.isFenced;
+		}
+
+		void releaseSegments()
+		{
+			for (auto& segment : m_segments)
+			{
+				segment.isUsed = false;
+				segment.isFenced = false;
+			}
+		}
+
+		bool resize(UINT size, UINT segmentCount)
+		{
+			if (0 == size)
+			{
+				m_ddi.destroyBuffer();
+				m_size = 0;
+				m_segmentSize = 0;
+				return true;
+			}
+
+			if (!m_ddi.createBuffer(size))
+			{
+				return false;
+			}
+
+			m_size = size;
+			m_segmentCount = segmentCount;
+			m_segmentSize = size / segmentCount;
+
+			while (m_segments.size() > segmentCount)
+			{
+				if (m_segments.back().query)
+				{
+					m_ddi.destroyFence(m_segments.back().query);
+				}
+				m_segments.pop_back();
+			}
+			m_segments.resize(segmentCount, {});
+			releaseSegments();
+
+			m_segment = 0;
+			m_pos = 0;
+			m_isDiscardNeeded = true;
+			return true;
+		}
+
+		void selectNextSegment(UINT size)
+		{
+			fenceSegments();
+			const UINT nextSegment = (m_segment + 1) % m_segmentCount;
+			const UINT pos = (nextSegment * m_segmentSize + m_stride - 1) / m_stride * m_stride;
+			if (isSegmentIdle(nextSegment) && pos + size <= getSegmentEnd(nextSegment))
+			{
+				m_segment = nextSegment;
+				m_pos = pos;
+				return;
+			}
+
+			++m_discardCount;
+			releaseSegments();
+			m_segment = 0;
+			m_pos = 0;
+			m_isDiscardNeeded = true;
+		}
+
+		void updateSegmentUsage(UINT size)
+		{
+			const UINT presentCount = m_ddi.getPresentCount();
+			if (presentCount == m_presentCount)
+			{
+				return;
+			}
+
+			m_presentCount = presentCount;
+			m_peakFrameUsage = std::max<UINT>(m_peakFrameUsage, m_frameUsage);
+			m_frameUsage = 0;
+			++m_usageSampleCount;
+			if (0 == m_discardCount && m_usageSampleCount < USAGE_SAMPLE_FRAMES)
+			{
+				return;
+			}
+
+			UINT segmentSize = m_segmentSize;
+			while (segmentSize > m_minSegmentSize && m_peakFrameUsage <= segmentSize / 4)
+			{
+				segmentSize /= 2;
+			}
+			segmentSize = std::max<UINT>(segmentSize, m_minSegmentSize);
+
+			UINT segmentCount = 0;
+			while (true)
+			{
+				const UINT segmentsPerFrame = std::max<UINT>((m_peakFrameUsage + segmentSize - 1) / segmentSize, 1);
+				segmentCount = segmentsPerFrame * (MAX_FRAME_LATENCY + 1) + 1;
+				if (segmentCount <= MAX_SEGMENT_COUNT || segmentSize * 2 > MAX_SEGMENT_SIZE)
+				{
+					break;
+				}
+				segmentSize *= 2;
+			}
+
+			if (0 != m_discardCount && segmentCount <= m_segmentCount && segmentSize == m_segmentSize)
+			{
+				++segmentCount;
+			}
+			segmentCount = std::clamp<UINT>(segmentCount, MIN_SEGMENT_COUNT, MAX_SEGMENT_COUNT);
+			segmentCount = std::min<UINT>(segmentCount,
+				std::max<UINT>(MAX_BUFFER_SIZE / segmentSize, MIN_SEGMENT_COUNT));
+
+			LOG_DEBUG << "Dynamic buffer usage: peak " << m_peakFrameUsage << " bytes/frame, "
+				<< m_discardCount << " discards in " << m_usageSampleCount << " frames";
+
+			m_peakFrameUsage = 0;
+			m_usageSampleCount = 0;
+			m_discardCount = 0;
+
+			if ((segmentCount != m_segmentCount || segmentSize != m_segmentSize) &&
+				segmentCount * segmentSize >= size)
+			{
+				LOG_DEBUG << "Resizing dynamic buffer to " << segmentCount << " segments of " << segmentSize << " bytes";
+				if (!resize(segmentCount * segmentSize, segmentCount))
+				{
+					LOG_ONCE("WARNING: Dynamic buffer resize failed, keeping the current buffer");
+				}
+			}
+		}
+
+		Ddi& m_ddi;
+		UINT m_size;
+		UINT m_stride;
+		UINT m_pos;
+		UINT m_minSegmentSize;
+		UINT m_segmentSize;
+		UINT m_segmentCount;
+		UINT m_segment;
+		std::vector<Segment> m_segments;
+		bool m_isDiscardNeeded;
+		UINT m_presentCount;
+		UINT m_frameUsage;
+		UINT m_peakFrameUsage;
+		UINT m_usageSampleCount;
+		UINT m_discardCount;
+	};
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <Windows.h>
+
+namespace D3dDdi
+{
+	// Shadow copy of a shader constant register file. Changed registers are kept as sorted ranges that neither
+	// overlap nor touch, so each flush uploads every contiguous run of changes with a single call.
+	template <typename ShaderConst>
+	class ShaderConstBank
+	{
+	public:
+		struct Range
+		{
+			UINT begin;
+			UINT end;
+		};
+
+		// Calls upload(begin, count, registers) for each dirty range. Ranges that fail to upload stay dirty.
+		// Returns the first failure.
+		template <typename Upload>
+		HRESULT flush(Upload upload)
+		{
+			HRESULT result = S_OK;
+			auto it = m_dirtyRanges.begin();
+			while (it != m_dirtyRanges.end())
+			{
+				HRESULT uploadResult = upload(it->begin, it->end - it->begin, &m_registers[it->begin]);
+				if (SUCCEEDED(uploadResult))
+				{
+					it = m_dirtyRanges.erase(it);
+				}
+				else
+				{
+					if (SUCCEEDED(result))
+					{
+						result = uploadResult;
+					}
+					++it;
+				}
+			}
+			return result;
+		}
+
+		const std::vector<Range>& getDirtyRanges() const { return m_dirtyRanges; }
+		const ShaderConst* getRegisters() const { return m_registers.data(); }
+
+		// Returns false without calling beforeChange if the registers already hold the values
+		template <typename BeforeChange>
+		bool set(UINT reg, UINT count, const ShaderConst* values, BeforeChange beforeChange)
+		{
+			if (reg + count > m_registers.size())
+			{
+				m_registers.resize(reg + count);
+			}
+
+			if (0 == std::memcmp(&m_registers[reg], values, count * sizeof(ShaderConst)))
+			{
+				return false;
+			}
+
+			beforeChange();
+			std::memcpy(&m_registers[reg], values, count * sizeof(ShaderConst));
+			addDirtyRange(reg, reg + count);
+			return true;
+		}
+
+	private:
+		void addDirtyRange(UINT begin, UINT end)
+		{
+			auto first = std::lower_bound(m_dirtyRanges.begin(), m_dirtyRanges.end(), begin,
+				[](const Range& range, UINT reg) { return range.end < reg; });
+			auto last = first;
+			while (last != m_dirtyRanges.end() && last->begin <= end)
+			{
+				begin = std::min<UINT>(begin, last->begin);
+				end = std::max<UINT>(end, last->end);
+				++last;
+			}
+
+			if (first == last)
+			{
+				m_dirtyRanges.insert(first, { begin, end });
+			}
+			else
+			{
+				*first = { begin, end };
+				m_dirtyRanges.erase(first + 1, last);
+			}
+		}
+
+		std::vector<ShaderConst> m_registers;
+		std::vector<Range> m_dirtyRanges;
+	};
+}
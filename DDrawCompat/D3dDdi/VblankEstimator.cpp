@@ -0,0 +1,143 @@
+#include <algorithm>
+#include <cmath>
+
+#include <D3dDdi/VblankEstimator.h>
+
+namespace
+{
+	const UINT MAX_SAMPLES = 64;
+	const UINT MAX_REJECTED_INTERVALS = 8;
+	const long long MAX_MISSED_VBLANKS = 16;
+	const double MAX_PHASE_ERROR = 0.1;
+	const double MAX_PERIOD_CHANGE = 0.02;
+}
+
+namespace D3dDdi
+{
+	VblankEstimator::VblankEstimator(double nominalPeriod)
+		: m_period(nominalPeriod)
+		, m_phase(0)
+		, m_lastQpc(0)
+	{
+	}
+
+	void VblankEstimator::addVblank(long long qpc)
+	{
+		if (m_samples.empty())
+		{
+			restart(qpc);
+			return;
+		}
+
+		const long long interval = qpc - m_lastQpc;
+		const double elapsed = qpc - m_phase;
+		const long long periods = std::llround(elapsed / m_period);
+		const double phaseError = elapsed - periods * m_period;
+		m_lastQpc = qpc;
+
+		if (periods < 1 || std::abs(phaseError) > m_period * MAX_PHASE_ERROR ||
+			interval < m_period * (1 - MAX_PHASE_ERROR))
+		{
+			m_rejectedIntervals.push_back(interval);
+			if (m_rejectedIntervals.size() >= MAX_REJECTED_INTERVALS)
+			{
+				auto median = m_rejectedIntervals.begin() + m_rejectedIntervals.size() / 2;
+				std::nth_element(m_rejectedIntervals.begin(), median, m_rejectedIntervals.end());
+				if (*median > 0)
+				{
+					m_period = static_cast<double>(*median);
+				}
+				restart(qpc);
+			}
+			return;
+		}
+
+		m_rejectedIntervals.clear();
+		if (periods > MAX_MISSED_VBLANKS)
+		{
+			restart(qpc);
+			return;
+		}
+
+		m_samples.push_back({ m_samples.back().index + periods, qpc });
+		if (m_samples.size() > MAX_SAMPLES)
+		{
+			m_samples.pop_front();
+		}
+		fit();
+	}
+
+	void VblankEstimator::fit()
+	{
+		const Sample& first = m_samples.front();
+		const Sample& last = m_samples.back();
+		if (m_samples.size() < 3)
+		{
+			m_phase = static_cast<double>(last.qpc);
+			return;
+		}
+
+		double meanX = 0;
+		double meanY = 0;
+		for (const auto& sample : m_samples)
+		{
+			meanX += sample.index - first.index;
+			meanY += sample.qpc - first.qpc;
+		}
+		meanX /= m_samples.size();
+		meanY /= m_samples.size();
+
+		double sxx = 0;
+		double sxy = 0;
+		for (const auto& sample : m_samples)
+		{
+			const double dx = sample.index - first.index - meanX;
+			const double dy = sample.qpc - first.qpc - meanY;
+			sxx += dx * dx;
+			sxy += dx * dy;
+		}
+
+		if (sxx <= 0)
+		{
+			m_phase = static_cast<double>(last.qpc);
+			return;
+		}
+
+		double period = sxy / sxx;
+		if (std::abs(period - m_period) > m_period * MAX_PERIOD_CHANGE && m_samples.size() < MAX_SAMPLES / 4)
+		{
+			period = std::clamp<double>(period, m_period * (1 - MAX_PERIOD_CHANGE), m_period * (1 + MAX_PERIOD_CHANGE));
+		}
+		m_period = period;
+		m_phase = first.qpc + meanY + (last.index - first.index - meanX) * m_period;
+	}
+
+	long long VblankEstimator::getNextVblank(long long qpc) const
+	{
+		if (m_samples.empty())
+		{
+			return qpc + std::llround(m_period);
+		}
+
+		const double periods = std::floor((qpc - m_phase) / m_period) + 1;
+		return std::llround(m_phase + periods * m_period);
+	}
+
+	void VblankEstimator::reset(double nominalPeriod)
+	{
+		m_samples.clear();
+		m_rejectedIntervals.clear();
+		m_period = nominalPeriod;
+		m_phase = 0;
+		m_lastQpc = 0;
+	}
+
+	void VblankEstimator::restart(long long qpc)
+	{
+		m_samples.clear();
+		m_samples.push_back({ 0, qpc });
+		m_rejectedIntervals.clear();
+		m_phase = static_cast<double>(qpc);
+		m_lastQpc = qpc;
+	}
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include <Windows.h>
+
+namespace D3dDdi
+{
+	class VblankEstimator
+	{
+	public:
+		VblankEstimator(double nominalPeriod);
+
+		void addVblank(long long qpc);
+		long long getNextVblank(long long qpc) const;
+		double getPeriod() const { return m_period; }
+		void reset(double nominalPeriod);
+
+	private:
+		struct Sample
+		{
+			long long index;
+			long long qpc;
+		};
+
+		void fit();
+		void restart(long long qpc);
+
+		std::deque<Sample> m_samples;
+		std::vector<long long> m_rejectedIntervals;
+		double m_period;
+		double m_phase;
+		long long m_lastQpc;
+	};
+}
@@ -0,0 +1,58 @@
+#include <D3dDdi/VertexCompactor.h>
+
+namespace
+{
+	const UINT MAX_RANGE_COPY_OVERHEAD_PERCENT = 150;
+}
+
+namespace D3dDdi
+{
+	VertexCompactor::VertexCompactor()
+		: m_generation(0)
+	{
+	}
+
+	void VertexCompactor::compact(const UINT16* indices, UINT count, UINT minIndex, UINT vertexCount,
+		UINT16 baseIndex, UINT16* remappedIndices)
+	{
+		startGeneration(vertexCount);
+		m_uniqueIndices.clear();
+
+		UINT16 newIndex = baseIndex;
+		for (UINT i = 0; i < count; ++i)
+		{
+			auto& entry = m_remapTable[indices[i] - minIndex];
+			if (m_generation != entry.generation)
+			{
+				entry.generation = m_generation;
+				entry.index = newIndex;
+				m_uniqueIndices.push_back(indices[i]);
+				++newIndex;
+			}
+			remappedIndices[i] = entry.index;
+		}
+	}
+
+	bool VertexCompactor::isRangeCopyPreferred(UINT indexCount, UINT vertexCount)
+	{
+		return vertexCount * 100 <= indexCount * MAX_RANGE_COPY_OVERHEAD_PERCENT;
+	}
+
+	void VertexCompactor::startGeneration(UINT vertexCount)
+	{
+		if (vertexCount > m_remapTable.size())
+		{
+			m_remapTable.resize(vertexCount, { m_generation, 0 });
+		}
+
+		++m_generation;
+		if (0 == m_generation)
+		{
+			for (auto& entry : m_remapTable)
+			{
+				entry.generation = 0;
+			}
+			m_generation = 1;
+		}
+	}
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+
+#include <Windows.h>
+
+namespace D3dDdi
+{
+	class VertexCompactor
+	{
+	public:
+		VertexCompactor();
+
+		void compact(const UINT16* indices, UINT count, UINT minIndex, UINT vertexCount,
+			UINT16 baseIndex, UINT16* remappedIndices);
+		const std::vector<UINT16>& getUniqueIndices() const { return m_uniqueIndices; }
+
+		static bool isRangeCopyPreferred(UINT indexCount, UINT vertexCount);
+
+	private:
+		struct RemapEntry
+		{
+			UINT generation;
+			UINT16 index;
+		};
+
+		void startGeneration(UINT vertexCount);
+
+		std::vector<RemapEntry> m_remapTable;
+		std::vector<UINT16> m_uniqueIndices;
+		UINT m_generation;
+	};
+}
@@ -5,6 +5,7 @@
 #include <intrin.h>
 
 #include <Common/ScopedCriticalSection.h>
+#include <Common/SharedMetrics.h>
 #include <DDraw/Blitter.h>
 
 #pragma warning(disable : 4127)
@@ -688,6 +689,8 @@ namespace DDraw
 			const void* src, DWORD srcPitch, LONG srcWidth, LONG srcHeight,
 			DWORD bytesPerPixel, const DWORD* dstColorKey, const DWORD* srcColorKey)
 		{
+			Compat::SharedMetrics::add(Compat::SharedMetrics::BLT_COUNT);
+			Compat::SharedMetrics::add(Compat::SharedMetrics::BLT_PIXELS, dstWidth * dstHeight);
 			::blt(static_cast<BYTE*>(dst), dstPitch, dstWidth, dstHeight,
 				static_cast<const BYTE*>(src), srcPitch, srcWidth, srcHeight,
 				bytesPerPixel, dstColorKey, srcColorKey);
@@ -695,6 +698,7 @@ namespace DDraw
 
 		void colorFill(void* dst, DWORD dstPitch, DWORD dstWidth, DWORD dstHeight, DWORD bytesPerPixel, DWORD color)
 		{
+			Compat::SharedMetrics::add(Compat::SharedMetrics::COLOR_FILL_COUNT);
 			switch (bytesPerPixel)
 			{
 			case 1: return ::colorFill<BYTE>(static_cast<BYTE*>(dst), dstPitch, dstWidth, dstHeight, color);
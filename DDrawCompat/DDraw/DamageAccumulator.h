@@ -0,0 +1,58 @@
+#pragma once
+
+#include <utility>
+
+#include <Windows.h>
+
+#include <DDraw/DamageTracker.h>
+
+namespace DDraw
+{
+	// Damage to the primary surface since the last present. Every fullRefreshInterval presents the whole surface is
+	// refreshed regardless, to recover from changes that were never reported as damage.
+	class DamageAccumulator
+	{
+	public:
+		DamageAccumulator(UINT fullRefreshInterval)
+			: m_fullRefreshInterval(fullRefreshInterval)
+			, m_framesSinceFullRefresh(0)
+		{
+		}
+
+		void add(const RECT* rect)
+		{
+			if (rect)
+			{
+				m_damage.add(*rect);
+			}
+			else
+			{
+				m_damage.addAll();
+			}
+		}
+
+		void add(const DamageTracker& damage)
+		{
+			m_damage.add(damage);
+		}
+
+		DamageTracker take()
+		{
+			DamageTracker damage;
+			std::swap(damage, m_damage);
+
+			++m_framesSinceFullRefresh;
+			if (m_framesSinceFullRefresh >= m_fullRefreshInterval)
+			{
+				damage.addAll();
+				m_framesSinceFullRefresh = 0;
+			}
+			return damage;
+		}
+
+	private:
+		DamageTracker m_damage;
+		UINT m_fullRefreshInterval;
+		UINT m_framesSinceFullRefresh;
+	};
+}
@@ -0,0 +1,108 @@
+#include <DDraw/DamageTracker.h>
+
+namespace
+{
+	const UINT MAX_RECTS = 16;
+
+	bool isTouching(const RECT& rect1, const RECT& rect2)
+	{
+		return rect1.left <= rect2.right && rect2.left <= rect1.right &&
+			rect1.top <= rect2.bottom && rect2.top <= rect1.bottom;
+	}
+
+	RECT getBoundingRect(const RECT& rect1, const RECT& rect2)
+	{
+		RECT rect = {};
+		rect.left = rect1.left < rect2.left ? rect1.left : rect2.left;
+		rect.top = rect1.top < rect2.top ? rect1.top : rect2.top;
+		rect.right = rect1.right > rect2.right ? rect1.right : rect2.right;
+		rect.bottom = rect1.bottom > rect2.bottom ? rect1.bottom : rect2.bottom;
+		return rect;
+	}
+}
+
+namespace DDraw
+{
+	DamageTracker::DamageTracker()
+		: m_isFull(false)
+	{
+	}
+
+	void DamageTracker::add(const RECT& rect)
+	{
+		if (m_isFull || rect.left >= rect.right || rect.top >= rect.bottom)
+		{
+			return;
+		}
+
+		RECT merged = rect;
+		for (auto it = m_rects.begin(); it != m_rects.end();)
+		{
+			if (isTouching(*it, merged))
+			{
+				merged = getBoundingRect(*it, merged);
+				m_rects.erase(it);
+				it = m_rects.begin();
+			}
+			else
+			{
+				++it;
+			}
+		}
+
+		if (m_rects.size() >= MAX_RECTS)
+		{
+			for (const auto& r : m_rects)
+			{
+				merged = getBoundingRect(r, merged);
+			}
+			m_rects.clear();
+		}
+		m_rects.push_back(merged);
+	}
+
+	void DamageTracker::add(const DamageTracker& other)
+	{
+		if (other.m_isFull)
+		{
+			addAll();
+			return;
+		}
+
+		for (const auto& rect : other.m_rects)
+		{
+			add(rect);
+		}
+	}
+
+	void DamageTracker::addAll()
+	{
+		m_rects.clear();
+		m_isFull = true;
+	}
+
+	void DamageTracker::clear()
+	{
+		m_rects.clear();
+		m_isFull = false;
+	}
+
+	std::vector<RECT> DamageTracker::getRects(const RECT& bounds) const
+	{
+		if (m_isFull)
+		{
+			return { bounds };
+		}
+
+		std::vector<RECT> rects;
+		for (const auto& rect : m_rects)
+		{
+			RECT clippedRect = {};
+			if (IntersectRect(&clippedRect, &rect, &bounds))
+			{
+				rects.push_back(clippedRect);
+			}
+		}
+		return rects;
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+
+#include <Windows.h>
+
+namespace DDraw
+{
+	class DamageTracker
+	{
+	public:
+		DamageTracker();
+
+		void add(const RECT& rect);
+		void add(const DamageTracker& other);
+		void addAll();
+		void clear();
+		std::vector<RECT> getRects(const RECT& bounds) const;
+		bool isEmpty() const { return !m_isFull && m_rects.empty(); }
+		bool isFull() const { return m_isFull; }
+
+	private:
+		std::vector<RECT> m_rects;
+		bool m_isFull;
+	};
+}
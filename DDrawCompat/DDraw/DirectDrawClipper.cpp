@@ -28,20 +28,18 @@ namespace
 	void updateWindowClipList(CompatRef<IDirectDrawClipper> clipper, ClipperData& data)
 	{
 		HDC dc = GetDCEx(data.hwnd, nullptr, DCX_CACHE | DCX_USESTYLE);
-		Gdi::Region rgn;
-		GetRandomRgn(dc, rgn, SYSRGN);
+		HRGN sysRgn = CreateRectRgn(0, 0, 0, 0);
+		GetRandomRgn(dc, sysRgn, SYSRGN);
 		CALL_ORIG_FUNC(ReleaseDC)(data.hwnd, dc);
 
+		Gdi::Region rgn(sysRgn);
 		RECT primaryRect = D3dDdi::KernelModeThunks::getMonitorRect();
 		if (0 != primaryRect.left || 0 != primaryRect.top)
 		{
 			rgn.offset(-primaryRect.left, -primaryRect.top);
 		}
 
-		DWORD rgnSize = GetRegionData(rgn, 0, nullptr);
-		std::vector<unsigned char> rgnData(rgnSize);
-		GetRegionData(rgn, rgnSize, reinterpret_cast<RGNDATA*>(rgnData.data()));
-
+		std::vector<unsigned char> rgnData(rgn.getData());
 		clipper->SetHWnd(&clipper, 0, nullptr);
 		if (FAILED(clipper->SetClipList(&clipper, reinterpret_cast<RGNDATA*>(rgnData.data()), 0)))
 		{
@@ -119,21 +117,23 @@ namespace
 
 namespace DDraw
 {
-	HRGN DirectDrawClipper::getClipRgn(CompatRef<IDirectDrawClipper> clipper)
+	Gdi::Region DirectDrawClipper::getClipRgn(CompatRef<IDirectDrawClipper> clipper)
 	{
 		std::vector<unsigned char> rgnData;
 		DWORD size = 0;
 		clipper->GetClipList(&clipper, nullptr, nullptr, &size);
+		if (size < sizeof(RGNDATAHEADER))
+		{
+			return Gdi::Region();
+		}
 		rgnData.resize(size);
 		clipper->GetClipList(&clipper, nullptr, reinterpret_cast<RGNDATA*>(rgnData.data()), &size);
-		return ExtCreateRegion(nullptr, size, reinterpret_cast<RGNDATA*>(rgnData.data()));
+		return Gdi::Region(*reinterpret_cast<RGNDATA*>(rgnData.data()));
 	}
 
-	HRESULT DirectDrawClipper::setClipRgn(CompatRef<IDirectDrawClipper> clipper, HRGN rgn)
+	HRESULT DirectDrawClipper::setClipRgn(CompatRef<IDirectDrawClipper> clipper, const Gdi::Region& rgn)
 	{
-		std::vector<unsigned char> rgnData;
-		rgnData.resize(GetRegionData(rgn, 0, nullptr));
-		GetRegionData(rgn, rgnData.size(), reinterpret_cast<RGNDATA*>(rgnData.data()));
+		std::vector<unsigned char> rgnData(rgn.getData());
 		return clipper->SetClipList(&clipper, reinterpret_cast<RGNDATA*>(rgnData.data()), 0);
 	}
 
@@ -3,14 +3,15 @@
 #include <Common/CompatRef.h>
 #include <Common/CompatVtable.h>
 #include <DDraw/Visitors/DirectDrawClipperVtblVisitor.h>
+#include <Gdi/Region.h>
 
 namespace DDraw
 {
 	class DirectDrawClipper : public CompatVtable<IDirectDrawClipperVtbl>
 	{
 	public:
-		static HRGN getClipRgn(CompatRef<IDirectDrawClipper> clipper);
-		static HRESULT setClipRgn(CompatRef<IDirectDrawClipper> clipper, HRGN rgn);
+		static Gdi::Region getClipRgn(CompatRef<IDirectDrawClipper> clipper);
+		static HRESULT setClipRgn(CompatRef<IDirectDrawClipper> clipper, const Gdi::Region& rgn);
 		static void update();
 
 		static void setCompatVtable(IDirectDrawClipperVtbl& vtable);
@@ -1,8 +1,4 @@
-#include <cstring>
-#include <deque>
-
-#include <Common/Time.h>
-#include <Config/Config.h>
+#include <Common/SharedMetrics.h>
 #include <DDraw/DirectDrawPalette.h>
 #include <DDraw/Surfaces/PrimarySurface.h>
 
@@ -20,36 +16,12 @@ namespace DDraw
 		DWORD dwCount,
 		LPPALETTEENTRY lpEntries)
 	{
-		if (This == PrimarySurface::s_palette)
-		{
-			waitForNextUpdate();
-		}
-
 		HRESULT result = s_origVtable.SetEntries(This, dwFlags, dwStartingEntry, dwCount, lpEntries);
 		if (SUCCEEDED(result) && This == PrimarySurface::s_palette)
 		{
+			Compat::SharedMetrics::add(Compat::SharedMetrics::PALETTE_UPDATE_COUNT);
 			PrimarySurface::updatePalette();
 		}
 		return result;
 	}
-
-	void DirectDrawPalette::waitForNextUpdate()
-	{
-		static std::deque<long long> updatesInLastMs;
-
-		const long long qpcNow = Time::queryPerformanceCounter();
-		const long long qpcLastMsBegin = qpcNow - Time::g_qpcFrequency / 1000;
-		while (!updatesInLastMs.empty() && qpcLastMsBegin - updatesInLastMs.front() > 0)
-		{
-			updatesInLastMs.pop_front();
-		}
-
-		if (updatesInLastMs.size() >= Config::maxPaletteUpdatesPerMs)
-		{
-			Sleep(1);
-			updatesInLastMs.clear();
-		}
-
-		updatesInLastMs.push_back(Time::queryPerformanceCounter());
-	}
 }
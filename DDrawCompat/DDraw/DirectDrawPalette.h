@@ -16,8 +16,6 @@ namespace DDraw
 			DWORD dwStartingEntry,
 			DWORD dwCount,
 			LPPALETTEENTRY lpEntries);
-
-		static void waitForNextUpdate();
 	};
 }
 
@@ -0,0 +1,69 @@
+#include <algorithm>
+
+#include <Common/Time.h>
+#include <D3dDdi/KernelModeThunks.h>
+#include <DDraw/FrameLimiter.h>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+namespace DDraw
+{
+	FrameLimiter::FrameLimiter()
+		: m_pacer(m_clock)
+	{
+	}
+
+	FrameLimiter::Clock::Clock()
+		: m_timer(CreateWaitableTimerEx(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS))
+	{
+		if (!m_timer)
+		{
+			m_timer = CreateWaitableTimer(nullptr, FALSE, nullptr);
+		}
+	}
+
+	FrameLimiter::Clock::~Clock()
+	{
+		if (m_timer)
+		{
+			CloseHandle(m_timer);
+		}
+	}
+
+	long long FrameLimiter::Clock::getFrequency() const
+	{
+		return Time::g_qpcFrequency;
+	}
+
+	long long FrameLimiter::Clock::getNextVblank(long long qpc) const
+	{
+		return D3dDdi::KernelModeThunks::getQpcNextVblank(qpc);
+	}
+
+	long long FrameLimiter::Clock::now() const
+	{
+		return Time::queryPerformanceCounter();
+	}
+
+	void FrameLimiter::Clock::sleepUntil(long long qpcTarget)
+	{
+		const long long qpcNow = Time::queryPerformanceCounter();
+		LARGE_INTEGER dueTime = {};
+		dueTime.QuadPart = -std::max<long long>((qpcTarget - qpcNow) * 10000000 / Time::g_qpcFrequency, 1);
+		if (m_timer && SetWaitableTimer(m_timer, &dueTime, 0, nullptr, nullptr, FALSE))
+		{
+			WaitForSingleObject(m_timer, INFINITE);
+		}
+		else
+		{
+			Sleep(static_cast<DWORD>(std::max<long long>(Time::qpcToMs(qpcTarget - qpcNow), 0)));
+		}
+	}
+
+	void FrameLimiter::Clock::spin() const
+	{
+		YieldProcessor();
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <DDraw/FramePacer.h>
+
+namespace DDraw
+{
+	class FrameLimiter
+	{
+	public:
+		FrameLimiter();
+
+		void waitForNextFrame(long long qpcFrameInterval, bool alignToVblank)
+		{
+			m_pacer.waitForNextFrame(qpcFrameInterval, alignToVblank);
+		}
+
+	private:
+		class Clock
+		{
+		public:
+			Clock();
+			~Clock();
+
+			long long getFrequency() const;
+			long long getNextVblank(long long qpc) const;
+			long long now() const;
+			void sleepUntil(long long qpcTarget);
+			void spin() const;
+
+		private:
+			HANDLE m_timer;
+		};
+
+		Clock m_clock;
+		FramePacer<Clock> m_pacer;
+	};
+}
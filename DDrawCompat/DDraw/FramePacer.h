@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+
+#include <Windows.h>
+
+#include <Common/Log.h>
+
+namespace DDraw
+{
+	// Paces frames to a fixed interval. Waits sleep until a margin before the deadline and spin the rest of the way,
+	// the margin adapting to how much the clock oversleeps. A frame that misses its deadline by more than a whole
+	// interval restarts the pacing instead of bursting to catch up.
+	//
+	// Clock provides the timing calls:
+	//   long long getFrequency(), long long getNextVblank(long long qpc), long long now(),
+	//   void sleepUntil(long long qpcTarget) and void spin()
+	template <typename Clock>
+	class FramePacer
+	{
+	public:
+		static const long long STATS_LOG_INTERVAL_MS = 10000;
+
+		FramePacer(Clock& clock)
+			: m_clock(clock)
+			, m_qpcLastFrame(0)
+			, m_qpcSpinMargin(0)
+			, m_qpcAvgOversleep(0)
+			, m_qpcStatsStart(0)
+			, m_qpcErrorSum(0)
+			, m_qpcErrorMax(0)
+			, m_frameCount(0)
+			, m_lateFrameCount(0)
+		{
+		}
+
+		UINT getFrameCount() const { return m_frameCount; }
+		UINT getLateFrameCount() const { return m_lateFrameCount; }
+		long long getSpinMargin() const { return m_qpcSpinMargin; }
+
+		void waitForNextFrame(long long qpcFrameInterval, bool alignToVblank)
+		{
+			long long qpcNow = m_clock.now();
+			if (0 == m_qpcSpinMargin)
+			{
+				m_qpcSpinMargin = usToQpc(2000);
+			}
+
+			long long qpcTarget = m_qpcLastFrame + qpcFrameInterval;
+			if (alignToVblank)
+			{
+				qpcTarget = m_clock.getNextVblank(qpcTarget - qpcFrameInterval / 4);
+			}
+
+			if (0 == m_qpcLastFrame || qpcNow - qpcTarget > qpcFrameInterval)
+			{
+				m_qpcLastFrame = qpcNow;
+				return;
+			}
+
+			if (qpcNow < qpcTarget)
+			{
+				waitUntil(qpcTarget);
+				qpcNow = m_clock.now();
+			}
+			else
+			{
+				++m_lateFrameCount;
+			}
+
+			const long long qpcError = qpcNow - qpcTarget;
+			m_qpcErrorSum += qpcError;
+			m_qpcErrorMax = std::max<long long>(m_qpcErrorMax, qpcError);
+			++m_frameCount;
+			m_qpcLastFrame = qpcTarget;
+			logStats(qpcNow);
+		}
+
+	private:
+		void logStats(long long qpcNow)
+		{
+			if (0 == m_qpcStatsStart)
+			{
+				m_qpcStatsStart = qpcNow;
+				return;
+			}
+
+			if ((qpcNow - m_qpcStatsStart) * 1000 / m_clock.getFrequency() < STATS_LOG_INTERVAL_MS || 0 == m_frameCount)
+			{
+				return;
+			}
+
+			Compat::Log() << "Frame pacing: " << m_frameCount << " frames, " << m_lateFrameCount << " late"
+				<< ", avg error " << qpcToUs(m_qpcErrorSum / m_frameCount) << " us"
+				<< ", max error " << qpcToUs(m_qpcErrorMax) << " us"
+				<< ", spin margin " << qpcToUs(m_qpcSpinMargin) << " us";
+
+			m_qpcStatsStart = qpcNow;
+			m_qpcErrorSum = 0;
+			m_qpcErrorMax = 0;
+			m_frameCount = 0;
+			m_lateFrameCount = 0;
+		}
+
+		long long qpcToUs(long long qpc) const
+		{
+			return qpc * 1000000 / m_clock.getFrequency();
+		}
+
+		void sleepUntil(long long qpcTarget)
+		{
+			if (qpcTarget <= m_clock.now())
+			{
+				return;
+			}
+
+			m_clock.sleepUntil(qpcTarget);
+
+			const long long qpcOversleep = std::max<long long>(m_clock.now() - qpcTarget, 0);
+			m_qpcAvgOversleep += (qpcOversleep - m_qpcAvgOversleep) / 8;
+			m_qpcSpinMargin = std::clamp<long long>(2 * m_qpcAvgOversleep + usToQpc(100), usToQpc(250), usToQpc(4000));
+		}
+
+		long long usToQpc(long long us) const
+		{
+			return us * m_clock.getFrequency() / 1000000;
+		}
+
+		void waitUntil(long long qpcTarget)
+		{
+			if (qpcTarget - m_clock.now() > m_qpcSpinMargin)
+			{
+				sleepUntil(qpcTarget - m_qpcSpinMargin);
+			}
+
+			while (m_clock.now() < qpcTarget)
+			{
+				m_clock.spin();
+			}
+		}
+
+		Clock& m_clock;
+		long long m_qpcLastFrame;
+		long long m_qpcSpinMargin;
+		long long m_qpcAvgOversleep;
+		long long m_qpcStatsStart;
+		long long m_qpcErrorSum;
+		long long m_qpcErrorMax;
+		UINT m_frameCount;
+		UINT m_lateFrameCount;
+	};
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+
+#include <Common/Time.h>
+#include <DDraw/FrameStats.h>
+
+namespace
+{
+	const UINT ROLLING_WINDOW_SIZE = 1024;
+
+	UINT qpcToUs(long long qpc)
+	{
+		return qpc > 0 ? static_cast<UINT>(qpc * 1000000 / Time::g_qpcFrequency) : 0;
+	}
+}
+
+namespace DDraw
+{
+	FrameStats::FrameStats()
+		: m_qpcLastFlip(0)
+		, m_qpcLastVblank(0)
+		, m_lastVsyncCount(0)
+		, m_flipCount(0)
+		, m_updateCount(0)
+		, m_presentCount(0)
+		, m_repeatedVblankCount(0)
+	{
+	}
+
+	void FrameStats::addFlip(long long qpc)
+	{
+		if (0 != m_qpcLastFlip)
+		{
+			m_frameTimes.add(qpcToUs(qpc - m_qpcLastFlip));
+		}
+		m_qpcLastFlip = qpc;
+		++m_flipCount;
+	}
+
+	void FrameStats::addPresent(long long qpcContent, long long qpcPresentStart, long long qpcPresentEnd,
+		long long qpcScanout)
+	{
+		m_presentTimes.add(qpcToUs(qpcPresentEnd - qpcPresentStart));
+		if (0 != qpcContent)
+		{
+			m_latencies.add(qpcToUs(qpcScanout - qpcContent));
+		}
+		++m_presentCount;
+	}
+
+	void FrameStats::addUpdate(long long /*qpc*/)
+	{
+		++m_updateCount;
+	}
+
+	void FrameStats::addVblank(UINT vsyncCount, long long qpcVblank)
+	{
+		if (0 != m_qpcLastVblank && vsyncCount == m_lastVsyncCount)
+		{
+			return;
+		}
+
+		if (0 != m_qpcLastVblank)
+		{
+			m_vblankIntervals.add(qpcToUs(qpcVblank - m_qpcLastVblank));
+			m_repeatedVblankCount += vsyncCount - m_lastVsyncCount - 1;
+		}
+		m_qpcLastVblank = qpcVblank;
+		m_lastVsyncCount = vsyncCount;
+	}
+
+	void FrameStats::reset()
+	{
+		m_flipCount = 0;
+		m_updateCount = 0;
+		m_presentCount = 0;
+		m_repeatedVblankCount = 0;
+		m_frameTimes.resetHistogram();
+		m_presentTimes.resetHistogram();
+		m_latencies.resetHistogram();
+		m_vblankIntervals.resetHistogram();
+	}
+
+	std::ostream& operator<<(std::ostream& os, const FrameStats& stats)
+	{
+		return os << "flips: " << stats.m_flipCount
+			<< ", updates: " << stats.m_updateCount
+			<< ", presents: " << stats.m_presentCount
+			<< "; frame time: " << stats.m_frameTimes
+			<< "; present time: " << stats.m_presentTimes
+			<< "; flip to scanout: " << stats.m_latencies
+			<< "; scanout interval: " << stats.m_vblankIntervals
+			<< ", repeated vblanks: " << stats.m_repeatedVblankCount;
+	}
+
+	FrameStats::Distribution::Distribution()
+		: m_nextSample(0)
+	{
+		m_samples.reserve(ROLLING_WINDOW_SIZE);
+	}
+
+	void FrameStats::Distribution::add(UINT us)
+	{
+		if (m_samples.size() < ROLLING_WINDOW_SIZE)
+		{
+			m_samples.push_back(us);
+		}
+		else
+		{
+			m_samples[m_nextSample] = us;
+		}
+		m_nextSample = (m_nextSample + 1) % ROLLING_WINDOW_SIZE;
+		m_msCounts.add(us / 1000);
+	}
+
+	UINT FrameStats::Distribution::getPercentile(UINT percent) const
+	{
+		if (m_samples.empty())
+		{
+			return 0;
+		}
+
+		std::vector<UINT> samples(m_samples);
+		const UINT rank = std::min<UINT>((samples.size() * percent + 99) / 100, samples.size());
+		auto it = samples.begin() + (0 == rank ? 0 : rank - 1);
+		std::nth_element(samples.begin(), it, samples.end());
+		return *it;
+	}
+
+	void FrameStats::Distribution::resetHistogram()
+	{
+		m_msCounts.reset();
+	}
+
+	std::ostream& operator<<(std::ostream& os, const FrameStats::Distribution& distribution)
+	{
+		if (distribution.m_samples.empty())
+		{
+			return os << "none";
+		}
+
+		return os << "p50 " << distribution.getPercentile(50) << " us, p90 " << distribution.getPercentile(90)
+			<< " us, p99 " << distribution.getPercentile(99) << " us, max " << distribution.getPercentile(100)
+			<< " us, ms " << distribution.m_msCounts;
+	}
+}
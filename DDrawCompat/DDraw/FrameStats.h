@@ -0,0 +1,56 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+#include <Windows.h>
+
+#include <Common/Histogram.h>
+
+namespace DDraw
+{
+	class FrameStats
+	{
+	public:
+		class Distribution
+		{
+		public:
+			Distribution();
+
+			void add(UINT us);
+			UINT getPercentile(UINT percent) const;
+			void resetHistogram();
+
+			friend std::ostream& operator<<(std::ostream& os, const Distribution& distribution);
+
+		private:
+			std::vector<UINT> m_samples;
+			UINT m_nextSample;
+			Compat::Histogram<9> m_msCounts;
+		};
+
+		FrameStats();
+
+		void addFlip(long long qpc);
+		void addPresent(long long qpcContent, long long qpcPresentStart, long long qpcPresentEnd, long long qpcScanout);
+		void addUpdate(long long qpc);
+		void addVblank(UINT vsyncCount, long long qpcVblank);
+		bool isEmpty() const { return 0 == m_flipCount && 0 == m_updateCount && 0 == m_presentCount; }
+		void reset();
+
+		friend std::ostream& operator<<(std::ostream& os, const FrameStats& stats);
+
+	private:
+		long long m_qpcLastFlip;
+		long long m_qpcLastVblank;
+		UINT m_lastVsyncCount;
+		UINT m_flipCount;
+		UINT m_updateCount;
+		UINT m_presentCount;
+		UINT m_repeatedVblankCount;
+		Distribution m_frameTimes;
+		Distribution m_presentTimes;
+		Distribution m_latencies;
+		Distribution m_vblankIntervals;
+	};
+}
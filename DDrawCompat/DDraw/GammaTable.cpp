@@ -0,0 +1,149 @@
+#include <DDraw/GammaTable.h>
+
+namespace
+{
+	DWORD getShift(DWORD mask)
+	{
+		DWORD shift = 0;
+		while (mask && !(mask & 1))
+		{
+			mask >>= 1;
+			++shift;
+		}
+		return shift;
+	}
+
+	template <typename Pixel>
+	void applyTables(Pixel* row, LONG width, const DWORD* red, const DWORD* green, const DWORD* blue,
+		DWORD redShift, DWORD greenShift, DWORD blueShift, DWORD redMask, DWORD greenMask, DWORD blueMask,
+		DWORD passThroughMask)
+	{
+		LONG x = 0;
+		for (; x + 4 <= width; x += 4)
+		{
+			const DWORD p0 = row[x];
+			const DWORD p1 = row[x + 1];
+			const DWORD p2 = row[x + 2];
+			const DWORD p3 = row[x + 3];
+			row[x] = static_cast<Pixel>(red[(p0 & redMask) >> redShift] | green[(p0 & greenMask) >> greenShift] |
+				blue[(p0 & blueMask) >> blueShift] | (p0 & passThroughMask));
+			row[x + 1] = static_cast<Pixel>(red[(p1 & redMask) >> redShift] | green[(p1 & greenMask) >> greenShift] |
+				blue[(p1 & blueMask) >> blueShift] | (p1 & passThroughMask));
+			row[x + 2] = static_cast<Pixel>(red[(p2 & redMask) >> redShift] | green[(p2 & greenMask) >> greenShift] |
+				blue[(p2 & blueMask) >> blueShift] | (p2 & passThroughMask));
+			row[x + 3] = static_cast<Pixel>(red[(p3 & redMask) >> redShift] | green[(p3 & greenMask) >> greenShift] |
+				blue[(p3 & blueMask) >> blueShift] | (p3 & passThroughMask));
+		}
+
+		for (; x < width; ++x)
+		{
+			const DWORD p = row[x];
+			row[x] = static_cast<Pixel>(red[(p & redMask) >> redShift] | green[(p & greenMask) >> greenShift] |
+				blue[(p & blueMask) >> blueShift] | (p & passThroughMask));
+		}
+	}
+}
+
+namespace DDraw
+{
+	GammaTable::GammaTable()
+		: m_ramp{}
+		, m_channels{}
+		, m_bitCount(0)
+		, m_passThroughMask(0)
+		, m_isIdentity(true)
+		, m_isSupported(false)
+	{
+		for (UINT i = 0; i < 256; ++i)
+		{
+			m_ramp[0][i] = m_ramp[1][i] = m_ramp[2][i] = static_cast<WORD>(i * 257);
+		}
+	}
+
+	void GammaTable::apply(void* surface, LONG pitch, const RECT& rect) const
+	{
+		if (!m_isSupported || m_isIdentity)
+		{
+			return;
+		}
+
+		const LONG width = rect.right - rect.left;
+		auto row = static_cast<BYTE*>(surface) + rect.top * pitch + rect.left * static_cast<LONG>(m_bitCount / 8);
+		for (LONG y = rect.top; y < rect.bottom; ++y)
+		{
+			if (32 == m_bitCount)
+			{
+				applyTables(reinterpret_cast<DWORD*>(row), width,
+					m_channels[0].table, m_channels[1].table, m_channels[2].table,
+					m_channels[0].shift, m_channels[1].shift, m_channels[2].shift,
+					m_channels[0].mask, m_channels[1].mask, m_channels[2].mask, m_passThroughMask);
+			}
+			else
+			{
+				applyTables(reinterpret_cast<WORD*>(row), width,
+					m_channels[0].table, m_channels[1].table, m_channels[2].table,
+					m_channels[0].shift, m_channels[1].shift, m_channels[2].shift,
+					m_channels[0].mask, m_channels[1].mask, m_channels[2].mask, m_passThroughMask);
+			}
+			row += pitch;
+		}
+	}
+
+	void GammaTable::setFormat(DWORD bitCount, DWORD redMask, DWORD greenMask, DWORD blueMask)
+	{
+		const DWORD masks[] = { redMask, greenMask, blueMask };
+		m_isSupported = 16 == bitCount || 32 == bitCount;
+		for (UINT i = 0; i < 3 && m_isSupported; ++i)
+		{
+			const DWORD shift = getShift(masks[i]);
+			const DWORD maxValue = masks[i] >> shift;
+			m_isSupported = 0 != masks[i] && maxValue <= 255 && 0 == (maxValue & (maxValue + 1));
+			m_channels[i].mask = masks[i];
+			m_channels[i].shift = shift;
+		}
+
+		m_bitCount = bitCount;
+		m_passThroughMask = ~(redMask | greenMask | blueMask);
+		if (m_isSupported)
+		{
+			updateTables();
+		}
+	}
+
+	void GammaTable::setRamp(const WORD* red, const WORD* green, const WORD* blue)
+	{
+		const WORD* ramps[] = { red, green, blue };
+		m_isIdentity = true;
+		for (UINT i = 0; i < 3; ++i)
+		{
+			for (UINT j = 0; j < 256; ++j)
+			{
+				m_ramp[i][j] = ramps[i][j];
+				if (ramps[i][j] >> 8 != j)
+				{
+					m_isIdentity = false;
+				}
+			}
+		}
+
+		if (m_isSupported)
+		{
+			updateTables();
+		}
+	}
+
+	void GammaTable::updateTables()
+	{
+		for (UINT i = 0; i < 3; ++i)
+		{
+			auto& channel = m_channels[i];
+			const DWORD maxValue = channel.mask >> channel.shift;
+			for (DWORD value = 0; value <= maxValue; ++value)
+			{
+				const DWORD rampIndex = (value * 255 + maxValue / 2) / maxValue;
+				const DWORD output = (m_ramp[i][rampIndex] * maxValue + 32767) / 65535;
+				channel.table[value] = output << channel.shift;
+			}
+		}
+	}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Windows.h>
+
+namespace DDraw
+{
+	class GammaTable
+	{
+	public:
+		GammaTable();
+
+		void apply(void* surface, LONG pitch, const RECT& rect) const;
+		bool isIdentity() const { return m_isIdentity; }
+		bool isSupported() const { return m_isSupported; }
+		void setFormat(DWORD bitCount, DWORD redMask, DWORD greenMask, DWORD blueMask);
+		void setRamp(const WORD* red, const WORD* green, const WORD* blue);
+
+	private:
+		struct Channel
+		{
+			DWORD mask;
+			DWORD shift;
+			DWORD table[256];
+		};
+
+		void updateTables();
+
+		WORD m_ramp[3][256];
+		Channel m_channels[3];
+		DWORD m_bitCount;
+		DWORD m_passThroughMask;
+		bool m_isIdentity;
+		bool m_isSupported;
+	};
+}
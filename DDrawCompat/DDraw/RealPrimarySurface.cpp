@@ -1,20 +1,31 @@
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <vector>
 
 #include <Common/CompatPtr.h>
 #include <Common/Hook.h>
+#include <Common/ScopedCriticalSection.h>
+#include <Common/ScopedSrwLock.h>
+#include <Common/SharedMetrics.h>
 #include <Common/Time.h>
+#include <Common/TripleBuffer.h>
 #include <Config/Config.h>
 #include <D3dDdi/Device.h>
 #include <D3dDdi/KernelModeThunks.h>
+#include <DDraw/DamageAccumulator.h>
+#include <DDraw/DamageTracker.h>
 #include <DDraw/DirectDraw.h>
 #include <DDraw/DirectDrawSurface.h>
+#include <DDraw/FrameLimiter.h>
+#include <DDraw/FrameStats.h>
+#include <DDraw/GammaTable.h>
 #include <DDraw/IReleaseNotifier.h>
 #include <DDraw/RealPrimarySurface.h>
 #include <DDraw/ScopedThreadLock.h>
 #include <DDraw/Surfaces/PrimarySurface.h>
 #include <DDraw/Types.h>
+#include <DDraw/UpdateScheduler.h>
 #include <Gdi/Caret.h>
 #include <Gdi/Gdi.h>
 #include <Gdi/VirtualScreen.h>
@@ -23,6 +34,29 @@
 
 namespace
 {
+	const DWORD IDLE_POLL_INTERVAL = 50;
+	const UINT PRESENT_FRAME_COUNT = Compat::TripleBuffer::SLOT_COUNT;
+
+	struct SysMemSurface
+	{
+		CompatWeakPtr<IDirectDrawSurface7> surface;
+		std::shared_ptr<BYTE[]> memory;
+		DDSURFACEDESC2 desc;
+	};
+
+	struct PresentFrame
+	{
+		CompatWeakPtr<IDirectDrawSurface7> surface;
+		std::shared_ptr<BYTE[]> memory;
+		DDSURFACEDESC2 desc;
+		RECT monitorRect;
+		DDraw::DamageTracker damage;
+		long long qpcContent;
+		UINT generation;
+		bool isValid;
+		bool isGdiSurface;
+	};
+
 	void onRelease();
 
 	CompatWeakPtr<IDirectDrawSurface7> g_frontBuffer;
@@ -32,10 +66,42 @@ namespace
 
 	bool g_stopUpdateThread = false;
 	HANDLE g_updateThread = nullptr;
+	HANDLE g_updateEvent = nullptr;
 	bool g_isFullScreen = false;
 	DDraw::Surface* g_lastFlipSurface = nullptr;
 
-	bool g_isUpdatePending = false;
+	PresentFrame g_presentFrames[PRESENT_FRAME_COUNT] = {};
+	Compat::TripleBuffer g_presentQueue;
+	UINT g_presentGeneration = 0;
+	std::atomic<UINT> g_presentedFrameCount = 0;
+	std::atomic<UINT> g_droppedFrameCount = 0;
+	bool g_stopPresentThread = false;
+	HANDLE g_presentThread = nullptr;
+	HANDLE g_presentEvent = nullptr;
+
+	DDraw::DamageAccumulator g_damage(Config::damageFullRefreshInterval);
+	Compat::SrwLock g_damageSrwLock;
+	DDraw::DamageTracker g_presentHistory[PRESENT_FRAME_COUNT - 1];
+	DDraw::DamageTracker g_snapshotStaleDamage[PRESENT_FRAME_COUNT];
+
+	DDraw::FrameLimiter g_frameLimiter;
+	Compat::CriticalSection g_frameLimiterCs;
+
+	DDraw::FrameStats g_frameStats;
+	Compat::SrwLock g_frameStatsSrwLock;
+	long long g_qpcFrameStatsStart = 0;
+	long long g_qpcFirstUnpresentedChange = 0;
+
+	DDraw::GammaTable g_gammaTable;
+	DDGAMMARAMP g_gammaRamp = {};
+	bool g_isSoftwareGammaRampSet = false;
+	UINT g_gammaRampVersion = 0;
+	DDraw::GammaTable g_presentGammaTable;
+	UINT g_presentGammaRampVersion = 0;
+	SysMemSurface g_composeSurface = {};
+	SysMemSurface g_syncComposeSurface = {};
+
+	std::atomic<bool> g_isUpdatePending = false;
 	bool g_waitingForPrimaryUnlock = false;
 	std::atomic<long long> g_qpcLastUpdate = 0;
 	long long g_qpcFlipEnd = 0;
@@ -44,19 +110,87 @@ namespace
 
 	CompatPtr<IDirectDrawSurface7> getBackBuffer();
 	CompatPtr<IDirectDrawSurface7> getLastSurface();
+	void releasePresentFrames();
+	void releaseSysMemSurface(SysMemSurface& surface);
+
+	void addDamage(const RECT* rect)
+	{
+		Compat::ScopedSrwLockExclusive lock(g_damageSrwLock);
+		g_damage.add(rect);
+	}
+
+	template <typename Func>
+	void addFrameStats(long long qpcNow, Func func)
+	{
+		if (0 == Config::frameStatsLogInterval)
+		{
+			return;
+		}
+
+		Compat::ScopedSrwLockExclusive lock(g_frameStatsSrwLock);
+		func(g_frameStats);
+		if (0 == g_qpcFrameStatsStart)
+		{
+			g_qpcFrameStatsStart = qpcNow;
+		}
+		else if (qpcNow - g_qpcFrameStatsStart >= Time::msToQpc(Config::frameStatsLogInterval))
+		{
+			Compat::Log() << "Frame stats: " << g_frameStats;
+			g_frameStats.reset();
+			g_qpcFrameStatsStart = qpcNow;
+		}
+	}
+
+	void addPresentStats(long long qpcContent, long long qpcPresentStart)
+	{
+		Compat::SharedMetrics::add(Compat::SharedMetrics::PRESENT_COUNT);
+		const long long qpcPresentEnd = Time::queryPerformanceCounter();
+		const long long qpcScanout = D3dDdi::KernelModeThunks::getQpcNextVblank(qpcPresentEnd);
+		const UINT vsyncCount = D3dDdi::KernelModeThunks::getVsyncCounter();
+		addFrameStats(qpcPresentEnd, [&](DDraw::FrameStats& stats) {
+			stats.addPresent(qpcContent, qpcPresentStart, qpcPresentEnd, qpcScanout);
+			stats.addVblank(vsyncCount, qpcScanout);
+		});
+	}
+
+	void applyGammaRamp(const DDraw::GammaTable& gammaTable, const BYTE* src, LONG srcPitch,
+		BYTE* dst, LONG dstPitch, LONG bytesPerPixel, const std::vector<RECT>& rects)
+	{
+		for (const auto& rect : rects)
+		{
+			const LONG offset = rect.left * bytesPerPixel;
+			const LONG size = (rect.right - rect.left) * bytesPerPixel;
+			for (LONG y = rect.top; y < rect.bottom; ++y)
+			{
+				memcpy(dst + y * dstPitch + offset, src + y * srcPitch + offset, size);
+			}
+			gammaTable.apply(dst, dstPitch, rect);
+		}
+	}
 
-	void bltToPrimaryChain(CompatRef<IDirectDrawSurface7> src)
+	void bltToPrimaryChain(CompatRef<IDirectDrawSurface7> src, const std::vector<RECT>& rects = {})
 	{
 		if (!g_isFullScreen)
 		{
-			Gdi::Window::present(*g_frontBuffer, src, *g_clipper);
+			Gdi::Window::present(*g_frontBuffer, src, *g_clipper, rects);
 			return;
 		}
 
 		auto backBuffer(getBackBuffer());
-		if (backBuffer)
+		if (!backBuffer)
+		{
+			return;
+		}
+
+		if (rects.empty())
 		{
 			backBuffer->Blt(backBuffer, nullptr, &src, nullptr, DDBLT_WAIT, nullptr);
+			return;
+		}
+
+		for (auto rect : rects)
+		{
+			backBuffer->Blt(backBuffer, &rect, &src, &rect, DDBLT_WAIT, nullptr);
 		}
 	}
 
@@ -85,6 +219,38 @@ namespace
 		return lastSurface;
 	}
 
+	bool createSysMemSurface(CompatRef<IDirectDrawSurface7> ddSource, const DDSURFACEDESC2& desc,
+		CompatWeakPtr<IDirectDrawSurface7>& surface, std::shared_ptr<BYTE[]>& memory, DDSURFACEDESC2& surfaceDesc)
+	{
+		CompatPtr<IUnknown> ddUnk;
+		ddSource->GetDDInterface(&ddSource, reinterpret_cast<void**>(&ddUnk.getRef()));
+		CompatPtr<IDirectDraw7> dd(ddUnk);
+		if (!dd)
+		{
+			return false;
+		}
+
+		DDSURFACEDESC2 sysMemDesc = {};
+		sysMemDesc.dwSize = sizeof(sysMemDesc);
+		sysMemDesc.dwFlags = DDSD_CAPS | DDSD_WIDTH | DDSD_HEIGHT | DDSD_PIXELFORMAT | DDSD_PITCH | DDSD_LPSURFACE;
+		sysMemDesc.dwWidth = desc.dwWidth;
+		sysMemDesc.dwHeight = desc.dwHeight;
+		sysMemDesc.ddpfPixelFormat = desc.ddpfPixelFormat;
+		sysMemDesc.ddsCaps.dwCaps = DDSCAPS_OFFSCREENPLAIN | DDSCAPS_SYSTEMMEMORY;
+		sysMemDesc.lPitch = (desc.dwWidth * desc.ddpfPixelFormat.dwRGBBitCount / 8 + 7) & ~7;
+
+		std::shared_ptr<BYTE[]> sysMem(new BYTE[sysMemDesc.lPitch * desc.dwHeight]);
+		sysMemDesc.lpSurface = sysMem.get();
+		if (FAILED(dd->CreateSurface(dd, &sysMemDesc, &surface.getRef(), nullptr)))
+		{
+			return false;
+		}
+
+		memory = sysMem;
+		surfaceDesc = sysMemDesc;
+		return true;
+	}
+
 	UINT getFlipInterval(DWORD flags)
 	{
 		if (flags & DDFLIP_NOVSYNC)
@@ -115,15 +281,79 @@ namespace
 		return static_cast<INT>(D3dDdi::KernelModeThunks::getVsyncCounter() - g_presentEndVsyncCount) < 0;
 	}
 
+	bool getPresentRects(const DDraw::DamageTracker& damage, const DDSURFACEDESC2& desc, std::vector<RECT>& rects)
+	{
+		DDraw::DamageTracker presentDamage(damage);
+		if (g_isFullScreen)
+		{
+			for (const auto& prevDamage : g_presentHistory)
+			{
+				presentDamage.add(prevDamage);
+			}
+		}
+
+		rects.clear();
+		if (!presentDamage.isFull() &&
+			desc.dwWidth == g_surfaceDesc.dwWidth && desc.dwHeight == g_surfaceDesc.dwHeight)
+		{
+			const RECT bounds = { 0, 0, static_cast<LONG>(desc.dwWidth), static_cast<LONG>(desc.dwHeight) };
+			rects = presentDamage.getRects(bounds);
+			if (rects.empty())
+			{
+				return false;
+			}
+		}
+
+		if (g_isFullScreen)
+		{
+			for (UINT i = PRESENT_FRAME_COUNT - 2; i > 0; --i)
+			{
+				g_presentHistory[i] = g_presentHistory[i - 1];
+			}
+			g_presentHistory[0] = damage;
+		}
+		return true;
+	}
+
+	bool isSoftwareGammaRampSupported()
+	{
+		const auto& pf = g_surfaceDesc.ddpfPixelFormat;
+		if (!(pf.dwFlags & DDPF_RGB))
+		{
+			return false;
+		}
+
+		g_gammaTable.setFormat(pf.dwRGBBitCount, pf.dwRBitMask, pf.dwGBitMask, pf.dwBBitMask);
+		return g_gammaTable.isSupported();
+	}
+
+	bool isSurfaceCompatible(CompatWeakPtr<IDirectDrawSurface7> surface, const DDSURFACEDESC2& surfaceDesc,
+		const DDSURFACEDESC2& desc)
+	{
+		return surface && surfaceDesc.dwWidth == desc.dwWidth && surfaceDesc.dwHeight == desc.dwHeight &&
+			0 == memcmp(&surfaceDesc.ddpfPixelFormat, &desc.ddpfPixelFormat, sizeof(desc.ddpfPixelFormat));
+	}
+
+	void markUpdatePending()
+	{
+		if (!g_isUpdatePending.exchange(true) && g_updateEvent)
+		{
+			SetEvent(g_updateEvent);
+		}
+	}
+
 	void onRelease()
 	{
 		LOG_FUNC("RealPrimarySurface::onRelease");
 
 		g_frontBuffer = nullptr;
 		g_clipper.release();
+		releasePresentFrames();
 		g_isFullScreen = false;
 		g_waitingForPrimaryUnlock = false;
 		g_surfaceDesc = {};
+		g_isSoftwareGammaRampSet = false;
+		DDraw::PrimarySurface::resetPaletteUpdate();
 	}
 
 	void onRestore()
@@ -142,9 +372,15 @@ namespace
 		}
 
 		g_surfaceDesc = desc;
+		g_isSoftwareGammaRampSet = false;
 		g_isFullScreen = isFlippable;
 		g_isUpdatePending = false;
 		g_qpcLastUpdate = Time::queryPerformanceCounter() - Time::msToQpc(Config::delayedFlipModeTimeout);
+		addDamage(nullptr);
+		if (DDraw::PrimarySurface::isPaletteUpdatePending())
+		{
+			markUpdatePending();
+		}
 
 		if (isFlippable)
 		{
@@ -155,24 +391,78 @@ namespace
 		}
 	}
 
-	void presentToPrimaryChain(CompatWeakPtr<IDirectDrawSurface7> src)
+	bool prepareComposeSurface(SysMemSurface& composeSurface, CompatRef<IDirectDrawSurface7> ddSource,
+		const DDSURFACEDESC2& desc)
 	{
-		LOG_FUNC("RealPrimarySurface::presentToPrimaryChain", src);
+		if (isSurfaceCompatible(composeSurface.surface, composeSurface.desc, desc))
+		{
+			return true;
+		}
 
-		Gdi::VirtualScreen::update();
+		releaseSysMemSurface(composeSurface);
+		return createSysMemSurface(ddSource, desc, composeSurface.surface, composeSurface.memory, composeSurface.desc);
+	}
+
+	CompatWeakPtr<IDirectDrawSurface7> composeGammaRamp(CompatWeakPtr<IDirectDrawSurface7> src,
+		const DDSURFACEDESC2& desc, const std::vector<RECT>& rects)
+	{
+		const auto& pf = desc.ddpfPixelFormat;
+		if (!g_isSoftwareGammaRampSet || g_gammaTable.isIdentity() || !(pf.dwFlags & DDPF_RGB))
+		{
+			return src;
+		}
+
+		g_gammaTable.setFormat(pf.dwRGBBitCount, pf.dwRBitMask, pf.dwGBitMask, pf.dwBBitMask);
+		if (!g_gammaTable.isSupported() || !prepareComposeSurface(g_syncComposeSurface, *src, desc))
+		{
+			return src;
+		}
+
+		DDSURFACEDESC2 srcDesc = {};
+		srcDesc.dwSize = sizeof(srcDesc);
+		if (FAILED(src->Lock(src, nullptr, &srcDesc, DDLOCK_WAIT | DDLOCK_READONLY, nullptr)))
+		{
+			return src;
+		}
+
+		std::vector<RECT> composeRects(rects);
+		if (composeRects.empty())
+		{
+			composeRects.push_back({ 0, 0, static_cast<LONG>(desc.dwWidth), static_cast<LONG>(desc.dwHeight) });
+		}
+		applyGammaRamp(g_gammaTable, static_cast<const BYTE*>(srcDesc.lpSurface), srcDesc.lPitch,
+			g_syncComposeSurface.memory.get(), g_syncComposeSurface.desc.lPitch, pf.dwRGBBitCount / 8, composeRects);
+		src->Unlock(src, nullptr);
+		return g_syncComposeSurface.surface;
+	}
+
+	bool presentToPrimaryChain(CompatWeakPtr<IDirectDrawSurface7> src, const DDraw::DamageTracker& damage)
+	{
+		LOG_FUNC("RealPrimarySurface::presentToPrimaryChain", src);
 
 		if (!g_frontBuffer || !src || DDraw::RealPrimarySurface::isLost())
 		{
 			Gdi::Window::present(nullptr);
-			return;
+			return LOG_RESULT(false);
 		}
 
 		RECT monitorRect = D3dDdi::KernelModeThunks::getMonitorRect();
 		Gdi::Region excludeRegion(monitorRect);
 		Gdi::Window::present(excludeRegion);
 
+		DDSURFACEDESC2 desc = {};
+		desc.dwSize = sizeof(desc);
+		src->GetSurfaceDesc(src, &desc);
+
+		std::vector<RECT> rects;
+		if (!getPresentRects(damage, desc, rects))
+		{
+			return LOG_RESULT(false);
+		}
+
+		auto presentSrc(composeGammaRamp(src, desc, rects));
 		D3dDdi::KernelModeThunks::setDcPaletteOverride(true);
-		bltToPrimaryChain(*src);
+		bltToPrimaryChain(*presentSrc, rects);
 		D3dDdi::KernelModeThunks::setDcPaletteOverride(false);
 
 		if (g_isFullScreen && src == DDraw::PrimarySurface::getGdiSurface())
@@ -184,18 +474,272 @@ namespace
 				Gdi::Window::presentLayered(*backBuffer, offset);
 			}
 		}
+		return LOG_RESULT(true);
+	}
+
+	void presentFrame(const PresentFrame& frame)
+	{
+		if (!frame.isValid)
+		{
+			Gdi::Window::present(nullptr);
+			return;
+		}
+
+		// releasePresentFrames resets the frame from the application thread, so only the copies made under the lock
+		// are used after it is released
+		DDSURFACEDESC2 desc = {};
+		RECT monitorRect = {};
+		bool isGdiSurface = false;
+		bool isPresentable = false;
+		std::vector<RECT> rects;
+		std::shared_ptr<BYTE[]> frameMemory;
+		std::shared_ptr<BYTE[]> composeMemory;
+		LONG composePitch = 0;
+
+		{
+			DDraw::ScopedThreadLock lock;
+			desc = frame.desc;
+			monitorRect = frame.monitorRect;
+			isGdiSurface = frame.isGdiSurface;
+			isPresentable = frame.generation == g_presentGeneration && g_frontBuffer &&
+				getPresentRects(frame.damage, desc, rects);
+
+			if (isPresentable && g_isSoftwareGammaRampSet && !g_gammaTable.isIdentity())
+			{
+				if (g_presentGammaRampVersion != g_gammaRampVersion)
+				{
+					g_presentGammaTable = g_gammaTable;
+					g_presentGammaRampVersion = g_gammaRampVersion;
+				}
+
+				const auto& pf = desc.ddpfPixelFormat;
+				g_presentGammaTable.setFormat(pf.dwRGBBitCount, pf.dwRBitMask, pf.dwGBitMask, pf.dwBBitMask);
+				if ((pf.dwFlags & DDPF_RGB) && g_presentGammaTable.isSupported() &&
+					prepareComposeSurface(g_composeSurface, *frame.surface, desc))
+				{
+					frameMemory = frame.memory;
+					composeMemory = g_composeSurface.memory;
+					composePitch = g_composeSurface.desc.lPitch;
+				}
+			}
+		}
+
+		Gdi::Region excludeRegion(monitorRect);
+		Gdi::Window::present(excludeRegion);
+		if (!isPresentable)
+		{
+			return;
+		}
+
+		if (composeMemory)
+		{
+			std::vector<RECT> composeRects(rects);
+			if (composeRects.empty())
+			{
+				composeRects.push_back({ 0, 0, static_cast<LONG>(desc.dwWidth), static_cast<LONG>(desc.dwHeight) });
+			}
+			applyGammaRamp(g_presentGammaTable, frameMemory.get(), desc.lPitch, composeMemory.get(), composePitch,
+				desc.ddpfPixelFormat.dwRGBBitCount / 8, composeRects);
+		}
+
+		{
+			DDraw::ScopedThreadLock lock;
+			if (frame.generation != g_presentGeneration || !g_frontBuffer)
+			{
+				return;
+			}
+
+			D3dDdi::KernelModeThunks::setDcPaletteOverride(true);
+			bltToPrimaryChain(composeMemory ? *g_composeSurface.surface : *frame.surface, rects);
+			D3dDdi::KernelModeThunks::setDcPaletteOverride(false);
+
+			if (!g_isFullScreen)
+			{
+				return;
+			}
+
+			if (isGdiSurface)
+			{
+				auto backBuffer(getBackBuffer());
+				if (backBuffer)
+				{
+					POINT offset = { -monitorRect.left, -monitorRect.top };
+					Gdi::Window::presentLayered(*backBuffer, offset);
+				}
+			}
+		}
+
+		while (true)
+		{
+			HRESULT result = DD_OK;
+			{
+				DDraw::ScopedThreadLock lock;
+				if (frame.generation != g_presentGeneration || !g_frontBuffer || !g_isFullScreen)
+				{
+					return;
+				}
+				result = g_frontBuffer->Flip(g_frontBuffer, getBackBuffer(), DDFLIP_DONOTWAIT);
+			}
+
+			if (DDERR_WASSTILLDRAWING != result)
+			{
+				return;
+			}
+			Sleep(1);
+		}
+	}
+
+	DWORD WINAPI presentThreadProc(LPVOID /*lpParameter*/)
+	{
+		while (!g_stopPresentThread)
+		{
+			if (!g_presentQueue.acquire())
+			{
+				WaitForSingleObject(g_presentEvent, INFINITE);
+				continue;
+			}
+
+			const auto& frame = g_presentFrames[g_presentQueue.getReadSlot()];
+			const long long qpcPresentStart = Time::queryPerformanceCounter();
+			presentFrame(frame);
+			addPresentStats(frame.qpcContent, qpcPresentStart);
+			++g_presentedFrameCount;
+		}
+		return 0;
+	}
+
+	bool queuePresent(CompatWeakPtr<IDirectDrawSurface7> src, long long qpcContent, const DDraw::DamageTracker& damage)
+	{
+		if (!g_presentThread)
+		{
+			return false;
+		}
+
+		for (auto& staleDamage : g_snapshotStaleDamage)
+		{
+			staleDamage.add(damage);
+		}
+
+		auto& frame = g_presentFrames[g_presentQueue.getWriteSlot()];
+		frame.isValid = g_frontBuffer && src && !DDraw::RealPrimarySurface::isLost();
+		if (frame.isValid)
+		{
+			DDSURFACEDESC2 desc = {};
+			desc.dwSize = sizeof(desc);
+			src->GetSurfaceDesc(src, &desc);
+
+			auto& staleDamage = g_snapshotStaleDamage[g_presentQueue.getWriteSlot()];
+			if (!isSurfaceCompatible(frame.surface, frame.desc, desc))
+			{
+				frame.surface.release();
+				frame.memory.reset();
+				frame.desc = {};
+				if (!createSysMemSurface(*src, desc, frame.surface, frame.memory, frame.desc))
+				{
+					return false;
+				}
+				staleDamage.addAll();
+			}
+
+			if (desc.ddpfPixelFormat.dwFlags & DDPF_PALETTEINDEXED8)
+			{
+				CompatPtr<IDirectDrawPalette> palette;
+				src->GetPalette(src, &palette.getRef());
+				frame.surface->SetPalette(frame.surface, palette);
+			}
+
+			if (staleDamage.isFull())
+			{
+				if (FAILED(frame.surface->Blt(frame.surface, nullptr, src, nullptr, DDBLT_WAIT, nullptr)))
+				{
+					return false;
+				}
+			}
+			else
+			{
+				const RECT bounds = { 0, 0, static_cast<LONG>(desc.dwWidth), static_cast<LONG>(desc.dwHeight) };
+				for (auto rect : staleDamage.getRects(bounds))
+				{
+					if (FAILED(frame.surface->Blt(frame.surface, &rect, src, &rect, DDBLT_WAIT, nullptr)))
+					{
+						return false;
+					}
+				}
+			}
+
+			staleDamage.clear();
+
+			frame.monitorRect = D3dDdi::KernelModeThunks::getMonitorRect();
+			frame.isGdiSurface = g_isFullScreen && src == DDraw::PrimarySurface::getGdiSurface();
+		}
+		frame.qpcContent = qpcContent;
+		frame.generation = g_presentGeneration;
+		frame.damage = damage;
+
+		if (g_presentQueue.publish())
+		{
+			++g_droppedFrameCount;
+			Compat::SharedMetrics::add(Compat::SharedMetrics::PRESENT_DROP_COUNT);
+			Compat::ScopedSrwLockExclusive lock(g_damageSrwLock);
+			g_damage.add(g_presentFrames[g_presentQueue.getWriteSlot()].damage);
+		}
+		SetEvent(g_presentEvent);
+		return true;
+	}
+
+	void releaseSysMemSurface(SysMemSurface& surface)
+	{
+		surface.surface.release();
+		surface.memory.reset();
+		surface.desc = {};
+	}
+
+	void releasePresentFrames()
+	{
+		++g_presentGeneration;
+		for (auto& frame : g_presentFrames)
+		{
+			frame.surface.release();
+			frame.memory.reset();
+			frame.desc = {};
+		}
+		releaseSysMemSurface(g_composeSurface);
+		releaseSysMemSurface(g_syncComposeSurface);
+		for (auto& damage : g_presentHistory)
+		{
+			damage.addAll();
+		}
+		for (auto& damage : g_snapshotStaleDamage)
+		{
+			damage.addAll();
+		}
+	}
+
+	DDraw::DamageTracker takeDamage()
+	{
+		Compat::ScopedSrwLockExclusive lock(g_damageSrwLock);
+		return g_damage.take();
 	}
 
 	void updateNow(CompatWeakPtr<IDirectDrawSurface7> src, UINT flipInterval)
 	{
-		presentToPrimaryChain(src);
-		g_isUpdatePending = false;
-		g_waitingForPrimaryUnlock = false;
+		const long long qpcContent = g_qpcFirstUnpresentedChange;
+		g_qpcFirstUnpresentedChange = 0;
 
-		if (g_isFullScreen)
+		DDraw::PrimarySurface::applyPalette();
+		Gdi::VirtualScreen::update();
+		const auto damage(takeDamage());
+		if (!queuePresent(src, qpcContent, damage))
 		{
-			g_frontBuffer->Flip(g_frontBuffer, getBackBuffer(), DDFLIP_WAIT);
+			const long long qpcPresentStart = Time::queryPerformanceCounter();
+			if (presentToPrimaryChain(src, damage) && g_isFullScreen)
+			{
+				g_frontBuffer->Flip(g_frontBuffer, getBackBuffer(), DDFLIP_WAIT);
+			}
+			addPresentStats(qpcContent, qpcPresentStart);
 		}
+		g_isUpdatePending = false;
+		g_waitingForPrimaryUnlock = false;
 		g_presentEndVsyncCount = D3dDdi::KernelModeThunks::getVsyncCounter() + max(flipInterval, 1);
 	}
 
@@ -213,34 +757,46 @@ namespace
 		}
 	}
 
-	DWORD WINAPI updateThreadProc(LPVOID /*lpParameter*/)
+	class UpdateThreadEnv
 	{
-		bool skipWaitForVsync = false;
+	public:
+		long long getFrequency() const { return Time::g_qpcFrequency; }
+		UINT getPresentEndVsyncCount() const { return g_presentEndVsyncCount; }
+		long long getQpcFlipEnd() const { return g_qpcFlipEnd; }
 
-		while (!g_stopUpdateThread)
+		long long getQpcUntilScanoutDeadline(long long qpcMargin) const
 		{
-			if (!skipWaitForVsync)
-			{
-				D3dDdi::KernelModeThunks::waitForVsync();
-			}
-			skipWaitForVsync = false;
-			Gdi::Caret::blink();
-			Sleep(1);
+			return D3dDdi::KernelModeThunks::getQpcUntilScanoutDeadline(qpcMargin);
+		}
+
+		bool isPresentPending() const { return ::isPresentPending(); }
+		bool isUpdatePending() const { return g_isUpdatePending; }
+		bool isWaitingForPrimaryUnlock() const { return g_waitingForPrimaryUnlock; }
+		long long now() const { return Time::queryPerformanceCounter(); }
+		void sleep(DWORD ms) const { Sleep(ms); }
 
+		void update() const
+		{
 			DDraw::ScopedThreadLock lock;
-			if (g_isUpdatePending && !isPresentPending())
+			if (g_isUpdatePending && !::isPresentPending())
 			{
-				if (Time::qpcToMs(Time::queryPerformanceCounter() - g_qpcFlipEnd) < 1)
-				{
-					skipWaitForVsync = true;
-				}
-				else
-				{
-					updateNowIfNotBusy();
-				}
+				updateNowIfNotBusy();
 			}
 		}
 
+		void waitForUpdate(DWORD timeoutMs) const { WaitForSingleObject(g_updateEvent, timeoutMs); }
+		void waitForVsyncCounter(UINT count) const { D3dDdi::KernelModeThunks::waitForVsyncCounter(count); }
+	};
+
+	DWORD WINAPI updateThreadProc(LPVOID /*lpParameter*/)
+	{
+		UpdateThreadEnv env;
+		DDraw::UpdateScheduler<UpdateThreadEnv> scheduler(env, IDLE_POLL_INTERVAL, Config::presentDeadlineMargin);
+		while (!g_stopUpdateThread)
+		{
+			Gdi::Caret::blink();
+			scheduler.runOnce();
+		}
 		return 0;
 	}
 }
@@ -290,10 +846,19 @@ namespace DDraw
 
 	HRESULT RealPrimarySurface::flip(CompatPtr<IDirectDrawSurface7> surfaceTargetOverride, DWORD flags)
 	{
+		const long long qpcNow = Time::queryPerformanceCounter();
+		addFrameStats(qpcNow, [&](FrameStats& stats) { stats.addFlip(qpcNow); });
+		Compat::SharedMetrics::add(Compat::SharedMetrics::FLIP_COUNT);
+		if (0 == g_qpcFirstUnpresentedChange)
+		{
+			g_qpcFirstUnpresentedChange = qpcNow;
+		}
+
+		addDamage(nullptr);
 		const DWORD flipInterval = getFlipInterval(flags);
 		if (0 == flipInterval)
 		{
-			g_isUpdatePending = true;
+			markUpdatePending();
 			return DD_OK;
 		}
 
@@ -307,7 +872,7 @@ namespace DDraw
 					surfaceTargetOverride ? surfaceTargetOverride : PrimarySurface::getLastSurface());
 				updateNow(prevPrimarySurface, 0);
 			}
-			g_isUpdatePending = true;
+			markUpdatePending();
 		}
 		else
 		{
@@ -340,6 +905,12 @@ namespace DDraw
 	HRESULT RealPrimarySurface::getGammaRamp(DDGAMMARAMP* rampData)
 	{
 		DDraw::ScopedThreadLock lock;
+		if (g_isSoftwareGammaRampSet)
+		{
+			*rampData = g_gammaRamp;
+			return DD_OK;
+		}
+
 		auto gammaControl(CompatPtr<IDirectDrawGammaControl>::from(g_frontBuffer.get()));
 		if (!gammaControl)
 		{
@@ -356,6 +927,11 @@ namespace DDraw
 
 	void RealPrimarySurface::init()
 	{
+		g_presentEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+		g_presentThread = CreateThread(nullptr, 0, &presentThreadProc, nullptr, 0, nullptr);
+		SetThreadPriority(g_presentThread, THREAD_PRIORITY_TIME_CRITICAL);
+
+		g_updateEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
 		g_updateThread = CreateThread(nullptr, 0, &updateThreadProc, nullptr, 0, nullptr);
 		SetThreadPriority(g_updateThread, THREAD_PRIORITY_TIME_CRITICAL);
 	}
@@ -371,9 +947,25 @@ namespace DDraw
 		return g_frontBuffer && DDERR_SURFACELOST == g_frontBuffer->IsLost(g_frontBuffer);
 	}
 
+	void RealPrimarySurface::limitFrameRate(DWORD flipFlags)
+	{
+		if (0 == Config::frameLimit || (flipFlags & DDFLIP_DONOTWAIT))
+		{
+			return;
+		}
+
+		// Only one level of the DirectDraw lock is released while waiting. If the application itself holds
+		// the lock through AcquireDDThreadLock, other threads remain blocked until the wait ends.
+		DDraw::ScopedThreadUnlock unlock;
+		Compat::ScopedCriticalSection lock(g_frameLimiterCs);
+		g_frameLimiter.waitForNextFrame(Time::g_qpcFrequency / std::max<unsigned>(Config::frameLimit, 1),
+			Config::frameLimitVsyncAligned);
+	}
+
 	void RealPrimarySurface::release()
 	{
 		DDraw::ScopedThreadLock lock;
+		releasePresentFrames();
 		g_frontBuffer.release();
 	}
 
@@ -385,12 +977,29 @@ namespace DDraw
 		}
 
 		g_stopUpdateThread = true;
+		SetEvent(g_updateEvent);
 		if (WAIT_OBJECT_0 != WaitForSingleObject(g_updateThread, 1000))
 		{
 			TerminateThread(g_updateThread, 0);
 			Compat::Log() << "The update thread was terminated forcefully";
 		}
 		g_updateThread = nullptr;
+
+		g_stopPresentThread = true;
+		SetEvent(g_presentEvent);
+		if (WAIT_OBJECT_0 != WaitForSingleObject(g_presentThread, 1000))
+		{
+			TerminateThread(g_presentThread, 0);
+			Compat::Log() << "The present thread was terminated forcefully";
+		}
+		g_presentThread = nullptr;
+
+		const UINT droppedFrameCount = g_droppedFrameCount;
+		if (0 != droppedFrameCount)
+		{
+			Compat::Log() << "Dropped " << droppedFrameCount << " of " <<
+				g_presentedFrameCount + droppedFrameCount << " queued frames";
+		}
 	}
 
 	HRESULT RealPrimarySurface::restore()
@@ -406,13 +1015,30 @@ namespace DDraw
 
 	void RealPrimarySurface::scheduleUpdate()
 	{
+		addDamage(nullptr);
 		g_qpcLastUpdate = Time::queryPerformanceCounter();
-		g_isUpdatePending = true;
+		markUpdatePending();
 	}
 
 	HRESULT RealPrimarySurface::setGammaRamp(DDGAMMARAMP* rampData)
 	{
 		DDraw::ScopedThreadLock lock;
+		if (Config::softwareGammaRamp && g_frontBuffer && isSoftwareGammaRampSupported())
+		{
+			if (!rampData)
+			{
+				return DDERR_INVALIDPARAMS;
+			}
+
+			g_gammaRamp = *rampData;
+			g_gammaTable.setRamp(g_gammaRamp.red, g_gammaRamp.green, g_gammaRamp.blue);
+			g_isSoftwareGammaRampSet = true;
+			++g_gammaRampVersion;
+			addDamage(nullptr);
+			markUpdatePending();
+			return DD_OK;
+		}
+
 		auto gammaControl(CompatPtr<IDirectDrawGammaControl>::from(g_frontBuffer.get()));
 		if (!gammaControl)
 		{
@@ -422,11 +1048,18 @@ namespace DDraw
 		return gammaControl->SetGammaRamp(gammaControl, 0, rampData);
 	}
 
-	void RealPrimarySurface::update()
+	void RealPrimarySurface::update(const RECT* rect)
 	{
 		DDraw::ScopedThreadLock lock;
+		addDamage(rect);
 		g_qpcLastUpdate = Time::queryPerformanceCounter();
-		g_isUpdatePending = true;
+		addFrameStats(g_qpcLastUpdate, [](FrameStats& stats) { stats.addUpdate(g_qpcLastUpdate); });
+		Compat::SharedMetrics::add(Compat::SharedMetrics::UPDATE_COUNT);
+		if (0 == g_qpcFirstUnpresentedChange)
+		{
+			g_qpcFirstUnpresentedChange = g_qpcLastUpdate;
+		}
+		markUpdatePending();
 		if (g_waitingForPrimaryUnlock)
 		{
 			updateNowIfNotBusy();
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Windows.h>
+
+#include <Common/Log.h>
+
+namespace DDraw
+{
+	// Flips of the primary chain go through the runtime, which rotates the surface memory and resources along the
+	// chain, or swaps them between the front and the target override. In windowed mode an emulated chain is pinned
+	// unless the target is the GDI surface, as the front has to stay backed by the virtual screen. A pinned chain, or
+	// an emulated one the runtime refuses to flip, presents by blitting the target to the front instead.
+	//
+	// Chain provides:
+	//   Surface getBackBuffer(), bool isEmulated(), bool isFullScreen(), bool isGdiSurface(Surface surface),
+	//   HRESULT flip(Surface target), HRESULT presentFlip(Surface target) and HRESULT presentBlt(Surface src)
+	template <typename Chain, typename Surface>
+	HRESULT flipChain(Chain& chain, Surface target)
+	{
+		const bool isPinned = !chain.isFullScreen() && !chain.isGdiSurface(target);
+		if (!chain.isEmulated() || !isPinned)
+		{
+			HRESULT result = chain.flip(target);
+			if (SUCCEEDED(result))
+			{
+				return chain.presentFlip(target);
+			}
+
+			if (!chain.isEmulated())
+			{
+				return result;
+			}
+			LOG_ONCE("Falling back to a blit for emulated flips: " << Compat::hex(result));
+		}
+
+		return chain.presentBlt(target ? target : chain.getBackBuffer());
+	}
+}
@@ -1,5 +1,7 @@
+#include <Common/CoalescedUpdate.h>
 #include <Common/CompatPtr.h>
 #include <Common/CompatRef.h>
+#include <Common/SharedMetrics.h>
 #include <Config/Config.h>
 #include <D3dDdi/Device.h>
 #include <D3dDdi/KernelModeThunks.h>
@@ -19,6 +21,7 @@ namespace
 	DWORD g_origCaps = 0;
 	HWND g_deviceWindow = nullptr;
 	HPALETTE g_palette = nullptr;
+	Compat::CoalescedUpdate g_paletteUpdate;
 }
 
 namespace DDraw
@@ -42,6 +45,23 @@ namespace DDraw
 		DDraw::RealPrimarySurface::release();
 	}
 
+	void PrimarySurface::applyPalette()
+	{
+		if (!g_paletteUpdate.take() || !s_palette || RealPrimarySurface::isFullScreen())
+		{
+			return;
+		}
+
+		PALETTEENTRY entries[256] = {};
+		PrimarySurface::s_palette->GetEntries(s_palette, 0, 0, 256, entries);
+		SetPaletteEntries(g_palette, 0, 256, entries);
+		HDC dc = GetDC(g_deviceWindow);
+		HPALETTE oldPal = SelectPalette(dc, g_palette, FALSE);
+		RealizePalette(dc);
+		SelectPalette(dc, oldPal, FALSE);
+		ReleaseDC(g_deviceWindow, dc);
+	}
+
 	template <typename TDirectDraw, typename TSurface, typename TSurfaceDesc>
 	HRESULT PrimarySurface::create(CompatRef<TDirectDraw> dd, TSurfaceDesc desc, TSurface*& surface)
 	{
@@ -206,6 +226,15 @@ namespace DDraw
 		LOG_FUNC("PrimarySurface::restore");
 
 		Gdi::VirtualScreen::update();
+		if (g_primarySurface == m_surface && (g_origCaps & DDSCAPS_SYSTEMMEMORY))
+		{
+			auto gdiSurface(getGdiSurface());
+			if (gdiSurface && gdiSurface.get() != m_surface.get())
+			{
+				CompatVtable<IDirectDrawSurface7Vtbl>::s_origVtable.Flip(m_surface, gdiSurface, DDFLIP_WAIT);
+			}
+		}
+
 		g_primarySurface = m_surface;
 		g_gdiResourceHandle = getRuntimeResourceHandle(*g_primarySurface);
 
@@ -227,6 +256,16 @@ namespace DDraw
 		Surface::restore();
 	}
 
+	bool PrimarySurface::isPaletteUpdatePending()
+	{
+		return g_paletteUpdate.isPending();
+	}
+
+	void PrimarySurface::resetPaletteUpdate()
+	{
+		g_paletteUpdate.reset();
+	}
+
 	void PrimarySurface::updateFrontResource()
 	{
 		g_frontResource = getDriverResourceHandle(*g_primarySurface);
@@ -239,21 +278,17 @@ namespace DDraw
 			return;
 		}
 
-		PALETTEENTRY entries[256] = {};
-		PrimarySurface::s_palette->GetEntries(s_palette, 0, 0, 256, entries);
-
 		if (RealPrimarySurface::isFullScreen())
 		{
+			PALETTEENTRY entries[256] = {};
+			s_palette->GetEntries(s_palette, 0, 0, 256, entries);
 			Gdi::Palette::setHardwarePalette(entries);
 		}
-		else
+
+		if (!g_paletteUpdate.request())
 		{
-			SetPaletteEntries(g_palette, 0, 256, entries);
-			HDC dc = GetDC(g_deviceWindow);
-			HPALETTE oldPal = SelectPalette(dc, g_palette, FALSE);
-			RealizePalette(dc);
-			SelectPalette(dc, oldPal, FALSE);
-			ReleaseDC(g_deviceWindow, dc);
+			Compat::SharedMetrics::add(Compat::SharedMetrics::PALETTE_THROTTLE_COUNT);
+			return;
 		}
 
 		RealPrimarySurface::update();
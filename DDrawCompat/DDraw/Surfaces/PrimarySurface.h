@@ -13,6 +13,8 @@ namespace DDraw
 	public:
 		virtual ~PrimarySurface();
 
+		static void applyPalette();
+
 		template <typename TDirectDraw, typename TSurface, typename TSurfaceDesc>
 		static HRESULT create(CompatRef<TDirectDraw> dd, TSurfaceDesc desc, TSurface*& surface);
 
@@ -23,6 +25,8 @@ namespace DDraw
 		static CompatWeakPtr<IDirectDrawSurface7> getPrimary();
 		static HANDLE getFrontResource();
 		static DWORD getOrigCaps();
+		static bool isPaletteUpdatePending();
+		static void resetPaletteUpdate();
 		static void updatePalette();
 
 		template <typename TSurface>
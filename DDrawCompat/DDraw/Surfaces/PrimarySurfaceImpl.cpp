@@ -2,9 +2,9 @@
 #include <D3dDdi/KernelModeThunks.h>
 #include <D3dDdi/ScopedCriticalSection.h>
 #include <DDraw/DirectDrawClipper.h>
-#include <DDraw/DirectDrawPalette.h>
 #include <DDraw/DirectDrawSurface.h>
 #include <DDraw/RealPrimarySurface.h>
+#include <DDraw/Surfaces/FlipChain.h>
 #include <DDraw/Surfaces/PrimarySurface.h>
 #include <DDraw/Surfaces/PrimarySurfaceImpl.h>
 #include <Dll/Dll.h>
@@ -66,6 +66,68 @@ namespace
 		gdiSurface->SetClipper(gdiSurface, nullptr);
 	}
 
+	template <typename TSurface>
+	class PrimaryFlipChain
+	{
+	public:
+		PrimaryFlipChain(DDraw::PrimarySurfaceImpl<TSurface>& impl, TSurface* This, DWORD flags)
+			: m_impl(impl)
+			, m_this(This)
+			, m_flags(flags)
+		{
+		}
+
+		TSurface* getBackBuffer()
+		{
+			typename DDraw::Types<TSurface>::TDdsCaps caps = {};
+			caps.dwCaps = DDSCAPS_BACKBUFFER;
+			CompatVtable<Vtable<TSurface>>::s_origVtable.GetAttachedSurface(m_this, &caps, &m_backBuffer.getRef());
+			return m_backBuffer;
+		}
+
+		bool isEmulated() const
+		{
+			return 0 != (DDraw::PrimarySurface::getOrigCaps() & DDSCAPS_SYSTEMMEMORY);
+		}
+
+		bool isFullScreen() const { return DDraw::RealPrimarySurface::isFullScreen(); }
+		bool isGdiSurface(TSurface* surface) const { return DDraw::PrimarySurface::isGdiSurface(surface); }
+
+		HRESULT flip(TSurface* target)
+		{
+			return m_impl.DDraw::SurfaceImpl<TSurface>::Flip(m_this, target, DDFLIP_WAIT);
+		}
+
+		HRESULT presentFlip(TSurface* target)
+		{
+			DDraw::PrimarySurface::updateFrontResource();
+			DDraw::RealPrimarySurface::limitFrameRate(m_flags);
+			return DDraw::RealPrimarySurface::flip(CompatPtr<IDirectDrawSurface7>::from(target), m_flags);
+		}
+
+		HRESULT presentBlt(TSurface* src)
+		{
+			DDraw::RealPrimarySurface::limitFrameRate(m_flags);
+			return m_impl.Blt(m_this, nullptr, src, nullptr, DDBLT_WAIT, nullptr);
+		}
+
+	private:
+		DDraw::PrimarySurfaceImpl<TSurface>& m_impl;
+		TSurface* m_this;
+		DWORD m_flags;
+		CompatPtr<TSurface> m_backBuffer;
+	};
+
+	const RECT* getUnlockRect(LPRECT lpRect)
+	{
+		return lpRect;
+	}
+
+	const RECT* getUnlockRect(LPVOID /*lpRect*/)
+	{
+		return nullptr;
+	}
+
 	void restorePrimaryCaps(DWORD& caps)
 	{
 		caps &= ~DDSCAPS_OFFSCREENPLAIN;
@@ -95,7 +157,7 @@ namespace DDraw
 		if (SUCCEEDED(result))
 		{
 			bltToGdi(This, lpDestRect, lpDDSrcSurface, lpSrcRect, dwFlags, lpDDBltFx);
-			RealPrimarySurface::update();
+			RealPrimarySurface::update(lpDestRect);
 		}
 		return result;
 	}
@@ -112,7 +174,17 @@ namespace DDraw
 		HRESULT result = SurfaceImpl::BltFast(This, dwX, dwY, lpDDSrcSurface, lpSrcRect, dwTrans);
 		if (SUCCEEDED(result))
 		{
-			RealPrimarySurface::update();
+			if (lpSrcRect)
+			{
+				RECT dstRect = { static_cast<LONG>(dwX), static_cast<LONG>(dwY),
+					static_cast<LONG>(dwX) + lpSrcRect->right - lpSrcRect->left,
+					static_cast<LONG>(dwY) + lpSrcRect->bottom - lpSrcRect->top };
+				RealPrimarySurface::update(&dstRect);
+			}
+			else
+			{
+				RealPrimarySurface::update();
+			}
 		}
 		return result;
 	}
@@ -125,27 +197,8 @@ namespace DDraw
 			return DDERR_WASSTILLDRAWING;
 		}
 
-		auto surfaceTargetOverride(CompatPtr<TSurface>::from(lpDDSurfaceTargetOverride));
-		const bool isFlipEmulated = 0 != (PrimarySurface::getOrigCaps() & DDSCAPS_SYSTEMMEMORY);
-		if (isFlipEmulated)
-		{
-			if (!surfaceTargetOverride)
-			{
-				TDdsCaps caps = {};
-				caps.dwCaps = DDSCAPS_BACKBUFFER;
-				s_origVtable.GetAttachedSurface(This, &caps, &surfaceTargetOverride.getRef());
-			}
-			return Blt(This, nullptr, surfaceTargetOverride.get(), nullptr, DDBLT_WAIT, nullptr);
-		}
-
-		HRESULT result = SurfaceImpl::Flip(This, surfaceTargetOverride, DDFLIP_WAIT);
-		if (FAILED(result))
-		{
-			return result;
-		}
-
-		PrimarySurface::updateFrontResource();
-		return RealPrimarySurface::flip(surfaceTargetOverride, dwFlags);
+		PrimaryFlipChain<TSurface> chain(*this, This, dwFlags);
+		return flipChain(chain, lpDDSurfaceTargetOverride);
 	}
 
 	template <typename TSurface>
@@ -228,11 +281,6 @@ namespace DDraw
 	template <typename TSurface>
 	HRESULT PrimarySurfaceImpl<TSurface>::SetPalette(TSurface* This, LPDIRECTDRAWPALETTE lpDDPalette)
 	{
-		if (lpDDPalette)
-		{
-			DirectDrawPalette::waitForNextUpdate();
-		}
-
 		HRESULT result = SurfaceImpl::SetPalette(This, lpDDPalette);
 		if (SUCCEEDED(result))
 		{
@@ -248,7 +296,7 @@ namespace DDraw
 		HRESULT result = SurfaceImpl::Unlock(This, lpRect);
 		if (SUCCEEDED(result))
 		{
-			RealPrimarySurface::update();
+			RealPrimarySurface::update(getUnlockRect(lpRect));
 		}
 		return result;
 	}
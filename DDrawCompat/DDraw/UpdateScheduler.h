@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Windows.h>
+
+namespace DDraw
+{
+	// Scheduling of the primary surface update thread. While no update is pending, an iteration blocks until one is
+	// requested. A pending update waits until the previous present has reached the screen and at least a millisecond
+	// has passed since the last flip, then sleeps until the present deadline margin before the next scanout.
+	//
+	// Env provides:
+	//   bool isUpdatePending(), bool isWaitingForPrimaryUnlock(), bool isPresentPending(),
+	//   UINT getPresentEndVsyncCount(), long long getFrequency(), long long getQpcFlipEnd(),
+	//   long long getQpcUntilScanoutDeadline(long long qpcMargin), long long now(), void sleep(DWORD ms),
+	//   void update(), void waitForUpdate(DWORD timeoutMs) and void waitForVsyncCounter(UINT count)
+	template <typename Env>
+	class UpdateScheduler
+	{
+	public:
+		UpdateScheduler(Env& env, DWORD idlePollInterval, DWORD presentDeadlineMargin)
+			: m_env(env)
+			, m_idlePollInterval(idlePollInterval)
+			, m_presentDeadlineMargin(presentDeadlineMargin)
+		{
+		}
+
+		void runOnce()
+		{
+			if (!m_env.isUpdatePending() || m_env.isWaitingForPrimaryUnlock())
+			{
+				m_env.waitForUpdate(m_idlePollInterval);
+				return;
+			}
+
+			if (m_env.isPresentPending())
+			{
+				m_env.waitForVsyncCounter(m_env.getPresentEndVsyncCount());
+				return;
+			}
+
+			if ((m_env.now() - m_env.getQpcFlipEnd()) * 1000 / m_env.getFrequency() < 1)
+			{
+				m_env.sleep(1);
+				return;
+			}
+
+			const long long msUntilDeadline = m_env.getQpcUntilScanoutDeadline(
+				m_presentDeadlineMargin * m_env.getFrequency() / 1000) * 1000 / m_env.getFrequency();
+			if (msUntilDeadline > 0)
+			{
+				m_env.sleep(static_cast<DWORD>(msUntilDeadline));
+			}
+
+			m_env.update();
+		}
+
+	private:
+		Env& m_env;
+		DWORD m_idlePollInterval;
+		long long m_presentDeadlineMargin;
+	};
+}
@@ -9,6 +9,7 @@
 
 #include <Common/Hook.h>
 #include <Common/Log.h>
+#include <Common/SharedMetrics.h>
 #include <Common/Time.h>
 #include <D3dDdi/Hooks.h>
 #include <DDraw/DirectDraw.h>
@@ -108,6 +109,7 @@ namespace
 			Compat::Log() << "Installing Win32 hooks";
 			Win32::WaitFunctions::installHooks();
 			Gdi::VirtualScreen::init();
+			Compat::SharedMetrics::init();
 
 			CompatPtr<IDirectDraw> dd;
 			CALL_ORIG_PROC(DirectDrawCreate)(nullptr, &dd.getRef(), nullptr);
@@ -295,6 +297,7 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD fdwReason, LPVOID lpvReserved)
 			FreeLibrary(g_origDciman32Module);
 			FreeLibrary(g_origDDrawModule);
 		}
+		Compat::SharedMetrics::uninit();
 		timeEndPeriod(1);
 		Compat::Log() << "DDrawCompat detached successfully";
 	}
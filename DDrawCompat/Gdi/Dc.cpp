@@ -1,5 +1,5 @@
 #include <algorithm>
-#include <map>
+#include <atomic>
 #include <vector>
 
 #include <Common/Hook.h>
@@ -7,122 +7,99 @@
 #include <Common/ScopedCriticalSection.h>
 #include <D3dDdi/ScopedCriticalSection.h>
 #include <Gdi/Dc.h>
+#include <Gdi/DcAttributes.h>
+#include <Gdi/DcPool.h>
 #include <Gdi/Gdi.h>
-#include <Gdi/Region.h>
 #include <Gdi/VirtualScreen.h>
 #include <Gdi/Window.h>
 
 namespace
 {
-	struct Cache
-	{
-		std::vector<std::unique_ptr<HDC__, void(*)(HDC)>> cache;
-		std::vector<std::unique_ptr<HDC__, void(*)(HDC)>> defPalCache;
-	};
-
-	struct CompatDc
-	{
-		HDC dc;
-		DWORD refCount;
-		HDC origDc;
-		DWORD threadId;
-		int savedState;
-		bool useDefaultPalette;
-	};
-
-	typedef std::map<HDC, CompatDc> CompatDcMap;
-
 	Compat::CriticalSection g_cs;
-	CompatDcMap g_origDcToCompatDc;
-	std::map<DWORD, Cache> g_threadIdToDcCache;
+	std::vector<Gdi::DcPool*> g_dcPools;
+	std::atomic<UINT> g_clipGeneration = 1;
+	thread_local Gdi::DcPool* g_dcPool = nullptr;
 
-	void restoreDc(const CompatDc& compatDc);
+	void releaseObjects(Gdi::PooledDc& compatDc)
+	{
+		compatDc.attributes.font = GetStockObject(SYSTEM_FONT);
+		compatDc.attributes.brush = GetStockObject(WHITE_BRUSH);
+		compatDc.attributes.pen = GetStockObject(BLACK_PEN);
+		compatDc.attributes.palette = GetStockObject(DEFAULT_PALETTE);
+
+		SelectObject(compatDc.dc, compatDc.attributes.font);
+		SelectObject(compatDc.dc, compatDc.attributes.brush);
+		SelectObject(compatDc.dc, compatDc.attributes.pen);
+		CALL_ORIG_FUNC(SelectPalette)(compatDc.dc, static_cast<HPALETTE>(compatDc.attributes.palette), FALSE);
+	}
 
-	void copyDcAttributes(CompatDc& compatDc, HDC origDc, const POINT& origin)
+	void restoreDc(const Gdi::PooledDc& compatDc)
 	{
-		SelectObject(compatDc.dc, GetCurrentObject(origDc, OBJ_FONT));
-		SelectObject(compatDc.dc, GetCurrentObject(origDc, OBJ_BRUSH));
-		SelectObject(compatDc.dc, GetCurrentObject(origDc, OBJ_PEN));
-		CALL_ORIG_FUNC(SelectPalette)(compatDc.dc, static_cast<HPALETTE>(GetCurrentObject(origDc, OBJ_PAL)), FALSE);
+		// Bitmap may have changed during VirtualScreen::update, do not let RestoreDC restore the old one
+		HGDIOBJ bitmap = GetCurrentObject(compatDc.dc, OBJ_BITMAP);
+		CALL_ORIG_FUNC(RestoreDC)(compatDc.dc, compatDc.savedState);
+		SelectObject(compatDc.dc, bitmap);
+	}
 
-		const int graphicsMode = GetGraphicsMode(origDc);
-		SetGraphicsMode(compatDc.dc, graphicsMode);
-		if (GM_ADVANCED == graphicsMode)
+	void setClippingRegion(const Gdi::PooledDc& compatDc, HWND hwnd, const POINT& origin,
+		const RECT& virtualScreenBounds)
+	{
+		HRGN rgn = CreateRectRgn(0, 0, 0, 0);
+		GetRandomRgn(compatDc.origDc, rgn, SYSRGN);
+		if (hwnd)
 		{
-			XFORM transform = {};
-			GetWorldTransform(origDc, &transform);
-			SetWorldTransform(compatDc.dc, &transform);
+			OffsetRgn(rgn, -virtualScreenBounds.left, -virtualScreenBounds.top);
 		}
+		CALL_ORIG_FUNC(SelectClipRgn)(compatDc.dc, rgn);
 
-		const int mapMode = GetMapMode(origDc);
-		SetMapMode(compatDc.dc, mapMode);
-		if (MM_TEXT != mapMode)
+		if (1 == GetClipRgn(compatDc.origDc, rgn))
 		{
-			SIZE windowExt = {};
-			GetWindowExtEx(origDc, &windowExt);
-			SetWindowExtEx(compatDc.dc, windowExt.cx, windowExt.cy, nullptr);
-
-			SIZE viewportExt = {};
-			GetViewportExtEx(origDc, &viewportExt);
-			SetViewportExtEx(compatDc.dc, viewportExt.cx, viewportExt.cy, nullptr);
+			OffsetRgn(rgn, origin.x, origin.y);
+			CALL_ORIG_FUNC(ExtSelectClipRgn)(compatDc.dc, rgn, RGN_AND);
 		}
 
-		POINT windowOrg = {};
-		GetWindowOrgEx(origDc, &windowOrg);
-		SetWindowOrgEx(compatDc.dc, windowOrg.x, windowOrg.y, nullptr);
-
-		POINT viewportOrg = {};
-		GetViewportOrgEx(origDc, &viewportOrg);
-		SetViewportOrgEx(compatDc.dc, viewportOrg.x + origin.x, viewportOrg.y + origin.y, nullptr);
-
-		SetArcDirection(compatDc.dc, GetArcDirection(origDc));
-		SetBkColor(compatDc.dc, GetBkColor(origDc));
-		SetBkMode(compatDc.dc, GetBkMode(origDc));
-		SetDCBrushColor(compatDc.dc, GetDCBrushColor(origDc));
-		SetDCPenColor(compatDc.dc, GetDCPenColor(origDc));
-		SetLayout(compatDc.dc, GetLayout(origDc));
-		SetPolyFillMode(compatDc.dc, GetPolyFillMode(origDc));
-		SetROP2(compatDc.dc, GetROP2(origDc));
-		SetStretchBltMode(compatDc.dc, GetStretchBltMode(origDc));
-		SetTextAlign(compatDc.dc, GetTextAlign(origDc));
-		SetTextCharacterExtra(compatDc.dc, GetTextCharacterExtra(origDc));
-		SetTextColor(compatDc.dc, GetTextColor(origDc));
-
-		POINT brushOrg = {};
-		GetBrushOrgEx(origDc, &brushOrg);
-		SetBrushOrgEx(compatDc.dc, brushOrg.x, brushOrg.y, nullptr);
-
-		POINT currentPos = {};
-		GetCurrentPositionEx(origDc, &currentPos);
-		MoveToEx(compatDc.dc, currentPos.x, currentPos.y, nullptr);
+		CALL_ORIG_FUNC(SetMetaRgn)(compatDc.dc);
+		DeleteObject(rgn);
 	}
 
-	void restoreDc(const CompatDc& compatDc)
+	// Palette changes reach a compat DC only when it is handed out, so a DC already in use keeps its previous
+	// colour table until its next getDc
+	void updatePalette(Gdi::PooledDc& compatDc)
 	{
-		// Bitmap may have changed during VirtualScreen::update, do not let RestoreDC restore the old one
-		HGDIOBJ bitmap = GetCurrentObject(compatDc.dc, OBJ_BITMAP);
-		RestoreDC(compatDc.dc, compatDc.savedState);
-		SelectObject(compatDc.dc, bitmap);
+		if (!compatDc.useDefaultPalette && compatDc.paletteVersion != Gdi::VirtualScreen::getPaletteVersion())
+		{
+			compatDc.paletteVersion = Gdi::VirtualScreen::updateDcPalette(compatDc.dc);
+		}
 	}
 
-	void setClippingRegion(const CompatDc& compatDc, HWND hwnd, const POINT& origin, const RECT& virtualScreenBounds)
+	void deleteDcPool(Gdi::DcPool* dcPool)
 	{
-		Gdi::Region sysRgn;
-		GetRandomRgn(compatDc.origDc, sysRgn, SYSRGN);
-		if (hwnd)
-		{
-			OffsetRgn(sysRgn, -virtualScreenBounds.left, -virtualScreenBounds.top);
-		}
-		SelectClipRgn(compatDc.dc, sysRgn);
+		dcPool->clear(
+			[](const Gdi::PooledDc& compatDc)
+			{
+				restoreDc(compatDc);
+				Gdi::VirtualScreen::deleteDc(compatDc.dc);
+			},
+			[](const Gdi::PooledDc& compatDc) { Gdi::VirtualScreen::deleteDc(compatDc.dc); });
+		delete dcPool;
+	}
 
-		Gdi::Region clipRgn;
-		if (1 == GetClipRgn(compatDc.origDc, clipRgn))
+	Gdi::DcPool& getDcPool()
+	{
+		if (!g_dcPool)
 		{
-			OffsetRgn(clipRgn, origin.x, origin.y);
-			ExtSelectClipRgn(compatDc.dc, clipRgn, RGN_AND);
+			g_dcPool = new Gdi::DcPool();
+			Compat::ScopedCriticalSection lock(g_cs);
+			g_dcPools.push_back(g_dcPool);
 		}
+		return *g_dcPool;
+	}
 
-		SetMetaRgn(compatDc.dc);
+	void releaseCompatDc(Gdi::PooledDc& compatDc)
+	{
+		// Drawing calls such as LineTo or TA_UPDATECP text output move the current position of the compat DC
+		GetCurrentPositionEx(compatDc.dc, &compatDc.attributes.currentPos);
+		releaseObjects(compatDc);
 	}
 }
 
@@ -133,34 +110,25 @@ namespace Gdi
 		void dllProcessDetach()
 		{
 			Compat::ScopedCriticalSection lock(g_cs);
-			for (auto& origDcToCompatDc : g_origDcToCompatDc)
+			for (auto dcPool : g_dcPools)
 			{
-				restoreDc(origDcToCompatDc.second);
-				Gdi::VirtualScreen::deleteDc(origDcToCompatDc.second.dc);
+				deleteDcPool(dcPool);
 			}
-			g_origDcToCompatDc.clear();
-			g_threadIdToDcCache.clear();
+			g_dcPools.clear();
+			g_dcPool = nullptr;
 		}
 
 		void dllThreadDetach()
 		{
-			Compat::ScopedCriticalSection lock(g_cs);
-			const DWORD threadId = GetCurrentThreadId();
-			auto it = g_origDcToCompatDc.begin();
-			while (it != g_origDcToCompatDc.end())
+			if (!g_dcPool)
 			{
-				if (threadId == it->second.threadId)
-				{
-					restoreDc(it->second);
-					Gdi::VirtualScreen::deleteDc(it->second.dc);
-					it = g_origDcToCompatDc.erase(it);
-				}
-				else
-				{
-					++it;
-				}
+				return;
 			}
-			g_threadIdToDcCache.erase(GetCurrentThreadId());
+
+			Compat::ScopedCriticalSection lock(g_cs);
+			g_dcPools.erase(std::find(g_dcPools.begin(), g_dcPools.end(), g_dcPool));
+			deleteDcPool(g_dcPool);
+			g_dcPool = nullptr;
 		}
 
 		HDC getDc(HDC origDc)
@@ -170,90 +138,104 @@ namespace Gdi
 				return nullptr;
 			}
 
-			RECT virtualScreenBounds = Gdi::VirtualScreen::getBounds();
-
-			D3dDdi::ScopedCriticalSection driverLock;
-			Compat::ScopedCriticalSection lock(g_cs);
-			auto it = g_origDcToCompatDc.find(origDc);
-			if (it != g_origDcToCompatDc.end())
+			auto& dcPool = getDcPool();
+			PooledDc* inUseDc = dcPool.acquireInUse(origDc);
+			if (inUseDc)
 			{
-				++it->second.refCount;
-				return it->second.dc;
+				updatePalette(*inUseDc);
+				return inUseDc->dc;
 			}
 
-			CompatDc compatDc;
-			compatDc.useDefaultPalette = GetStockObject(DEFAULT_PALETTE) == GetCurrentObject(origDc, OBJ_PAL);
+			const bool useDefaultPalette = GetStockObject(DEFAULT_PALETTE) == GetCurrentObject(origDc, OBJ_PAL);
+			PooledDc compatDc = dcPool.takeFree(origDc, useDefaultPalette);
 
-			auto& cache = g_threadIdToDcCache[GetCurrentThreadId()];
-			auto& dcCache = compatDc.useDefaultPalette ? cache.defPalCache : cache.cache;
-			if (dcCache.empty())
-			{
-				compatDc.dc = Gdi::VirtualScreen::createDc(compatDc.useDefaultPalette);
-				if (!compatDc.dc)
-				{
-					return nullptr;
-				}
-			}
-			else
-			{
-				compatDc.dc = dcCache.back().release();
-				dcCache.pop_back();
-			}
+			const Gdi::DcAttributes attributes = Gdi::getDcAttributes(origDc);
+			const HWND origHwnd = CALL_ORIG_FUNC(WindowFromDC)(origDc);
+			POINT dcOrg = {};
+			GetDCOrgEx(origDc, &dcOrg);
 
-			POINT origin = {};
-			GetDCOrgEx(origDc, &origin);
-			HWND hwnd = CALL_ORIG_FUNC(WindowFromDC)(origDc);
-			if (hwnd)
 			{
-				if (GetDesktopWindow() == hwnd)
+				// VirtualScreen::update replaces the DC bitmaps and bumps the clip generation under the driver lock
+				D3dDdi::ScopedCriticalSection driverLock;
+				const UINT clipGeneration = g_clipGeneration;
+				if (compatDc.isValidFor(origDc, origHwnd, dcOrg, clipGeneration))
 				{
-					hwnd = nullptr;
+					Gdi::setDcAttributes(compatDc.dc, attributes, &compatDc.attributes, compatDc.origin);
 				}
 				else
 				{
-					origin.x -= virtualScreenBounds.left;
-					origin.y -= virtualScreenBounds.top;
+					if (compatDc.dc)
+					{
+						restoreDc(compatDc);
+					}
+					else
+					{
+						compatDc.dc = Gdi::VirtualScreen::createDc(useDefaultPalette);
+						if (!compatDc.dc)
+						{
+							return nullptr;
+						}
+						compatDc.useDefaultPalette = useDefaultPalette;
+					}
+
+					RECT virtualScreenBounds = Gdi::VirtualScreen::getBounds();
+					POINT origin = dcOrg;
+					HWND hwnd = origHwnd;
+					if (hwnd)
+					{
+						if (GetDesktopWindow() == hwnd)
+						{
+							hwnd = nullptr;
+						}
+						else
+						{
+							origin.x -= virtualScreenBounds.left;
+							origin.y -= virtualScreenBounds.top;
+						}
+					}
+
+					compatDc.origDc = origDc;
+					compatDc.hwnd = origHwnd;
+					compatDc.dcOrg = dcOrg;
+					compatDc.savedState = SaveDC(compatDc.dc);
+					compatDc.origin = origin;
+					compatDc.clipGeneration = clipGeneration;
+					Gdi::setDcAttributes(compatDc.dc, attributes, nullptr, origin);
+					setClippingRegion(compatDc, hwnd, origin, virtualScreenBounds);
 				}
 			}
 
+			compatDc.attributes = attributes;
 			compatDc.refCount = 1;
-			compatDc.origDc = origDc;
-			compatDc.threadId = GetCurrentThreadId();
-			compatDc.savedState = SaveDC(compatDc.dc);
-			copyDcAttributes(compatDc, origDc, origin);
-			setClippingRegion(compatDc, hwnd, origin, virtualScreenBounds);
-
-			g_origDcToCompatDc.insert(CompatDcMap::value_type(origDc, compatDc));
-
+			updatePalette(compatDc);
+			dcPool.addInUse(compatDc);
 			return compatDc.dc;
 		}
 
 		HDC getOrigDc(HDC dc)
 		{
-			Compat::ScopedCriticalSection lock(g_cs);
-			const auto it = std::find_if(g_origDcToCompatDc.begin(), g_origDcToCompatDc.end(),
-				[dc](const CompatDcMap::value_type& compatDc) { return compatDc.second.dc == dc; });
-			return it != g_origDcToCompatDc.end() ? it->first : dc;
+			if (g_dcPool)
+			{
+				HDC origDc = g_dcPool->getOrigDc(dc);
+				if (origDc)
+				{
+					return origDc;
+				}
+			}
+			return dc;
 		}
 
-		void releaseDc(HDC origDc)
+		void invalidateClipRegions()
 		{
-			Compat::ScopedCriticalSection lock(g_cs);
-			auto it = g_origDcToCompatDc.find(origDc);
-			if (it == g_origDcToCompatDc.end())
-			{
-				return;
-			}
+			++g_clipGeneration;
+		}
 
-			CompatDc& compatDc = it->second;
-			--compatDc.refCount;
-			if (0 == compatDc.refCount)
+		// Compat DCs are scope-bound (see Gdi::CompatDc), so they are always released by the thread that got them
+		void releaseDc(HDC origDc)
+		{
+			if (g_dcPool)
 			{
-				restoreDc(compatDc);
-				auto& cache = g_threadIdToDcCache[GetCurrentThreadId()];
-				auto& dcCache = compatDc.useDefaultPalette ? cache.defPalCache : cache.cache;
-				dcCache.emplace_back(compatDc.dc, Gdi::VirtualScreen::deleteDc);
-				g_origDcToCompatDc.erase(origDc);
+				g_dcPool->release(origDc, releaseCompatDc);
 			}
 		}
 	}
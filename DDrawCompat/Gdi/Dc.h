@@ -10,6 +10,7 @@ namespace Gdi
 		void dllThreadDetach();
 		HDC getDc(HDC origDc);
 		HDC getOrigDc(HDC dc);
+		void invalidateClipRegions();
 		void releaseDc(HDC origDc);
 	}
 }
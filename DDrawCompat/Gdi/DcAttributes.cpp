@@ -0,0 +1,164 @@
+#include <cstring>
+
+#include <Common/Hook.h>
+#include <Gdi/DcAttributes.h>
+
+namespace Gdi
+{
+	DcAttributes getDcAttributes(HDC dc)
+	{
+		DcAttributes attributes = {};
+		attributes.font = GetCurrentObject(dc, OBJ_FONT);
+		attributes.brush = GetCurrentObject(dc, OBJ_BRUSH);
+		attributes.pen = GetCurrentObject(dc, OBJ_PEN);
+		attributes.palette = GetCurrentObject(dc, OBJ_PAL);
+
+		attributes.graphicsMode = GetGraphicsMode(dc);
+		if (GM_ADVANCED == attributes.graphicsMode)
+		{
+			GetWorldTransform(dc, &attributes.transform);
+		}
+
+		attributes.mapMode = GetMapMode(dc);
+		if (MM_TEXT != attributes.mapMode)
+		{
+			GetWindowExtEx(dc, &attributes.windowExt);
+			GetViewportExtEx(dc, &attributes.viewportExt);
+		}
+
+		GetWindowOrgEx(dc, &attributes.windowOrg);
+		GetViewportOrgEx(dc, &attributes.viewportOrg);
+		attributes.arcDirection = GetArcDirection(dc);
+		attributes.bkColor = GetBkColor(dc);
+		attributes.bkMode = GetBkMode(dc);
+		attributes.dcBrushColor = GetDCBrushColor(dc);
+		attributes.dcPenColor = GetDCPenColor(dc);
+		attributes.layout = GetLayout(dc);
+		attributes.polyFillMode = GetPolyFillMode(dc);
+		attributes.rop2 = GetROP2(dc);
+		attributes.stretchBltMode = GetStretchBltMode(dc);
+		attributes.textAlign = GetTextAlign(dc);
+		attributes.textCharacterExtra = GetTextCharacterExtra(dc);
+		attributes.textColor = GetTextColor(dc);
+		GetBrushOrgEx(dc, &attributes.brushOrg);
+		GetCurrentPositionEx(dc, &attributes.currentPos);
+		return attributes;
+	}
+
+#define IS_CHANGED(member) (!prev || 0 != std::memcmp(&prev->member, &attributes.member, sizeof(attributes.member)))
+
+	void setDcAttributes(HDC dc, const DcAttributes& attributes, const DcAttributes* prev, const POINT& origin)
+	{
+		if (IS_CHANGED(font))
+		{
+			SelectObject(dc, attributes.font);
+		}
+		if (IS_CHANGED(brush))
+		{
+			SelectObject(dc, attributes.brush);
+		}
+		if (IS_CHANGED(pen))
+		{
+			SelectObject(dc, attributes.pen);
+		}
+		if (IS_CHANGED(palette))
+		{
+			CALL_ORIG_FUNC(SelectPalette)(dc, static_cast<HPALETTE>(attributes.palette), FALSE);
+		}
+
+		if (IS_CHANGED(graphicsMode) || IS_CHANGED(transform))
+		{
+			if (GM_ADVANCED == attributes.graphicsMode)
+			{
+				SetGraphicsMode(dc, GM_ADVANCED);
+				SetWorldTransform(dc, &attributes.transform);
+			}
+			else
+			{
+				if (prev && GM_ADVANCED == prev->graphicsMode)
+				{
+					ModifyWorldTransform(dc, nullptr, MWT_IDENTITY);
+				}
+				SetGraphicsMode(dc, attributes.graphicsMode);
+			}
+		}
+
+		if (IS_CHANGED(mapMode) || IS_CHANGED(windowExt) || IS_CHANGED(viewportExt))
+		{
+			SetMapMode(dc, attributes.mapMode);
+			if (MM_TEXT != attributes.mapMode)
+			{
+				SetWindowExtEx(dc, attributes.windowExt.cx, attributes.windowExt.cy, nullptr);
+				SetViewportExtEx(dc, attributes.viewportExt.cx, attributes.viewportExt.cy, nullptr);
+			}
+		}
+
+		if (IS_CHANGED(windowOrg))
+		{
+			SetWindowOrgEx(dc, attributes.windowOrg.x, attributes.windowOrg.y, nullptr);
+		}
+		if (IS_CHANGED(viewportOrg))
+		{
+			SetViewportOrgEx(dc, attributes.viewportOrg.x + origin.x, attributes.viewportOrg.y + origin.y, nullptr);
+		}
+
+		if (IS_CHANGED(arcDirection))
+		{
+			SetArcDirection(dc, attributes.arcDirection);
+		}
+		if (IS_CHANGED(bkColor))
+		{
+			SetBkColor(dc, attributes.bkColor);
+		}
+		if (IS_CHANGED(bkMode))
+		{
+			SetBkMode(dc, attributes.bkMode);
+		}
+		if (IS_CHANGED(dcBrushColor))
+		{
+			SetDCBrushColor(dc, attributes.dcBrushColor);
+		}
+		if (IS_CHANGED(dcPenColor))
+		{
+			SetDCPenColor(dc, attributes.dcPenColor);
+		}
+		if (IS_CHANGED(layout))
+		{
+			SetLayout(dc, attributes.layout);
+		}
+		if (IS_CHANGED(polyFillMode))
+		{
+			SetPolyFillMode(dc, attributes.polyFillMode);
+		}
+		if (IS_CHANGED(rop2))
+		{
+			SetROP2(dc, attributes.rop2);
+		}
+		if (IS_CHANGED(stretchBltMode))
+		{
+			SetStretchBltMode(dc, attributes.stretchBltMode);
+		}
+		if (IS_CHANGED(textAlign))
+		{
+			SetTextAlign(dc, attributes.textAlign);
+		}
+		if (IS_CHANGED(textCharacterExtra))
+		{
+			SetTextCharacterExtra(dc, attributes.textCharacterExtra);
+		}
+		if (IS_CHANGED(textColor))
+		{
+			SetTextColor(dc, attributes.textColor);
+		}
+		if (IS_CHANGED(brushOrg))
+		{
+			SetBrushOrgEx(dc, attributes.brushOrg.x, attributes.brushOrg.y, nullptr);
+		}
+		if (IS_CHANGED(currentPos))
+		{
+			MoveToEx(dc, attributes.currentPos.x, attributes.currentPos.y, nullptr);
+		}
+	}
+
+#undef IS_CHANGED
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Windows.h>
+
+namespace Gdi
+{
+	struct DcAttributes
+	{
+		HGDIOBJ font;
+		HGDIOBJ brush;
+		HGDIOBJ pen;
+		HGDIOBJ palette;
+		int graphicsMode;
+		XFORM transform;
+		int mapMode;
+		SIZE windowExt;
+		SIZE viewportExt;
+		POINT windowOrg;
+		POINT viewportOrg;
+		int arcDirection;
+		COLORREF bkColor;
+		int bkMode;
+		COLORREF dcBrushColor;
+		COLORREF dcPenColor;
+		DWORD layout;
+		int polyFillMode;
+		int rop2;
+		int stretchBltMode;
+		UINT textAlign;
+		int textCharacterExtra;
+		COLORREF textColor;
+		POINT brushOrg;
+		POINT currentPos;
+	};
+
+	DcAttributes getDcAttributes(HDC dc);
+	void setDcAttributes(HDC dc, const DcAttributes& attributes, const DcAttributes* prev, const POINT& origin);
+}
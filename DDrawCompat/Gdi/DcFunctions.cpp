@@ -5,6 +5,7 @@
 #include <Gdi/CompatDc.h>
 #include <Gdi/Dc.h>
 #include <Gdi/DcFunctions.h>
+#include <Gdi/DisplayDcCache.h>
 #include <Gdi/Font.h>
 #include <Gdi/Gdi.h>
 #include <Gdi/Region.h>
@@ -58,7 +59,7 @@ namespace
 
 	bool hasDisplayDcArg(HDC dc)
 	{
-		return Gdi::isDisplayDc(dc);
+		return Gdi::DisplayDcCache::isDisplayDc(dc);
 	}
 
 	template <typename T>
@@ -164,6 +165,17 @@ namespace
 		return LOG_RESULT(TRUE);
 	}
 
+	template <typename OrigFuncPtr, OrigFuncPtr origFunc, typename Result, typename... Params>
+	Result WINAPI clipDcFunc(HDC hdc, Params... params)
+	{
+#ifdef DEBUGLOGS
+		LOG_FUNC(g_funcNames[origFunc], hdc, params...);
+#endif
+
+		Gdi::Dc::invalidateClipRegions();
+		return LOG_RESULT(Compat::getOrigFuncPtr<OrigFuncPtr, origFunc>()(hdc, params...));
+	}
+
 	template <typename OrigFuncPtr, OrigFuncPtr origFunc, typename Result, typename... Params>
 	Result WINAPI compatGdiTextDcFunc(HDC dc, Params... params)
 	{
@@ -171,10 +183,18 @@ namespace
 		return compatGdiDcFunc<OrigFuncPtr, origFunc, Result>(dc, params...);
 	}
 
+	HDC WINAPI beginPaint(HWND hWnd, LPPAINTSTRUCT lpPaint)
+	{
+		LOG_FUNC("BeginPaint", hWnd, lpPaint);
+		HDC dc = CALL_ORIG_FUNC(BeginPaint)(hWnd, lpPaint);
+		Gdi::DisplayDcCache::invalidate(dc);
+		return LOG_RESULT(dc);
+	}
+
 	HBITMAP WINAPI createCompatibleBitmap(HDC hdc, int cx, int cy)
 	{
 		LOG_FUNC("CreateCompatibleBitmap", hdc, cx, cy);
-		if (!g_disableDibRedirection && Gdi::isDisplayDc(hdc))
+		if (!g_disableDibRedirection && Gdi::DisplayDcCache::isDisplayDc(hdc))
 		{
 			const bool useDefaultPalette = false;
 			return LOG_RESULT(Gdi::VirtualScreen::createOffScreenDib(cx, cy, useDefaultPalette));
@@ -182,12 +202,36 @@ namespace
 		return LOG_RESULT(CALL_ORIG_FUNC(CreateCompatibleBitmap)(hdc, cx, cy));
 	}
 
+	HDC WINAPI createCompatibleDc(HDC hdc)
+	{
+		LOG_FUNC("CreateCompatibleDC", hdc);
+		HDC dc = CALL_ORIG_FUNC(CreateCompatibleDC)(hdc);
+		Gdi::DisplayDcCache::invalidate(dc);
+		return LOG_RESULT(dc);
+	}
+
+	HDC WINAPI createDcA(LPCSTR pwszDriver, LPCSTR pwszDevice, LPCSTR pszPort, const DEVMODEA* pdm)
+	{
+		LOG_FUNC("CreateDCA", pwszDriver, pwszDevice, pszPort, pdm);
+		HDC dc = CALL_ORIG_FUNC(CreateDCA)(pwszDriver, pwszDevice, pszPort, pdm);
+		Gdi::DisplayDcCache::invalidate(dc);
+		return LOG_RESULT(dc);
+	}
+
+	HDC WINAPI createDcW(LPCWSTR pwszDriver, LPCWSTR pwszDevice, LPCWSTR pszPort, const DEVMODEW* pdm)
+	{
+		LOG_FUNC("CreateDCW", pwszDriver, pwszDevice, pszPort, pdm);
+		HDC dc = CALL_ORIG_FUNC(CreateDCW)(pwszDriver, pwszDevice, pszPort, pdm);
+		Gdi::DisplayDcCache::invalidate(dc);
+		return LOG_RESULT(dc);
+	}
+
 	HBITMAP WINAPI createDIBitmap(HDC hdc, const BITMAPINFOHEADER* lpbmih, DWORD fdwInit,
 		const void* lpbInit, const BITMAPINFO* lpbmi, UINT fuUsage)
 	{
 		LOG_FUNC("CreateDIBitmap", hdc, lpbmih, fdwInit, lpbInit, lpbmi, fuUsage);
 		const DWORD CBM_CREATDIB = 2;
-		if (!g_disableDibRedirection && !(fdwInit & CBM_CREATDIB) && lpbmih && Gdi::isDisplayDc(hdc))
+		if (!g_disableDibRedirection && !(fdwInit & CBM_CREATDIB) && lpbmih && Gdi::DisplayDcCache::isDisplayDc(hdc))
 		{
 			const bool useDefaultPalette = false;
 			HBITMAP bitmap = Gdi::VirtualScreen::createOffScreenDib(
@@ -204,7 +248,7 @@ namespace
 	HBITMAP WINAPI createDiscardableBitmap(HDC hdc, int nWidth, int nHeight)
 	{
 		LOG_FUNC("CreateDiscardableBitmap", hdc, nWidth, nHeight);
-		if (!g_disableDibRedirection && Gdi::isDisplayDc(hdc))
+		if (!g_disableDibRedirection && Gdi::DisplayDcCache::isDisplayDc(hdc))
 		{
 			const bool useDefaultPalette = false;
 			return LOG_RESULT(Gdi::VirtualScreen::createOffScreenDib(nWidth, nHeight, useDefaultPalette));
@@ -212,16 +256,39 @@ namespace
 		return LOG_RESULT(CALL_ORIG_FUNC(createDiscardableBitmap)(hdc, nWidth, nHeight));
 	}
 
+	BOOL WINAPI deleteDc(HDC hdc)
+	{
+		LOG_FUNC("DeleteDC", hdc);
+		Gdi::DisplayDcCache::invalidate(hdc);
+		return LOG_RESULT(CALL_ORIG_FUNC(DeleteDC)(hdc));
+	}
+
 	BOOL WINAPI drawCaption(HWND hwnd, HDC hdc, const RECT* lprect, UINT flags)
 	{
 		LOG_FUNC("DrawCaption", hwnd, hdc, lprect, flags);
-		if (Gdi::isDisplayDc(hdc))
+		if (Gdi::DisplayDcCache::isDisplayDc(hdc))
 		{
 			return LOG_RESULT(CALL_ORIG_FUNC(DrawCaption)(hwnd, Gdi::CompatDc(hdc), lprect, flags));
 		}
 		return LOG_RESULT(CALL_ORIG_FUNC(DrawCaption)(hwnd, hdc, lprect, flags));
 	}
 
+	BOOL WINAPI endPaint(HWND hWnd, const PAINTSTRUCT* lpPaint)
+	{
+		LOG_FUNC("EndPaint", hWnd, lpPaint);
+		if (lpPaint)
+		{
+			Gdi::DisplayDcCache::invalidate(lpPaint->hdc);
+		}
+		return LOG_RESULT(CALL_ORIG_FUNC(EndPaint)(hWnd, lpPaint));
+	}
+
+	template <typename OrigFuncPtr, OrigFuncPtr origFunc, typename Result, typename... Params>
+	OrigFuncPtr getClipDcFuncPtr(FuncPtr<Result, HDC, Params...>)
+	{
+		return &clipDcFunc<OrigFuncPtr, origFunc, Result, Params...>;
+	}
+
 	template <typename OrigFuncPtr, OrigFuncPtr origFunc, typename Result, typename... Params>
 	OrigFuncPtr getCompatGdiDcFuncPtr(FuncPtr<Result, HDC, Params...>)
 	{
@@ -234,6 +301,41 @@ namespace
 		return &compatGdiTextDcFunc<OrigFuncPtr, origFunc, Result, Params...>;
 	}
 
+	HDC WINAPI getDc(HWND hWnd)
+	{
+		LOG_FUNC("GetDC", hWnd);
+		HDC dc = CALL_ORIG_FUNC(GetDC)(hWnd);
+		Gdi::DisplayDcCache::invalidate(dc);
+		return LOG_RESULT(dc);
+	}
+
+	HDC WINAPI getDcEx(HWND hWnd, HRGN hrgnClip, DWORD flags)
+	{
+		LOG_FUNC("GetDCEx", hWnd, hrgnClip, flags);
+		HDC dc = CALL_ORIG_FUNC(GetDCEx)(hWnd, hrgnClip, flags);
+		Gdi::DisplayDcCache::invalidate(dc);
+		return LOG_RESULT(dc);
+	}
+
+	HDC WINAPI getWindowDc(HWND hWnd)
+	{
+		LOG_FUNC("GetWindowDC", hWnd);
+		HDC dc = CALL_ORIG_FUNC(GetWindowDC)(hWnd);
+		Gdi::DisplayDcCache::invalidate(dc);
+		return LOG_RESULT(dc);
+	}
+
+	template <typename OrigFuncPtr, OrigFuncPtr origFunc>
+	void hookClipDcFunction(const char* moduleName, const char* funcName)
+	{
+#ifdef DEBUGLOGS
+		g_funcNames[origFunc] = funcName;
+#endif
+
+		Compat::hookFunction<OrigFuncPtr, origFunc>(
+			moduleName, funcName, getClipDcFuncPtr<OrigFuncPtr, origFunc>(origFunc));
+	}
+
 	template <typename OrigFuncPtr, OrigFuncPtr origFunc>
 	void hookGdiDcFunction(const char* moduleName, const char* funcName)
 	{
@@ -256,12 +358,22 @@ namespace
 			moduleName, funcName, getCompatGdiTextDcFuncPtr<OrigFuncPtr, origFunc>(origFunc));
 	}
 
+	int WINAPI releaseDc(HWND hWnd, HDC hDC)
+	{
+		LOG_FUNC("ReleaseDC", hWnd, hDC);
+		Gdi::DisplayDcCache::invalidate(hDC);
+		return LOG_RESULT(CALL_ORIG_FUNC(ReleaseDC)(hWnd, hDC));
+	}
+
 	HWND WINAPI windowFromDc(HDC dc)
 	{
 		return CALL_ORIG_FUNC(WindowFromDC)(Gdi::Dc::getOrigDc(dc));
 	}
 }
 
+#define HOOK_CLIP_DC_FUNCTION(module, func) \
+	hookClipDcFunction<decltype(&func), &func>(#module, #func)
+
 #define HOOK_GDI_DC_FUNCTION(module, func) \
 	hookGdiDcFunction<decltype(&func), &func>(#module, #func)
 
@@ -278,6 +390,11 @@ namespace Gdi
 			g_disableDibRedirection += disable ? 1 : -1;
 		}
 
+		void onStyleChanged()
+		{
+			Gdi::DisplayDcCache::invalidate();
+		}
+
 		void installHooks()
 		{
 			// Bitmap functions
@@ -301,11 +418,29 @@ namespace Gdi
 			HOOK_GDI_DC_FUNCTION(gdi32, StretchDIBits);
 			HOOK_GDI_DC_FUNCTION(msimg32, TransparentBlt);
 
+			// Clipping functions
+			HOOK_CLIP_DC_FUNCTION(gdi32, ExcludeClipRect);
+			HOOK_CLIP_DC_FUNCTION(gdi32, ExtSelectClipRgn);
+			HOOK_CLIP_DC_FUNCTION(gdi32, IntersectClipRect);
+			HOOK_CLIP_DC_FUNCTION(gdi32, OffsetClipRgn);
+			HOOK_CLIP_DC_FUNCTION(gdi32, SelectClipPath);
+			HOOK_CLIP_DC_FUNCTION(gdi32, SelectClipRgn);
+			HOOK_CLIP_DC_FUNCTION(gdi32, SetMetaRgn);
+
 			// Brush functions
 			HOOK_GDI_DC_FUNCTION(gdi32, PatBlt);
 
 			// Device context functions
+			HOOK_FUNCTION(gdi32, CreateCompatibleDC, createCompatibleDc);
+			HOOK_FUNCTION(gdi32, CreateDCA, createDcA);
+			HOOK_FUNCTION(gdi32, CreateDCW, createDcW);
+			HOOK_FUNCTION(gdi32, DeleteDC, deleteDc);
 			HOOK_GDI_DC_FUNCTION(gdi32, DrawEscape);
+			HOOK_CLIP_DC_FUNCTION(gdi32, RestoreDC);
+			HOOK_FUNCTION(user32, GetDC, getDc);
+			HOOK_FUNCTION(user32, GetDCEx, getDcEx);
+			HOOK_FUNCTION(user32, GetWindowDC, getWindowDc);
+			HOOK_FUNCTION(user32, ReleaseDC, releaseDc);
 			HOOK_FUNCTION(user32, WindowFromDC, windowFromDc);
 
 			// Filled shape functions
@@ -345,10 +480,12 @@ namespace Gdi
 			HOOK_GDI_DC_FUNCTION(gdi32, PolyPolyline);
 
 			// Painting and drawing functions
+			HOOK_FUNCTION(user32, BeginPaint, beginPaint);
 			HOOK_FUNCTION(user32, DrawCaption, drawCaption);
 			HOOK_GDI_DC_FUNCTION(user32, DrawEdge);
 			HOOK_GDI_DC_FUNCTION(user32, DrawFocusRect);
 			HOOK_GDI_DC_FUNCTION(user32, DrawFrameControl);
+			HOOK_FUNCTION(user32, EndPaint, endPaint);
 			HOOK_GDI_TEXT_DC_FUNCTION(user32, DrawState);
 			HOOK_GDI_TEXT_DC_FUNCTION(user32, GrayString);
 			HOOK_GDI_DC_FUNCTION(user32, PaintDesktop);
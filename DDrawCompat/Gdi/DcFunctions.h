@@ -7,5 +7,6 @@ namespace Gdi
 		void disableDibRedirection(bool disable);
 
 		void installHooks();
+		void onStyleChanged();
 	}
 }
@@ -0,0 +1,54 @@
+#include <algorithm>
+
+#include <Gdi/DcPool.h>
+
+namespace Gdi
+{
+	bool PooledDc::isValidFor(HDC origDc, HWND hwnd, const POINT& dcOrg, UINT clipGeneration) const
+	{
+		return this->origDc == origDc && this->hwnd == hwnd && this->clipGeneration == clipGeneration &&
+			this->dcOrg.x == dcOrg.x && this->dcOrg.y == dcOrg.y;
+	}
+
+	PooledDc* DcPool::acquireInUse(HDC origDc)
+	{
+		auto it = m_origDcToCompatDc.find(origDc);
+		if (it == m_origDcToCompatDc.end())
+		{
+			return nullptr;
+		}
+		++it->second.refCount;
+		return &it->second;
+	}
+
+	void DcPool::addInUse(const PooledDc& pooledDc)
+	{
+		m_compatDcToOrigDc[pooledDc.dc] = pooledDc.origDc;
+		m_origDcToCompatDc[pooledDc.origDc] = pooledDc;
+	}
+
+	HDC DcPool::getOrigDc(HDC dc) const
+	{
+		auto it = m_compatDcToOrigDc.find(dc);
+		return it != m_compatDcToOrigDc.end() ? it->second : nullptr;
+	}
+
+	PooledDc DcPool::takeFree(HDC origDc, bool useDefaultPalette)
+	{
+		auto& freeList = getFreeList(useDefaultPalette);
+		auto it = std::find_if(freeList.begin(), freeList.end(),
+			[origDc](const PooledDc& pooledDc) { return pooledDc.origDc == origDc; });
+		if (it == freeList.end() && !freeList.empty())
+		{
+			it = freeList.end() - 1;
+		}
+
+		PooledDc pooledDc = {};
+		if (it != freeList.end())
+		{
+			pooledDc = *it;
+			freeList.erase(it);
+		}
+		return pooledDc;
+	}
+}
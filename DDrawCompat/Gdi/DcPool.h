@@ -0,0 +1,92 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include <Windows.h>
+
+#include <Gdi/DcAttributes.h>
+
+namespace Gdi
+{
+	struct PooledDc
+	{
+		HDC dc;
+		DWORD refCount;
+		HDC origDc;
+		HWND hwnd;
+		int savedState;
+		bool useDefaultPalette;
+		DcAttributes attributes;
+		POINT dcOrg;
+		POINT origin;
+		UINT clipGeneration;
+		UINT paletteVersion;
+
+		bool isValidFor(HDC origDc, HWND hwnd, const POINT& dcOrg, UINT clipGeneration) const;
+	};
+
+	// Compat DCs owned by a single thread, either in use for an original DC or free for reuse
+	class DcPool
+	{
+	public:
+		PooledDc* acquireInUse(HDC origDc);
+		void addInUse(const PooledDc& pooledDc);
+		HDC getOrigDc(HDC dc) const;
+		PooledDc takeFree(HDC origDc, bool useDefaultPalette);
+
+		template <typename InUseFunc, typename FreeFunc>
+		void clear(InUseFunc inUseFunc, FreeFunc freeFunc)
+		{
+			for (auto& origDcToCompatDc : m_origDcToCompatDc)
+			{
+				inUseFunc(origDcToCompatDc.second);
+			}
+			for (auto& pooledDc : m_free)
+			{
+				freeFunc(pooledDc);
+			}
+			for (auto& pooledDc : m_defPalFree)
+			{
+				freeFunc(pooledDc);
+			}
+			m_origDcToCompatDc.clear();
+			m_compatDcToOrigDc.clear();
+			m_free.clear();
+			m_defPalFree.clear();
+		}
+
+		// Returns false if origDc has no compat DC in use. onFree is called before the last reference is released.
+		template <typename OnFree>
+		bool release(HDC origDc, OnFree onFree)
+		{
+			auto it = m_origDcToCompatDc.find(origDc);
+			if (it == m_origDcToCompatDc.end())
+			{
+				return false;
+			}
+
+			PooledDc& pooledDc = it->second;
+			--pooledDc.refCount;
+			if (0 == pooledDc.refCount)
+			{
+				onFree(pooledDc);
+				getFreeList(pooledDc.useDefaultPalette).push_back(pooledDc);
+				m_compatDcToOrigDc.erase(pooledDc.dc);
+				m_origDcToCompatDc.erase(it);
+			}
+			return true;
+		}
+
+	private:
+		std::vector<PooledDc>& getFreeList(bool useDefaultPalette)
+		{
+			return useDefaultPalette ? m_defPalFree : m_free;
+		}
+
+		std::unordered_map<HDC, PooledDc> m_origDcToCompatDc;
+		std::unordered_map<HDC, HDC> m_compatDcToOrigDc;
+		std::vector<PooledDc> m_free;
+		std::vector<PooledDc> m_defPalFree;
+	};
+}
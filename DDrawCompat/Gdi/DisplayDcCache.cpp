@@ -0,0 +1,77 @@
+#include <atomic>
+
+#include <Gdi/DisplayDcCache.h>
+#include <Gdi/Gdi.h>
+
+namespace
+{
+	const UINT SLOT_COUNT = 64;
+
+	struct Entry
+	{
+		HDC dc;
+		UINT epoch;
+		bool isDisplayDc;
+	};
+
+	struct Cache
+	{
+		UINT generation;
+		Entry entries[SLOT_COUNT];
+	};
+
+	std::atomic<UINT> g_generation = 1;
+	std::atomic<UINT> g_epochs[SLOT_COUNT];
+	thread_local Cache g_cache = {};
+
+	UINT getSlot(HDC dc)
+	{
+		return (reinterpret_cast<UINT_PTR>(dc) >> 2) % SLOT_COUNT;
+	}
+}
+
+namespace Gdi
+{
+	namespace DisplayDcCache
+	{
+		void invalidate()
+		{
+			++g_generation;
+		}
+
+		void invalidate(HDC dc)
+		{
+			if (dc)
+			{
+				++g_epochs[getSlot(dc)];
+			}
+		}
+
+		bool isDisplayDc(HDC dc)
+		{
+			if (!dc)
+			{
+				return false;
+			}
+
+			auto& cache = g_cache;
+			const UINT generation = g_generation;
+			if (cache.generation != generation)
+			{
+				cache = {};
+				cache.generation = generation;
+			}
+
+			const UINT slot = getSlot(dc);
+			const UINT epoch = g_epochs[slot];
+			auto& entry = cache.entries[slot];
+			if (entry.dc != dc || entry.epoch != epoch)
+			{
+				entry.dc = dc;
+				entry.epoch = epoch;
+				entry.isDisplayDc = Gdi::isDisplayDc(dc);
+			}
+			return entry.isDisplayDc;
+		}
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <Windows.h>
+
+namespace Gdi
+{
+	namespace DisplayDcCache
+	{
+		void invalidate();
+		void invalidate(HDC dc);
+		bool isDisplayDc(HDC dc);
+	}
+}
@@ -1,10 +1,45 @@
 #include <Common/Hook.h>
 #include <Common/Log.h>
+#include <Common/ScopedSrwLock.h>
 #include <Gdi/Font.h>
+#include <Gdi/SubstituteFontCache.h>
 
 namespace
 {
+	struct FontFactory
+	{
+		static bool createSubstitute(HFONT origFont, HFONT& substituteFont)
+		{
+			LOGFONT logFont = {};
+			if (!GetObject(origFont, sizeof(logFont), &logFont))
+			{
+				return false;
+			}
+
+			switch (logFont.lfQuality)
+			{
+			case NONANTIALIASED_QUALITY:
+			case ANTIALIASED_QUALITY:
+			case CLEARTYPE_QUALITY:
+			case CLEARTYPE_NATURAL_QUALITY:
+				substituteFont = nullptr;
+				return true;
+			}
+
+			logFont.lfQuality = NONANTIALIASED_QUALITY;
+			substituteFont = CreateFontIndirect(&logFont);
+			return nullptr != substituteFont;
+		}
+
+		static void deleteFont(HFONT font)
+		{
+			CALL_ORIG_FUNC(DeleteObject)(font);
+		}
+	};
+
 	BOOL g_isFontSmoothingEnabled = FALSE;
+	Compat::SrwLock g_srwLock;
+	Gdi::SubstituteFontCache<FontFactory> g_substituteFontCache;
 
 	BOOL WINAPI systemParametersInfo(UINT uiAction, UINT uiParam, PVOID pvParam, UINT fWinIni,
 		decltype(&SystemParametersInfoA) origSystemParametersInfo, [[maybe_unused]] const char* origFuncName)
@@ -43,7 +78,7 @@ namespace Gdi
 {
 	namespace Font
 	{
-		Mapper::Mapper(HDC dc) : m_dc(dc), m_origFont(nullptr)
+		Mapper::Mapper(HDC dc) : m_dc(dc), m_origFont(nullptr), m_substituteFont(nullptr)
 		{
 			if (!dc || g_isFontSmoothingEnabled)
 			{
@@ -56,26 +91,24 @@ namespace Gdi
 				return;
 			}
 
-			LOGFONT logFont = {};
-			GetObject(origFont, sizeof(logFont), &logFont);
-			switch (logFont.lfQuality)
 			{
-			case NONANTIALIASED_QUALITY:
-			case ANTIALIASED_QUALITY:
-			case CLEARTYPE_QUALITY:
-			case CLEARTYPE_NATURAL_QUALITY:
-				return;
+				Compat::ScopedSrwLockExclusive lock(g_srwLock);
+				m_substituteFont = g_substituteFontCache.acquire(origFont);
+			}
+			if (m_substituteFont)
+			{
+				m_origFont = origFont;
+				SelectObject(dc, m_substituteFont);
 			}
-
-			logFont.lfQuality = NONANTIALIASED_QUALITY;
-			m_origFont = static_cast<HFONT>(SelectObject(dc, CreateFontIndirect(&logFont)));
 		}
 
 		Mapper::~Mapper()
 		{
-			if (m_origFont)
+			if (m_substituteFont)
 			{
-				DeleteObject(SelectObject(m_dc, m_origFont));
+				SelectObject(m_dc, m_origFont);
+				Compat::ScopedSrwLockExclusive lock(g_srwLock);
+				g_substituteFontCache.release(m_origFont, m_substituteFont);
 			}
 		}
 
@@ -103,5 +136,11 @@ namespace Gdi
 		{
 			return g_isFontSmoothingEnabled;
 		}
+
+		void onDeleteFont(HFONT font)
+		{
+			Compat::ScopedSrwLockExclusive lock(g_srwLock);
+			g_substituteFontCache.onDeleteFont(font);
+		}
 	}
 }
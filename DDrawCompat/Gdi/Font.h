@@ -15,8 +15,10 @@ namespace Gdi
 		private:
 			HDC m_dc;
 			HFONT m_origFont;
+			HFONT m_substituteFont;
 		};
 
 		void installHooks();
+		void onDeleteFont(HFONT font);
 	}
 }
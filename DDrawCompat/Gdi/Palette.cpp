@@ -1,10 +1,13 @@
+#include <atomic>
 #include <map>
 
 #include <Common/Hook.h>
 #include <Common/Log.h>
 #include <Common/ScopedSrwLock.h>
+#include <Gdi/Font.h>
 #include <Gdi/Gdi.h>
 #include <Gdi/Palette.h>
+#include <Gdi/PaletteColorIndex.h>
 #include <Gdi/VirtualScreen.h>
 #include <Win32/DisplayMode.h>
 
@@ -33,36 +36,70 @@ namespace
 
 	std::map<HPALETTE, PaletteInfo> g_paletteInfo;
 
-	bool isSameColor(PALETTEENTRY entry1, PALETTEENTRY entry2)
+	Gdi::PaletteColorIndex g_colorIndex;
+	bool g_isColorIndexValid = false;
+
+	std::shared_ptr<const Gdi::Palette::Snapshot> g_hardwarePaletteSnapshot(
+		std::make_shared<Gdi::Palette::Snapshot>());
+	std::shared_ptr<const Gdi::Palette::Snapshot> g_systemPaletteSnapshot(
+		std::make_shared<Gdi::Palette::Snapshot>());
+	std::atomic<UINT> g_paletteVersion = 0;
+
+	void addColor(PALETTEENTRY entry)
 	{
-		return entry1.peRed == entry2.peRed &&
-			entry1.peGreen == entry2.peGreen &&
-			entry1.peBlue == entry2.peBlue;
+		if (g_isColorIndexValid)
+		{
+			g_colorIndex.add(entry);
+		}
 	}
 
-	bool exactMatch(PALETTEENTRY entry)
+	void rebuildColorIndex()
 	{
+		g_colorIndex.clear();
+		g_isColorIndexValid = true;
+
 		for (UINT i = 0; i < g_systemPaletteFirstUnusedIndex; ++i)
 		{
-			if (isSameColor(entry, g_systemPalette[i]))
-			{
-				return true;
-			}
+			addColor(g_systemPalette[i]);
 		}
 
 		for (UINT i = g_systemPaletteLastNonReservedIndex + 1; i < 256; ++i)
 		{
-			if (isSameColor(entry, g_systemPalette[i]))
-			{
-				return true;
-			}
+			addColor(g_systemPalette[i]);
 		}
+	}
 
-		return false;
+	void publishPalette(std::shared_ptr<const Gdi::Palette::Snapshot>& snapshot, const PALETTEENTRY(&entries)[256])
+	{
+		if (0 == std::memcmp(std::atomic_load(&snapshot)->entries, entries, sizeof(entries)))
+		{
+			return;
+		}
+
+		auto newSnapshot(std::make_shared<Gdi::Palette::Snapshot>());
+		newSnapshot->version = ++g_paletteVersion;
+		std::memcpy(newSnapshot->entries, entries, sizeof(entries));
+		std::atomic_store(&snapshot, std::shared_ptr<const Gdi::Palette::Snapshot>(std::move(newSnapshot)));
+	}
+
+	void publishPalettes()
+	{
+		publishPalette(g_systemPaletteSnapshot, g_systemPalette);
+		publishPalette(g_hardwarePaletteSnapshot, g_hardwarePalette);
+	}
+
+	bool exactMatch(PALETTEENTRY entry)
+	{
+		if (!g_isColorIndexValid)
+		{
+			rebuildColorIndex();
+		}
+		return g_colorIndex.contains(entry);
 	}
 
 	void updateStaticSysPalEntries()
 	{
+		g_isColorIndexValid = false;
 		const UINT count = g_systemPaletteFirstNonReservedIndex;
 		if (0 == count)
 		{
@@ -72,13 +109,20 @@ namespace
 		std::memcpy(g_systemPalette, g_defaultPalette, count * sizeof(g_systemPalette[0]));
 		std::memcpy(&g_systemPalette[256 - count], &g_defaultPalette[256 - count], count * sizeof(g_systemPalette[0]));
 		std::memcpy(g_hardwarePalette, g_systemPalette, sizeof(g_hardwarePalette));
+		publishPalettes();
 		Gdi::VirtualScreen::updatePalette(g_systemPalette);
 	}
 
 	BOOL WINAPI deleteObject(HGDIOBJ ho)
 	{
+		const DWORD type = GetObjectType(ho);
+		if (OBJ_FONT == type)
+		{
+			Gdi::Font::onDeleteFont(static_cast<HFONT>(ho));
+		}
+
 		BOOL result = CALL_ORIG_FUNC(DeleteObject)(ho);
-		if (result && OBJ_PAL == GetObjectType(ho))
+		if (result && OBJ_PAL == type)
 		{
 			Compat::ScopedSrwLockExclusive lock(g_srwLock);
 			g_paletteInfo.erase(static_cast<HPALETTE>(ho));
@@ -109,8 +153,8 @@ namespace
 			nEntries = 256 - iStartIndex;
 		}
 
-		Compat::ScopedSrwLockShared lock(g_srwLock);
-		std::memcpy(lppe, &g_systemPalette[iStartIndex], nEntries * sizeof(PALETTEENTRY));
+		std::memcpy(lppe, &std::atomic_load(&g_systemPaletteSnapshot)->entries[iStartIndex],
+			nEntries * sizeof(PALETTEENTRY));
 
 		return LOG_RESULT(nEntries);
 	}
@@ -150,6 +194,7 @@ namespace
 			if (paletteInfo.isForeground)
 			{
 				g_systemPaletteFirstUnusedIndex = g_systemPaletteFirstNonReservedIndex;
+				g_isColorIndexValid = false;
 				for (auto& pi : g_paletteInfo)
 				{
 					pi.second.isRealized = false;
@@ -166,11 +211,13 @@ namespace
 
 				g_systemPalette[g_systemPaletteFirstUnusedIndex] = entries[i];
 				g_systemPalette[g_systemPaletteFirstUnusedIndex].peFlags = 0;
+				addColor(entries[i]);
 				++g_systemPaletteFirstUnusedIndex;
 			}
 
 			paletteInfo.isRealized = true;
 			std::memcpy(g_hardwarePalette, g_systemPalette, sizeof(g_hardwarePalette));
+			publishPalettes();
 			Gdi::VirtualScreen::updatePalette(g_systemPalette);
 			return LOG_RESULT(count);
 		}
@@ -284,16 +331,14 @@ namespace Gdi
 			return g_defaultPalette;
 		}
 
-		std::vector<PALETTEENTRY> getHardwarePalette()
+		std::shared_ptr<const Snapshot> getHardwarePalette()
 		{
-			Compat::ScopedSrwLockShared lock(g_srwLock);
-			return std::vector<PALETTEENTRY>(g_hardwarePalette, g_hardwarePalette + 256);
+			return std::atomic_load(&g_hardwarePaletteSnapshot);
 		}
 
-		std::vector<PALETTEENTRY> getSystemPalette()
+		std::shared_ptr<const Snapshot> getSystemPalette()
 		{
-			Compat::ScopedSrwLockShared lock(g_srwLock);
-			return std::vector<PALETTEENTRY>(g_systemPalette, g_systemPalette + 256);
+			return std::atomic_load(&g_systemPaletteSnapshot);
 		}
 
 		void installHooks()
@@ -319,6 +364,7 @@ namespace Gdi
 		{
 			Compat::ScopedSrwLockExclusive lock(g_srwLock);
 			std::memcpy(g_hardwarePalette, entries, sizeof(g_hardwarePalette));
+			publishPalette(g_hardwarePaletteSnapshot, g_hardwarePalette);
 		}
 	}
 }
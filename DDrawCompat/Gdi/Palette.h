@@ -1,6 +1,6 @@
 #pragma once
 
-#include <vector>
+#include <memory>
 
 #include <Windows.h>
 
@@ -8,9 +8,15 @@ namespace Gdi
 {
 	namespace Palette
 	{
+		struct Snapshot
+		{
+			UINT version;
+			PALETTEENTRY entries[256];
+		};
+
 		PALETTEENTRY* getDefaultPalette();
-		std::vector<PALETTEENTRY> getHardwarePalette();
-		std::vector<PALETTEENTRY> getSystemPalette();
+		std::shared_ptr<const Snapshot> getHardwarePalette();
+		std::shared_ptr<const Snapshot> getSystemPalette();
 		void installHooks();
 		void setHardwarePalette(PALETTEENTRY* entries);
 	}
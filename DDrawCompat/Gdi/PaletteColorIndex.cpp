@@ -0,0 +1,50 @@
+#include <algorithm>
+#include <iterator>
+
+#include <Gdi/PaletteColorIndex.h>
+
+namespace
+{
+	const DWORD EMPTY_COLOR = 0xFFFFFFFF;
+
+	DWORD getColor(const PALETTEENTRY& entry)
+	{
+		return (entry.peRed << 16) | (entry.peGreen << 8) | entry.peBlue;
+	}
+}
+
+namespace Gdi
+{
+	PaletteColorIndex::PaletteColorIndex()
+	{
+		clear();
+	}
+
+	void PaletteColorIndex::add(const PALETTEENTRY& entry)
+	{
+		const DWORD color = getColor(entry);
+		m_colors[findSlot(color)] = color;
+	}
+
+	void PaletteColorIndex::clear()
+	{
+		std::fill(std::begin(m_colors), std::end(m_colors), EMPTY_COLOR);
+	}
+
+	bool PaletteColorIndex::contains(const PALETTEENTRY& entry) const
+	{
+		return EMPTY_COLOR != m_colors[findSlot(getColor(entry))];
+	}
+
+	UINT PaletteColorIndex::findSlot(DWORD color) const
+	{
+		// The table holds at most 256 colors, so there is always an empty slot to stop the probing
+		const UINT mask = sizeof(m_colors) / sizeof(m_colors[0]) - 1;
+		UINT slot = (color * 0x9E3779B1) >> 23;
+		while (EMPTY_COLOR != m_colors[slot] && color != m_colors[slot])
+		{
+			slot = (slot + 1) & mask;
+		}
+		return slot;
+	}
+}
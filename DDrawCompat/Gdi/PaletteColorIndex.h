@@ -0,0 +1,21 @@
+#pragma once
+
+#include <Windows.h>
+
+namespace Gdi
+{
+	class PaletteColorIndex
+	{
+	public:
+		PaletteColorIndex();
+
+		void add(const PALETTEENTRY& entry);
+		void clear();
+		bool contains(const PALETTEENTRY& entry) const;
+
+	private:
+		UINT findSlot(DWORD color) const;
+
+		DWORD m_colors[512];
+	};
+}
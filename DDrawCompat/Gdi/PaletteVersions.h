@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <map>
+
+#include <Windows.h>
+
+namespace Gdi
+{
+	// Palette version each DC's colour table was last synced to. A palette change only bumps the version, and stale
+	// DCs are refreshed by update when they are handed out. A DC that is already in use therefore keeps its previous
+	// colour table until it is handed out again. DCs using the default palette are never refreshed.
+	template <typename Dc>
+	class PaletteVersions
+	{
+	public:
+		void add(Dc dc, bool useDefaultPalette)
+		{
+			m_dcs[dc] = { useDefaultPalette, m_version };
+		}
+
+		template <typename Func>
+		void forEach(Func func) const
+		{
+			for (const auto& dc : m_dcs)
+			{
+				func(dc.first, dc.second.useDefaultPalette);
+			}
+		}
+
+		UINT getVersion() const
+		{
+			return m_version;
+		}
+
+		void invalidate()
+		{
+			++m_version;
+		}
+
+		void markAllCurrent()
+		{
+			for (auto& dc : m_dcs)
+			{
+				dc.second.version = m_version;
+			}
+		}
+
+		void remove(Dc dc)
+		{
+			m_dcs.erase(dc);
+		}
+
+		// Calls setColorTable(dc) if the DC is stale, and returns the version the DC is synced to
+		template <typename SetColorTable>
+		UINT update(Dc dc, SetColorTable setColorTable)
+		{
+			auto it = m_dcs.find(dc);
+			if (it == m_dcs.end())
+			{
+				return m_version;
+			}
+
+			if (!it->second.useDefaultPalette && it->second.version != m_version)
+			{
+				setColorTable(dc);
+				it->second.version = m_version;
+			}
+			return it->second.version;
+		}
+
+	private:
+		struct Entry
+		{
+			bool useDefaultPalette;
+			UINT version;
+		};
+
+		std::atomic<UINT> m_version = 0;
+		std::map<Dc, Entry> m_dcs;
+	};
+}
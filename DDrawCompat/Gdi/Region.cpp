@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include <utility>
 
 #include <Common/Hook.h>
@@ -5,61 +8,265 @@
 
 namespace
 {
-	Gdi::Region combineRegions(const Gdi::Region& rgn1, const Gdi::Region& rgn2, int mode)
+	typedef Gdi::Region::Rects Rects;
+
+	bool isInResult(int mode, bool isInRgn1, bool isInRgn2)
+	{
+		switch (mode)
+		{
+		case RGN_AND:
+			return isInRgn1 && isInRgn2;
+		case RGN_OR:
+			return isInRgn1 || isInRgn2;
+		case RGN_DIFF:
+			return isInRgn1 && !isInRgn2;
+		case RGN_XOR:
+			return isInRgn1 != isInRgn2;
+		default:
+			return isInRgn1;
+		}
+	}
+
+	const RECT* getBandEnd(const RECT* band, const RECT* end)
+	{
+		const RECT* bandEnd = band;
+		while (bandEnd != end && bandEnd->top == band->top)
+		{
+			++bandEnd;
+		}
+		return bandEnd;
+	}
+
+	void combineSpans(const RECT* spans1, const RECT* spans1End, const RECT* spans2, const RECT* spans2End,
+		int mode, LONG top, LONG bottom, Rects& result)
+	{
+		bool isInRgn1 = false;
+		bool isInRgn2 = false;
+		bool isInResultRgn = false;
+		LONG left = 0;
+
+		while (spans1 != spans1End || spans2 != spans2End)
+		{
+			const LONG x1 = spans1 != spans1End ? (isInRgn1 ? spans1->right : spans1->left) : std::numeric_limits<LONG>::max();
+			const LONG x2 = spans2 != spans2End ? (isInRgn2 ? spans2->right : spans2->left) : std::numeric_limits<LONG>::max();
+			const LONG x = std::min<LONG>(x1, x2);
+
+			if (x == x1)
+			{
+				if (isInRgn1)
+				{
+					++spans1;
+				}
+				isInRgn1 = !isInRgn1;
+			}
+			if (x == x2)
+			{
+				if (isInRgn2)
+				{
+					++spans2;
+				}
+				isInRgn2 = !isInRgn2;
+			}
+
+			const bool isIn = isInResult(mode, isInRgn1, isInRgn2);
+			if (isIn != isInResultRgn)
+			{
+				if (isIn)
+				{
+					left = x;
+				}
+				else
+				{
+					result.push_back({ left, top, x, bottom });
+				}
+				isInResultRgn = isIn;
+			}
+		}
+	}
+
+	bool isBandEqual(const RECT* band1, const RECT* band2, std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (band1[i].left != band2[i].left || band1[i].right != band2[i].right)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void combineRects(const RECT* rgn1, const RECT* rgn1End, const RECT* rgn2, const RECT* rgn2End,
+		int mode, Rects& result)
+	{
+		Compat::SmallVector<LONG, 16> ys;
+		for (const RECT* r = rgn1; r != rgn1End; r = getBandEnd(r, rgn1End))
+		{
+			ys.push_back(r->top);
+			ys.push_back(r->bottom);
+		}
+		for (const RECT* r = rgn2; r != rgn2End; r = getBandEnd(r, rgn2End))
+		{
+			ys.push_back(r->top);
+			ys.push_back(r->bottom);
+		}
+		std::sort(ys.begin(), ys.end());
+		ys.resize(std::unique(ys.begin(), ys.end()) - ys.begin());
+
+		result.clear();
+		std::size_t prevBandStart = 0;
+		std::size_t prevBandEnd = 0;
+
+		for (std::size_t i = 1; i < ys.size(); ++i)
+		{
+			const LONG top = ys[i - 1];
+			const LONG bottom = ys[i];
+
+			while (rgn1 != rgn1End && rgn1->bottom <= top)
+			{
+				rgn1 = getBandEnd(rgn1, rgn1End);
+			}
+			while (rgn2 != rgn2End && rgn2->bottom <= top)
+			{
+				rgn2 = getBandEnd(rgn2, rgn2End);
+			}
+
+			const RECT* spans1End = rgn1 != rgn1End && rgn1->top <= top ? getBandEnd(rgn1, rgn1End) : rgn1;
+			const RECT* spans2End = rgn2 != rgn2End && rgn2->top <= top ? getBandEnd(rgn2, rgn2End) : rgn2;
+			if (rgn1 == spans1End && rgn2 == spans2End)
+			{
+				continue;
+			}
+
+			const std::size_t bandStart = result.size();
+			combineSpans(rgn1, spans1End, rgn2, spans2End, mode, top, bottom, result);
+			const std::size_t bandEnd = result.size();
+			if (bandStart == bandEnd)
+			{
+				continue;
+			}
+
+			if (prevBandStart != prevBandEnd && result[prevBandStart].bottom == top &&
+				prevBandEnd - prevBandStart == bandEnd - bandStart &&
+				isBandEqual(&result[prevBandStart], &result[bandStart], bandEnd - bandStart))
+			{
+				for (std::size_t j = prevBandStart; j < prevBandEnd; ++j)
+				{
+					result[j].bottom = bottom;
+				}
+				result.resize(bandStart);
+			}
+			else
+			{
+				prevBandStart = bandStart;
+				prevBandEnd = bandEnd;
+			}
+		}
+	}
+
+	HRGN getSysRgn(HWND hwnd)
 	{
-		Gdi::Region region;
-		CombineRgn(region, rgn1, rgn2, mode);
-		return region;
+		HRGN rgn = CreateRectRgn(0, 0, 0, 0);
+		HDC dc = GetWindowDC(hwnd);
+		GetRandomRgn(dc, rgn, SYSRGN);
+		CALL_ORIG_FUNC(ReleaseDC)(hwnd, dc);
+		return rgn;
+	}
+
+	bool isBanded(const RECT* rects, std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const RECT& r = rects[i];
+			if (r.left >= r.right || r.top >= r.bottom)
+			{
+				return false;
+			}
+
+			if (0 != i)
+			{
+				const RECT& prev = rects[i - 1];
+				if (r.top == prev.top ? r.bottom != prev.bottom || r.left < prev.right : r.top < prev.bottom)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
 	}
 }
 
 namespace Gdi
 {
 	Region::Region(std::nullptr_t)
-		: m_region(nullptr)
+		: m_isNull(true)
+		, m_rgn(nullptr)
 	{
 	}
 
 	Region::Region(HRGN rgn)
-		: m_region(rgn)
+		: Region(nullptr)
 	{
+		if (!rgn)
+		{
+			return;
+		}
+
+		std::vector<unsigned char> data(GetRegionData(rgn, 0, nullptr));
+		if (!data.empty())
+		{
+			auto& rgnData = *reinterpret_cast<RGNDATA*>(data.data());
+			GetRegionData(rgn, data.size(), &rgnData);
+			setRects(reinterpret_cast<const RECT*>(rgnData.Buffer), rgnData.rdh.nCount);
+		}
+		m_isNull = false;
+		DeleteObject(rgn);
 	}
 
 	Region::Region(const RECT& rect)
-		: m_region(CreateRectRgnIndirect(&rect))
+		: m_isNull(false)
+		, m_rgn(nullptr)
 	{
+		RECT r = { std::min<LONG>(rect.left, rect.right), std::min<LONG>(rect.top, rect.bottom),
+			std::max<LONG>(rect.left, rect.right), std::max<LONG>(rect.top, rect.bottom) };
+		if (r.left < r.right && r.top < r.bottom)
+		{
+			m_rects.push_back(r);
+		}
 	}
 
 	Region::Region(HWND hwnd)
-		: m_region(CreateRectRgn(0, 0, 0, 0))
+		: Region(getSysRgn(hwnd))
 	{
-		HDC dc = GetWindowDC(hwnd);
-		GetRandomRgn(dc, m_region, SYSRGN);
-		CALL_ORIG_FUNC(ReleaseDC)(hwnd, dc);
+	}
+
+	Region::Region(const RGNDATA& data)
+		: m_isNull(false)
+		, m_rgn(nullptr)
+	{
+		setRects(reinterpret_cast<const RECT*>(data.Buffer), data.rdh.nCount);
 	}
 
 	Region::~Region()
 	{
-		if (m_region)
-		{
-			DeleteObject(m_region);
-		}
+		deleteRgn();
 	}
 
 	Region::Region(const Region& other)
-		: Region(nullptr)
+		: m_rects(other.m_rects)
+		, m_isNull(other.m_isNull)
+		, m_rgn(nullptr)
 	{
-		if (other.m_region)
-		{
-			m_region = CreateRectRgn(0, 0, 0, 0);
-			CombineRgn(m_region, other, nullptr, RGN_COPY);
-		}
 	}
 
 	Region::Region(Region&& other)
-		: m_region(other.m_region)
+		: m_rects(std::move(other.m_rects))
+		, m_isNull(other.m_isNull)
+		, m_rgn(other.m_rgn)
 	{
-		other.m_region = nullptr;
+		other.m_rects.clear();
+		other.m_isNull = true;
+		other.m_rgn = nullptr;
 	}
 
 	Region& Region::operator=(Region other)
@@ -70,41 +277,109 @@ namespace Gdi
 
 	void Region::clear()
 	{
-		SetRectRgn(m_region, 0, 0, 0, 0);
+		m_rects.clear();
+		deleteRgn();
+	}
+
+	bool Region::contains(POINT point) const
+	{
+		for (const auto& r : m_rects)
+		{
+			if (r.top > point.y)
+			{
+				break;
+			}
+			if (point.y < r.bottom && point.x >= r.left && point.x < r.right)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	RECT Region::getBounds() const
+	{
+		if (m_rects.empty())
+		{
+			return {};
+		}
+
+		RECT bounds = { m_rects[0].left, m_rects[0].top, m_rects[0].right, m_rects.back().bottom };
+		for (const auto& r : m_rects)
+		{
+			bounds.left = std::min<LONG>(bounds.left, r.left);
+			bounds.right = std::max<LONG>(bounds.right, r.right);
+		}
+		return bounds;
+	}
+
+	std::vector<unsigned char> Region::getData() const
+	{
+		const DWORD rectsSize = m_rects.size() * sizeof(RECT);
+		std::vector<unsigned char> data(sizeof(RGNDATAHEADER) + rectsSize);
+		auto& rgnData = *reinterpret_cast<RGNDATA*>(data.data());
+		rgnData.rdh.dwSize = sizeof(RGNDATAHEADER);
+		rgnData.rdh.iType = RDH_RECTANGLES;
+		rgnData.rdh.nCount = m_rects.size();
+		rgnData.rdh.nRgnSize = rectsSize;
+		rgnData.rdh.rcBound = getBounds();
+		if (0 != rectsSize)
+		{
+			std::memcpy(rgnData.Buffer, m_rects.data(), rectsSize);
+		}
+		return data;
+	}
+
+	const Region::Rects& Region::getRects() const
+	{
+		return m_rects;
 	}
 
 	bool Region::isEmpty() const
 	{
-		return sizeof(RGNDATAHEADER) == GetRegionData(m_region, 0, nullptr);
+		return !m_isNull && m_rects.empty();
 	}
 
 	void Region::offset(int x, int y)
 	{
-		OffsetRgn(m_region, x, y);
+		for (auto& r : m_rects)
+		{
+			OffsetRect(&r, x, y);
+		}
+		deleteRgn();
 	}
 
 	HRGN Region::release()
 	{
-		HRGN rgn = m_region;
-		m_region = nullptr;
+		HRGN rgn = m_rgn ? m_rgn : createRgn();
+		m_rgn = nullptr;
+		m_rects.clear();
+		m_isNull = true;
 		return rgn;
 	}
 
-	Region::operator HRGN() const
+	Region::operator bool() const
 	{
-		return m_region;
+		return !m_isNull;
 	}
 
-	bool Region::operator==(const Region& other) const
+	Region::operator HRGN() const
 	{
-		if (m_region)
+		if (!m_rgn)
 		{
-			return other.m_region && EqualRgn(m_region, other.m_region);
+			m_rgn = createRgn();
 		}
-		else
+		return m_rgn;
+	}
+
+	bool Region::operator==(const Region& other) const
+	{
+		if (m_isNull || other.m_isNull)
 		{
-			return !other.m_region;
+			return m_isNull == other.m_isNull;
 		}
+		return m_rects.size() == other.m_rects.size() &&
+			0 == std::memcmp(m_rects.data(), other.m_rects.data(), m_rects.size() * sizeof(RECT));
 	}
 
 	bool Region::operator!=(const Region& other) const
@@ -114,57 +389,121 @@ namespace Gdi
 
 	Region Region::operator&(const Region& other) const
 	{
-		return combineRegions(*this, other, RGN_AND);
+		return Region(*this).combine(other, RGN_AND);
 	}
 
 	Region Region::operator|(const Region& other) const
 	{
-		return combineRegions(*this, other, RGN_OR);
+		return Region(*this).combine(other, RGN_OR);
 	}
 
 	Region Region::operator-(const Region& other) const
 	{
-		return combineRegions(*this, other, RGN_DIFF);
+		return Region(*this).combine(other, RGN_DIFF);
 	}
 
-	Region Region::operator&=(const Region& other)
+	Region& Region::operator&=(const Region& other)
 	{
 		return combine(other, RGN_AND);
 	}
 
-	Region Region::operator|=(const Region& other)
+	Region& Region::operator|=(const Region& other)
 	{
 		return combine(other, RGN_OR);
 	}
 
-	Region Region::operator-=(const Region& other)
+	Region& Region::operator-=(const Region& other)
 	{
 		return combine(other, RGN_DIFF);
 	}
 
 	void swap(Region& rgn1, Region& rgn2)
 	{
-		std::swap(rgn1.m_region, rgn2.m_region);
+		std::swap(rgn1.m_rects, rgn2.m_rects);
+		std::swap(rgn1.m_isNull, rgn2.m_isNull);
+		std::swap(rgn1.m_rgn, rgn2.m_rgn);
 	}
 
-	Region operator&(const Region& rgn1, const Region& rgn2)
+	Region& Region::combine(const Region& other, int mode)
 	{
-		return combineRegions(rgn1, rgn2, RGN_AND);
+		m_isNull = false;
+		deleteRgn();
+
+		if (other.m_rects.empty())
+		{
+			if (RGN_AND == mode)
+			{
+				m_rects.clear();
+			}
+			return *this;
+		}
+
+		if (m_rects.empty())
+		{
+			if (RGN_OR == mode || RGN_XOR == mode)
+			{
+				m_rects = other.m_rects;
+			}
+			return *this;
+		}
+
+		if (RGN_AND == mode && 1 == m_rects.size() && 1 == other.m_rects.size())
+		{
+			RECT r = {};
+			if (IntersectRect(&r, &m_rects[0], &other.m_rects[0]))
+			{
+				m_rects[0] = r;
+			}
+			else
+			{
+				m_rects.clear();
+			}
+			return *this;
+		}
+
+		Rects result;
+		combineRects(m_rects.begin(), m_rects.end(), other.m_rects.begin(), other.m_rects.end(), mode, result);
+		m_rects = std::move(result);
+		return *this;
 	}
 
-	Region operator|(const Region& rgn1, const Region& rgn2)
+	HRGN Region::createRgn() const
 	{
-		return combineRegions(rgn1, rgn2, RGN_OR);
+		if (m_isNull)
+		{
+			return nullptr;
+		}
+
+		if (m_rects.size() <= 1)
+		{
+			return m_rects.empty() ? CreateRectRgn(0, 0, 0, 0) : CreateRectRgnIndirect(&m_rects[0]);
+		}
+
+		auto data(getData());
+		return ExtCreateRegion(nullptr, data.size(), reinterpret_cast<RGNDATA*>(data.data()));
 	}
 
-	Region operator-(const Region& rgn1, const Region& rgn2)
+	void Region::deleteRgn()
 	{
-		return combineRegions(rgn1, rgn2, RGN_DIFF);
+		if (m_rgn)
+		{
+			DeleteObject(m_rgn);
+			m_rgn = nullptr;
+		}
 	}
 
-	Region& Region::combine(const Region& other, int mode)
+	void Region::setRects(const RECT* rects, std::size_t count)
 	{
-		CombineRgn(m_region, m_region, other, mode);
-		return *this;
+		if (isBanded(rects, count))
+		{
+			combineRects(rects, rects + count, nullptr, nullptr, RGN_COPY, m_rects);
+			return;
+		}
+
+		m_rects.clear();
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			combine(rects[i], RGN_OR);
+		}
 	}
 }
@@ -1,28 +1,39 @@
 #pragma once
 
 #include <cstddef>
+#include <vector>
 
 #include <Windows.h>
 
+#include <Common/SmallVector.h>
+
 namespace Gdi
 {
 	class Region
 	{
 	public:
+		typedef Compat::SmallVector<RECT, 4> Rects;
+
 		Region(std::nullptr_t);
 		Region(HRGN rgn);
 		Region(const RECT& rect = RECT{ 0, 0, 0, 0 });
 		Region(HWND hwnd);
+		Region(const RGNDATA& data);
 		~Region();
 		Region(const Region& other);
 		Region(Region&& other);
 		Region& operator=(Region other);
 
 		void clear();
+		bool contains(POINT point) const;
+		RECT getBounds() const;
+		std::vector<unsigned char> getData() const;
+		const Rects& getRects() const;
 		bool isEmpty() const;
 		void offset(int x, int y);
 		HRGN release();
 
+		explicit operator bool() const;
 		operator HRGN() const;
 
 		bool operator==(const Region& other) const;
@@ -32,15 +43,20 @@ namespace Gdi
 		Region operator|(const Region& other) const;
 		Region operator-(const Region& other) const;
 
-		Region operator&=(const Region& other);
-		Region operator|=(const Region& other);
-		Region operator-=(const Region& other);
+		Region& operator&=(const Region& other);
+		Region& operator|=(const Region& other);
+		Region& operator-=(const Region& other);
 
 		friend void swap(Region& rgn1, Region& rgn2);
 
 	private:
 		Region& combine(const Region& other, int mode);
+		HRGN createRgn() const;
+		void deleteRgn();
+		void setRects(const RECT* rects, std::size_t count);
 
-		HRGN m_region;
+		Rects m_rects;
+		bool m_isNull;
+		mutable HRGN m_rgn;
 	};
 }
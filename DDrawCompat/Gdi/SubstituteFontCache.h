@@ -0,0 +1,104 @@
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include <Windows.h>
+
+namespace Gdi
+{
+	// Substitute fonts keyed by the original font. Factory::createSubstitute returns false on failure, which is not
+	// cached, or true with a null substitute if the original font can be used as is. Substitutes still selected
+	// into a DC when their original font is deleted are kept until their last release.
+	template <typename Factory>
+	class SubstituteFontCache
+	{
+	public:
+		HFONT acquire(HFONT origFont)
+		{
+			if (m_substitutes.find(origFont) != m_substitutes.end())
+			{
+				return nullptr;
+			}
+
+			auto it = m_substituteFonts.find(origFont);
+			if (it == m_substituteFonts.end())
+			{
+				HFONT substituteFont = nullptr;
+				if (!Factory::createSubstitute(origFont, substituteFont))
+				{
+					return nullptr;
+				}
+
+				it = m_substituteFonts.insert({ origFont, { substituteFont, 0 } }).first;
+				if (substituteFont)
+				{
+					m_substitutes.insert(substituteFont);
+				}
+			}
+
+			if (it->second.font)
+			{
+				++it->second.refCount;
+			}
+			return it->second.font;
+		}
+
+		void onDeleteFont(HFONT font)
+		{
+			auto it = m_substituteFonts.find(font);
+			if (it == m_substituteFonts.end())
+			{
+				return;
+			}
+
+			const Entry entry = it->second;
+			m_substituteFonts.erase(it);
+			if (entry.font)
+			{
+				if (0 == entry.refCount)
+				{
+					deleteSubstitute(entry.font);
+				}
+				else
+				{
+					m_orphanedFonts[entry.font] = entry.refCount;
+				}
+			}
+		}
+
+		void release(HFONT origFont, HFONT substituteFont)
+		{
+			auto it = m_substituteFonts.find(origFont);
+			if (it != m_substituteFonts.end() && it->second.font == substituteFont)
+			{
+				--it->second.refCount;
+				return;
+			}
+
+			auto orphanIt = m_orphanedFonts.find(substituteFont);
+			if (orphanIt != m_orphanedFonts.end() && 0 == --orphanIt->second)
+			{
+				m_orphanedFonts.erase(orphanIt);
+				deleteSubstitute(substituteFont);
+			}
+		}
+
+	private:
+		struct Entry
+		{
+			HFONT font;
+			DWORD refCount;
+		};
+
+		void deleteSubstitute(HFONT font)
+		{
+			m_substitutes.erase(font);
+			Factory::deleteFont(font);
+		}
+
+		std::unordered_map<HFONT, Entry> m_substituteFonts;
+		std::unordered_map<HFONT, DWORD> m_orphanedFonts;
+		std::unordered_set<HFONT> m_substitutes;
+	};
+}
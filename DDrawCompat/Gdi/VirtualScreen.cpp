@@ -1,5 +1,3 @@
-#include <map>
-
 #include <Config/Config.h>
 #include <Common/ScopedCriticalSection.h>
 #include <D3dDdi/Device.h>
@@ -8,18 +6,15 @@
 #include <DDraw/RealPrimarySurface.h>
 #include <DDraw/ScopedThreadLock.h>
 #include <DDraw/Surfaces/PrimarySurface.h>
+#include <Gdi/Dc.h>
 #include <Gdi/Gdi.h>
+#include <Gdi/PaletteVersions.h>
 #include <Gdi/Region.h>
 #include <Gdi/VirtualScreen.h>
 #include <Win32/DisplayMode.h>
 
 namespace
 {
-	struct VirtualScreenDc
-	{
-		bool useDefaultPalette;
-	};
-
 	Compat::CriticalSection g_cs;
 	Gdi::Region g_region;
 	RECT g_bounds = {};
@@ -33,7 +28,7 @@ namespace
 	HGDIOBJ g_stockBitmap = nullptr;
 	RGBQUAD g_defaultPalette[256] = {};
 	RGBQUAD g_systemPalette[256] = {};
-	std::map<HDC, VirtualScreenDc> g_dcs;
+	Gdi::PaletteVersions<HDC> g_paletteVersions;
 
 	BOOL CALLBACK addMonitorRectToRegion(
 		HMONITOR /*hMonitor*/, HDC /*hdcMonitor*/, LPRECT lprcMonitor, LPARAM dwData)
@@ -120,7 +115,7 @@ namespace Gdi
 			dib.release();
 
 			g_stockBitmap = stockBitmap;
-			g_dcs[dc.get()] = { useDefaultPalette };
+			g_paletteVersions.add(dc.get(), useDefaultPalette);
 			return dc.release();
 		}
 
@@ -172,7 +167,7 @@ namespace Gdi
 			Compat::ScopedCriticalSection lock(g_cs);
 			DeleteObject(SelectObject(dc, g_stockBitmap));
 			DeleteDC(dc);
-			g_dcs.erase(dc);
+			g_paletteVersions.remove(dc);
 		}
 
 		RECT getBounds()
@@ -181,6 +176,11 @@ namespace Gdi
 			return g_bounds;
 		}
 
+		UINT getPaletteVersion()
+		{
+			return g_paletteVersions.getVersion();
+		}
+
 		Region getRegion()
 		{
 			Compat::ScopedCriticalSection lock(g_cs);
@@ -248,7 +248,7 @@ namespace Gdi
 
 				g_region = Region();
 				EnumDisplayMonitors(nullptr, nullptr, addMonitorRectToRegion, reinterpret_cast<LPARAM>(&g_region));
-				GetRgnBox(g_region, &g_bounds);
+				g_bounds = g_region.getBounds();
 
 				g_bpp = Win32::DisplayMode::getBpp();
 				g_width = g_bounds.right - g_bounds.left;
@@ -257,10 +257,10 @@ namespace Gdi
 
 				if (g_surfaceFileMapping)
 				{
-					for (auto& dc : g_dcs)
-					{
-						DeleteObject(SelectObject(dc.first, g_stockBitmap));
-					}
+					g_paletteVersions.forEach([](HDC dc, bool /*useDefaultPalette*/)
+						{
+							DeleteObject(SelectObject(dc, g_stockBitmap));
+						});
 					UnmapViewOfFile(g_surfaceView);
 					CloseHandle(g_surfaceFileMapping);
 				}
@@ -269,16 +269,28 @@ namespace Gdi
 					g_pitch * g_height + 8, nullptr);
 				g_surfaceView = MapViewOfFile(g_surfaceFileMapping, FILE_MAP_WRITE, 0, 0, 0);
 
-				for (auto& dc : g_dcs)
-				{
-					SelectObject(dc.first, createDib(dc.second.useDefaultPalette));
-				}
+				g_paletteVersions.forEach([](HDC dc, bool useDefaultPalette)
+					{
+						SelectObject(dc, createDib(useDefaultPalette));
+					});
+				g_paletteVersions.markAllCurrent();
+
+				Gdi::Dc::invalidateClipRegions();
 			}
 
 			Gdi::redraw(nullptr);
 			return LOG_RESULT(true);
 		}
 
+		UINT updateDcPalette(HDC dc)
+		{
+			Compat::ScopedCriticalSection lock(g_cs);
+			return g_paletteVersions.update(dc, [](HDC staleDc)
+				{
+					SetDIBColorTable(staleDc, 0, 256, g_systemPalette);
+				});
+		}
+
 		void updatePalette(PALETTEENTRY(&palette)[256])
 		{
 			Compat::ScopedCriticalSection lock(g_cs);
@@ -292,13 +304,7 @@ namespace Gdi
 			if (0 != memcmp(g_systemPalette, systemPalette, sizeof(systemPalette)))
 			{
 				memcpy(g_systemPalette, systemPalette, sizeof(systemPalette));
-				for (auto& dc : g_dcs)
-				{
-					if (!dc.second.useDefaultPalette)
-					{
-						SetDIBColorTable(dc.first, 0, 256, systemPalette);
-					}
-				}
+				g_paletteVersions.invalidate();
 			}
 
 			DDraw::RealPrimarySurface::scheduleUpdate();
@@ -17,11 +17,13 @@ namespace Gdi
 		void deleteDc(HDC dc);
 
 		RECT getBounds();
+		UINT getPaletteVersion();
 		Region getRegion();
 		DDSURFACEDESC2 getSurfaceDesc(const RECT& rect);
 
 		void init();
 		bool update();
+		UINT updateDcPalette(HDC dc);
 		void updatePalette(PALETTEENTRY(&palette)[256]);
 	}
 }
@@ -9,6 +9,7 @@
 #include <Dll/Dll.h>
 #include <Gdi/CompatDc.h>
 #include <Gdi/Dc.h>
+#include <Gdi/DcFunctions.h>
 #include <Gdi/PresentationWindow.h>
 #include <Gdi/ScrollBar.h>
 #include <Gdi/ScrollFunctions.h>
@@ -78,6 +79,10 @@ namespace
 			break;
 
 		case WM_STYLECHANGED:
+			if (GWL_EXSTYLE == wParam)
+			{
+				Gdi::DcFunctions::onStyleChanged();
+			}
 			if (isTopLevelWindow(hwnd))
 			{
 				Gdi::Window::onStyleChanged(hwnd, wParam);
@@ -271,14 +276,14 @@ namespace
 			return;
 		}
 
-		Gdi::Window::updateAll();
+		Gdi::Window::onCreateWindow(hwnd);
 	}
 
 	void onDestroyWindow(HWND hwnd)
 	{
 		if (isTopLevelWindow(hwnd))
 		{
-			Gdi::Window::updateAll();
+			Gdi::Window::onDestroyWindow(hwnd);
 			return;
 		}
 
@@ -300,7 +305,13 @@ namespace
 
 		if (isTopLevelWindow(hwnd))
 		{
-			Gdi::Window::updateAll();
+			Gdi::Window::onWindowPosChanged(hwnd, wp);
+		}
+		else if ((SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER) != (wp.flags & (SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER)) ||
+			(wp.flags & (SWP_SHOWWINDOW | SWP_HIDEWINDOW | SWP_FRAMECHANGED)))
+		{
+			// Child windows are not tracked by Gdi::Window, but moving them changes the clip regions of pooled DCs
+			Gdi::Dc::invalidateClipRegions();
 		}
 
 		if (wp.flags & SWP_FRAMECHANGED)
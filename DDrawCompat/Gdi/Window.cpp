@@ -1,5 +1,4 @@
 #include <algorithm>
-#include <map>
 #include <vector>
 
 #include <dwmapi.h>
@@ -8,9 +7,11 @@
 #include <D3dDdi/KernelModeThunks.h>
 #include <D3dDdi/ScopedCriticalSection.h>
 #include <DDraw/RealPrimarySurface.h>
+#include <Gdi/Dc.h>
 #include <Gdi/PresentationWindow.h>
 #include <Gdi/VirtualScreen.h>
 #include <Gdi/Window.h>
+#include <Gdi/WindowZOrder.h>
 
 namespace
 {
@@ -19,7 +20,6 @@ namespace
 		Gdi::Region obscuredRegion;
 		Gdi::Region invalidatedRegion;
 		Gdi::Region virtualScreenRegion;
-		DWORD processId;
 	};
 
 	struct Window
@@ -31,6 +31,9 @@ namespace
 		Gdi::Region windowRegion;
 		Gdi::Region visibleRegion;
 		Gdi::Region invalidatedRegion;
+		Gdi::Region obscuredRegion;
+		Window* above;
+		Window* below;
 		COLORREF colorKey;
 		BYTE alpha;
 		bool isLayered;
@@ -42,6 +45,8 @@ namespace
 			, windowRect{}
 			, clientRect{}
 			, windowRegion(nullptr)
+			, above(nullptr)
+			, below(nullptr)
 			, colorKey(CLR_INVALID)
 			, alpha(255)
 			, isLayered(true)
@@ -52,10 +57,10 @@ namespace
 
 	const RECT REGION_OVERRIDE_MARKER_RECT = { 32000, 32000, 32001, 32001 };
 
-	std::map<HWND, Window> g_windows;
-	std::vector<Window*> g_windowZOrder;
+	Gdi::WindowZOrder<HWND, Window> g_windows;
+	Gdi::Region g_virtualScreenRegion;
 
-	std::map<HWND, Window>::iterator addWindow(HWND hwnd)
+	Window createWindow(HWND hwnd)
 	{
 		DWMNCRENDERINGPOLICY ncRenderingPolicy = DWMNCRP_DISABLED;
 		DwmSetWindowAttribute(hwnd, DWMWA_NCRENDERING_POLICY, &ncRenderingPolicy, sizeof(ncRenderingPolicy));
@@ -69,7 +74,13 @@ namespace
 			CALL_ORIG_FUNC(SetClassLongA)(hwnd, GCL_STYLE, style & ~CS_DROPSHADOW);
 		}
 
-		return g_windows.emplace(hwnd, Window(hwnd)).first;
+		return Window(hwnd);
+	}
+
+	BOOL CALLBACK addWindowHandle(HWND hwnd, LPARAM lParam)
+	{
+		reinterpret_cast<std::vector<HWND>*>(lParam)->push_back(hwnd);
+		return TRUE;
 	}
 
 	bool bltWindow(const RECT& dst, const RECT& src, const Gdi::Region& clipRegion)
@@ -87,16 +98,52 @@ namespace
 		return true;
 	}
 
+	Gdi::Region getUpdateRegion(HWND hwnd)
+	{
+		HRGN rgn = CreateRectRgn(0, 0, 0, 0);
+		GetUpdateRgn(hwnd, rgn, FALSE);
+		return rgn;
+	}
+
 	Gdi::Region getWindowRegion(HWND hwnd)
 	{
-		Gdi::Region rgn;
+		HRGN rgn = CreateRectRgn(0, 0, 0, 0);
 		if (ERROR == CALL_ORIG_FUNC(GetWindowRgn)(hwnd, rgn))
 		{
+			DeleteObject(rgn);
 			return nullptr;
 		}
 		return rgn;
 	}
 
+	bool isTrackedWindow(HWND hwnd)
+	{
+		DWORD processId = 0;
+		GetWindowThreadProcessId(hwnd, &processId);
+		return processId == GetCurrentProcessId() && !Gdi::PresentationWindow::isPresentationWindow(hwnd);
+	}
+
+	Window* findWindowAbove(HWND hwnd)
+	{
+		for (hwnd = GetWindow(hwnd, GW_HWNDPREV); hwnd; hwnd = GetWindow(hwnd, GW_HWNDPREV))
+		{
+			auto window = g_windows.find(hwnd);
+			if (window)
+			{
+				return window;
+			}
+		}
+		return nullptr;
+	}
+
+	void sendSyncPaint(const std::vector<HWND>& invalidatedWindows)
+	{
+		for (auto it = invalidatedWindows.rbegin(); it != invalidatedWindows.rend(); ++it)
+		{
+			SendNotifyMessage(*it, WM_SYNCPAINT, 0, 0);
+		}
+	}
+
 	void updatePosition(Window& window, const RECT& oldWindowRect, const RECT& oldClientRect,
 		const Gdi::Region& oldVisibleRegion, Gdi::Region& invalidatedRegion)
 	{
@@ -151,8 +198,7 @@ namespace
 					}
 				}
 
-				Gdi::Region updateRegion;
-				GetUpdateRgn(window.hwnd, updateRegion, FALSE);
+				Gdi::Region updateRegion(getUpdateRegion(window.hwnd));
 				updateRegion.offset(window.clientRect.left, window.clientRect.top);
 				preservedRegion -= updateRegion;
 			}
@@ -180,51 +226,35 @@ namespace
 		}
 	}
 
-	BOOL CALLBACK updateWindow(HWND hwnd, LPARAM lParam)
+	void updateWindow(Window& window, UpdateWindowContext& context)
 	{
-		auto& context = *reinterpret_cast<UpdateWindowContext*>(lParam);
-
-		DWORD processId = 0;
-		GetWindowThreadProcessId(hwnd, &processId);
-		if (processId != context.processId ||
-			Gdi::PresentationWindow::isPresentationWindow(hwnd))
-		{
-			return TRUE;
-		}
-
-		auto it = g_windows.find(hwnd);
-		if (it == g_windows.end())
-		{
-			it = addWindow(hwnd);
-		}
-		g_windowZOrder.push_back(&it->second);
-
+		const HWND hwnd = window.hwnd;
 		const LONG exStyle = CALL_ORIG_FUNC(GetWindowLongA)(hwnd, GWL_EXSTYLE);
 		const bool isLayered = exStyle & WS_EX_LAYERED;
 		const bool isVisible = IsWindowVisible(hwnd) && !IsIconic(hwnd);
 		bool setPresentationWindowRgn = false;
 
-		if (isLayered != it->second.isLayered)
+		if (isLayered != window.isLayered)
 		{
-			it->second.isLayered = isLayered;
-			it->second.isVisibleRegionChanged = isVisible;
+			window.isLayered = isLayered;
+			window.isVisibleRegionChanged = isVisible;
 			if (!isLayered)
 			{
-				it->second.presentationWindow = Gdi::PresentationWindow::create(hwnd);
+				window.presentationWindow = Gdi::PresentationWindow::create(hwnd);
 				setPresentationWindowRgn = true;
 			}
-			else if (it->second.presentationWindow)
+			else if (window.presentationWindow)
 			{
-				Gdi::PresentationWindow::destroy(it->second.presentationWindow);
-				it->second.presentationWindow = nullptr;
+				Gdi::PresentationWindow::destroy(window.presentationWindow);
+				window.presentationWindow = nullptr;
 			}
 		}
 
 		Gdi::Region windowRegion(getWindowRegion(hwnd));
-		if (windowRegion && !PtInRegion(windowRegion, REGION_OVERRIDE_MARKER_RECT.left, REGION_OVERRIDE_MARKER_RECT.top) ||
-			!windowRegion && it->second.windowRegion)
+		if (windowRegion && !windowRegion.contains({ REGION_OVERRIDE_MARKER_RECT.left, REGION_OVERRIDE_MARKER_RECT.top }) ||
+			!windowRegion && window.windowRegion)
 		{
-			swap(it->second.windowRegion, windowRegion);
+			swap(window.windowRegion, windowRegion);
 			setPresentationWindowRgn = true;
 		}
 
@@ -237,9 +267,9 @@ namespace
 			GetWindowInfo(hwnd, &wi);
 			if (!IsRectEmpty(&wi.rcWindow))
 			{
-				if (it->second.windowRegion)
+				if (window.windowRegion)
 				{
-					visibleRegion = it->second.windowRegion;
+					visibleRegion = window.windowRegion;
 					visibleRegion.offset(wi.rcWindow.left, wi.rcWindow.top);
 				}
 				else
@@ -256,37 +286,37 @@ namespace
 			}
 		}
 
-		std::swap(it->second.windowRect, wi.rcWindow);
-		std::swap(it->second.clientRect, wi.rcClient);
-		swap(it->second.visibleRegion, visibleRegion);
+		std::swap(window.windowRect, wi.rcWindow);
+		std::swap(window.clientRect, wi.rcClient);
+		swap(window.visibleRegion, visibleRegion);
 
 		if (!isLayered)
 		{
-			if (!it->second.visibleRegion.isEmpty())
+			if (!window.visibleRegion.isEmpty())
 			{
-				updatePosition(it->second, wi.rcWindow, wi.rcClient, visibleRegion, context.invalidatedRegion);
+				updatePosition(window, wi.rcWindow, wi.rcClient, visibleRegion, context.invalidatedRegion);
 			}
 
 			if (exStyle & WS_EX_TRANSPARENT)
 			{
-				context.invalidatedRegion |= visibleRegion - it->second.visibleRegion;
+				context.invalidatedRegion |= visibleRegion - window.visibleRegion;
 			}
 
-			if (isVisible && !it->second.isVisibleRegionChanged)
+			if (isVisible && !window.isVisibleRegionChanged)
 			{
-				visibleRegion.offset(it->second.windowRect.left - wi.rcWindow.left, it->second.windowRect.top - wi.rcWindow.top);
+				visibleRegion.offset(window.windowRect.left - wi.rcWindow.left, window.windowRect.top - wi.rcWindow.top);
 
-				if (it->second.visibleRegion != visibleRegion)
+				if (window.visibleRegion != visibleRegion)
 				{
-					it->second.isVisibleRegionChanged = true;
+					window.isVisibleRegionChanged = true;
 				}
 			}
 
-			if (it->second.presentationWindow)
+			if (window.presentationWindow)
 			{
 				if (setPresentationWindowRgn)
 				{
-					Gdi::PresentationWindow::setWindowRgn(it->second.presentationWindow, it->second.windowRegion);
+					Gdi::PresentationWindow::setWindowRgn(window.presentationWindow, window.windowRegion);
 				}
 
 				WINDOWPOS wp = {};
@@ -298,15 +328,15 @@ namespace
 					{
 						wp.hwndInsertAfter = (GetWindowLong(hwnd, GWL_EXSTYLE) & WS_EX_TOPMOST) ? HWND_TOPMOST : HWND_TOP;
 					}
-					else if (wp.hwndInsertAfter == it->second.presentationWindow)
+					else if (wp.hwndInsertAfter == window.presentationWindow)
 					{
 						wp.flags |= SWP_NOZORDER;
 					}
 
-					wp.x = it->second.windowRect.left;
-					wp.y = it->second.windowRect.top;
-					wp.cx = it->second.windowRect.right - it->second.windowRect.left;
-					wp.cy = it->second.windowRect.bottom - it->second.windowRect.top;
+					wp.x = window.windowRect.left;
+					wp.y = window.windowRect.top;
+					wp.cx = window.windowRect.right - window.windowRect.left;
+					wp.cy = window.windowRect.bottom - window.windowRect.top;
 					wp.flags |= SWP_SHOWWINDOW;
 				}
 				else
@@ -314,10 +344,56 @@ namespace
 					wp.flags |= SWP_HIDEWINDOW | SWP_NOMOVE | SWP_NOSIZE | SWP_NOZORDER;
 				}
 
-				Gdi::PresentationWindow::setWindowPos(it->second.presentationWindow, wp);
+				Gdi::PresentationWindow::setWindowPos(window.presentationWindow, wp);
 			}
 		}
-		return TRUE;
+	}
+
+	void updateWindows(Window* start, Window* lowestChanged, std::vector<HWND>& invalidatedWindows)
+	{
+		Gdi::Dc::invalidateClipRegions();
+
+		UpdateWindowContext context;
+		context.virtualScreenRegion = Gdi::VirtualScreen::getRegion();
+		if (context.virtualScreenRegion != g_virtualScreenRegion)
+		{
+			g_virtualScreenRegion = context.virtualScreenRegion;
+			start = g_windows.getTop();
+			lowestChanged = nullptr;
+		}
+
+		g_windows.update(start, lowestChanged, context, [&](Window& window, UpdateWindowContext& ctx)
+			{
+				updateWindow(window, ctx);
+				if (window.isVisibleRegionChanged || !window.invalidatedRegion.isEmpty())
+				{
+					invalidatedWindows.push_back(window.hwnd);
+				}
+			});
+	}
+
+	void updateWindowPos(HWND hwnd, bool isZOrderChanged, std::vector<HWND>& invalidatedWindows)
+	{
+		auto window = g_windows.find(hwnd);
+		if (!window)
+		{
+			if (!IsWindow(hwnd) || !isTrackedWindow(hwnd))
+			{
+				return;
+			}
+			window = &g_windows.insert(hwnd, createWindow(hwnd), findWindowAbove(hwnd));
+			updateWindows(window, window, invalidatedWindows);
+			return;
+		}
+
+		if (!isZOrderChanged)
+		{
+			updateWindows(window, window, invalidatedWindows);
+			return;
+		}
+
+		const auto change = g_windows.move(*window, findWindowAbove(hwnd));
+		updateWindows(change.start, change.lowestChanged, invalidatedWindows);
 	}
 }
 
@@ -325,16 +401,53 @@ namespace Gdi
 {
 	namespace Window
 	{
+		void onCreateWindow(HWND hwnd)
+		{
+			LOG_FUNC("Window::onCreateWindow", hwnd);
+			std::vector<HWND> invalidatedWindows;
+			{
+				D3dDdi::ScopedCriticalSection lock;
+				updateWindowPos(hwnd, true, invalidatedWindows);
+			}
+			sendSyncPaint(invalidatedWindows);
+		}
+
+		void onDestroyWindow(HWND hwnd)
+		{
+			LOG_FUNC("Window::onDestroyWindow", hwnd);
+			std::vector<HWND> invalidatedWindows;
+			{
+				D3dDdi::ScopedCriticalSection lock;
+				auto window = g_windows.find(hwnd);
+				if (!window)
+				{
+					return;
+				}
+
+				if (window->presentationWindow)
+				{
+					Gdi::PresentationWindow::destroy(window->presentationWindow);
+				}
+
+				auto below = g_windows.remove(hwnd);
+				if (below)
+				{
+					updateWindows(below, below, invalidatedWindows);
+				}
+			}
+			sendSyncPaint(invalidatedWindows);
+		}
+
 		void onStyleChanged(HWND hwnd, WPARAM wParam)
 		{
 			if (GWL_EXSTYLE == wParam)
 			{
 				D3dDdi::ScopedCriticalSection lock;
-				auto it = g_windows.find(hwnd);
-				if (it != g_windows.end())
+				auto window = g_windows.find(hwnd);
+				if (window)
 				{
 					const bool isLayered = GetWindowLong(hwnd, GWL_EXSTYLE) & WS_EX_LAYERED;
-					if (isLayered != it->second.isLayered)
+					if (isLayered != window->isLayered)
 					{
 						updateAll();
 					}
@@ -349,37 +462,37 @@ namespace Gdi
 
 			{
 				D3dDdi::ScopedCriticalSection lock;
-				auto it = g_windows.find(hwnd);
-				if (it == g_windows.end())
+				auto window = g_windows.find(hwnd);
+				if (!window)
 				{
 					return;
 				}
 
-				if (it->second.isVisibleRegionChanged)
+				if (window->isVisibleRegionChanged)
 				{
-					it->second.isVisibleRegionChanged = false;
+					window->isVisibleRegionChanged = false;
 					const LONG origWndProc = CALL_ORIG_FUNC(GetWindowLongA)(hwnd, GWL_WNDPROC);
 					CALL_ORIG_FUNC(SetWindowLongA)(hwnd, GWL_WNDPROC, reinterpret_cast<LONG>(CALL_ORIG_FUNC(DefWindowProcA)));
-					if (it->second.isLayered)
+					if (window->isLayered)
 					{
-						SetWindowRgn(hwnd, Gdi::Region(it->second.windowRegion).release(), FALSE);
+						SetWindowRgn(hwnd, Gdi::Region(window->windowRegion).release(), FALSE);
 					}
 					else
 					{
-						Gdi::Region rgn(it->second.visibleRegion);
-						rgn.offset(-it->second.windowRect.left, -it->second.windowRect.top);
+						Gdi::Region rgn(window->visibleRegion);
+						rgn.offset(-window->windowRect.left, -window->windowRect.top);
 						rgn |= REGION_OVERRIDE_MARKER_RECT;
-						SetWindowRgn(hwnd, rgn, FALSE);
+						SetWindowRgn(hwnd, rgn.release(), FALSE);
 					}
 					CALL_ORIG_FUNC(SetWindowLongA)(hwnd, GWL_WNDPROC, origWndProc);
 				}
 
-				isInvalidated = !it->second.invalidatedRegion.isEmpty();
+				isInvalidated = !window->invalidatedRegion.isEmpty();
 				if (isInvalidated)
 				{
-					RedrawWindow(hwnd, nullptr, it->second.invalidatedRegion,
+					RedrawWindow(hwnd, nullptr, window->invalidatedRegion,
 						RDW_INVALIDATE | RDW_ERASE | RDW_FRAME | RDW_ALLCHILDREN);
-					it->second.invalidatedRegion = nullptr;
+					window->invalidatedRegion = nullptr;
 				}
 			}
 
@@ -390,16 +503,36 @@ namespace Gdi
 			}
 		}
 
+		void onWindowPosChanged(HWND hwnd, const WINDOWPOS& wp)
+		{
+			LOG_FUNC("Window::onWindowPosChanged", hwnd);
+			std::vector<HWND> invalidatedWindows;
+			{
+				D3dDdi::ScopedCriticalSection lock;
+				updateWindowPos(hwnd, !(wp.flags & SWP_NOZORDER), invalidatedWindows);
+			}
+			sendSyncPaint(invalidatedWindows);
+		}
+
 		void present(CompatRef<IDirectDrawSurface7> dst, CompatRef<IDirectDrawSurface7> src,
-			CompatRef<IDirectDrawClipper> clipper)
+			CompatRef<IDirectDrawClipper> clipper, const std::vector<RECT>& rects)
 		{
 			D3dDdi::ScopedCriticalSection lock;
-			for (auto window : g_windowZOrder)
+			for (auto window = g_windows.getTop(); window; window = window->below)
 			{
 				if (window->presentationWindow && !window->visibleRegion.isEmpty())
 				{
 					clipper->SetHWnd(&clipper, 0, window->presentationWindow);
-					dst->Blt(&dst, nullptr, &src, nullptr, DDBLT_WAIT, nullptr);
+					if (rects.empty())
+					{
+						dst->Blt(&dst, nullptr, &src, nullptr, DDBLT_WAIT, nullptr);
+						continue;
+					}
+
+					for (auto rect : rects)
+					{
+						dst->Blt(&dst, &rect, &src, &rect, DDBLT_WAIT, nullptr);
+					}
 				}
 			}
 		}
@@ -410,7 +543,7 @@ namespace Gdi
 			std::unique_ptr<HDC__, void(*)(HDC)> virtualScreenDc(nullptr, &Gdi::VirtualScreen::deleteDc);
 			RECT virtualScreenBounds = Gdi::VirtualScreen::getBounds();
 
-			for (auto window : g_windowZOrder)
+			for (auto window = g_windows.getTop(); window; window = window->below)
 			{
 				if (!window->presentationWindow)
 				{
@@ -438,11 +571,13 @@ namespace Gdi
 				}
 
 				HDC dc = GetWindowDC(window->presentationWindow);
-				RECT rect = window->windowRect;
-				visibleRegion.offset(-rect.left, -rect.top);
+				const RECT& windowRect = window->windowRect;
+				const RECT bounds = visibleRegion.getBounds();
+				visibleRegion.offset(-windowRect.left, -windowRect.top);
 				SelectClipRgn(dc, visibleRegion);
-				CALL_ORIG_FUNC(BitBlt)(dc, 0, 0, rect.right - rect.left, rect.bottom - rect.top, virtualScreenDc.get(),
-					rect.left - virtualScreenBounds.left, rect.top - virtualScreenBounds.top, SRCCOPY);
+				CALL_ORIG_FUNC(BitBlt)(dc, bounds.left - windowRect.left, bounds.top - windowRect.top,
+					bounds.right - bounds.left, bounds.bottom - bounds.top, virtualScreenDc.get(),
+					bounds.left - virtualScreenBounds.left, bounds.top - virtualScreenBounds.top, SRCCOPY);
 				CALL_ORIG_FUNC(ReleaseDC)(window->presentationWindow, dc);
 			}
 		}
@@ -452,9 +587,9 @@ namespace Gdi
 			D3dDdi::ScopedCriticalSection lock;
 
 			HDC dstDc = nullptr;
-			for (auto it = g_windowZOrder.rbegin(); it != g_windowZOrder.rend(); ++it)
+			for (auto it = g_windows.getBottom(); it; it = it->above)
 			{
-				auto& window = **it;
+				auto& window = *it;
 				if (!window.isLayered)
 				{
 					continue;
@@ -512,57 +647,37 @@ namespace Gdi
 		void updateAll()
 		{
 			LOG_FUNC("Window::updateAll");
-			UpdateWindowContext context;
-			context.processId = GetCurrentProcessId();
-			context.virtualScreenRegion = VirtualScreen::getRegion();
 			std::vector<HWND> invalidatedWindows;
 
 			{
 				D3dDdi::ScopedCriticalSection lock;
-				g_windowZOrder.clear();
-				EnumWindows(updateWindow, reinterpret_cast<LPARAM>(&context));
+				std::vector<HWND> windows;
+				EnumWindows(addWindowHandle, reinterpret_cast<LPARAM>(&windows));
+				windows.erase(std::remove_if(windows.begin(), windows.end(),
+					[](HWND hwnd) { return !isTrackedWindow(hwnd); }), windows.end());
 
-				for (auto it = g_windows.begin(); it != g_windows.end();)
-				{
-					if (g_windowZOrder.end() == std::find(g_windowZOrder.begin(), g_windowZOrder.end(), &it->second))
+				g_windows.reset(windows, createWindow, [](auto& window)
 					{
-						if (it->second.presentationWindow)
+						if (window.presentationWindow)
 						{
-							Gdi::PresentationWindow::destroy(it->second.presentationWindow);
+							Gdi::PresentationWindow::destroy(window.presentationWindow);
 						}
-						it = g_windows.erase(it);
-					}
-					else
-					{
-						++it;
-					}
-				}
-
-				for (auto it = g_windowZOrder.rbegin(); it != g_windowZOrder.rend(); ++it)
-				{
-					auto& window = **it;
-					if (window.isVisibleRegionChanged || !window.invalidatedRegion.isEmpty())
-					{
-						invalidatedWindows.push_back(window.hwnd);
-					}
-				}
+					});
+				updateWindows(g_windows.getTop(), nullptr, invalidatedWindows);
 			}
 
-			for (auto hwnd : invalidatedWindows)
-			{
-				SendNotifyMessage(hwnd, WM_SYNCPAINT, 0, 0);
-			}
+			sendSyncPaint(invalidatedWindows);
 		}
 
 		void updateLayeredWindowInfo(HWND hwnd, COLORREF colorKey, BYTE alpha)
 		{
 			D3dDdi::ScopedCriticalSection lock;
-			auto it = g_windows.find(hwnd);
-			if (it != g_windows.end())
+			auto window = g_windows.find(hwnd);
+			if (window)
 			{
-				it->second.colorKey = colorKey;
-				it->second.alpha = alpha;
-				if (!it->second.visibleRegion.isEmpty())
+				window->colorKey = colorKey;
+				window->alpha = alpha;
+				if (!window->visibleRegion.isEmpty())
 				{
 					DDraw::RealPrimarySurface::scheduleUpdate();
 				}
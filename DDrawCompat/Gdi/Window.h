@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include <ddraw.h>
 
 #include <Common/CompatRef.h>
@@ -9,10 +11,13 @@ namespace Gdi
 {
 	namespace Window
 	{
+		void onCreateWindow(HWND hwnd);
+		void onDestroyWindow(HWND hwnd);
 		void onStyleChanged(HWND hwnd, WPARAM wParam);
 		void onSyncPaint(HWND hwnd);
+		void onWindowPosChanged(HWND hwnd, const WINDOWPOS& wp);
 		void present(CompatRef<IDirectDrawSurface7> dst, CompatRef<IDirectDrawSurface7> src,
-			CompatRef<IDirectDrawClipper> clipper);
+			CompatRef<IDirectDrawClipper> clipper, const std::vector<RECT>& rects = {});
 		void present(Gdi::Region excludeRegion);
 		void presentLayered(CompatRef<IDirectDrawSurface7> dst, POINT offset);
 		void updateAll();
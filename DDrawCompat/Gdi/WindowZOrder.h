@@ -0,0 +1,181 @@
+#pragma once
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace Gdi
+{
+	// Tracked top-level windows, looked up by handle and linked into a list from top to bottom z-order.
+	// Each window caches the region obscured by itself and the windows above it. Updates walk down from the
+	// highest changed window and stop past the lowest changed one at the first window whose cached obscured region
+	// is unchanged, as the windows below it are obscured the same as before.
+	//
+	// Window must have the members Window* above, Window* below and obscuredRegion. The update context must have
+	// an obscuredRegion member of the same type, which updateWindow(window, context) accumulates.
+	template <typename Key, typename Window>
+	class WindowZOrder
+	{
+	public:
+		struct Change
+		{
+			Window* start;
+			Window* lowestChanged;
+		};
+
+		WindowZOrder()
+			: m_top(nullptr)
+			, m_bottom(nullptr)
+		{
+		}
+
+		Window* find(Key key)
+		{
+			auto it = m_windows.find(key);
+			return it != m_windows.end() ? &it->second : nullptr;
+		}
+
+		Window* getBottom() const { return m_bottom; }
+		Window* getTop() const { return m_top; }
+
+		// Links a new window below above, or at the top if above is null. Only the new window has changed.
+		Window& insert(Key key, Window window, Window* above)
+		{
+			auto& newWindow = m_windows.emplace(key, std::move(window)).first->second;
+			link(newWindow, above);
+			return newWindow;
+		}
+
+		// Relinks a window below above, or at the top if above is null, and returns the windows to update
+		Change move(Window& window, Window* above)
+		{
+			Window* oldBelow = window.below;
+			unlink(window);
+			link(window, above);
+
+			if (oldBelow == window.below)
+			{
+				return { &window, &window };
+			}
+			if (!oldBelow)
+			{
+				return { &window, nullptr };
+			}
+
+			Window* start = getHigher(&window, oldBelow);
+			return { start, start == &window ? oldBelow : &window };
+		}
+
+		// Erases a window and returns the window that was below it, the only one to update
+		Window* remove(Key key)
+		{
+			auto it = m_windows.find(key);
+			if (it == m_windows.end())
+			{
+				return nullptr;
+			}
+
+			Window* below = it->second.below;
+			unlink(it->second);
+			m_windows.erase(it);
+			return below;
+		}
+
+		// Relinks the windows in the given top to bottom order, creating missing ones with createWindow(key).
+		// Windows not in the order are passed to destroyWindow(window) and erased.
+		template <typename CreateFunc, typename DestroyFunc>
+		void reset(const std::vector<Key>& order, CreateFunc createWindow, DestroyFunc destroyWindow)
+		{
+			for (auto& window : m_windows)
+			{
+				window.second.above = nullptr;
+				window.second.below = nullptr;
+			}
+			m_top = nullptr;
+			m_bottom = nullptr;
+
+			for (Key key : order)
+			{
+				auto it = m_windows.find(key);
+				if (it == m_windows.end())
+				{
+					it = m_windows.emplace(key, createWindow(key)).first;
+				}
+				link(it->second, m_bottom);
+			}
+
+			for (auto it = m_windows.begin(); it != m_windows.end();)
+			{
+				if (&it->second != m_top && !it->second.above)
+				{
+					destroyWindow(it->second);
+					it = m_windows.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+
+		// Updates the windows from start downward. A null lowestChanged updates all the way to the bottom.
+		template <typename Context, typename UpdateFunc>
+		void update(Window* start, Window* lowestChanged, Context& context, UpdateFunc updateWindow)
+		{
+			if (start && start->above)
+			{
+				context.obscuredRegion = start->above->obscuredRegion;
+			}
+
+			bool isLowestChangedReached = false;
+			for (auto window = start; window; window = window->below)
+			{
+				updateWindow(*window, context);
+
+				if (window == lowestChanged)
+				{
+					isLowestChangedReached = true;
+				}
+
+				if (isLowestChangedReached && window->obscuredRegion == context.obscuredRegion)
+				{
+					break;
+				}
+				window->obscuredRegion = context.obscuredRegion;
+			}
+		}
+
+	private:
+		Window* getHigher(Window* window1, Window* window2) const
+		{
+			for (auto window = m_top; window; window = window->below)
+			{
+				if (window == window1 || window == window2)
+				{
+					return window;
+				}
+			}
+			return nullptr;
+		}
+
+		void link(Window& window, Window* above)
+		{
+			window.above = above;
+			window.below = above ? above->below : m_top;
+			(above ? above->below : m_top) = &window;
+			(window.below ? window.below->above : m_bottom) = &window;
+		}
+
+		void unlink(Window& window)
+		{
+			(window.above ? window.above->below : m_top) = window.below;
+			(window.below ? window.below->above : m_bottom) = window.above;
+			window.above = nullptr;
+			window.below = nullptr;
+		}
+
+		std::unordered_map<Key, Window> m_windows;
+		Window* m_top;
+		Window* m_bottom;
+	};
+}
@@ -0,0 +1,53 @@
+#include <string>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <MetricsBlock.h>
+
+using namespace Compat::SharedMetrics;
+
+namespace MetricsReader
+{
+	void closeBlock(const Block* block)
+	{
+		if (!block)
+		{
+			return;
+		}
+#ifdef _WIN32
+		UnmapViewOfFile(block);
+#else
+		munmap(const_cast<Block*>(block), sizeof(Block));
+#endif
+	}
+
+	const Block* openBlock(unsigned long processId)
+	{
+		const std::string name(NAME_PREFIX + std::to_string(processId));
+#ifdef _WIN32
+		HANDLE mapping = OpenFileMapping(FILE_MAP_READ, FALSE, name.c_str());
+		if (!mapping)
+		{
+			return nullptr;
+		}
+		void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(Block));
+		CloseHandle(mapping);
+		return static_cast<const Block*>(view);
+#else
+		int fd = shm_open(name.c_str(), O_RDONLY, 0);
+		if (fd < 0)
+		{
+			return nullptr;
+		}
+		void* view = mmap(nullptr, sizeof(Block), PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		return MAP_FAILED == view ? nullptr : static_cast<const Block*>(view);
+#endif
+	}
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <Common/SharedMetricsLayout.h>
+
+namespace MetricsReader
+{
+	void closeBlock(const Compat::SharedMetrics::Block* block);
+	const Compat::SharedMetrics::Block* openBlock(unsigned long processId);
+}
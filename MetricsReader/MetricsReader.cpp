@@ -0,0 +1,97 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include <Common/SharedMetricsLayout.h>
+#include <MetricsBlock.h>
+
+using namespace Compat::SharedMetrics;
+
+namespace
+{
+	const unsigned MAX_READ_ATTEMPTS = 1000;
+
+	bool readSnapshot(const Block& block, Snapshot& snapshot)
+	{
+		for (unsigned attempt = 0; attempt < MAX_READ_ATTEMPTS; ++attempt)
+		{
+			if (!tryRead(block, snapshot))
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			if (MAGIC != snapshot.magic || VERSION != snapshot.version || snapshot.counterCount < COUNTER_COUNT)
+			{
+				std::fprintf(stderr, "Unsupported metrics block (magic 0x%08X, version %u, %u counters)\n",
+					snapshot.magic, snapshot.version, snapshot.counterCount);
+				return false;
+			}
+			return true;
+		}
+
+		std::fprintf(stderr, "Timed out waiting for a consistent metrics block\n");
+		return false;
+	}
+
+	void printSnapshot(const Snapshot& snapshot, const Snapshot* prevSnapshot)
+	{
+		double seconds = 0;
+		if (prevSnapshot && 0 != snapshot.qpcFrequency)
+		{
+			seconds = static_cast<double>(snapshot.qpcTimestamp - prevSnapshot->qpcTimestamp) / snapshot.qpcFrequency;
+		}
+
+		std::printf("pid %u, sequence %u\n", snapshot.processId, snapshot.sequence);
+		for (std::uint32_t i = 0; i < COUNTER_COUNT; ++i)
+		{
+			std::printf("  %-24s %16llu", COUNTER_NAMES[i], static_cast<unsigned long long>(snapshot.counters[i]));
+			if (seconds > 0)
+			{
+				std::printf(" %14.1f/s", (snapshot.counters[i] - prevSnapshot->counters[i]) / seconds);
+			}
+			std::printf("\n");
+		}
+		std::fflush(stdout);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		std::fprintf(stderr, "Usage: %s <pid> [interval ms] [sample count]\n", argv[0]);
+		return 1;
+	}
+
+	const unsigned long processId = std::strtoul(argv[1], nullptr, 10);
+	const unsigned long interval = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+	const unsigned long sampleCount = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 0;
+
+	const Block* block = MetricsReader::openBlock(processId);
+	if (!block)
+	{
+		std::fprintf(stderr, "No metrics block found for process %lu\n", processId);
+		return 1;
+	}
+
+	Snapshot snapshots[2] = {};
+	Snapshot* prevSnapshot = nullptr;
+	for (unsigned long sample = 0; 0 == sampleCount || sample < sampleCount; ++sample)
+	{
+		if (0 != sample)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(interval));
+		}
+
+		Snapshot& snapshot = snapshots[sample % 2];
+		if (!readSnapshot(*block, snapshot))
+		{
+			return 1;
+		}
+		printSnapshot(snapshot, prevSnapshot);
+		prevSnapshot = &snapshot;
+	}
+	return 0;
+}
@@ -0,0 +1,91 @@
+#include <sstream>
+#include <string>
+
+#include <D3dDdi/BatchStats.h>
+#include <Test.h>
+
+namespace
+{
+	std::string toString(const D3dDdi::BatchStats& stats)
+	{
+		std::ostringstream os;
+		os << stats;
+		return os.str();
+	}
+
+	bool contains(const std::string& str, const std::string& substr)
+	{
+		return std::string::npos != str.find(substr);
+	}
+}
+
+TEST_CASE(emptyStats)
+{
+	D3dDdi::BatchStats stats;
+	CHECK(stats.isEmpty());
+	CHECK("draws: 0, flushes: 0; vertices: none; indices: none; primitives: none; flush reasons: " == toString(stats));
+}
+
+TEST_CASE(drawsAndFlushesAreAggregated)
+{
+	D3dDdi::BatchStats stats;
+	for (UINT i = 0; i < 6; ++i)
+	{
+		stats.addDraw();
+	}
+	stats.addFlush("pfnPresent", 4, 0, 2);
+	stats.addFlush("pfnPresent", 12, 6, 4);
+	stats.addFlush("pfnLock", 200, 0, 100);
+	CHECK(!stats.isEmpty());
+
+	const std::string str = toString(stats);
+	CHECK(contains(str, "draws: 6, flushes: 3 (2 draws/flush)"));
+	CHECK(contains(str, "; vertices: avg 72, max 200 [4-7: 1, 8-15: 1, 128-255: 1];"));
+	CHECK(contains(str, "; indices: avg 2, max 6 [0: 2, 4-7: 1];"));
+	CHECK(contains(str, "; primitives: avg 35, max 100 [2-3: 1, 4-7: 1, 64-127: 1];"));
+}
+
+TEST_CASE(flushReasonsAreSortedByCount)
+{
+	D3dDdi::BatchStats stats;
+	stats.addFlush("pfnLock", 1, 0, 1);
+	for (UINT i = 0; i < 3; ++i)
+	{
+		stats.addFlush("pfnPresent", 1, 0, 1);
+	}
+	stats.addFlush("pfnSetRenderTarget", 1, 0, 1);
+	stats.addFlush("pfnSetRenderTarget", 1, 0, 1);
+	CHECK(contains(toString(stats), "flush reasons: pfnPresent=3, pfnSetRenderTarget=2, pfnLock=1"));
+}
+
+TEST_CASE(flushesOutsideDdiCallsAreNamed)
+{
+	D3dDdi::BatchStats stats;
+	stats.addFlush(nullptr, 1, 0, 1);
+	stats.addFlush(nullptr, 1, 0, 1);
+	stats.addFlush("pfnPresent", 1, 0, 1);
+	const std::string str = toString(stats);
+	CHECK(contains(str, std::string("flush reasons: ") + D3dDdi::BatchStats::OUTSIDE_DDI_CALL + "=2, pfnPresent=1"));
+	CHECK(!contains(str, "unknown"));
+}
+
+TEST_CASE(largeCountsFallInLastBucket)
+{
+	D3dDdi::BatchStats stats;
+	stats.addFlush("pfnPresent", 1000000, 0, 1);
+	CHECK(contains(toString(stats), "max 1000000 [131072+: 1]"));
+}
+
+TEST_CASE(resetStartsNewPeriod)
+{
+	D3dDdi::BatchStats stats;
+	stats.addDraw();
+	stats.addFlush("pfnPresent", 3, 3, 1);
+	stats.reset();
+	CHECK(stats.isEmpty());
+	CHECK("draws: 0, flushes: 0; vertices: none; indices: none; primitives: none; flush reasons: " == toString(stats));
+
+	stats.addFlush("pfnLock", 5, 0, 1);
+	CHECK(contains(toString(stats), "flushes: 1 (0 draws/flush); vertices: avg 5, max 5 [4-7: 1];"));
+	CHECK(contains(toString(stats), "flush reasons: pfnLock=1"));
+}
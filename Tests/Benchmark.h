@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+
+namespace Benchmark
+{
+	struct BenchmarkCase
+	{
+		const char* name;
+		void (*func)(unsigned iterationCount);
+	};
+
+	class Registrar
+	{
+	public:
+		Registrar(const char* name, void (*func)(unsigned iterationCount));
+	};
+
+	void doNotOptimize(const void* value);
+	std::vector<BenchmarkCase>& getBenchmarkCases();
+}
+
+#define BENCHMARK(name) \
+	static void name(unsigned iterationCount); \
+	static Benchmark::Registrar name##Registrar(#name, &name); \
+	static void name(unsigned iterationCount)
@@ -0,0 +1,56 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <Benchmark.h>
+
+namespace
+{
+	const double MIN_DURATION = 0.2;
+	const void* volatile g_sink = nullptr;
+
+	double run(const Benchmark::BenchmarkCase& benchmarkCase, unsigned iterationCount)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		benchmarkCase.func(iterationCount);
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+namespace Benchmark
+{
+	Registrar::Registrar(const char* name, void (*func)(unsigned iterationCount))
+	{
+		getBenchmarkCases().push_back({ name, func });
+	}
+
+	void doNotOptimize(const void* value)
+	{
+		g_sink = value;
+	}
+
+	std::vector<BenchmarkCase>& getBenchmarkCases()
+	{
+		static std::vector<BenchmarkCase> benchmarkCases;
+		return benchmarkCases;
+	}
+}
+
+// With --smoke every benchmark runs a single iteration, so ctest only checks that they still work
+int main(int argc, char* argv[])
+{
+	const bool isSmokeRun = argc > 1 && 0 == std::strcmp(argv[1], "--smoke");
+	for (const auto& benchmarkCase : Benchmark::getBenchmarkCases())
+	{
+		unsigned iterationCount = 1;
+		double duration = run(benchmarkCase, iterationCount);
+		while (!isSmokeRun && duration < MIN_DURATION && iterationCount < 0x40000000)
+		{
+			iterationCount *= 2;
+			duration = run(benchmarkCase, iterationCount);
+		}
+		std::printf("%-40s %12.1f ns/iteration (%u iterations)\n",
+			benchmarkCase.name, duration * 1e9 / iterationCount, iterationCount);
+	}
+	return 0;
+}
@@ -0,0 +1,140 @@
+#include <Common/CoalescedUpdate.h>
+#include <Test.h>
+
+namespace
+{
+	const unsigned PRESENT_INTERVAL = 16;
+
+	// Models the palette path of the primary surface: palette changes schedule an update only when they make the
+	// palette update pending, and the update thread applies the palette before presenting.
+	struct PaletteModel
+	{
+		Compat::CoalescedUpdate paletteUpdate;
+		bool isUpdatePending = false;
+		unsigned paletteVersion = 0;
+		unsigned appliedVersion = 0;
+		unsigned scheduleCount = 0;
+		unsigned throttleCount = 0;
+		unsigned presentCount = 0;
+
+		void changePalette()
+		{
+			++paletteVersion;
+			if (!paletteUpdate.request())
+			{
+				++throttleCount;
+				return;
+			}
+			++scheduleCount;
+			isUpdatePending = true;
+		}
+
+		void present()
+		{
+			if (!isUpdatePending)
+			{
+				return;
+			}
+			if (paletteUpdate.take())
+			{
+				appliedVersion = paletteVersion;
+			}
+			isUpdatePending = false;
+			++presentCount;
+		}
+
+		void restore()
+		{
+			isUpdatePending = false;
+			if (paletteUpdate.isPending())
+			{
+				isUpdatePending = true;
+			}
+		}
+
+		void release()
+		{
+			isUpdatePending = false;
+			paletteUpdate.reset();
+		}
+	};
+
+	// Runs a palette animation changing every changeInterval ms against a present every PRESENT_INTERVAL ms, and
+	// checks that no animated frame goes unpresented for longer than one present interval
+	void animate(PaletteModel& model, unsigned startMs, unsigned endMs, unsigned changeInterval)
+	{
+		for (unsigned ms = startMs; ms < endMs; ++ms)
+		{
+			if (0 == ms % changeInterval)
+			{
+				model.changePalette();
+			}
+			if (0 == ms % PRESENT_INTERVAL)
+			{
+				model.present();
+				CHECK(model.appliedVersion + PRESENT_INTERVAL / changeInterval + 1 >= model.paletteVersion);
+			}
+		}
+	}
+}
+
+TEST_CASE(onlyFirstRequestSchedules)
+{
+	Compat::CoalescedUpdate update;
+	CHECK(!update.isPending());
+	CHECK(!update.take());
+	CHECK(update.request());
+	CHECK(!update.request());
+	CHECK(update.isPending());
+	CHECK(update.take());
+	CHECK(!update.take());
+	CHECK(update.request());
+	update.reset();
+	CHECK(!update.isPending());
+	CHECK(update.request());
+}
+
+TEST_CASE(fastAnimationIsCoalescedToPresentRate)
+{
+	PaletteModel model;
+	animate(model, 1, 1001, 1);
+	CHECK(1000 == model.paletteVersion);
+	CHECK(model.scheduleCount <= model.presentCount + 1);
+	CHECK(1000 == model.scheduleCount + model.throttleCount);
+	CHECK(model.presentCount >= 1000 / PRESENT_INTERVAL - 1);
+}
+
+TEST_CASE(slowAnimationIsNotThrottled)
+{
+	PaletteModel model;
+	animate(model, 1, 1001, 2 * PRESENT_INTERVAL);
+	CHECK(0 == model.throttleCount);
+	CHECK(model.scheduleCount == model.presentCount);
+	CHECK(model.appliedVersion == model.paletteVersion);
+}
+
+TEST_CASE(animationContinuesAfterRestore)
+{
+	PaletteModel model;
+	animate(model, 1, 500, 1);
+	model.changePalette();
+	model.restore();
+	const unsigned presentCount = model.presentCount;
+	animate(model, 501, 1001, 1);
+	CHECK(model.presentCount >= presentCount + 500 / PRESENT_INTERVAL - 1);
+	model.present();
+	model.changePalette();
+	model.present();
+	CHECK(model.appliedVersion == model.paletteVersion);
+}
+
+TEST_CASE(animationContinuesAfterRelease)
+{
+	PaletteModel model;
+	animate(model, 1, 500, 1);
+	model.changePalette();
+	model.release();
+	const unsigned presentCount = model.presentCount;
+	animate(model, 501, 1001, 1);
+	CHECK(model.presentCount >= presentCount + 500 / PRESENT_INTERVAL - 1);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include <Windows.h>
+
+// Portable stand-in for the condition variable fallback of the vsync counter wait in KernelModeThunks.cpp
+struct ConditionVariableWait
+{
+	static void wait(std::atomic<UINT>& value, UINT expected)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (value == expected)
+		{
+			cv.wait(lock);
+		}
+	}
+
+	static void wakeAll(std::atomic<UINT>& /*value*/)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+		}
+		cv.notify_all();
+	}
+
+	static inline std::mutex mutex;
+	static inline std::condition_variable cv;
+};
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <DDraw/DamageAccumulator.h>
+#include <DDraw/DamageTracker.h>
+#include <Test.h>
+
+namespace
+{
+	const LONG GRID_SIZE = 64;
+	const RECT BOUNDS = { 0, 0, GRID_SIZE, GRID_SIZE };
+
+	typedef std::vector<bool> Mask;
+
+	void addToMask(Mask& mask, const RECT& rect)
+	{
+		for (LONG y = std::max<LONG>(rect.top, 0); y < std::min(rect.bottom, GRID_SIZE); ++y)
+		{
+			for (LONG x = std::max<LONG>(rect.left, 0); x < std::min(rect.right, GRID_SIZE); ++x)
+			{
+				mask[y * GRID_SIZE + x] = true;
+			}
+		}
+	}
+
+	Mask getMask(const std::vector<RECT>& rects)
+	{
+		Mask mask(GRID_SIZE * GRID_SIZE);
+		for (const auto& rect : rects)
+		{
+			addToMask(mask, rect);
+		}
+		return mask;
+	}
+
+	bool covers(const Mask& mask, const Mask& subset)
+	{
+		for (std::size_t i = 0; i < mask.size(); ++i)
+		{
+			if (subset[i] && !mask[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool isTouching(const RECT& rect1, const RECT& rect2)
+	{
+		return rect1.left <= rect2.right && rect2.left <= rect1.right &&
+			rect1.top <= rect2.bottom && rect2.top <= rect1.bottom;
+	}
+
+	RECT createRect(std::mt19937& random)
+	{
+		std::uniform_int_distribution<LONG> pos(-4, GRID_SIZE);
+		std::uniform_int_distribution<LONG> size(0, 12);
+		const LONG left = pos(random);
+		const LONG top = pos(random);
+		return { left, top, left + size(random), top + size(random) };
+	}
+
+	bool isEqual(const std::vector<RECT>& rects, const std::vector<RECT>& expected)
+	{
+		return rects.size() == expected.size() && std::equal(rects.begin(), rects.end(), expected.begin(),
+			[](const RECT& r1, const RECT& r2)
+			{
+				return r1.left == r2.left && r1.top == r2.top && r1.right == r2.right && r1.bottom == r2.bottom;
+			});
+	}
+}
+
+BOOL IntersectRect(RECT* dst, const RECT* src1, const RECT* src2)
+{
+	*dst = { std::max<LONG>(src1->left, src2->left), std::max<LONG>(src1->top, src2->top),
+		std::min<LONG>(src1->right, src2->right), std::min<LONG>(src1->bottom, src2->bottom) };
+	if (dst->left >= dst->right || dst->top >= dst->bottom)
+	{
+		*dst = {};
+		return FALSE;
+	}
+	return TRUE;
+}
+
+TEST_CASE(emptyRectsAreIgnored)
+{
+	DDraw::DamageTracker damage;
+	damage.add(RECT{ 5, 5, 5, 10 });
+	damage.add(RECT{ 5, 5, 10, 4 });
+	CHECK(damage.isEmpty());
+	CHECK(damage.getRects(BOUNDS).empty());
+}
+
+TEST_CASE(touchingRectsAreMerged)
+{
+	DDraw::DamageTracker damage;
+	damage.add(RECT{ 0, 0, 10, 10 });
+	damage.add(RECT{ 20, 0, 30, 10 });
+	CHECK(2 == damage.getRects(BOUNDS).size());
+	damage.add(RECT{ 10, 2, 20, 4 });
+	CHECK(isEqual(damage.getRects(BOUNDS), { { 0, 0, 30, 10 } }));
+}
+
+TEST_CASE(rectsAreClippedToBounds)
+{
+	DDraw::DamageTracker damage;
+	damage.add(RECT{ -5, -5, 5, 5 });
+	damage.add(RECT{ 100, 100, 110, 110 });
+	CHECK(isEqual(damage.getRects(BOUNDS), { { 0, 0, 5, 5 } }));
+}
+
+TEST_CASE(fullDamageCoversBounds)
+{
+	DDraw::DamageTracker damage;
+	damage.add(RECT{ 1, 1, 2, 2 });
+	damage.addAll();
+	damage.add(RECT{ 3, 3, 4, 4 });
+	CHECK(damage.isFull() && !damage.isEmpty());
+	CHECK(isEqual(damage.getRects(BOUNDS), { BOUNDS }));
+
+	DDraw::DamageTracker other;
+	other.add(damage);
+	CHECK(other.isFull());
+
+	damage.clear();
+	CHECK(damage.isEmpty() && !damage.isFull());
+}
+
+TEST_CASE(randomDamageIsCoveredAndBounded)
+{
+	std::mt19937 random(42);
+	for (unsigned round = 0; round < 300; ++round)
+	{
+		DDraw::DamageTracker damage;
+		std::vector<RECT> added;
+		const unsigned count = random() % 40;
+		for (unsigned i = 0; i < count; ++i)
+		{
+			added.push_back(createRect(random));
+			damage.add(added.back());
+		}
+
+		const auto rects = damage.getRects(BOUNDS);
+		CHECK(covers(getMask(rects), getMask(added)));
+		CHECK(rects.size() <= 16);
+
+		DDraw::DamageTracker unclipped;
+		unclipped.add(damage);
+		const auto allRects = unclipped.getRects({ -100, -100, 100, 100 });
+		for (std::size_t i = 0; i < allRects.size(); ++i)
+		{
+			for (std::size_t j = i + 1; j < allRects.size(); ++j)
+			{
+				CHECK(!isTouching(allRects[i], allRects[j]));
+			}
+		}
+	}
+}
+
+TEST_CASE(takeReturnsAndClearsDamage)
+{
+	DDraw::DamageAccumulator accumulator(60);
+	const RECT rect = { 1, 2, 3, 4 };
+	accumulator.add(&rect);
+	auto damage = accumulator.take();
+	CHECK(isEqual(damage.getRects(BOUNDS), { rect }));
+	CHECK(accumulator.take().isEmpty());
+
+	accumulator.add(nullptr);
+	CHECK(accumulator.take().isFull());
+	CHECK(accumulator.take().isEmpty());
+}
+
+TEST_CASE(requeuedDamageIsMerged)
+{
+	DDraw::DamageAccumulator accumulator(60);
+	const RECT rect1 = { 0, 0, 4, 4 };
+	const RECT rect2 = { 10, 10, 14, 14 };
+	accumulator.add(&rect1);
+	auto dropped = accumulator.take();
+	accumulator.add(&rect2);
+	accumulator.add(dropped);
+	CHECK(covers(getMask(accumulator.take().getRects(BOUNDS)), getMask({ rect1, rect2 })));
+}
+
+TEST_CASE(fullRefreshHappensPeriodically)
+{
+	DDraw::DamageAccumulator accumulator(4);
+	std::vector<bool> fullFrames;
+	for (unsigned i = 0; i < 12; ++i)
+	{
+		fullFrames.push_back(accumulator.take().isFull());
+	}
+	CHECK((fullFrames == std::vector<bool>{ false, false, false, true, false, false, false, true,
+		false, false, false, true }));
+}
@@ -0,0 +1,290 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <Gdi/DcAttributes.h>
+#include <Test.h>
+
+struct HDC__
+{
+	Gdi::DcAttributes attributes;
+	std::vector<std::string> calls;
+};
+
+namespace
+{
+	const POINT ORIGIN = { 3, -5 };
+	const XFORM IDENTITY = { 1, 0, 0, 1, 0, 0 };
+
+	HGDIOBJ getHandle(UINT_PTR value)
+	{
+		return reinterpret_cast<HGDIOBJ>(value);
+	}
+
+	HDC__ createDc()
+	{
+		HDC__ dc = {};
+		dc.attributes.font = getHandle(0x10);
+		dc.attributes.brush = getHandle(0x20);
+		dc.attributes.pen = getHandle(0x30);
+		dc.attributes.palette = getHandle(0x40);
+		dc.attributes.graphicsMode = GM_ADVANCED;
+		dc.attributes.transform = { 2, 0, 0, 2, 10, 20 };
+		dc.attributes.mapMode = MM_ANISOTROPIC;
+		dc.attributes.windowExt = { 100, 200 };
+		dc.attributes.viewportExt = { 300, 400 };
+		dc.attributes.windowOrg = { 1, 2 };
+		dc.attributes.viewportOrg = { 3, 4 };
+		dc.attributes.arcDirection = 2;
+		dc.attributes.bkColor = 0x123456;
+		dc.attributes.bkMode = 2;
+		dc.attributes.dcBrushColor = 0x234567;
+		dc.attributes.dcPenColor = 0x345678;
+		dc.attributes.layout = 1;
+		dc.attributes.polyFillMode = 2;
+		dc.attributes.rop2 = 7;
+		dc.attributes.stretchBltMode = 4;
+		dc.attributes.textAlign = 24;
+		dc.attributes.textCharacterExtra = 5;
+		dc.attributes.textColor = 0x456789;
+		dc.attributes.brushOrg = { 6, 7 };
+		dc.attributes.currentPos = { 8, 9 };
+		return dc;
+	}
+
+	template <typename T>
+	bool isEqual(const T& value1, const T& value2)
+	{
+		return 0 == std::memcmp(&value1, &value2, sizeof(T));
+	}
+
+	bool isEqual(const Gdi::DcAttributes& a1, const Gdi::DcAttributes& a2)
+	{
+		return isEqual(a1.font, a2.font) && isEqual(a1.brush, a2.brush) && isEqual(a1.pen, a2.pen) &&
+			isEqual(a1.palette, a2.palette) && isEqual(a1.graphicsMode, a2.graphicsMode) &&
+			isEqual(a1.transform, a2.transform) && isEqual(a1.mapMode, a2.mapMode) &&
+			isEqual(a1.windowExt, a2.windowExt) && isEqual(a1.viewportExt, a2.viewportExt) &&
+			isEqual(a1.windowOrg, a2.windowOrg) && isEqual(a1.viewportOrg, a2.viewportOrg) &&
+			isEqual(a1.arcDirection, a2.arcDirection) && isEqual(a1.bkColor, a2.bkColor) &&
+			isEqual(a1.bkMode, a2.bkMode) && isEqual(a1.dcBrushColor, a2.dcBrushColor) &&
+			isEqual(a1.dcPenColor, a2.dcPenColor) && isEqual(a1.layout, a2.layout) &&
+			isEqual(a1.polyFillMode, a2.polyFillMode) && isEqual(a1.rop2, a2.rop2) &&
+			isEqual(a1.stretchBltMode, a2.stretchBltMode) && isEqual(a1.textAlign, a2.textAlign) &&
+			isEqual(a1.textCharacterExtra, a2.textCharacterExtra) && isEqual(a1.textColor, a2.textColor) &&
+			isEqual(a1.brushOrg, a2.brushOrg) && isEqual(a1.currentPos, a2.currentPos);
+	}
+
+	template <typename T>
+	T set(HDC dc, const char* name, T& member, T value)
+	{
+		dc->calls.push_back(name);
+		const T prev = member;
+		member = value;
+		return prev;
+	}
+
+	template <typename T>
+	BOOL get(const T& member, T* value)
+	{
+		*value = member;
+		return TRUE;
+	}
+
+	std::vector<std::string> applyChange(Gdi::DcAttributes& (*modify)(Gdi::DcAttributes&))
+	{
+		HDC__ dc = createDc();
+		const Gdi::DcAttributes prev = dc.attributes;
+		Gdi::DcAttributes attributes = prev;
+		modify(attributes);
+		Gdi::setDcAttributes(&dc, attributes, &prev, ORIGIN);
+		return dc.calls;
+	}
+
+	std::vector<std::string> getCalls(std::initializer_list<const char*> calls)
+	{
+		return std::vector<std::string>(calls.begin(), calls.end());
+	}
+}
+
+HGDIOBJ GetCurrentObject(HDC dc, UINT type)
+{
+	switch (type)
+	{
+	case OBJ_FONT:
+		return dc->attributes.font;
+	case OBJ_BRUSH:
+		return dc->attributes.brush;
+	case OBJ_PEN:
+		return dc->attributes.pen;
+	case OBJ_PAL:
+		return dc->attributes.palette;
+	}
+	return nullptr;
+}
+
+int GetArcDirection(HDC dc) { return dc->attributes.arcDirection; }
+COLORREF GetBkColor(HDC dc) { return dc->attributes.bkColor; }
+int GetBkMode(HDC dc) { return dc->attributes.bkMode; }
+BOOL GetBrushOrgEx(HDC dc, POINT* point) { return get(dc->attributes.brushOrg, point); }
+BOOL GetCurrentPositionEx(HDC dc, POINT* point) { return get(dc->attributes.currentPos, point); }
+COLORREF GetDCBrushColor(HDC dc) { return dc->attributes.dcBrushColor; }
+COLORREF GetDCPenColor(HDC dc) { return dc->attributes.dcPenColor; }
+int GetGraphicsMode(HDC dc) { return dc->attributes.graphicsMode; }
+DWORD GetLayout(HDC dc) { return dc->attributes.layout; }
+int GetMapMode(HDC dc) { return dc->attributes.mapMode; }
+int GetPolyFillMode(HDC dc) { return dc->attributes.polyFillMode; }
+int GetROP2(HDC dc) { return dc->attributes.rop2; }
+int GetStretchBltMode(HDC dc) { return dc->attributes.stretchBltMode; }
+UINT GetTextAlign(HDC dc) { return dc->attributes.textAlign; }
+int GetTextCharacterExtra(HDC dc) { return dc->attributes.textCharacterExtra; }
+COLORREF GetTextColor(HDC dc) { return dc->attributes.textColor; }
+BOOL GetViewportExtEx(HDC dc, SIZE* size) { return get(dc->attributes.viewportExt, size); }
+BOOL GetViewportOrgEx(HDC dc, POINT* point) { return get(dc->attributes.viewportOrg, point); }
+BOOL GetWindowExtEx(HDC dc, SIZE* size) { return get(dc->attributes.windowExt, size); }
+BOOL GetWindowOrgEx(HDC dc, POINT* point) { return get(dc->attributes.windowOrg, point); }
+BOOL GetWorldTransform(HDC dc, XFORM* xform) { return get(dc->attributes.transform, xform); }
+
+BOOL ModifyWorldTransform(HDC dc, const XFORM* /*xform*/, DWORD mode)
+{
+	CHECK(MWT_IDENTITY == mode);
+	set(dc, "ModifyWorldTransform", dc->attributes.transform, IDENTITY);
+	return TRUE;
+}
+
+BOOL MoveToEx(HDC dc, int x, int y, POINT* /*point*/)
+{
+	set(dc, "MoveToEx", dc->attributes.currentPos, POINT{ x, y });
+	return TRUE;
+}
+
+HGDIOBJ SelectObject(HDC dc, HGDIOBJ obj)
+{
+	const UINT_PTR type = reinterpret_cast<UINT_PTR>(obj) & 0xF0;
+	HGDIOBJ& member = 0x10 == type ? dc->attributes.font : 0x20 == type ? dc->attributes.brush : dc->attributes.pen;
+	return set(dc, "SelectObject", member, obj);
+}
+
+HPALETTE SelectPalette(HDC dc, HPALETTE palette, BOOL /*forceBackground*/)
+{
+	return static_cast<HPALETTE>(set(dc, "SelectPalette", dc->attributes.palette, static_cast<HGDIOBJ>(palette)));
+}
+
+int SetArcDirection(HDC dc, int direction) { return set(dc, "SetArcDirection", dc->attributes.arcDirection, direction); }
+COLORREF SetBkColor(HDC dc, COLORREF color) { return set(dc, "SetBkColor", dc->attributes.bkColor, color); }
+int SetBkMode(HDC dc, int mode) { return set(dc, "SetBkMode", dc->attributes.bkMode, mode); }
+COLORREF SetDCBrushColor(HDC dc, COLORREF color) { return set(dc, "SetDCBrushColor", dc->attributes.dcBrushColor, color); }
+COLORREF SetDCPenColor(HDC dc, COLORREF color) { return set(dc, "SetDCPenColor", dc->attributes.dcPenColor, color); }
+int SetGraphicsMode(HDC dc, int mode) { return set(dc, "SetGraphicsMode", dc->attributes.graphicsMode, mode); }
+DWORD SetLayout(HDC dc, DWORD layout) { return set(dc, "SetLayout", dc->attributes.layout, layout); }
+int SetMapMode(HDC dc, int mode) { return set(dc, "SetMapMode", dc->attributes.mapMode, mode); }
+int SetPolyFillMode(HDC dc, int mode) { return set(dc, "SetPolyFillMode", dc->attributes.polyFillMode, mode); }
+int SetROP2(HDC dc, int rop2) { return set(dc, "SetROP2", dc->attributes.rop2, rop2); }
+int SetStretchBltMode(HDC dc, int mode) { return set(dc, "SetStretchBltMode", dc->attributes.stretchBltMode, mode); }
+UINT SetTextAlign(HDC dc, UINT align) { return set(dc, "SetTextAlign", dc->attributes.textAlign, align); }
+int SetTextCharacterExtra(HDC dc, int extra) { return set(dc, "SetTextCharacterExtra", dc->attributes.textCharacterExtra, extra); }
+COLORREF SetTextColor(HDC dc, COLORREF color) { return set(dc, "SetTextColor", dc->attributes.textColor, color); }
+
+BOOL SetBrushOrgEx(HDC dc, int x, int y, POINT* /*point*/)
+{
+	set(dc, "SetBrushOrgEx", dc->attributes.brushOrg, POINT{ x, y });
+	return TRUE;
+}
+
+BOOL SetViewportExtEx(HDC dc, int x, int y, SIZE* /*size*/)
+{
+	set(dc, "SetViewportExtEx", dc->attributes.viewportExt, SIZE{ x, y });
+	return TRUE;
+}
+
+BOOL SetViewportOrgEx(HDC dc, int x, int y, POINT* /*point*/)
+{
+	set(dc, "SetViewportOrgEx", dc->attributes.viewportOrg, POINT{ x, y });
+	return TRUE;
+}
+
+BOOL SetWindowExtEx(HDC dc, int x, int y, SIZE* /*size*/)
+{
+	set(dc, "SetWindowExtEx", dc->attributes.windowExt, SIZE{ x, y });
+	return TRUE;
+}
+
+BOOL SetWindowOrgEx(HDC dc, int x, int y, POINT* /*point*/)
+{
+	set(dc, "SetWindowOrgEx", dc->attributes.windowOrg, POINT{ x, y });
+	return TRUE;
+}
+
+BOOL SetWorldTransform(HDC dc, const XFORM* xform)
+{
+	set(dc, "SetWorldTransform", dc->attributes.transform, *xform);
+	return TRUE;
+}
+
+TEST_CASE(fullApplyCopiesAllAttributes)
+{
+	HDC__ src = createDc();
+	HDC__ dst = {};
+	const Gdi::DcAttributes attributes = Gdi::getDcAttributes(&src);
+	CHECK(isEqual(attributes, src.attributes));
+
+	Gdi::setDcAttributes(&dst, attributes, nullptr, ORIGIN);
+	Gdi::DcAttributes expected = attributes;
+	expected.viewportOrg.x += ORIGIN.x;
+	expected.viewportOrg.y += ORIGIN.y;
+	CHECK(isEqual(dst.attributes, expected));
+}
+
+TEST_CASE(unchangedAttributesAreSkipped)
+{
+	HDC__ dc = createDc();
+	const Gdi::DcAttributes attributes = Gdi::getDcAttributes(&dc);
+	Gdi::setDcAttributes(&dc, attributes, &attributes, ORIGIN);
+	CHECK(dc.calls.empty());
+}
+
+TEST_CASE(changedAttributesIssueOnlyTheirSetters)
+{
+	CHECK(applyChange([](auto& a) -> auto& { a.textColor = 0; return a; }) == getCalls({ "SetTextColor" }));
+	CHECK(applyChange([](auto& a) -> auto& { a.pen = getHandle(0x31); return a; }) == getCalls({ "SelectObject" }));
+	CHECK(applyChange([](auto& a) -> auto& { a.palette = getHandle(0x41); return a; }) ==
+		getCalls({ "SelectPalette" }));
+	CHECK(applyChange([](auto& a) -> auto& { a.viewportOrg.y = 0; return a; }) == getCalls({ "SetViewportOrgEx" }));
+	CHECK(applyChange([](auto& a) -> auto& { a.currentPos.x = 0; return a; }) == getCalls({ "MoveToEx" }));
+	CHECK(applyChange([](auto& a) -> auto& { a.windowExt.cx = 1; return a; }) ==
+		getCalls({ "SetMapMode", "SetWindowExtEx", "SetViewportExtEx" }));
+	CHECK(applyChange([](auto& a) -> auto& { a.transform.eDx = 0; return a; }) ==
+		getCalls({ "SetGraphicsMode", "SetWorldTransform" }));
+	CHECK(applyChange([](auto& a) -> auto& { a.bkMode = 1; a.rop2 = 13; return a; }) ==
+		getCalls({ "SetBkMode", "SetROP2" }));
+}
+
+TEST_CASE(leavingAdvancedModeResetsTransform)
+{
+	HDC__ dc = createDc();
+	const Gdi::DcAttributes prev = dc.attributes;
+	Gdi::DcAttributes attributes = prev;
+	attributes.graphicsMode = GM_COMPATIBLE;
+	attributes.transform = {};
+
+	Gdi::setDcAttributes(&dc, attributes, &prev, ORIGIN);
+	CHECK(dc.calls == getCalls({ "ModifyWorldTransform", "SetGraphicsMode" }));
+	CHECK(isEqual(dc.attributes.transform, IDENTITY));
+	CHECK(GM_COMPATIBLE == dc.attributes.graphicsMode);
+}
+
+TEST_CASE(textMapModeSkipsExtents)
+{
+	HDC__ src = createDc();
+	src.attributes.mapMode = MM_TEXT;
+	src.attributes.graphicsMode = GM_COMPATIBLE;
+	HDC__ dst = {};
+	const Gdi::DcAttributes attributes = Gdi::getDcAttributes(&src);
+	CHECK(isEqual(attributes.windowExt, SIZE{}));
+	CHECK(isEqual(attributes.transform, XFORM{}));
+
+	Gdi::setDcAttributes(&dst, attributes, nullptr, ORIGIN);
+	for (const auto& call : dst.calls)
+	{
+		CHECK("SetWindowExtEx" != call && "SetViewportExtEx" != call && "SetWorldTransform" != call);
+	}
+}
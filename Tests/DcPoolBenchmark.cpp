@@ -0,0 +1,64 @@
+#include <Gdi/DcPool.h>
+#include <Benchmark.h>
+
+namespace
+{
+	HDC getDc(UINT_PTR value)
+	{
+		return reinterpret_cast<HDC>(value);
+	}
+
+	void noop(Gdi::PooledDc&)
+	{
+	}
+
+	// One getDc/releaseDc pair per iteration, cycling through origDcCount original DCs
+	void getAndRelease(unsigned iterationCount, unsigned origDcCount)
+	{
+		Gdi::DcPool pool;
+		for (unsigned i = 0; i < origDcCount; ++i)
+		{
+			Gdi::PooledDc pooledDc = {};
+			pooledDc.dc = getDc(0x10000 + 4 * i);
+			pooledDc.origDc = getDc(0x100 * (i + 1));
+			pooledDc.refCount = 1;
+			pool.addInUse(pooledDc);
+			pool.release(pooledDc.origDc, noop);
+		}
+
+		for (unsigned i = 0; i < iterationCount; ++i)
+		{
+			const HDC origDc = getDc(0x100 * (i % origDcCount + 1));
+			Gdi::PooledDc pooledDc = pool.takeFree(origDc, false);
+			Benchmark::doNotOptimize(&pooledDc);
+			pooledDc.refCount = 1;
+			pool.addInUse(pooledDc);
+			pool.release(origDc, noop);
+		}
+	}
+}
+
+BENCHMARK(getAndReleaseSameDc)
+{
+	getAndRelease(iterationCount, 1);
+}
+
+BENCHMARK(getAndRelease16Dcs)
+{
+	getAndRelease(iterationCount, 16);
+}
+
+BENCHMARK(acquireNestedDc)
+{
+	Gdi::DcPool pool;
+	Gdi::PooledDc pooledDc = {};
+	pooledDc.dc = getDc(0x10000);
+	pooledDc.origDc = getDc(0x100);
+	pooledDc.refCount = 1;
+	pool.addInUse(pooledDc);
+	for (unsigned i = 0; i < iterationCount; ++i)
+	{
+		Benchmark::doNotOptimize(pool.acquireInUse(pooledDc.origDc));
+		pool.release(pooledDc.origDc, noop);
+	}
+}
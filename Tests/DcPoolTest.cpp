@@ -0,0 +1,260 @@
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <Gdi/DcPool.h>
+#include <Test.h>
+
+namespace
+{
+	const unsigned THREAD_COUNT = 4;
+	const unsigned ORIG_DC_COUNT = 8;
+	const unsigned ITERATION_COUNT = 20000;
+
+	std::atomic<UINT_PTR> g_nextDc = 0x10000;
+
+	HDC getDc(UINT_PTR value)
+	{
+		return reinterpret_cast<HDC>(value);
+	}
+
+	Gdi::PooledDc createPooledDc(HDC origDc, bool useDefaultPalette = false)
+	{
+		Gdi::PooledDc pooledDc = {};
+		pooledDc.dc = getDc(g_nextDc += 4);
+		pooledDc.origDc = origDc;
+		pooledDc.useDefaultPalette = useDefaultPalette;
+		pooledDc.refCount = 1;
+		return pooledDc;
+	}
+
+	void noop(Gdi::PooledDc&)
+	{
+	}
+
+	// Stand-ins for the driver lock, the clip generation and the DC bitmaps replaced by VirtualScreen::update
+	struct VirtualScreen
+	{
+		std::mutex driverLock;
+		std::atomic<UINT> clipGeneration = 1;
+		UINT surfaceVersion = 1;
+
+		void update()
+		{
+			std::lock_guard<std::mutex> lock(driverLock);
+			++surfaceVersion;
+			++clipGeneration;
+		}
+	};
+
+	// Follows Gdi::Dc::getDc and records the surface version each compat DC was set up for
+	class DcModel
+	{
+	public:
+		DcModel(VirtualScreen& virtualScreen) : m_virtualScreen(virtualScreen), m_isValid(true) {}
+
+		HDC getDc(HDC origDc)
+		{
+			Gdi::PooledDc* inUseDc = m_pool.acquireInUse(origDc);
+			if (inUseDc)
+			{
+				return inUseDc->dc;
+			}
+
+			Gdi::PooledDc pooledDc = m_pool.takeFree(origDc, false);
+			const HWND hwnd = reinterpret_cast<HWND>(origDc);
+			const POINT dcOrg = {};
+			{
+				std::lock_guard<std::mutex> lock(m_virtualScreen.driverLock);
+				const UINT clipGeneration = m_virtualScreen.clipGeneration;
+				if (pooledDc.isValidFor(origDc, hwnd, dcOrg, clipGeneration))
+				{
+					m_isValid = m_isValid && m_surfaceVersions[pooledDc.dc] == m_virtualScreen.surfaceVersion;
+					++m_reuseCount;
+				}
+				else
+				{
+					if (!pooledDc.dc)
+					{
+						pooledDc.dc = createPooledDc(origDc).dc;
+					}
+					pooledDc.origDc = origDc;
+					pooledDc.hwnd = hwnd;
+					pooledDc.dcOrg = dcOrg;
+					pooledDc.clipGeneration = clipGeneration;
+					m_surfaceVersions[pooledDc.dc] = m_virtualScreen.surfaceVersion;
+				}
+			}
+
+			pooledDc.refCount = 1;
+			m_pool.addInUse(pooledDc);
+			return pooledDc.dc;
+		}
+
+		void releaseDc(HDC origDc)
+		{
+			m_isValid = m_isValid && m_pool.release(origDc, noop);
+		}
+
+		Gdi::DcPool& getPool() { return m_pool; }
+		unsigned getReuseCount() const { return m_reuseCount; }
+		bool isValid() const { return m_isValid; }
+
+	private:
+		VirtualScreen& m_virtualScreen;
+		Gdi::DcPool m_pool;
+		std::unordered_map<HDC, UINT> m_surfaceVersions;
+		unsigned m_reuseCount = 0;
+		bool m_isValid;
+	};
+}
+
+TEST_CASE(inUseDcIsSharedAndCounted)
+{
+	Gdi::DcPool pool;
+	const HDC origDc = getDc(0x100);
+	CHECK(!pool.acquireInUse(origDc));
+
+	const Gdi::PooledDc pooledDc = createPooledDc(origDc);
+	pool.addInUse(pooledDc);
+	CHECK(origDc == pool.getOrigDc(pooledDc.dc));
+	CHECK(!pool.getOrigDc(origDc));
+
+	Gdi::PooledDc* inUseDc = pool.acquireInUse(origDc);
+	CHECK(inUseDc && pooledDc.dc == inUseDc->dc && 2 == inUseDc->refCount);
+
+	unsigned freeCount = 0;
+	auto onFree = [&](Gdi::PooledDc&) { ++freeCount; };
+	CHECK(pool.release(origDc, onFree));
+	CHECK(0 == freeCount);
+	CHECK(origDc == pool.getOrigDc(pooledDc.dc));
+	CHECK(pool.release(origDc, onFree));
+	CHECK(1 == freeCount);
+	CHECK(!pool.getOrigDc(pooledDc.dc));
+	CHECK(!pool.acquireInUse(origDc));
+	CHECK(!pool.release(origDc, onFree));
+}
+
+TEST_CASE(freeDcForSameOrigDcIsPreferred)
+{
+	Gdi::DcPool pool;
+	const HDC origDc1 = getDc(0x100);
+	const HDC origDc2 = getDc(0x200);
+	const Gdi::PooledDc pooledDc1 = createPooledDc(origDc1);
+	const Gdi::PooledDc pooledDc2 = createPooledDc(origDc2);
+	pool.addInUse(pooledDc1);
+	pool.addInUse(pooledDc2);
+	pool.release(origDc1, noop);
+	pool.release(origDc2, noop);
+
+	CHECK(pooledDc1.dc == pool.takeFree(origDc1, false).dc);
+	CHECK(pooledDc2.dc == pool.takeFree(getDc(0x300), false).dc);
+	CHECK(!pool.takeFree(origDc2, false).dc);
+}
+
+TEST_CASE(freeListsAreSplitByPalette)
+{
+	Gdi::DcPool pool;
+	const HDC origDc = getDc(0x100);
+	const Gdi::PooledDc pooledDc = createPooledDc(origDc, true);
+	pool.addInUse(pooledDc);
+	pool.release(origDc, noop);
+
+	CHECK(!pool.takeFree(origDc, false).dc);
+	CHECK(pooledDc.dc == pool.takeFree(origDc, true).dc);
+}
+
+TEST_CASE(clearVisitsAllDcs)
+{
+	Gdi::DcPool pool;
+	const Gdi::PooledDc inUseDc = createPooledDc(getDc(0x100));
+	const Gdi::PooledDc freeDc = createPooledDc(getDc(0x200));
+	const Gdi::PooledDc defPalFreeDc = createPooledDc(getDc(0x300), true);
+	pool.addInUse(inUseDc);
+	pool.addInUse(freeDc);
+	pool.addInUse(defPalFreeDc);
+	pool.release(freeDc.origDc, noop);
+	pool.release(defPalFreeDc.origDc, noop);
+
+	std::vector<HDC> inUseDcs;
+	std::vector<HDC> freeDcs;
+	pool.clear([&](Gdi::PooledDc& dc) { inUseDcs.push_back(dc.dc); },
+		[&](Gdi::PooledDc& dc) { freeDcs.push_back(dc.dc); });
+	CHECK(1 == inUseDcs.size() && inUseDc.dc == inUseDcs[0]);
+	CHECK(2 == freeDcs.size());
+	CHECK(!pool.acquireInUse(inUseDc.origDc));
+	CHECK(!pool.takeFree(freeDc.origDc, false).dc);
+	CHECK(!pool.takeFree(defPalFreeDc.origDc, true).dc);
+}
+
+TEST_CASE(reuseRequiresMatchingKey)
+{
+	Gdi::PooledDc pooledDc = createPooledDc(getDc(0x100));
+	pooledDc.hwnd = reinterpret_cast<HWND>(0x10);
+	pooledDc.dcOrg = { 5, 6 };
+	pooledDc.clipGeneration = 7;
+
+	const HWND hwnd = pooledDc.hwnd;
+	CHECK(pooledDc.isValidFor(pooledDc.origDc, hwnd, { 5, 6 }, 7));
+	CHECK(!pooledDc.isValidFor(getDc(0x200), hwnd, { 5, 6 }, 7));
+	CHECK(!pooledDc.isValidFor(pooledDc.origDc, reinterpret_cast<HWND>(0x20), { 5, 6 }, 7));
+	CHECK(!pooledDc.isValidFor(pooledDc.origDc, hwnd, { 5, 7 }, 7));
+	CHECK(!pooledDc.isValidFor(pooledDc.origDc, hwnd, { 4, 6 }, 7));
+	CHECK(!pooledDc.isValidFor(pooledDc.origDc, hwnd, { 5, 6 }, 8));
+}
+
+TEST_CASE(concurrentPoolsNeverReuseStaleDcs)
+{
+	VirtualScreen virtualScreen;
+	std::atomic<unsigned> doneCount = 0;
+	std::atomic<bool> isValid = true;
+	std::atomic<unsigned> reuseCount = 0;
+
+	std::vector<std::thread> threads;
+	for (unsigned i = 0; i < THREAD_COUNT; ++i)
+	{
+		threads.emplace_back([&, i]()
+			{
+				DcModel model(virtualScreen);
+				std::mt19937 rng(i);
+				std::uniform_int_distribution<unsigned> origDcDist(1, ORIG_DC_COUNT);
+				std::uniform_int_distribution<unsigned> depthDist(1, 3);
+				for (unsigned j = 0; j < ITERATION_COUNT; ++j)
+				{
+					const HDC origDc = getDc(origDcDist(rng) * 0x100);
+					const unsigned depth = depthDist(rng);
+					HDC dc = nullptr;
+					for (unsigned k = 0; k < depth; ++k)
+					{
+						HDC nestedDc = model.getDc(origDc);
+						isValid = isValid && (!dc || dc == nestedDc) && origDc == model.getPool().getOrigDc(nestedDc);
+						dc = nestedDc;
+					}
+					for (unsigned k = 0; k < depth; ++k)
+					{
+						model.releaseDc(origDc);
+					}
+					isValid = isValid && !model.getPool().acquireInUse(origDc);
+				}
+				isValid = isValid && model.isValid();
+				reuseCount += model.getReuseCount();
+				++doneCount;
+			});
+	}
+
+	while (doneCount < THREAD_COUNT)
+	{
+		virtualScreen.update();
+		std::this_thread::yield();
+	}
+
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+	CHECK(isValid);
+	CHECK(0 != reuseCount);
+}
@@ -0,0 +1,168 @@
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include <Gdi/DisplayDcCache.h>
+#include <Gdi/Gdi.h>
+#include <Test.h>
+
+namespace
+{
+	std::mutex g_mutex;
+	std::map<HDC, bool> g_displayDcs;
+	std::atomic<unsigned> g_classifyCount = 0;
+
+	HDC getDc(UINT_PTR value)
+	{
+		return reinterpret_cast<HDC>(value);
+	}
+
+	void setDisplayDc(HDC dc, bool isDisplayDc)
+	{
+		std::lock_guard<std::mutex> lock(g_mutex);
+		g_displayDcs[dc] = isDisplayDc;
+	}
+}
+
+namespace Gdi
+{
+	bool isDisplayDc(HDC dc)
+	{
+		++g_classifyCount;
+		std::lock_guard<std::mutex> lock(g_mutex);
+		auto it = g_displayDcs.find(dc);
+		return it != g_displayDcs.end() && it->second;
+	}
+}
+
+TEST_CASE(nullDcIsNotClassified)
+{
+	const unsigned classifyCount = g_classifyCount;
+	CHECK(!Gdi::DisplayDcCache::isDisplayDc(nullptr));
+	CHECK(classifyCount == g_classifyCount);
+}
+
+TEST_CASE(repeatedLookupsClassifyOnce)
+{
+	const HDC dc = getDc(0x1000);
+	setDisplayDc(dc, true);
+	const unsigned classifyCount = g_classifyCount;
+	for (int i = 0; i < 100; ++i)
+	{
+		CHECK(Gdi::DisplayDcCache::isDisplayDc(dc));
+	}
+	CHECK(classifyCount + 1 == g_classifyCount);
+}
+
+TEST_CASE(invalidatedDcIsReclassified)
+{
+	const HDC dc = getDc(0x2000);
+	setDisplayDc(dc, true);
+	CHECK(Gdi::DisplayDcCache::isDisplayDc(dc));
+
+	setDisplayDc(dc, false);
+	CHECK(Gdi::DisplayDcCache::isDisplayDc(dc));
+	Gdi::DisplayDcCache::invalidate(dc);
+	CHECK(!Gdi::DisplayDcCache::isDisplayDc(dc));
+}
+
+TEST_CASE(invalidatingOneDcKeepsOthers)
+{
+	const HDC dc1 = getDc(0x3000);
+	const HDC dc2 = getDc(0x3004);
+	setDisplayDc(dc1, true);
+	setDisplayDc(dc2, true);
+	CHECK(Gdi::DisplayDcCache::isDisplayDc(dc1));
+	CHECK(Gdi::DisplayDcCache::isDisplayDc(dc2));
+
+	const unsigned classifyCount = g_classifyCount;
+	Gdi::DisplayDcCache::invalidate(dc1);
+	CHECK(Gdi::DisplayDcCache::isDisplayDc(dc2));
+	CHECK(classifyCount == g_classifyCount);
+	CHECK(Gdi::DisplayDcCache::isDisplayDc(dc1));
+	CHECK(classifyCount + 1 == g_classifyCount);
+}
+
+TEST_CASE(collidingDcsAreClassifiedSeparately)
+{
+	const HDC dc1 = getDc(0x4000);
+	const HDC dc2 = getDc(0x4000 + 64 * 4);
+	setDisplayDc(dc1, true);
+	setDisplayDc(dc2, false);
+	for (int i = 0; i < 3; ++i)
+	{
+		CHECK(Gdi::DisplayDcCache::isDisplayDc(dc1));
+		CHECK(!Gdi::DisplayDcCache::isDisplayDc(dc2));
+	}
+}
+
+TEST_CASE(globalInvalidationReclassifiesAll)
+{
+	const HDC dc1 = getDc(0x5000);
+	const HDC dc2 = getDc(0x5010);
+	setDisplayDc(dc1, true);
+	setDisplayDc(dc2, true);
+	CHECK(Gdi::DisplayDcCache::isDisplayDc(dc1));
+	CHECK(Gdi::DisplayDcCache::isDisplayDc(dc2));
+
+	setDisplayDc(dc1, false);
+	setDisplayDc(dc2, false);
+	Gdi::DisplayDcCache::invalidate();
+	CHECK(!Gdi::DisplayDcCache::isDisplayDc(dc1));
+	CHECK(!Gdi::DisplayDcCache::isDisplayDc(dc2));
+}
+
+TEST_CASE(recycledDcIsReclassifiedOnOtherThreads)
+{
+	const HDC dc = getDc(0x6000);
+	setDisplayDc(dc, true);
+	CHECK(Gdi::DisplayDcCache::isDisplayDc(dc));
+
+	// Another thread releases the HDC and gets it back for a different window, as user32 does with DCE handles
+	std::thread([=]()
+		{
+			Gdi::DisplayDcCache::invalidate(dc);
+			setDisplayDc(dc, false);
+			Gdi::DisplayDcCache::invalidate(dc);
+			CHECK(!Gdi::DisplayDcCache::isDisplayDc(dc));
+		}).join();
+
+	CHECK(!Gdi::DisplayDcCache::isDisplayDc(dc));
+}
+
+TEST_CASE(concurrentLookupsSeeInvalidations)
+{
+	const HDC dc = getDc(0x7000);
+	setDisplayDc(dc, false);
+	std::atomic<unsigned> version = 0;
+	std::atomic<bool> stop = false;
+
+	std::thread reader([&]()
+		{
+			while (!stop)
+			{
+				const unsigned expectedVersion = version;
+				if (0 != expectedVersion % 2)
+				{
+					continue;
+				}
+				const bool isDisplayDc = Gdi::DisplayDcCache::isDisplayDc(dc);
+				if (expectedVersion == version)
+				{
+					CHECK(isDisplayDc == (1 == expectedVersion / 2 % 2));
+				}
+			}
+		});
+
+	// Odd versions mark a change in progress
+	for (unsigned i = 1; i <= 10000; ++i)
+	{
+		version = 2 * i - 1;
+		setDisplayDc(dc, 1 == i % 2);
+		Gdi::DisplayDcCache::invalidate(dc);
+		version = 2 * i;
+	}
+	stop = true;
+	reader.join();
+}
@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <Windows.h>
+
+#include <DDraw/Surfaces/FlipChain.h>
+#include <Test.h>
+
+namespace
+{
+	const int DRIVER_RESOURCE_BASE = 100;
+	const int RUNTIME_HANDLE_BASE = 200;
+
+	// Backing of a chain member, which runtime flips move between the members together
+	struct Buffer
+	{
+		int memory;
+		int driverResource;
+		int runtimeHandle;
+	};
+
+	struct Surface
+	{
+		Buffer buffer;
+	};
+
+	// Flip chain with the runtime flip semantics, front first. Each surface memory holds the number of the frame
+	// last drawn to it. The GDI surface is the one created as the front, backed by the virtual screen.
+	class FakeChain
+	{
+	public:
+		std::vector<Surface> surfaces;
+		std::vector<int> contents;
+		int frontResource = DRIVER_RESOURCE_BASE;
+		bool isEmulatedChain = true;
+		bool isFullScreenMode = false;
+		bool isFlipRefused = false;
+		UINT flipCount = 0;
+		UINT bltCount = 0;
+
+		FakeChain(int count)
+			: surfaces(count)
+			, contents(count)
+		{
+			for (int i = 0; i < count; ++i)
+			{
+				surfaces[i].buffer = { i, DRIVER_RESOURCE_BASE + i, RUNTIME_HANDLE_BASE + i };
+			}
+		}
+
+		Surface* getBackBuffer() { return &surfaces[1]; }
+		int getFrontContent() const { return contents[surfaces[0].buffer.memory]; }
+		bool isEmulated() const { return isEmulatedChain; }
+		bool isFullScreen() const { return isFullScreenMode; }
+
+		bool isGdiSurface(const Surface* surface) const
+		{
+			return surface && RUNTIME_HANDLE_BASE == surface->buffer.runtimeHandle;
+		}
+
+		HRESULT flip(Surface* target)
+		{
+			if (isFlipRefused)
+			{
+				return E_FAIL;
+			}
+
+			if (target)
+			{
+				std::swap(surfaces[0].buffer, target->buffer);
+			}
+			else
+			{
+				std::rotate(surfaces.begin(), surfaces.begin() + 1, surfaces.end());
+			}
+			return S_OK;
+		}
+
+		HRESULT presentFlip(Surface* /*target*/)
+		{
+			++flipCount;
+			frontResource = surfaces[0].buffer.driverResource;
+			return S_OK;
+		}
+
+		HRESULT presentBlt(Surface* src)
+		{
+			++bltCount;
+			contents[surfaces[0].buffer.memory] = contents[src->buffer.memory];
+			return S_OK;
+		}
+	};
+
+	void checkConsistent(const FakeChain& chain)
+	{
+		std::vector<int> memories;
+		for (const auto& surface : chain.surfaces)
+		{
+			memories.push_back(surface.buffer.memory);
+			CHECK(DRIVER_RESOURCE_BASE + surface.buffer.memory == surface.buffer.driverResource);
+			CHECK(RUNTIME_HANDLE_BASE + surface.buffer.memory == surface.buffer.runtimeHandle);
+		}
+		std::sort(memories.begin(), memories.end());
+		for (int i = 0; i < static_cast<int>(memories.size()); ++i)
+		{
+			CHECK(i == memories[i]);
+		}
+		CHECK(chain.surfaces[0].buffer.driverResource == chain.frontResource);
+	}
+
+	int draw(FakeChain& chain, Surface* target, int frame)
+	{
+		Surface* src = target ? target : chain.getBackBuffer();
+		chain.contents[src->buffer.memory] = frame;
+		return DDraw::flipChain(chain, target);
+	}
+}
+
+TEST_CASE(fullScreenFlipsRotateWithoutCopies)
+{
+	FakeChain chain(3);
+	chain.isFullScreenMode = true;
+
+	for (int frame = 1; frame <= 6; ++frame)
+	{
+		CHECK(S_OK == draw(chain, nullptr, frame));
+		CHECK(frame == chain.getFrontContent());
+		CHECK(frame % 3 == chain.surfaces[0].buffer.memory);
+		checkConsistent(chain);
+	}
+	CHECK(6 == chain.flipCount);
+	CHECK(0 == chain.bltCount);
+}
+
+TEST_CASE(targetOverrideSwapsWithFront)
+{
+	FakeChain chain(3);
+	chain.isFullScreenMode = true;
+
+	CHECK(S_OK == draw(chain, &chain.surfaces[2], 1));
+	CHECK(1 == chain.getFrontContent());
+	CHECK(2 == chain.surfaces[0].buffer.memory);
+	CHECK(1 == chain.surfaces[1].buffer.memory);
+	CHECK(0 == chain.surfaces[2].buffer.memory);
+	CHECK(0 == chain.bltCount);
+	checkConsistent(chain);
+}
+
+TEST_CASE(windowedEmulatedChainIsPinned)
+{
+	FakeChain chain(3);
+
+	CHECK(S_OK == draw(chain, nullptr, 1));
+	CHECK(S_OK == draw(chain, &chain.surfaces[2], 2));
+	CHECK(2 == chain.getFrontContent());
+	CHECK(chain.isGdiSurface(&chain.surfaces[0]));
+	CHECK(0 == chain.flipCount);
+	CHECK(2 == chain.bltCount);
+	checkConsistent(chain);
+}
+
+TEST_CASE(windowedFlipToGdiSurfaceUnpins)
+{
+	FakeChain chain(3);
+	chain.isFullScreenMode = true;
+	CHECK(S_OK == draw(chain, nullptr, 1));
+	CHECK(chain.isGdiSurface(&chain.surfaces[2]));
+
+	chain.isFullScreenMode = false;
+	CHECK(S_OK == DDraw::flipChain(chain, &chain.surfaces[2]));
+	CHECK(chain.isGdiSurface(&chain.surfaces[0]));
+	CHECK(2 == chain.flipCount);
+	CHECK(0 == chain.bltCount);
+	checkConsistent(chain);
+}
+
+TEST_CASE(windowedNonEmulatedChainFlips)
+{
+	FakeChain chain(2);
+	chain.isEmulatedChain = false;
+
+	CHECK(S_OK == draw(chain, nullptr, 1));
+	CHECK(1 == chain.getFrontContent());
+	CHECK(1 == chain.surfaces[0].buffer.memory);
+	CHECK(0 == chain.bltCount);
+	checkConsistent(chain);
+}
+
+TEST_CASE(refusedFlipFallsBackToBlit)
+{
+	FakeChain chain(3);
+	chain.isFullScreenMode = true;
+	chain.isFlipRefused = true;
+
+	CHECK(S_OK == draw(chain, nullptr, 1));
+	CHECK(1 == chain.getFrontContent());
+	CHECK(0 == chain.surfaces[0].buffer.memory);
+	CHECK(0 == chain.flipCount);
+	CHECK(1 == chain.bltCount);
+	checkConsistent(chain);
+}
+
+TEST_CASE(refusedFlipFailsWithoutEmulation)
+{
+	FakeChain chain(3);
+	chain.isEmulatedChain = false;
+	chain.isFullScreenMode = true;
+	chain.isFlipRefused = true;
+
+	CHECK(E_FAIL == draw(chain, nullptr, 1));
+	CHECK(0 == chain.flipCount);
+	CHECK(0 == chain.bltCount);
+	checkConsistent(chain);
+}
+
+TEST_CASE(randomFlipsKeepChainConsistent)
+{
+	std::mt19937 random(42);
+	for (int count = 2; count <= 4; ++count)
+	{
+		FakeChain chain(count);
+		for (int frame = 1; frame <= 2000; ++frame)
+		{
+			if (0 == random() % 16)
+			{
+				chain.isFullScreenMode = !chain.isFullScreenMode;
+			}
+			chain.isFlipRefused = 0 == random() % 8;
+
+			const int targetIndex = random() % count;
+			Surface* target = 0 == targetIndex ? nullptr : &chain.surfaces[targetIndex];
+			const bool wasGdiFront = chain.isGdiSurface(&chain.surfaces[0]);
+			const UINT bltCount = chain.bltCount;
+
+			CHECK(S_OK == draw(chain, target, frame));
+			CHECK(frame == chain.getFrontContent());
+			checkConsistent(chain);
+
+			if (!chain.isFullScreenMode && wasGdiFront)
+			{
+				CHECK(chain.isGdiSurface(&chain.surfaces[0]));
+			}
+			if (chain.isFullScreenMode && !chain.isFlipRefused)
+			{
+				CHECK(bltCount == chain.bltCount);
+			}
+		}
+	}
+}
@@ -0,0 +1,197 @@
+#include <cstdlib>
+#include <vector>
+
+#include <DDraw/FramePacer.h>
+#include <Test.h>
+
+namespace
+{
+	const long long FREQUENCY = 1000000;
+	const long long FRAME_INTERVAL = FREQUENCY / 60;
+
+	// Virtual clock in microseconds. Sleeps overshoot by a fixed amount, spins advance by one tick and render time
+	// is added by the test between frames.
+	class VirtualClock
+	{
+	public:
+		long long qpc = 1000;
+		long long oversleep = 0;
+		long long vblankInterval = 0;
+		long long vblankPhase = 0;
+		UINT sleepCount = 0;
+		UINT spinCount = 0;
+
+		long long getFrequency() const { return FREQUENCY; }
+
+		long long getNextVblank(long long qpcAfter) const
+		{
+			const long long qpcVblank = (qpcAfter - vblankPhase) / vblankInterval * vblankInterval + vblankPhase;
+			return qpcVblank < qpcAfter ? qpcVblank + vblankInterval : qpcVblank;
+		}
+
+		long long now() const { return qpc; }
+
+		void sleepUntil(long long qpcTarget)
+		{
+			++sleepCount;
+			qpc = std::max(qpc, qpcTarget + oversleep);
+		}
+
+		void spin()
+		{
+			++spinCount;
+			++qpc;
+		}
+	};
+
+	typedef DDraw::FramePacer<VirtualClock> Pacer;
+
+	std::vector<long long> runFrames(VirtualClock& clock, Pacer& pacer, UINT frameCount, long long renderTime,
+		bool alignToVblank = false)
+	{
+		std::vector<long long> frameTimes;
+		for (UINT i = 0; i < frameCount; ++i)
+		{
+			clock.qpc += renderTime;
+			pacer.waitForNextFrame(FRAME_INTERVAL, alignToVblank);
+			frameTimes.push_back(clock.qpc);
+		}
+		return frameTimes;
+	}
+}
+
+TEST_CASE(firstFrameDoesNotWait)
+{
+	VirtualClock clock;
+	Pacer pacer(clock);
+	pacer.waitForNextFrame(FRAME_INTERVAL, false);
+	CHECK(1000 == clock.qpc);
+	CHECK(0 == clock.sleepCount && 0 == clock.spinCount);
+	CHECK(0 == pacer.getFrameCount());
+}
+
+TEST_CASE(fastFramesArePacedToInterval)
+{
+	VirtualClock clock;
+	Pacer pacer(clock);
+	const auto frameTimes = runFrames(clock, pacer, 100, 1000);
+	for (std::size_t i = 1; i < frameTimes.size(); ++i)
+	{
+		CHECK(frameTimes[i] == frameTimes[0] + static_cast<long long>(i) * FRAME_INTERVAL);
+	}
+	CHECK(99 == pacer.getFrameCount());
+	CHECK(0 == pacer.getLateFrameCount());
+}
+
+TEST_CASE(sleepsBeforeSpinning)
+{
+	VirtualClock clock;
+	Pacer pacer(clock);
+	runFrames(clock, pacer, 10, 1000);
+	CHECK(9 == clock.sleepCount);
+	// Only the spin margin is spun: the 250 us minimum margin with a precise sleep
+	CHECK(clock.spinCount <= 9 * 2000);
+	CHECK(250 == pacer.getSpinMargin());
+}
+
+TEST_CASE(spinMarginAdaptsToOversleep)
+{
+	VirtualClock clock;
+	clock.oversleep = 1000;
+	Pacer pacer(clock);
+	const auto frameTimes = runFrames(clock, pacer, 200, 1000);
+	CHECK(pacer.getSpinMargin() > 2000 && pacer.getSpinMargin() <= 2100);
+	CHECK(0 == pacer.getLateFrameCount());
+	for (std::size_t i = 100; i < frameTimes.size(); ++i)
+	{
+		CHECK(frameTimes[i] - frameTimes[i - 1] == FRAME_INTERVAL);
+	}
+}
+
+TEST_CASE(spinMarginIsCapped)
+{
+	VirtualClock clock;
+	clock.oversleep = 10000;
+	Pacer pacer(clock);
+	runFrames(clock, pacer, 200, 1000);
+	CHECK(4000 == pacer.getSpinMargin());
+}
+
+TEST_CASE(slowFramesAreLateWithoutWaiting)
+{
+	VirtualClock clock;
+	Pacer pacer(clock);
+	runFrames(clock, pacer, 1, 0);
+	const UINT sleepCount = clock.sleepCount;
+	const auto frameTimes = runFrames(clock, pacer, 10, FRAME_INTERVAL + 100);
+	CHECK(sleepCount == clock.sleepCount);
+	CHECK(0 == clock.spinCount);
+	CHECK(frameTimes.size() == pacer.getLateFrameCount());
+}
+
+TEST_CASE(lateFramesCatchUpToSchedule)
+{
+	VirtualClock clock;
+	Pacer pacer(clock);
+	auto frameTimes = runFrames(clock, pacer, 1, 0);
+	const long long qpcStart = frameTimes[0];
+
+	// One slow frame followed by fast ones: the schedule is kept, so the next frames come early to catch up
+	runFrames(clock, pacer, 1, FRAME_INTERVAL + FRAME_INTERVAL / 2);
+	frameTimes = runFrames(clock, pacer, 4, 1000);
+	CHECK(1 == pacer.getLateFrameCount());
+	CHECK(frameTimes.back() == qpcStart + 5 * FRAME_INTERVAL);
+}
+
+TEST_CASE(longStallRestartsSchedule)
+{
+	VirtualClock clock;
+	Pacer pacer(clock);
+	runFrames(clock, pacer, 5, 1000);
+	clock.qpc += 10 * FRAME_INTERVAL;
+	const long long qpcResume = clock.qpc;
+	pacer.waitForNextFrame(FRAME_INTERVAL, false);
+	CHECK(qpcResume == clock.qpc);
+
+	const auto frameTimes = runFrames(clock, pacer, 3, 1000);
+	CHECK(frameTimes[0] == qpcResume + FRAME_INTERVAL);
+	CHECK(frameTimes[2] == qpcResume + 3 * FRAME_INTERVAL);
+	CHECK(0 == pacer.getLateFrameCount());
+}
+
+TEST_CASE(framesAlignToVblank)
+{
+	VirtualClock clock;
+	clock.vblankInterval = FRAME_INTERVAL;
+	clock.vblankPhase = 5000;
+	Pacer pacer(clock);
+	const auto frameTimes = runFrames(clock, pacer, 50, 1000, true);
+	for (std::size_t i = 1; i < frameTimes.size(); ++i)
+	{
+		CHECK(clock.vblankPhase == frameTimes[i] % FRAME_INTERVAL);
+		CHECK(i < 2 || frameTimes[i] - frameTimes[i - 1] == FRAME_INTERVAL);
+	}
+	CHECK(frameTimes.back() - frameTimes[1] == 48 * FRAME_INTERVAL);
+}
+
+TEST_CASE(halfRateVblankAlignmentSkipsEveryOtherVblank)
+{
+	VirtualClock clock;
+	clock.vblankInterval = FRAME_INTERVAL / 2;
+	Pacer pacer(clock);
+	const auto frameTimes = runFrames(clock, pacer, 50, 1000, true);
+	for (std::size_t i = 2; i < frameTimes.size(); ++i)
+	{
+		CHECK(0 == frameTimes[i] % clock.vblankInterval);
+		CHECK(std::llabs(frameTimes[i] - frameTimes[i - 1] - FRAME_INTERVAL) <= 1);
+	}
+}
+
+TEST_CASE(statsResetAfterLogInterval)
+{
+	VirtualClock clock;
+	Pacer pacer(clock);
+	const UINT framesPerLog = static_cast<UINT>(Pacer::STATS_LOG_INTERVAL_MS * FREQUENCY / 1000 / FRAME_INTERVAL);
+	runFrames(clock, pacer, framesPerLog + 10, 1000);
+	CHECK(pacer.getFrameCount() < 20);
+}
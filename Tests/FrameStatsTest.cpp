@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <Common/Time.h>
+#include <DDraw/FrameStats.h>
+#include <Test.h>
+
+long long Time::g_qpcFrequency = 1000000;
+
+namespace
+{
+	typedef DDraw::FrameStats::Distribution Distribution;
+
+	// Nearest-rank percentile: the smallest sample with at least percent% of the samples at or below it
+	UINT getNearestRank(std::vector<UINT> samples, UINT percent)
+	{
+		std::sort(samples.begin(), samples.end());
+		for (UINT sample : samples)
+		{
+			const auto atOrBelow = std::upper_bound(samples.begin(), samples.end(), sample) - samples.begin();
+			if (static_cast<std::size_t>(atOrBelow) * 100 >= samples.size() * percent)
+			{
+				return sample;
+			}
+		}
+		return samples.back();
+	}
+
+	template <typename T>
+	std::string toString(const T& value)
+	{
+		std::ostringstream os;
+		os << value;
+		return os.str();
+	}
+
+	bool contains(const std::string& str, const std::string& substr)
+	{
+		return std::string::npos != str.find(substr);
+	}
+}
+
+TEST_CASE(emptyDistribution)
+{
+	Distribution distribution;
+	CHECK(0 == distribution.getPercentile(50));
+	CHECK("none" == toString(distribution));
+}
+
+TEST_CASE(singleSample)
+{
+	Distribution distribution;
+	distribution.add(1234);
+	CHECK(1234 == distribution.getPercentile(0));
+	CHECK(1234 == distribution.getPercentile(50));
+	CHECK(1234 == distribution.getPercentile(100));
+}
+
+TEST_CASE(percentilesOfOneToHundred)
+{
+	Distribution distribution;
+	for (UINT i = 100; i > 0; --i)
+	{
+		distribution.add(i);
+	}
+	CHECK(1 == distribution.getPercentile(0));
+	CHECK(1 == distribution.getPercentile(1));
+	CHECK(50 == distribution.getPercentile(50));
+	CHECK(90 == distribution.getPercentile(90));
+	CHECK(99 == distribution.getPercentile(99));
+	CHECK(100 == distribution.getPercentile(100));
+}
+
+TEST_CASE(percentilesRoundUpToNextRank)
+{
+	Distribution distribution;
+	for (UINT i = 1; i <= 10; ++i)
+	{
+		distribution.add(i * 10);
+	}
+	CHECK(50 == distribution.getPercentile(50));
+	CHECK(60 == distribution.getPercentile(51));
+	CHECK(100 == distribution.getPercentile(91));
+	CHECK(100 == distribution.getPercentile(99));
+}
+
+TEST_CASE(percentilesMatchNearestRank)
+{
+	std::mt19937 random(7);
+	for (unsigned round = 0; round < 100; ++round)
+	{
+		Distribution distribution;
+		std::vector<UINT> samples(1 + random() % 300);
+		for (auto& sample : samples)
+		{
+			sample = random() % 50000;
+			distribution.add(sample);
+		}
+		for (UINT percent : { 0, 1, 25, 50, 90, 99, 100 })
+		{
+			CHECK(getNearestRank(samples, percent) == distribution.getPercentile(percent));
+		}
+	}
+}
+
+TEST_CASE(percentilesUseRollingWindow)
+{
+	Distribution distribution;
+	for (UINT i = 0; i < 1024; ++i)
+	{
+		distribution.add(100000);
+	}
+	for (UINT i = 0; i < 1024; ++i)
+	{
+		distribution.add(i);
+	}
+	CHECK(1023 == distribution.getPercentile(100));
+	CHECK(511 == distribution.getPercentile(50));
+
+	distribution.add(5000);
+	CHECK(5000 == distribution.getPercentile(100));
+	CHECK(1 == distribution.getPercentile(0));
+}
+
+TEST_CASE(resetHistogramKeepsPercentiles)
+{
+	Distribution distribution;
+	distribution.add(500);
+	distribution.add(16700);
+	CHECK(contains(toString(distribution), "ms [0: 1, 16-31: 1]"));
+
+	distribution.resetHistogram();
+	CHECK(16700 == distribution.getPercentile(100));
+	CHECK(contains(toString(distribution), "max 16700 us, ms []"));
+}
+
+TEST_CASE(frameStatsConvertQpcToUs)
+{
+	Time::g_qpcFrequency = 10000000;
+	DDraw::FrameStats stats;
+	for (long long i = 0; i < 11; ++i)
+	{
+		stats.addFlip(1000 + i * 166667);
+	}
+	stats.addPresent(1000, 2000, 12000, 200000);
+	const std::string str = toString(stats);
+	Time::g_qpcFrequency = 1000000;
+
+	CHECK(contains(str, "flips: 11, updates: 0, presents: 1"));
+	CHECK(contains(str, "frame time: p50 16666 us, p90 16666 us, p99 16666 us, max 16666 us, ms [16-31: 10]"));
+	CHECK(contains(str, "present time: p50 1000 us"));
+	CHECK(contains(str, "flip to scanout: p50 19900 us"));
+}
+
+TEST_CASE(repeatedVblanksAreCounted)
+{
+	DDraw::FrameStats stats;
+	stats.addVblank(10, 1000);
+	stats.addVblank(10, 1500);
+	stats.addVblank(11, 17667);
+	stats.addVblank(14, 67667);
+	const std::string str = toString(stats);
+	CHECK(contains(str, "scanout interval: p50 16667 us, p90 50000 us"));
+	CHECK(contains(str, "repeated vblanks: 2"));
+}
@@ -0,0 +1,151 @@
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <DDraw/GammaTable.h>
+#include <Test.h>
+
+namespace
+{
+	const LONG WIDTH = 13;
+	const LONG HEIGHT = 7;
+
+	struct Ramp
+	{
+		WORD red[256];
+		WORD green[256];
+		WORD blue[256];
+	};
+
+	Ramp createRamp(double redGamma, double greenGamma, double blueGamma)
+	{
+		Ramp ramp = {};
+		for (UINT i = 0; i < 256; ++i)
+		{
+			ramp.red[i] = static_cast<WORD>(std::lround(std::pow(i / 255.0, redGamma) * 65535));
+			ramp.green[i] = static_cast<WORD>(std::lround(std::pow(i / 255.0, greenGamma) * 65535));
+			ramp.blue[i] = static_cast<WORD>(std::lround(std::pow(i / 255.0, blueGamma) * 65535));
+		}
+		return ramp;
+	}
+
+	DWORD getShift(DWORD mask)
+	{
+		DWORD shift = 0;
+		while (!(mask & 1))
+		{
+			mask >>= 1;
+			++shift;
+		}
+		return shift;
+	}
+
+	DWORD mapChannel(DWORD pixel, DWORD mask, const WORD* ramp)
+	{
+		const DWORD shift = getShift(mask);
+		const DWORD maxValue = mask >> shift;
+		const DWORD value = (pixel & mask) >> shift;
+		const DWORD output = (ramp[(value * 255 + maxValue / 2) / maxValue] * maxValue + 32767) / 65535;
+		return output << shift;
+	}
+
+	DWORD mapPixel(DWORD pixel, DWORD redMask, DWORD greenMask, DWORD blueMask, const Ramp& ramp)
+	{
+		return mapChannel(pixel, redMask, ramp.red) | mapChannel(pixel, greenMask, ramp.green) |
+			mapChannel(pixel, blueMask, ramp.blue) | (pixel & ~(redMask | greenMask | blueMask));
+	}
+
+	template <typename Pixel>
+	std::vector<Pixel> createSurface()
+	{
+		std::mt19937 rng(7);
+		std::vector<Pixel> surface(WIDTH * HEIGHT);
+		for (auto& pixel : surface)
+		{
+			pixel = static_cast<Pixel>(rng());
+		}
+		return surface;
+	}
+
+	template <typename Pixel>
+	void checkApply(DWORD redMask, DWORD greenMask, DWORD blueMask)
+	{
+		const Ramp ramp = createRamp(0.5, 1.5, 2.2);
+		DDraw::GammaTable gammaTable;
+		gammaTable.setFormat(sizeof(Pixel) * 8, redMask, greenMask, blueMask);
+		gammaTable.setRamp(ramp.red, ramp.green, ramp.blue);
+		CHECK(gammaTable.isSupported());
+		CHECK(!gammaTable.isIdentity());
+
+		const RECT rect = { 2, 1, 11, 6 };
+		const auto orig = createSurface<Pixel>();
+		auto surface = orig;
+		gammaTable.apply(surface.data(), WIDTH * sizeof(Pixel), rect);
+
+		for (LONG y = 0; y < HEIGHT; ++y)
+		{
+			for (LONG x = 0; x < WIDTH; ++x)
+			{
+				const DWORD pixel = orig[y * WIDTH + x];
+				const bool isInside = x >= rect.left && x < rect.right && y >= rect.top && y < rect.bottom;
+				const DWORD expected = isInside ? mapPixel(pixel, redMask, greenMask, blueMask, ramp) : pixel;
+				CHECK(static_cast<Pixel>(expected) == surface[y * WIDTH + x]);
+			}
+		}
+	}
+
+	template <typename Pixel>
+	void checkUnchanged(const DDraw::GammaTable& gammaTable)
+	{
+		const RECT rect = { 0, 0, WIDTH, HEIGHT };
+		const auto orig = createSurface<Pixel>();
+		auto surface = orig;
+		gammaTable.apply(surface.data(), WIDTH * sizeof(Pixel), rect);
+		CHECK(orig == surface);
+	}
+}
+
+TEST_CASE(applies32BitRamp)
+{
+	checkApply<DWORD>(0xFF0000, 0x00FF00, 0x0000FF);
+	checkApply<DWORD>(0x0000FF, 0x00FF00, 0xFF0000);
+}
+
+TEST_CASE(applies16BitRamp)
+{
+	checkApply<WORD>(0xF800, 0x07E0, 0x001F);
+	checkApply<WORD>(0x7C00, 0x03E0, 0x001F);
+}
+
+TEST_CASE(identityRampIsNoOp)
+{
+	DDraw::GammaTable gammaTable;
+	gammaTable.setFormat(32, 0xFF0000, 0x00FF00, 0x0000FF);
+	CHECK(gammaTable.isIdentity());
+
+	const Ramp ramp = createRamp(1, 1, 1);
+	gammaTable.setRamp(ramp.red, ramp.green, ramp.blue);
+	CHECK(gammaTable.isIdentity());
+	checkUnchanged<DWORD>(gammaTable);
+}
+
+TEST_CASE(rejectsUnsupportedFormats)
+{
+	const Ramp ramp = createRamp(0.5, 0.5, 0.5);
+	DDraw::GammaTable gammaTable;
+	gammaTable.setRamp(ramp.red, ramp.green, ramp.blue);
+	CHECK(!gammaTable.isSupported());
+
+	gammaTable.setFormat(24, 0xFF0000, 0x00FF00, 0x0000FF);
+	CHECK(!gammaTable.isSupported());
+	gammaTable.setFormat(8, 0, 0, 0);
+	CHECK(!gammaTable.isSupported());
+	gammaTable.setFormat(32, 0x3FF00000, 0x000FFC00, 0x000003FF);
+	CHECK(!gammaTable.isSupported());
+	gammaTable.setFormat(16, 0xF000, 0x0F00, 0x00F0 | 0x0002);
+	CHECK(!gammaTable.isSupported());
+	checkUnchanged<WORD>(gammaTable);
+
+	gammaTable.setFormat(16, 0xF800, 0x07E0, 0x001F);
+	CHECK(gammaTable.isSupported());
+}
@@ -0,0 +1,74 @@
+#include <sstream>
+#include <string>
+
+#include <Common/Histogram.h>
+#include <Test.h>
+
+namespace
+{
+	template <UINT bucketCount>
+	std::string toString(const Compat::Histogram<bucketCount>& histogram)
+	{
+		std::ostringstream os;
+		os << histogram;
+		return os.str();
+	}
+}
+
+TEST_CASE(bucketsArePowersOfTwo)
+{
+	typedef Compat::Histogram<8> Histogram;
+	CHECK(0 == Histogram::getBucketIndex(0));
+	CHECK(1 == Histogram::getBucketIndex(1));
+	CHECK(2 == Histogram::getBucketIndex(2));
+	CHECK(2 == Histogram::getBucketIndex(3));
+	CHECK(3 == Histogram::getBucketIndex(4));
+	CHECK(3 == Histogram::getBucketIndex(7));
+	CHECK(4 == Histogram::getBucketIndex(8));
+	CHECK(32 == Histogram::getBucketIndex(0xFFFFFFFF));
+}
+
+TEST_CASE(lastBucketIsOpenEnded)
+{
+	Compat::Histogram<4> histogram;
+	histogram.add(3);
+	histogram.add(4);
+	histogram.add(1000);
+	CHECK(1 == histogram.getBucket(2));
+	CHECK(2 == histogram.getBucket(3));
+	CHECK("[2-3: 1, 4+: 2]" == toString(histogram));
+}
+
+TEST_CASE(summaryTracksAllValues)
+{
+	Compat::Histogram<4> histogram;
+	CHECK(0 == histogram.getAverage());
+	histogram.add(0);
+	histogram.add(0xFFFFFFFF);
+	histogram.add(0xFFFFFFFF);
+	CHECK(3 == histogram.getCount());
+	CHECK(0xFFFFFFFF == histogram.getMax());
+	CHECK(0xAAAAAAAA == histogram.getAverage());
+}
+
+TEST_CASE(emptyBucketsAreNotPrinted)
+{
+	Compat::Histogram<8> histogram;
+	CHECK("[]" == toString(histogram));
+	histogram.add(0);
+	histogram.add(1);
+	histogram.add(1);
+	histogram.add(20);
+	CHECK("[0: 1, 1: 2, 16-31: 1]" == toString(histogram));
+}
+
+TEST_CASE(resetClearsEverything)
+{
+	Compat::Histogram<8> histogram;
+	histogram.add(5);
+	histogram.reset();
+	CHECK(0 == histogram.getCount());
+	CHECK(0 == histogram.getMax());
+	CHECK(0 == histogram.getBucket(3));
+	CHECK("[]" == toString(histogram));
+}
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <D3dDdi/Indices.h>
+#include <Test.h>
+
+namespace
+{
+	const UINT16 GUARD = 0xCDCD;
+	const UINT GUARD_COUNT = 16;
+
+	std::vector<UINT16> createIndices(UINT count, std::mt19937& rng)
+	{
+		std::uniform_int_distribution<UINT> dist(0, 0xFFFF);
+		std::vector<UINT16> indices(count);
+		for (auto& index : indices)
+		{
+			index = static_cast<UINT16>(dist(rng));
+		}
+		return indices;
+	}
+
+	std::vector<UINT16> createOutput(UINT count)
+	{
+		return std::vector<UINT16>(count + GUARD_COUNT, GUARD);
+	}
+
+	bool isGuardIntact(const std::vector<UINT16>& output, UINT count)
+	{
+		return std::all_of(output.begin() + count, output.end(), [](UINT16 index) { return GUARD == index; });
+	}
+}
+
+TEST_CASE(convertTriangleFanToListMatchesScalar)
+{
+	std::mt19937 rng(1);
+	for (UINT primitiveCount = 1; primitiveCount < 64; ++primitiveCount)
+	{
+		const auto src(createIndices(primitiveCount + 2, rng));
+		auto dst(createOutput(primitiveCount * 3));
+		D3dDdi::Indices::convertTriangleFanToList(dst.data(), src.data(), primitiveCount);
+
+		for (UINT i = 0; i < primitiveCount; ++i)
+		{
+			CHECK(dst[i * 3] == src[i + 1]);
+			CHECK(dst[i * 3 + 1] == src[i + 2]);
+			CHECK(dst[i * 3 + 2] == src[0]);
+		}
+		CHECK(isGuardIntact(dst, primitiveCount * 3));
+	}
+}
+
+TEST_CASE(convertTriangleStripToListMatchesScalar)
+{
+	std::mt19937 rng(2);
+	for (UINT primitiveCount = 1; primitiveCount < 64; ++primitiveCount)
+	{
+		const auto src(createIndices(primitiveCount + 2, rng));
+		auto dst(createOutput(primitiveCount * 3));
+		D3dDdi::Indices::convertTriangleStripToList(dst.data(), src.data(), primitiveCount);
+
+		for (UINT i = 0; i < primitiveCount; ++i)
+		{
+			const bool isOdd = 0 != i % 2;
+			CHECK(dst[i * 3] == src[i]);
+			CHECK(dst[i * 3 + 1] == src[isOdd ? i + 2 : i + 1]);
+			CHECK(dst[i * 3 + 2] == src[isOdd ? i + 1 : i + 2]);
+		}
+		CHECK(isGuardIntact(dst, primitiveCount * 3));
+	}
+}
+
+TEST_CASE(generateRangeWrapsAt16Bits)
+{
+	for (UINT count = 0; count < 40; ++count)
+	{
+		const UINT base = 0xFFF0;
+		auto dst(createOutput(count));
+		D3dDdi::Indices::generateRange(dst.data(), base, count);
+
+		for (UINT i = 0; i < count; ++i)
+		{
+			CHECK(dst[i] == static_cast<UINT16>(base + i));
+		}
+		CHECK(isGuardIntact(dst, count));
+	}
+}
+
+TEST_CASE(getMinMaxMatchesScalar)
+{
+	std::mt19937 rng(3);
+	CHECK((D3dDdi::Indices::getMinMax(nullptr, 0) == std::pair<UINT16, UINT16>(0, 0)));
+
+	for (UINT count = 1; count < 80; ++count)
+	{
+		const auto indices(createIndices(count, rng));
+		const auto minMax = D3dDdi::Indices::getMinMax(indices.data(), count);
+		CHECK(minMax.first == *std::min_element(indices.begin(), indices.end()));
+		CHECK(minMax.second == *std::max_element(indices.begin(), indices.end()));
+	}
+
+	const UINT16 extremes[] = { 0x8000, 0x7FFF, 0xFFFF, 0x0000, 0x8001, 0x7FFE, 0x1234, 0xFEDC, 0x8000 };
+	const auto minMax = D3dDdi::Indices::getMinMax(extremes, sizeof(extremes) / sizeof(extremes[0]));
+	CHECK(0x0000 == minMax.first);
+	CHECK(0xFFFF == minMax.second);
+}
+
+TEST_CASE(rebaseMatchesScalar)
+{
+	std::mt19937 rng(4);
+	const INT deltas[] = { 0, 1, -1, 1000, -1000, 0x7FFF, -0x8000 };
+	for (INT delta : deltas)
+	{
+		for (UINT count = 0; count < 40; ++count)
+		{
+			const auto src(createIndices(count, rng));
+			auto dst(createOutput(count));
+			D3dDdi::Indices::rebase(dst.data(), src.data(), count, delta);
+
+			for (UINT i = 0; i < count; ++i)
+			{
+				CHECK(dst[i] == static_cast<UINT16>(src[i] + delta));
+			}
+			CHECK(isGuardIntact(dst, count));
+		}
+	}
+}
@@ -0,0 +1,186 @@
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <Common/SharedMetricsLayout.h>
+#include <MetricsBlock.h>
+#include <Test.h>
+
+using namespace Compat::SharedMetrics;
+
+namespace
+{
+	const std::uint32_t WRITE_COUNT = 100000;
+
+	std::string getName(pid_t processId)
+	{
+		return NAME_PREFIX + std::to_string(processId);
+	}
+
+	// Linux stand-in for the publisher in Common/SharedMetrics.cpp
+	Block* createBlock(pid_t processId)
+	{
+		int fd = shm_open(getName(processId).c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		if (fd < 0)
+		{
+			return nullptr;
+		}
+		void* view = MAP_FAILED;
+		if (0 == ftruncate(fd, sizeof(Block)))
+		{
+			view = mmap(nullptr, sizeof(Block), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		}
+		close(fd);
+		return MAP_FAILED == view ? nullptr : static_cast<Block*>(view);
+	}
+
+	void write(Block& block, std::uint32_t value)
+	{
+		const std::uint32_t sequence = beginWrite(block);
+		block.magic = MAGIC;
+		block.version = VERSION;
+		block.size = sizeof(Block);
+		block.counterCount = COUNTER_COUNT;
+		block.processId = value;
+		block.qpcFrequency = value;
+		block.qpcTimestamp = value;
+		for (std::uint32_t i = 0; i < COUNTER_COUNT; ++i)
+		{
+			block.counters[i] = value;
+		}
+		endWrite(block, sequence);
+	}
+
+	bool isConsistent(const Snapshot& snapshot)
+	{
+		const std::uint32_t value = snapshot.sequence / 2;
+		bool result = MAGIC == snapshot.magic && VERSION == snapshot.version &&
+			COUNTER_COUNT == snapshot.counterCount && value == snapshot.processId &&
+			value == snapshot.qpcFrequency && value == snapshot.qpcTimestamp;
+		for (std::uint32_t i = 0; i < COUNTER_COUNT; ++i)
+		{
+			result = result && value == snapshot.counters[i];
+		}
+		return result;
+	}
+}
+
+TEST_CASE(openFailsWithoutWriter)
+{
+	shm_unlink(getName(getpid()).c_str());
+	CHECK(!MetricsReader::openBlock(getpid()));
+}
+
+TEST_CASE(readerSeesWrites)
+{
+	shm_unlink(getName(getpid()).c_str());
+	Block* block = createBlock(getpid());
+	CHECK(block);
+	if (!block)
+	{
+		return;
+	}
+
+	const Block* readBlock = MetricsReader::openBlock(getpid());
+	CHECK(readBlock);
+	if (readBlock)
+	{
+		Snapshot snapshot = {};
+		CHECK(!tryRead(*readBlock, snapshot));
+
+		write(*block, 1);
+		CHECK(tryRead(*readBlock, snapshot));
+		CHECK(2 == snapshot.sequence);
+		CHECK(isConsistent(snapshot));
+
+		write(*block, 2);
+		CHECK(tryRead(*readBlock, snapshot));
+		CHECK(4 == snapshot.sequence);
+		CHECK(isConsistent(snapshot));
+		MetricsReader::closeBlock(readBlock);
+	}
+
+	munmap(block, sizeof(Block));
+	shm_unlink(getName(getpid()).c_str());
+}
+
+TEST_CASE(readerSeesWritesFromOtherProcess)
+{
+	int readyPipe[2] = {};
+	CHECK(0 == pipe(readyPipe));
+
+	const pid_t writerId = fork();
+	if (0 == writerId)
+	{
+		close(readyPipe[0]);
+		shm_unlink(getName(getpid()).c_str());
+		Block* block = createBlock(getpid());
+		const char ready = block ? 1 : 0;
+		const bool isSignaled = 1 == ::write(readyPipe[1], &ready, 1);
+		close(readyPipe[1]);
+		if (!block || !isSignaled)
+		{
+			_exit(1);
+		}
+		for (std::uint32_t value = 1; value <= WRITE_COUNT; ++value)
+		{
+			write(*block, value);
+		}
+		munmap(block, sizeof(Block));
+		_exit(0);
+	}
+
+	CHECK(writerId > 0);
+	close(readyPipe[1]);
+	char ready = 0;
+	CHECK(1 == read(readyPipe[0], &ready, 1) && 1 == ready);
+	close(readyPipe[0]);
+
+	int status = 0;
+	bool isWriterDone = false;
+	const Block* block = MetricsReader::openBlock(writerId);
+	CHECK(block);
+	if (block)
+	{
+		std::uint32_t readCount = 0;
+		std::uint32_t lastSequence = 0;
+		bool isOrdered = true;
+		bool isAllConsistent = true;
+		while (lastSequence < 2 * WRITE_COUNT)
+		{
+			// Once the writer has exited the block no longer changes, so one more read is final
+			const bool isFinalRead = isWriterDone;
+			if (!isWriterDone)
+			{
+				isWriterDone = writerId == waitpid(writerId, &status, WNOHANG);
+			}
+			Snapshot snapshot = {};
+			if (tryRead(*block, snapshot))
+			{
+				++readCount;
+				isOrdered = isOrdered && snapshot.sequence >= lastSequence;
+				isAllConsistent = isAllConsistent && isConsistent(snapshot);
+				lastSequence = snapshot.sequence;
+			}
+			if (isFinalRead)
+			{
+				break;
+			}
+		}
+		CHECK(2 * WRITE_COUNT == lastSequence);
+		CHECK(isOrdered);
+		CHECK(isAllConsistent);
+		CHECK(0 != readCount);
+		MetricsReader::closeBlock(block);
+	}
+
+	if (!isWriterDone)
+	{
+		CHECK(writerId == waitpid(writerId, &status, 0));
+	}
+	CHECK(WIFEXITED(status) && 0 == WEXITSTATUS(status));
+	shm_unlink(getName(writerId).c_str());
+}
@@ -0,0 +1,93 @@
+#include <random>
+#include <vector>
+
+#include <Gdi/PaletteColorIndex.h>
+#include <Benchmark.h>
+
+namespace
+{
+	PALETTEENTRY getEntry(DWORD color)
+	{
+		return { static_cast<BYTE>(color >> 16), static_cast<BYTE>(color >> 8), static_cast<BYTE>(color), 0 };
+	}
+
+	// 256 distinct colors, either spread over the whole color space or a gray ramp with only the low bits differing
+	std::vector<PALETTEENTRY> createPalette(bool isRamp)
+	{
+		std::mt19937 rng(7);
+		std::uniform_int_distribution<DWORD> dist(0, 0xFFFFFF);
+		std::vector<PALETTEENTRY> entries;
+		for (DWORD i = 0; i < 256; ++i)
+		{
+			entries.push_back(getEntry(isRamp ? i * 0x010101 : dist(rng)));
+		}
+		return entries;
+	}
+
+	// Per iteration, rebuilds the index from a whole palette
+	void rebuild(unsigned iterationCount, bool isRamp)
+	{
+		const auto entries = createPalette(isRamp);
+		Gdi::PaletteColorIndex index;
+		for (unsigned i = 0; i < iterationCount; ++i)
+		{
+			index.clear();
+			for (const auto& entry : entries)
+			{
+				index.add(entry);
+			}
+			Benchmark::doNotOptimize(&index);
+		}
+	}
+
+	// One lookup per iteration, cycling through 1024 colors of which hitRatio in every 4 are in the palette
+	void lookup(unsigned iterationCount, bool isRamp, unsigned hitRatio)
+	{
+		const auto entries = createPalette(isRamp);
+		Gdi::PaletteColorIndex index;
+		for (const auto& entry : entries)
+		{
+			index.add(entry);
+		}
+
+		std::mt19937 rng(8);
+		std::uniform_int_distribution<DWORD> dist(0, 0xFFFFFF);
+		std::vector<PALETTEENTRY> queries;
+		for (unsigned i = 0; i < 1024; ++i)
+		{
+			queries.push_back(i % 4 < hitRatio ? entries[i % 256] : getEntry(dist(rng)));
+		}
+
+		unsigned hitCount = 0;
+		for (unsigned i = 0; i < iterationCount; ++i)
+		{
+			hitCount += index.contains(queries[i % 1024]);
+		}
+		Benchmark::doNotOptimize(&hitCount);
+	}
+}
+
+BENCHMARK(rebuildRandomPalette)
+{
+	rebuild(iterationCount, false);
+}
+
+BENCHMARK(rebuildRampPalette)
+{
+	rebuild(iterationCount, true);
+}
+
+BENCHMARK(lookupRandomPaletteHits)
+{
+	lookup(iterationCount, false, 4);
+}
+
+BENCHMARK(lookupRandomPaletteMisses)
+{
+	lookup(iterationCount, false, 0);
+}
+
+BENCHMARK(lookupRampPaletteMixed)
+{
+	lookup(iterationCount, true, 2);
+}
@@ -0,0 +1,70 @@
+#include <random>
+#include <set>
+
+#include <Gdi/PaletteColorIndex.h>
+#include <Test.h>
+
+namespace
+{
+	PALETTEENTRY getEntry(DWORD color, BYTE flags = 0)
+	{
+		return { static_cast<BYTE>(color >> 16), static_cast<BYTE>(color >> 8), static_cast<BYTE>(color), flags };
+	}
+}
+
+TEST_CASE(emptyIndexContainsNothing)
+{
+	Gdi::PaletteColorIndex index;
+	CHECK(!index.contains(getEntry(0)));
+	CHECK(!index.contains(getEntry(0xFFFFFF)));
+}
+
+TEST_CASE(fullPaletteMatchesReferenceSet)
+{
+	std::mt19937 rng(6);
+	for (int iteration = 0; iteration < 50; ++iteration)
+	{
+		std::uniform_int_distribution<DWORD> dist(0, 0 == iteration % 2 ? 0xFFFFFF : 0x3FF);
+		Gdi::PaletteColorIndex index;
+		std::set<DWORD> colors;
+		for (int i = 0; i < 256; ++i)
+		{
+			const DWORD color = dist(rng);
+			index.add(getEntry(color));
+			colors.insert(color);
+		}
+
+		for (DWORD color : colors)
+		{
+			CHECK(index.contains(getEntry(color)));
+		}
+		for (int i = 0; i < 10000; ++i)
+		{
+			const DWORD color = dist(rng);
+			CHECK(index.contains(getEntry(color)) == (0 != colors.count(color)));
+		}
+	}
+}
+
+TEST_CASE(flagsAreIgnored)
+{
+	Gdi::PaletteColorIndex index;
+	index.add(getEntry(0x102030, 0x04));
+	CHECK(index.contains(getEntry(0x102030)));
+	CHECK(index.contains(getEntry(0x102030, 0x01)));
+	CHECK(!index.contains(getEntry(0x102031)));
+}
+
+TEST_CASE(clearRemovesAllColors)
+{
+	Gdi::PaletteColorIndex index;
+	for (DWORD i = 0; i < 256; ++i)
+	{
+		index.add(getEntry(i * 0x010101));
+	}
+	index.clear();
+	for (DWORD i = 0; i < 256; ++i)
+	{
+		CHECK(!index.contains(getEntry(i * 0x010101)));
+	}
+}
@@ -0,0 +1,162 @@
+#include <map>
+
+#include <Gdi/PaletteVersions.h>
+#include <Test.h>
+
+namespace
+{
+	// Models Gdi::Dc handing out virtual screen DCs that cache their palette version, with colour table contents
+	// tracked as the palette version written by the last SetDIBColorTable
+	struct DcModel
+	{
+		Gdi::PaletteVersions<int> versions;
+		std::map<int, UINT> colorTables;
+		unsigned setColorTableCount = 0;
+
+		struct CompatDc
+		{
+			int dc;
+			bool useDefaultPalette;
+			UINT paletteVersion;
+		};
+
+		CompatDc createDc(int dc, bool useDefaultPalette)
+		{
+			versions.add(dc, useDefaultPalette);
+			colorTables[dc] = versions.getVersion();
+			return { dc, useDefaultPalette, versions.getVersion() };
+		}
+
+		void changePalette()
+		{
+			versions.invalidate();
+		}
+
+		void getDc(CompatDc& compatDc)
+		{
+			if (!compatDc.useDefaultPalette && compatDc.paletteVersion != versions.getVersion())
+			{
+				compatDc.paletteVersion = versions.update(compatDc.dc, [&](int dc)
+					{
+						colorTables[dc] = versions.getVersion();
+						++setColorTableCount;
+					});
+			}
+		}
+
+		void recreateDibs()
+		{
+			versions.forEach([&](int dc, bool /*useDefaultPalette*/)
+				{
+					colorTables[dc] = versions.getVersion();
+				});
+			versions.markAllCurrent();
+		}
+	};
+}
+
+TEST_CASE(newDcIsCurrent)
+{
+	DcModel model;
+	model.changePalette();
+	auto dc = model.createDc(1, false);
+	model.getDc(dc);
+	CHECK(0 == model.setColorTableCount);
+	CHECK(model.versions.getVersion() == model.colorTables[1]);
+}
+
+TEST_CASE(staleDcIsRefreshedOnceWhenHandedOut)
+{
+	DcModel model;
+	auto dc = model.createDc(1, false);
+	model.changePalette();
+	CHECK(model.versions.getVersion() != model.colorTables[1]);
+
+	model.getDc(dc);
+	CHECK(1 == model.setColorTableCount);
+	CHECK(model.versions.getVersion() == model.colorTables[1]);
+	CHECK(model.versions.getVersion() == dc.paletteVersion);
+
+	model.getDc(dc);
+	CHECK(1 == model.setColorTableCount);
+}
+
+TEST_CASE(repeatedChangesAreRefreshedOnce)
+{
+	DcModel model;
+	auto dc = model.createDc(1, false);
+	for (int i = 0; i < 100; ++i)
+	{
+		model.changePalette();
+	}
+	model.getDc(dc);
+	CHECK(1 == model.setColorTableCount);
+	CHECK(100 == model.colorTables[1]);
+}
+
+TEST_CASE(inUseDcKeepsStaleColorTableUntilHandedOutAgain)
+{
+	DcModel model;
+	auto dc = model.createDc(1, false);
+	model.getDc(dc);
+	model.changePalette();
+	CHECK(0 == model.colorTables[1]);
+	model.getDc(dc);
+	CHECK(1 == model.colorTables[1]);
+}
+
+TEST_CASE(defaultPaletteDcIsNeverRefreshed)
+{
+	DcModel model;
+	auto dc = model.createDc(1, true);
+	model.changePalette();
+	model.getDc(dc);
+	CHECK(0 == model.setColorTableCount);
+	CHECK(0 == model.versions.update(1, [](int) { CHECK(false); }));
+}
+
+TEST_CASE(onlyStaleDcsAreRefreshed)
+{
+	DcModel model;
+	auto dc1 = model.createDc(1, false);
+	auto dc2 = model.createDc(2, false);
+	model.changePalette();
+	auto dc3 = model.createDc(3, false);
+
+	model.getDc(dc1);
+	model.getDc(dc3);
+	CHECK(1 == model.setColorTableCount);
+	CHECK(0 == model.colorTables[2]);
+
+	model.getDc(dc2);
+	CHECK(2 == model.setColorTableCount);
+	CHECK(1 == model.colorTables[2]);
+}
+
+TEST_CASE(recreatedDibsAreCurrent)
+{
+	DcModel model;
+	auto dc1 = model.createDc(1, false);
+	auto dc2 = model.createDc(2, true);
+	model.changePalette();
+	model.recreateDibs();
+	CHECK(1 == model.versions.update(2, [](int) { CHECK(false); }));
+
+	// The compat DC cached an older version and is synced without another SetDIBColorTable
+	model.getDc(dc1);
+	model.getDc(dc2);
+	CHECK(0 == model.setColorTableCount);
+	CHECK(1 == dc1.paletteVersion);
+	CHECK(1 == model.colorTables[1]);
+}
+
+TEST_CASE(removedDcIsNotRefreshed)
+{
+	DcModel model;
+	auto dc = model.createDc(1, false);
+	model.versions.remove(1);
+	model.changePalette();
+	model.getDc(dc);
+	CHECK(0 == model.setColorTableCount);
+	CHECK(1 == dc.paletteVersion);
+}
@@ -0,0 +1,131 @@
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <D3dDdi/PresentationPalette.h>
+#include <Test.h>
+
+namespace
+{
+	const UINT PUBLISH_COUNT = 20000;
+	const unsigned READER_COUNT = 4;
+
+	DWORD getColor(UINT version, UINT index)
+	{
+		return ((version + index) & 0xFF) << 16 | ((version * 3 + index) & 0xFF) << 8 | ((version ^ index) & 0xFF);
+	}
+
+	std::shared_ptr<const Gdi::Palette::Snapshot> createSnapshot(UINT version)
+	{
+		auto snapshot(std::make_shared<Gdi::Palette::Snapshot>());
+		snapshot->version = version;
+		for (UINT i = 0; i < 256; ++i)
+		{
+			const DWORD color = getColor(version, i);
+			snapshot->entries[i] = { static_cast<BYTE>(color >> 16), static_cast<BYTE>(color >> 8),
+				static_cast<BYTE>(color), 0 };
+		}
+		return snapshot;
+	}
+
+	bool isConverted(const DWORD* palette, UINT version)
+	{
+		for (UINT i = 0; i < 256; ++i)
+		{
+			if (palette[i] != getColor(version, i))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+TEST_CASE(convertsEntriesToX8R8G8B8)
+{
+	Gdi::Palette::Snapshot snapshot = {};
+	snapshot.entries[1] = { 0x12, 0x34, 0x56, 0x02 };
+	snapshot.entries[255] = { 0xFF, 0x00, 0x80, 0 };
+	D3dDdi::PresentationPalette palette;
+	const DWORD* pal = palette.get(snapshot);
+	CHECK(0 == pal[0]);
+	CHECK(0x123456 == pal[1]);
+	CHECK(0xFF0080 == pal[255]);
+}
+
+TEST_CASE(unchangedVersionIsNotReconverted)
+{
+	D3dDdi::PresentationPalette palette;
+	auto snapshot(createSnapshot(1));
+	CHECK(isConverted(palette.get(*snapshot), 1));
+
+	// Same version with different entries would only be reconverted if the version check were skipped
+	auto modified(std::make_shared<Gdi::Palette::Snapshot>(*createSnapshot(2)));
+	modified->version = 1;
+	CHECK(isConverted(palette.get(*modified), 1));
+
+	CHECK(isConverted(palette.get(*createSnapshot(2)), 2));
+}
+
+TEST_CASE(initialSnapshotIsConverted)
+{
+	D3dDdi::PresentationPalette palette;
+	CHECK(isConverted(palette.get(*createSnapshot(0)), 0));
+}
+
+TEST_CASE(concurrentPublicationIsSeenConsistently)
+{
+	// Mirrors Gdi::Palette publishing snapshots with atomic_store while presentation blits convert them under the
+	// driver lock
+	std::shared_ptr<const Gdi::Palette::Snapshot> published(createSnapshot(0));
+	std::mutex driverLock;
+	D3dDdi::PresentationPalette palette;
+	std::atomic<bool> stop = false;
+	std::atomic<unsigned> inconsistentCount = 0;
+	std::atomic<unsigned> conversionCount = 0;
+
+	std::vector<std::thread> readers;
+	for (unsigned i = 0; i < READER_COUNT; ++i)
+	{
+		readers.emplace_back([&]()
+			{
+				UINT lastVersion = 0;
+				while (!stop)
+				{
+					auto snapshot(std::atomic_load(&published));
+					if (snapshot->version < lastVersion)
+					{
+						++inconsistentCount;
+					}
+					lastVersion = snapshot->version;
+
+					std::lock_guard<std::mutex> lock(driverLock);
+					if (!isConverted(palette.get(*snapshot), snapshot->version))
+					{
+						++inconsistentCount;
+					}
+					++conversionCount;
+				}
+			});
+	}
+
+	for (UINT version = 1; version <= PUBLISH_COUNT; ++version)
+	{
+		std::atomic_store(&published, createSnapshot(version));
+	}
+	while (0 == conversionCount)
+	{
+		std::this_thread::yield();
+	}
+	stop = true;
+	for (auto& reader : readers)
+	{
+		reader.join();
+	}
+
+	CHECK(0 == inconsistentCount);
+	std::lock_guard<std::mutex> lock(driverLock);
+	CHECK(isConverted(palette.get(*std::atomic_load(&published)), PUBLISH_COUNT));
+}
@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <Gdi/Region.h>
+#include <Benchmark.h>
+
+struct HRGN__
+{
+	std::vector<RECT> rects;
+};
+
+namespace
+{
+	// Staggered, overlapping window rects, similar to a cascade of top-level windows on a desktop
+	std::vector<RECT> createWindowRects(unsigned count)
+	{
+		std::vector<RECT> rects;
+		for (unsigned i = 0; i < count; ++i)
+		{
+			const LONG x = 37 * i % 800;
+			const LONG y = 23 * i % 600;
+			rects.push_back({ x, y, x + 320, y + 240 });
+		}
+		return rects;
+	}
+
+	// A checkerboard of count by count cells, one band of rects per row
+	Gdi::Region createCheckerboard(LONG count, LONG cellSize, LONG offset)
+	{
+		Gdi::Region rgn;
+		for (LONG y = 0; y < count; ++y)
+		{
+			for (LONG x = y % 2; x < count; x += 2)
+			{
+				rgn |= RECT{ offset + x * cellSize, offset + y * cellSize,
+					offset + (x + 1) * cellSize, offset + (y + 1) * cellSize };
+			}
+		}
+		return rgn;
+	}
+}
+
+HRGN CreateRectRgn(int left, int top, int right, int bottom)
+{
+	if (left < right && top < bottom)
+	{
+		return new HRGN__{ { RECT{ left, top, right, bottom } } };
+	}
+	return new HRGN__{};
+}
+
+HRGN CreateRectRgnIndirect(const RECT* rect)
+{
+	return CreateRectRgn(rect->left, rect->top, rect->right, rect->bottom);
+}
+
+BOOL DeleteObject(HGDIOBJ obj)
+{
+	delete static_cast<HRGN>(obj);
+	return TRUE;
+}
+
+HRGN ExtCreateRegion(const XFORM* /*xform*/, DWORD /*count*/, const RGNDATA* data)
+{
+	const RECT* rects = reinterpret_cast<const RECT*>(data->Buffer);
+	return new HRGN__{ std::vector<RECT>(rects, rects + data->rdh.nCount) };
+}
+
+int GetRandomRgn(HDC /*dc*/, HRGN /*rgn*/, INT /*num*/)
+{
+	return 0;
+}
+
+DWORD GetRegionData(HRGN rgn, DWORD count, RGNDATA* data)
+{
+	const DWORD rectsSize = rgn->rects.size() * sizeof(RECT);
+	const DWORD size = sizeof(RGNDATAHEADER) + rectsSize;
+	if (!data)
+	{
+		return size;
+	}
+	if (count < size)
+	{
+		return 0;
+	}
+
+	data->rdh = { sizeof(RGNDATAHEADER), RDH_RECTANGLES, static_cast<DWORD>(rgn->rects.size()), rectsSize, {} };
+	std::memcpy(data->Buffer, rgn->rects.data(), rectsSize);
+	return size;
+}
+
+HDC GetWindowDC(HWND /*hwnd*/)
+{
+	return nullptr;
+}
+
+BOOL IntersectRect(RECT* dst, const RECT* src1, const RECT* src2)
+{
+	*dst = { std::max<LONG>(src1->left, src2->left), std::max<LONG>(src1->top, src2->top),
+		std::min<LONG>(src1->right, src2->right), std::min<LONG>(src1->bottom, src2->bottom) };
+	if (dst->left >= dst->right || dst->top >= dst->bottom)
+	{
+		*dst = {};
+		return FALSE;
+	}
+	return TRUE;
+}
+
+BOOL OffsetRect(RECT* rect, int dx, int dy)
+{
+	rect->left += dx;
+	rect->top += dy;
+	rect->right += dx;
+	rect->bottom += dy;
+	return TRUE;
+}
+
+int ReleaseDC(HWND /*hwnd*/, HDC /*dc*/)
+{
+	return 1;
+}
+
+BENCHMARK(intersectRects)
+{
+	const Gdi::Region clip(RECT{ 100, 100, 700, 500 });
+	for (unsigned i = 0; i < iterationCount; ++i)
+	{
+		const LONG x = i % 256;
+		Gdi::Region rgn(RECT{ x, x, x + 320, x + 240 });
+		rgn &= clip;
+		Benchmark::doNotOptimize(&rgn);
+	}
+}
+
+// Per iteration, the visible regions of 16 windows from top to bottom, as in a z-order update
+BENCHMARK(accumulateWindowVisibility)
+{
+	const auto windowRects = createWindowRects(16);
+	for (unsigned i = 0; i < iterationCount; ++i)
+	{
+		Gdi::Region obscuredRegion;
+		for (const auto& windowRect : windowRects)
+		{
+			Gdi::Region visibleRegion(windowRect);
+			visibleRegion -= obscuredRegion;
+			Benchmark::doNotOptimize(&visibleRegion);
+			obscuredRegion |= windowRect;
+		}
+		Benchmark::doNotOptimize(&obscuredRegion);
+	}
+}
+
+BENCHMARK(combineCheckerboards)
+{
+	const Gdi::Region rgn1(createCheckerboard(8, 16, 0));
+	const Gdi::Region rgn2(createCheckerboard(8, 16, 8));
+	for (unsigned i = 0; i < iterationCount; ++i)
+	{
+		Gdi::Region result(rgn1 | rgn2);
+		result -= rgn1 & rgn2;
+		Benchmark::doNotOptimize(&result);
+	}
+}
+
+BENCHMARK(hrgnRoundTrip)
+{
+	const Gdi::Region rgn(createCheckerboard(8, 16, 0));
+	for (unsigned i = 0; i < iterationCount; ++i)
+	{
+		Gdi::Region copy(rgn);
+		Gdi::Region result(copy.release());
+		Benchmark::doNotOptimize(&result);
+	}
+}
@@ -0,0 +1,317 @@
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <Gdi/Region.h>
+#include <Test.h>
+
+struct HRGN__
+{
+	std::vector<RECT> rects;
+};
+
+namespace
+{
+	const LONG GRID_SIZE = 24;
+
+	typedef std::vector<bool> Mask;
+
+	int g_liveRgnCount = 0;
+
+	HRGN createFakeRgn(const RECT* rects, std::size_t count)
+	{
+		++g_liveRgnCount;
+		return new HRGN__{ std::vector<RECT>(rects, rects + count) };
+	}
+
+	Mask getMask(const Gdi::Region& rgn)
+	{
+		Mask mask(GRID_SIZE * GRID_SIZE);
+		for (const auto& r : rgn.getRects())
+		{
+			for (LONG y = r.top; y < r.bottom; ++y)
+			{
+				for (LONG x = r.left; x < r.right; ++x)
+				{
+					mask[y * GRID_SIZE + x] = true;
+				}
+			}
+		}
+		return mask;
+	}
+
+	Mask combineMasks(const Mask& mask1, const Mask& mask2, int mode)
+	{
+		Mask result(mask1.size());
+		for (std::size_t i = 0; i < mask1.size(); ++i)
+		{
+			switch (mode)
+			{
+			case RGN_AND:
+				result[i] = mask1[i] && mask2[i];
+				break;
+			case RGN_OR:
+				result[i] = mask1[i] || mask2[i];
+				break;
+			case RGN_DIFF:
+				result[i] = mask1[i] && !mask2[i];
+				break;
+			}
+		}
+		return result;
+	}
+
+	bool isNormalized(const Gdi::Region& rgn)
+	{
+		const auto& rects = rgn.getRects();
+		std::size_t prevBandStart = 0;
+		std::size_t bandStart = 0;
+		for (std::size_t i = 0; i <= rects.size(); ++i)
+		{
+			if (i < rects.size())
+			{
+				const RECT& r = rects[i];
+				if (r.left >= r.right || r.top >= r.bottom)
+				{
+					return false;
+				}
+				if (i != bandStart)
+				{
+					const RECT& prev = rects[i - 1];
+					if (r.top == prev.top)
+					{
+						if (r.bottom != prev.bottom || r.left <= prev.right)
+						{
+							return false;
+						}
+						continue;
+					}
+					if (r.top < prev.bottom)
+					{
+						return false;
+					}
+				}
+				else
+				{
+					continue;
+				}
+			}
+
+			if (prevBandStart != bandStart && rects[prevBandStart].bottom == rects[bandStart].top &&
+				i - bandStart == bandStart - prevBandStart)
+			{
+				bool isEqual = true;
+				for (std::size_t j = 0; j < i - bandStart; ++j)
+				{
+					isEqual = isEqual && rects[prevBandStart + j].left == rects[bandStart + j].left &&
+						rects[prevBandStart + j].right == rects[bandStart + j].right;
+				}
+				if (isEqual)
+				{
+					return false;
+				}
+			}
+			prevBandStart = bandStart;
+			bandStart = i;
+		}
+		return true;
+	}
+
+	RECT createRect(std::mt19937& rng)
+	{
+		std::uniform_int_distribution<LONG> dist(0, GRID_SIZE);
+		const LONG x1 = dist(rng);
+		const LONG x2 = dist(rng);
+		const LONG y1 = dist(rng);
+		const LONG y2 = dist(rng);
+		return { std::min<LONG>(x1, x2), std::min<LONG>(y1, y2), std::max<LONG>(x1, x2), std::max<LONG>(y1, y2) };
+	}
+
+	std::vector<RECT> createRects(std::mt19937& rng)
+	{
+		std::uniform_int_distribution<int> countDist(0, 6);
+		std::vector<RECT> rects(countDist(rng));
+		for (auto& r : rects)
+		{
+			r = createRect(rng);
+		}
+		return rects;
+	}
+
+	Gdi::Region createRegion(const std::vector<RECT>& rects)
+	{
+		Gdi::Region rgn;
+		for (const auto& r : rects)
+		{
+			rgn |= r;
+		}
+		return rgn;
+	}
+}
+
+HRGN CreateRectRgn(int left, int top, int right, int bottom)
+{
+	const RECT r = { left, top, right, bottom };
+	return left < right && top < bottom ? createFakeRgn(&r, 1) : createFakeRgn(nullptr, 0);
+}
+
+HRGN CreateRectRgnIndirect(const RECT* rect)
+{
+	return CreateRectRgn(rect->left, rect->top, rect->right, rect->bottom);
+}
+
+BOOL DeleteObject(HGDIOBJ obj)
+{
+	--g_liveRgnCount;
+	delete static_cast<HRGN>(obj);
+	return TRUE;
+}
+
+HRGN ExtCreateRegion(const XFORM* /*xform*/, DWORD /*count*/, const RGNDATA* data)
+{
+	return createFakeRgn(reinterpret_cast<const RECT*>(data->Buffer), data->rdh.nCount);
+}
+
+int GetRandomRgn(HDC /*dc*/, HRGN /*rgn*/, INT /*num*/)
+{
+	return 0;
+}
+
+DWORD GetRegionData(HRGN rgn, DWORD count, RGNDATA* data)
+{
+	const DWORD rectsSize = rgn->rects.size() * sizeof(RECT);
+	const DWORD size = sizeof(RGNDATAHEADER) + rectsSize;
+	if (!data)
+	{
+		return size;
+	}
+	if (count < size)
+	{
+		return 0;
+	}
+
+	data->rdh = { sizeof(RGNDATAHEADER), RDH_RECTANGLES, static_cast<DWORD>(rgn->rects.size()), rectsSize, {} };
+	std::memcpy(data->Buffer, rgn->rects.data(), rectsSize);
+	return size;
+}
+
+HDC GetWindowDC(HWND /*hwnd*/)
+{
+	return nullptr;
+}
+
+BOOL IntersectRect(RECT* dst, const RECT* src1, const RECT* src2)
+{
+	*dst = { std::max<LONG>(src1->left, src2->left), std::max<LONG>(src1->top, src2->top),
+		std::min<LONG>(src1->right, src2->right), std::min<LONG>(src1->bottom, src2->bottom) };
+	if (dst->left >= dst->right || dst->top >= dst->bottom)
+	{
+		*dst = {};
+		return FALSE;
+	}
+	return TRUE;
+}
+
+BOOL OffsetRect(RECT* rect, int dx, int dy)
+{
+	rect->left += dx;
+	rect->top += dy;
+	rect->right += dx;
+	rect->bottom += dy;
+	return TRUE;
+}
+
+int ReleaseDC(HWND /*hwnd*/, HDC /*dc*/)
+{
+	return 1;
+}
+
+TEST_CASE(combineMatchesPixelModel)
+{
+	std::mt19937 rng(3);
+	const int modes[] = { RGN_AND, RGN_OR, RGN_DIFF };
+	for (int i = 0; i < 2000; ++i)
+	{
+		const auto rects1(createRects(rng));
+		const auto rects2(createRects(rng));
+		const Gdi::Region rgn1(createRegion(rects1));
+		const Gdi::Region rgn2(createRegion(rects2));
+		CHECK(isNormalized(rgn1));
+
+		for (int mode : modes)
+		{
+			Gdi::Region result(rgn1);
+			switch (mode)
+			{
+			case RGN_AND:
+				result &= rgn2;
+				break;
+			case RGN_OR:
+				result |= rgn2;
+				break;
+			case RGN_DIFF:
+				result -= rgn2;
+				break;
+			}
+
+			CHECK(isNormalized(result));
+			CHECK(getMask(result) == combineMasks(getMask(rgn1), getMask(rgn2), mode));
+		}
+	}
+}
+
+TEST_CASE(unbandedRgnDataIsNormalized)
+{
+	std::mt19937 rng(4);
+	for (int i = 0; i < 500; ++i)
+	{
+		const auto rects(createRects(rng));
+		std::vector<RECT> nonEmptyRects;
+		std::copy_if(rects.begin(), rects.end(), std::back_inserter(nonEmptyRects),
+			[](const RECT& r) { return r.left < r.right && r.top < r.bottom; });
+
+		const Gdi::Region rgn(createFakeRgn(nonEmptyRects.data(), nonEmptyRects.size()));
+		CHECK(isNormalized(rgn));
+		CHECK(rgn == createRegion(rects));
+	}
+	CHECK(0 == g_liveRgnCount);
+}
+
+TEST_CASE(hrgnRoundTripPreservesRects)
+{
+	std::mt19937 rng(5);
+	for (int i = 0; i < 200; ++i)
+	{
+		Gdi::Region rgn(createRegion(createRects(rng)));
+		const Gdi::Region copy(rgn);
+		CHECK(static_cast<HRGN>(rgn));
+		CHECK(Gdi::Region(rgn.release()) == copy);
+		CHECK(!rgn);
+	}
+	CHECK(0 == g_liveRgnCount);
+}
+
+TEST_CASE(queriesAndOffset)
+{
+	Gdi::Region rgn(RECT{ 0, 0, 4, 4 });
+	rgn |= RECT{ 6, 2, 8, 10 };
+	CHECK(isNormalized(rgn));
+	CHECK(rgn.contains({ 3, 3 }));
+	CHECK(!rgn.contains({ 4, 3 }));
+	CHECK(rgn.contains({ 7, 9 }));
+	CHECK(!rgn.contains({ 7, 10 }));
+
+	const RECT bounds = rgn.getBounds();
+	CHECK(0 == bounds.left && 0 == bounds.top && 8 == bounds.right && 10 == bounds.bottom);
+
+	rgn.offset(-2, 5);
+	CHECK(rgn.contains({ 5, 14 }));
+	CHECK(!rgn.contains({ 5, 15 }));
+
+	rgn -= rgn;
+	CHECK(rgn.isEmpty());
+	CHECK(static_cast<bool>(rgn));
+	CHECK(!Gdi::Region(nullptr).isEmpty());
+	CHECK(Gdi::Region(RECT{ 5, 5, 1, 1 }) == Gdi::Region(RECT{ 1, 1, 5, 5 }));
+}
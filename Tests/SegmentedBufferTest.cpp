@@ -0,0 +1,323 @@
+#include <algorithm>
+#include <vector>
+
+#include <D3dDdi/SegmentedBuffer.h>
+#include <Test.h>
+
+namespace
+{
+	const UINT VERTEX_BUFFER_SIZE = 1024 * 1024;
+	const UINT STRIDE = 32;
+
+	// Driver model: draws are executed gpuLatency presents after they were submitted, fences signal once the draws
+	// before them are executed, and a discard renames the buffer so earlier draws no longer reference it
+	struct MockDdi
+	{
+		struct Write
+		{
+			UINT begin;
+			UINT end;
+			UINT presentCount;
+		};
+
+		UINT presentCount = 0;
+		UINT gpuLatency = 2;
+		bool isFenceSupported = true;
+		bool isCreateFailing = false;
+
+		std::vector<BYTE> storage;
+		std::vector<Write> pendingWrites;
+		std::vector<UINT> fences;
+		UINT liveFenceCount = 0;
+		UINT createCount = 0;
+		UINT discardCount = 0;
+		UINT hazardCount = 0;
+		UINT peakSize = 0;
+
+		bool createBuffer(UINT size)
+		{
+			if (isCreateFailing)
+			{
+				return false;
+			}
+			storage.assign(size, 0);
+			pendingWrites.clear();
+			++createCount;
+			peakSize = std::max(peakSize, size);
+			return true;
+		}
+
+		void destroyBuffer()
+		{
+			storage.clear();
+			pendingWrites.clear();
+		}
+
+		void* lock(UINT offset, UINT size, bool discard)
+		{
+			CHECK(offset + size <= storage.size());
+			if (discard)
+			{
+				++discardCount;
+				pendingWrites.clear();
+			}
+			else
+			{
+				for (const auto& write : pendingWrites)
+				{
+					if (offset < write.end && write.begin < offset + size && !isExecuted(write.presentCount))
+					{
+						++hazardCount;
+					}
+				}
+			}
+			pendingWrites.push_back({ offset, offset + size, presentCount });
+			return storage.data() + offset;
+		}
+
+		void unlock()
+		{
+		}
+
+		HANDLE createFence()
+		{
+			if (!isFenceSupported)
+			{
+				return nullptr;
+			}
+			fences.push_back(0);
+			++liveFenceCount;
+			return reinterpret_cast<HANDLE>(static_cast<UINT_PTR>(fences.size()));
+		}
+
+		void destroyFence(HANDLE /*fence*/)
+		{
+			--liveFenceCount;
+		}
+
+		bool isFenceSignaled(HANDLE fence)
+		{
+			return isExecuted(fences[reinterpret_cast<UINT_PTR>(fence) - 1]);
+		}
+
+		bool issueFence(HANDLE fence)
+		{
+			fences[reinterpret_cast<UINT_PTR>(fence) - 1] = presentCount;
+			return true;
+		}
+
+		UINT getPresentCount() const
+		{
+			return presentCount;
+		}
+
+		bool isExecuted(UINT submitPresentCount) const
+		{
+			return presentCount - submitPresentCount >= gpuLatency;
+		}
+
+		void present()
+		{
+			++presentCount;
+			pendingWrites.erase(std::remove_if(pendingWrites.begin(), pendingWrites.end(),
+				[this](const Write& write) { return isExecuted(write.presentCount); }), pendingWrites.end());
+		}
+	};
+
+	typedef D3dDdi::SegmentedBuffer<MockDdi> Buffer;
+
+	struct Simulation
+	{
+		MockDdi ddi;
+		Buffer buffer;
+
+		Simulation(UINT size, UINT gpuLatency = 2, bool isFenceSupported = true)
+			: ddi(createDdi(gpuLatency, isFenceSupported))
+			, buffer(ddi, size)
+		{
+			buffer.setStride(STRIDE);
+		}
+
+		// Returns the number of discards in the simulated frames, not counting the first lock of a new buffer
+		UINT runFrames(UINT frameCount, UINT drawCount, UINT drawSize)
+		{
+			static const std::vector<BYTE> vertices(Buffer::MAX_SEGMENT_SIZE);
+			UINT discardCount = 0;
+			for (UINT frame = 0; frame < frameCount; ++frame)
+			{
+				for (UINT draw = 0; draw < drawCount; ++draw)
+				{
+					const UINT createCount = ddi.createCount;
+					const UINT prevDiscardCount = ddi.discardCount;
+					CHECK(buffer.load(vertices.data(), drawSize / STRIDE) >= 0);
+					if (createCount == ddi.createCount)
+					{
+						discardCount += ddi.discardCount - prevDiscardCount;
+					}
+				}
+				ddi.present();
+			}
+			return discardCount;
+		}
+
+		static MockDdi createDdi(UINT gpuLatency, bool isFenceSupported)
+		{
+			MockDdi ddi;
+			ddi.gpuLatency = gpuLatency;
+			ddi.isFenceSupported = isFenceSupported;
+			return ddi;
+		}
+	};
+}
+
+TEST_CASE(layoutIsKeptUntilUsageIsSampled)
+{
+	Simulation sim(VERTEX_BUFFER_SIZE);
+	CHECK(1 == sim.ddi.createCount);
+	CHECK(Buffer::INITIAL_SEGMENT_COUNT == sim.buffer.getSegmentCount());
+
+	sim.runFrames(Buffer::USAGE_SAMPLE_FRAMES - 1, 4, 1024);
+	CHECK(1 == sim.ddi.createCount);
+	CHECK(0 == sim.ddi.hazardCount);
+}
+
+TEST_CASE(lightUsageUsesMinimumSegmentSize)
+{
+	Simulation sim(VERTEX_BUFFER_SIZE);
+	sim.runFrames(Buffer::USAGE_SAMPLE_FRAMES + 1, 4, 1024);
+	CHECK(2 == sim.ddi.createCount);
+	CHECK(VERTEX_BUFFER_SIZE / Buffer::INITIAL_SEGMENT_COUNT == sim.buffer.getSegmentSize());
+	CHECK((Buffer::MAX_FRAME_LATENCY + 1) + 1 == sim.buffer.getSegmentCount());
+
+	// The layout is stable, so later samples do not recreate the buffer
+	CHECK(0 == sim.runFrames(10 * Buffer::USAGE_SAMPLE_FRAMES, 4, 1024));
+	CHECK(2 == sim.ddi.createCount);
+}
+
+TEST_CASE(segmentsAreSizedForFrameLatency)
+{
+	// 600 KB per frame spans three minimum segments, which would need 3 * 4 + 1 segments
+	Simulation sim(VERTEX_BUFFER_SIZE);
+	sim.runFrames(3 * Buffer::USAGE_SAMPLE_FRAMES, 100, 6 * 1024);
+	const UINT segmentSize = sim.buffer.getSegmentSize();
+	const UINT segmentCount = sim.buffer.getSegmentCount();
+	CHECK(segmentCount >= Buffer::MIN_SEGMENT_COUNT && segmentCount <= Buffer::MAX_SEGMENT_COUNT);
+	CHECK(segmentSize * segmentCount == sim.buffer.getSize());
+	CHECK(sim.buffer.getSize() <= Buffer::MAX_BUFFER_SIZE);
+	CHECK((100 * 6 * 1024 + segmentSize - 1) / segmentSize * (Buffer::MAX_FRAME_LATENCY + 1) < segmentCount);
+	CHECK(0 == sim.ddi.hazardCount);
+}
+
+TEST_CASE(steadyUsageStopsDiscarding)
+{
+	Simulation sim(VERTEX_BUFFER_SIZE);
+	const UINT warmupDiscards = sim.runFrames(4 * Buffer::USAGE_SAMPLE_FRAMES, 200, 4 * 1024);
+	CHECK(0 != warmupDiscards);
+	const UINT createCount = sim.ddi.createCount;
+	CHECK(0 == sim.runFrames(10 * Buffer::USAGE_SAMPLE_FRAMES, 200, 4 * 1024));
+	CHECK(createCount == sim.ddi.createCount);
+	CHECK(0 == sim.ddi.hazardCount);
+}
+
+TEST_CASE(discardsTriggerEarlyResize)
+{
+	// The second frame runs out of idle segments, and the first load of the third frame resizes
+	Simulation sim(VERTEX_BUFFER_SIZE);
+	CHECK(0 != sim.runFrames(2, 200, 4 * 1024));
+	CHECK(1 == sim.ddi.createCount);
+	sim.runFrames(1, 200, 4 * 1024);
+	CHECK(2 == sim.ddi.createCount);
+	CHECK(sim.buffer.getSize() > VERTEX_BUFFER_SIZE);
+}
+
+TEST_CASE(heavyUsageIsCappedAtMaxBufferSize)
+{
+	Simulation sim(VERTEX_BUFFER_SIZE);
+	sim.runFrames(4 * Buffer::USAGE_SAMPLE_FRAMES, 48, 64 * 1024);
+	CHECK(sim.ddi.peakSize <= Buffer::MAX_BUFFER_SIZE);
+	CHECK(sim.buffer.getSegmentSize() <= Buffer::MAX_SEGMENT_SIZE);
+	CHECK(sim.buffer.getSegmentCount() >= Buffer::MIN_SEGMENT_COUNT);
+	CHECK(0 == sim.ddi.hazardCount);
+}
+
+TEST_CASE(usageDropShrinksBuffer)
+{
+	Simulation sim(VERTEX_BUFFER_SIZE);
+	sim.runFrames(4 * Buffer::USAGE_SAMPLE_FRAMES, 48, 64 * 1024);
+	const UINT heavySize = sim.buffer.getSize();
+	sim.runFrames(4 * Buffer::USAGE_SAMPLE_FRAMES, 4, 1024);
+	CHECK(sim.buffer.getSize() < heavySize);
+	CHECK(VERTEX_BUFFER_SIZE / Buffer::INITIAL_SEGMENT_COUNT == sim.buffer.getSegmentSize());
+	CHECK(0 == sim.ddi.hazardCount);
+}
+
+TEST_CASE(slowGpuIsNotOverwritten)
+{
+	Simulation sim(VERTEX_BUFFER_SIZE, 8);
+	sim.runFrames(6 * Buffer::USAGE_SAMPLE_FRAMES, 100, 4 * 1024);
+	CHECK(0 == sim.ddi.hazardCount);
+}
+
+TEST_CASE(presentCountIsUsedWithoutFences)
+{
+	Simulation sim(VERTEX_BUFFER_SIZE, Buffer::MAX_FRAME_LATENCY, false);
+	sim.runFrames(4 * Buffer::USAGE_SAMPLE_FRAMES, 200, 4 * 1024);
+	CHECK(0 == sim.runFrames(10 * Buffer::USAGE_SAMPLE_FRAMES, 200, 4 * 1024));
+	CHECK(0 == sim.ddi.hazardCount);
+	CHECK(0 == sim.ddi.liveFenceCount);
+}
+
+TEST_CASE(presentCountFallbackAssumesMaxFrameLatency)
+{
+	// Checks that the hazard model catches reuse when the driver lags further behind than the fallback assumes
+	Simulation sim(VERTEX_BUFFER_SIZE, Buffer::MAX_FRAME_LATENCY + 3, false);
+	sim.runFrames(4 * Buffer::USAGE_SAMPLE_FRAMES, 200, 4 * 1024);
+	CHECK(0 != sim.ddi.hazardCount);
+}
+
+TEST_CASE(failedResizeKeepsBuffer)
+{
+	Simulation sim(VERTEX_BUFFER_SIZE);
+	sim.ddi.isCreateFailing = true;
+	sim.runFrames(2 * Buffer::USAGE_SAMPLE_FRAMES, 200, 4 * 1024);
+	CHECK(1 == sim.ddi.createCount);
+	CHECK(VERTEX_BUFFER_SIZE == sim.buffer.getSize());
+	CHECK(0 == sim.ddi.hazardCount);
+}
+
+TEST_CASE(oversizedLoadFails)
+{
+	Simulation sim(VERTEX_BUFFER_SIZE);
+	static const std::vector<BYTE> vertices(2 * VERTEX_BUFFER_SIZE);
+	CHECK(-1 == sim.buffer.load(vertices.data(), 2 * VERTEX_BUFFER_SIZE / STRIDE));
+	CHECK(0 <= sim.buffer.load(vertices.data(), VERTEX_BUFFER_SIZE / STRIDE));
+}
+
+TEST_CASE(emptyBufferFailsLoads)
+{
+	Simulation sim(VERTEX_BUFFER_SIZE);
+	sim.buffer.resize(0);
+	BYTE vertex[STRIDE] = {};
+	CHECK(-1 == sim.buffer.load(vertex, 1));
+}
+
+TEST_CASE(fencesAreReleased)
+{
+	MockDdi ddi;
+	{
+		Buffer buffer(ddi, VERTEX_BUFFER_SIZE);
+		buffer.setStride(STRIDE);
+		static const std::vector<BYTE> vertices(64 * 1024);
+		for (UINT frame = 0; frame < 2 * Buffer::USAGE_SAMPLE_FRAMES; ++frame)
+		{
+			for (UINT draw = 0; draw < 48; ++draw)
+			{
+				buffer.load(vertices.data(), vertices.size() / STRIDE);
+			}
+			ddi.present();
+		}
+		CHECK(0 != ddi.liveFenceCount);
+		CHECK(ddi.liveFenceCount <= buffer.getSegmentCount());
+	}
+	CHECK(0 == ddi.liveFenceCount);
+}
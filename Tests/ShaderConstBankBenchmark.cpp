@@ -0,0 +1,59 @@
+#include <vector>
+
+#include <D3dDdi/ShaderConstBank.h>
+#include <Benchmark.h>
+
+namespace
+{
+	typedef D3dDdi::ShaderConstBank<INT> Bank;
+
+	HRESULT upload(UINT /*reg*/, UINT /*count*/, const INT* values)
+	{
+		Benchmark::doNotOptimize(values);
+		return S_OK;
+	}
+
+	// Per iteration, writes setCount runs of registers spaced by stride with a changed value, then flushes
+	void setAndFlush(unsigned iterationCount, UINT setCount, UINT count, UINT stride)
+	{
+		Bank bank;
+		std::vector<INT> values(count);
+		for (unsigned i = 0; i < iterationCount; ++i)
+		{
+			values.assign(count, static_cast<INT>(i + 1));
+			for (UINT j = 0; j < setCount; ++j)
+			{
+				bank.set(j * stride, count, values.data(), []() {});
+			}
+			bank.flush(upload);
+		}
+	}
+}
+
+BENCHMARK(setContiguousRegisters)
+{
+	setAndFlush(iterationCount, 64, 4, 4);
+}
+
+BENCHMARK(setScatteredRegisters)
+{
+	setAndFlush(iterationCount, 64, 1, 4);
+}
+
+BENCHMARK(setOverlappingRegisters)
+{
+	setAndFlush(iterationCount, 64, 8, 2);
+}
+
+BENCHMARK(setUnchangedRegisters)
+{
+	Bank bank;
+	std::vector<INT> values(256, 1);
+	bank.set(0, 256, values.data(), []() {});
+	bank.flush(upload);
+	for (unsigned i = 0; i < iterationCount; ++i)
+	{
+		bank.set(i % 240, 16, values.data(), []() {});
+		Benchmark::doNotOptimize(&bank);
+	}
+}
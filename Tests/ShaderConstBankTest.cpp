@@ -0,0 +1,227 @@
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <D3dDdi/ShaderConstBank.h>
+#include <Test.h>
+
+namespace
+{
+	typedef std::tuple<FLOAT, FLOAT, FLOAT, FLOAT> ShaderConstF;
+	typedef D3dDdi::ShaderConstBank<INT> Bank;
+
+	const UINT REGISTER_COUNT = 256;
+
+	struct Driver
+	{
+		std::vector<INT> registers = std::vector<INT>(REGISTER_COUNT);
+		std::vector<Bank::Range> uploads;
+		UINT failingRegister = REGISTER_COUNT;
+
+		HRESULT upload(UINT reg, UINT count, const INT* values)
+		{
+			if (failingRegister >= reg && failingRegister < reg + count)
+			{
+				return E_FAIL;
+			}
+			uploads.push_back({ reg, reg + count });
+			std::copy(values, values + count, registers.begin() + reg);
+			return S_OK;
+		}
+	};
+
+	HRESULT flush(Bank& bank, Driver& driver)
+	{
+		return bank.flush([&](UINT reg, UINT count, const INT* values) { return driver.upload(reg, count, values); });
+	}
+
+	bool set(Bank& bank, UINT reg, std::vector<INT> values)
+	{
+		return bank.set(reg, values.size(), values.data(), []() {});
+	}
+
+	bool isEqual(const std::vector<Bank::Range>& ranges, const std::vector<Bank::Range>& expected)
+	{
+		if (ranges.size() != expected.size())
+		{
+			return false;
+		}
+		for (std::size_t i = 0; i < ranges.size(); ++i)
+		{
+			if (ranges[i].begin != expected[i].begin || ranges[i].end != expected[i].end)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Maximal runs of dirty registers
+	std::vector<Bank::Range> getRuns(const std::vector<bool>& isDirty)
+	{
+		std::vector<Bank::Range> runs;
+		for (UINT i = 0; i < isDirty.size(); ++i)
+		{
+			if (isDirty[i])
+			{
+				if (runs.empty() || runs.back().end != i)
+				{
+					runs.push_back({ i, i + 1 });
+				}
+				else
+				{
+					++runs.back().end;
+				}
+			}
+		}
+		return runs;
+	}
+}
+
+TEST_CASE(unchangedRegistersAreNotDirty)
+{
+	Bank bank;
+	CHECK(!set(bank, 0, { 0, 0, 0 }));
+	CHECK(bank.getDirtyRanges().empty());
+	CHECK(set(bank, 0, { 0, 1, 0 }));
+	CHECK(!set(bank, 0, { 0, 1, 0 }));
+	CHECK(isEqual(bank.getDirtyRanges(), { { 0, 3 } }));
+}
+
+TEST_CASE(beforeChangeIsCalledOnlyForChanges)
+{
+	Bank bank;
+	INT value = 1;
+	unsigned callCount = 0;
+	bank.set(4, 1, &value, [&]() { ++callCount; });
+	bank.set(4, 1, &value, [&]() { ++callCount; });
+	CHECK(1 == callCount);
+}
+
+TEST_CASE(disjointRangesStaySeparate)
+{
+	Bank bank;
+	set(bank, 10, { 1, 1 });
+	set(bank, 0, { 1, 1 });
+	set(bank, 20, { 1 });
+	CHECK(isEqual(bank.getDirtyRanges(), { { 0, 2 }, { 10, 12 }, { 20, 21 } }));
+}
+
+TEST_CASE(touchingRangesAreMerged)
+{
+	Bank bank;
+	set(bank, 0, { 1, 1 });
+	set(bank, 4, { 1, 1 });
+	set(bank, 2, { 1, 1 });
+	CHECK(isEqual(bank.getDirtyRanges(), { { 0, 6 } }));
+}
+
+TEST_CASE(overlappingRangeSwallowsSeveral)
+{
+	Bank bank;
+	set(bank, 2, { 1 });
+	set(bank, 5, { 1 });
+	set(bank, 8, { 1 });
+	set(bank, 20, { 1 });
+	set(bank, 1, std::vector<INT>(9, 2));
+	CHECK(isEqual(bank.getDirtyRanges(), { { 1, 10 }, { 20, 21 } }));
+}
+
+TEST_CASE(rangesMatchBruteForceRuns)
+{
+	std::mt19937 random(12345);
+	for (unsigned round = 0; round < 200; ++round)
+	{
+		Bank bank;
+		Driver driver;
+		std::vector<INT> shadow(REGISTER_COUNT);
+		std::vector<bool> isDirty(REGISTER_COUNT);
+		for (unsigned i = 0; i < 50; ++i)
+		{
+			const UINT reg = random() % REGISTER_COUNT;
+			const UINT count = 1 + random() % std::min<UINT>(16, REGISTER_COUNT - reg);
+			std::vector<INT> values(count);
+			for (auto& value : values)
+			{
+				value = random() % 3;
+			}
+
+			const bool isChanged = !std::equal(values.begin(), values.end(), shadow.begin() + reg);
+			CHECK(isChanged == set(bank, reg, values));
+			if (isChanged)
+			{
+				std::copy(values.begin(), values.end(), shadow.begin() + reg);
+				std::fill(isDirty.begin() + reg, isDirty.begin() + reg + count, true);
+			}
+			CHECK(isEqual(bank.getDirtyRanges(), getRuns(isDirty)));
+
+			if (0 == random() % 10)
+			{
+				CHECK(S_OK == flush(bank, driver));
+				CHECK(driver.registers == shadow);
+				CHECK(bank.getDirtyRanges().empty());
+				isDirty.assign(REGISTER_COUNT, false);
+			}
+		}
+	}
+}
+
+TEST_CASE(flushUploadsEachRangeOnce)
+{
+	Bank bank;
+	Driver driver;
+	set(bank, 0, { 1, 2 });
+	set(bank, 8, { 3 });
+	set(bank, 2, { 4 });
+	CHECK(S_OK == flush(bank, driver));
+	CHECK(isEqual(driver.uploads, { { 0, 3 }, { 8, 9 } }));
+	CHECK(1 == driver.registers[0] && 2 == driver.registers[1] && 4 == driver.registers[2] && 3 == driver.registers[8]);
+
+	driver.uploads.clear();
+	CHECK(S_OK == flush(bank, driver));
+	CHECK(driver.uploads.empty());
+}
+
+TEST_CASE(failedUploadIsReturnedAndRetried)
+{
+	Bank bank;
+	Driver driver;
+	set(bank, 0, { 1 });
+	set(bank, 4, { 2 });
+	set(bank, 8, { 3 });
+	driver.failingRegister = 4;
+	CHECK(E_FAIL == flush(bank, driver));
+	CHECK(isEqual(driver.uploads, { { 0, 1 }, { 8, 9 } }));
+	CHECK(isEqual(bank.getDirtyRanges(), { { 4, 5 } }));
+
+	set(bank, 5, { 5 });
+	driver.failingRegister = REGISTER_COUNT;
+	driver.uploads.clear();
+	CHECK(S_OK == flush(bank, driver));
+	CHECK(isEqual(driver.uploads, { { 4, 6 } }));
+	CHECK(2 == driver.registers[4] && 5 == driver.registers[5]);
+}
+
+TEST_CASE(firstFailureIsReturned)
+{
+	Bank bank;
+	set(bank, 0, { 1 });
+	set(bank, 4, { 2 });
+	const HRESULT result = bank.flush([](UINT reg, UINT /*count*/, const INT* /*values*/)
+		{
+			return 0 == reg ? E_OUTOFMEMORY : E_FAIL;
+		});
+	CHECK(E_OUTOFMEMORY == result);
+	CHECK(2 == bank.getDirtyRanges().size());
+}
+
+TEST_CASE(vectorRegistersAreComparedByValue)
+{
+	D3dDdi::ShaderConstBank<ShaderConstF> bank;
+	const ShaderConstF values[] = { { 1, 2, 3, 4 }, { 5, 6, 7, 8 } };
+	CHECK(bank.set(2, 2, values, []() {}));
+	CHECK(!bank.set(3, 1, &values[1], []() {}));
+	CHECK(std::get<3>(bank.getRegisters()[3]) == 8);
+	CHECK(1 == bank.getDirtyRanges().size());
+}
@@ -0,0 +1,104 @@
+#include <atomic>
+#include <thread>
+
+#include <Common/SharedMetricsLayout.h>
+#include <Test.h>
+
+using namespace Compat::SharedMetrics;
+
+namespace
+{
+	const std::uint32_t READ_COUNT = 10000;
+	const std::uint32_t MIN_WRITE_COUNT = 200000;
+
+	void write(Block& block, std::uint32_t value)
+	{
+		const std::uint32_t sequence = beginWrite(block);
+		block.magic = MAGIC;
+		block.version = VERSION;
+		block.size = sizeof(Block);
+		block.counterCount = COUNTER_COUNT;
+		block.processId = value;
+		block.qpcFrequency = value;
+		block.qpcTimestamp = value;
+		for (std::uint32_t i = 0; i < COUNTER_COUNT; ++i)
+		{
+			block.counters[i] = value;
+		}
+		endWrite(block, sequence);
+	}
+}
+
+TEST_CASE(readFailsBeforeFirstWrite)
+{
+	Block block = {};
+	Snapshot snapshot = {};
+	CHECK(!tryRead(block, snapshot));
+
+	write(block, 1);
+	CHECK(tryRead(block, snapshot));
+	CHECK(2 == snapshot.sequence);
+	CHECK(MAGIC == snapshot.magic);
+	CHECK(VERSION == snapshot.version);
+	CHECK(COUNTER_COUNT == snapshot.counterCount);
+	CHECK(1 == snapshot.counters[COUNTER_COUNT - 1]);
+}
+
+TEST_CASE(readFailsDuringWrite)
+{
+	Block block = {};
+	write(block, 1);
+
+	Snapshot snapshot = {};
+	const std::uint32_t sequence = beginWrite(block);
+	CHECK(!tryRead(block, snapshot));
+	endWrite(block, sequence);
+	CHECK(tryRead(block, snapshot));
+	CHECK(4 == snapshot.sequence);
+}
+
+TEST_CASE(concurrentReadsAreConsistent)
+{
+	Block block = {};
+	std::atomic<bool> isReaderDone(false);
+	std::uint32_t writeCount = 0;
+	std::thread writer([&]()
+		{
+			// Keep writing until the reader is done, so that no read can miss the writer entirely
+			while (!isReaderDone || writeCount < MIN_WRITE_COUNT)
+			{
+				write(block, ++writeCount);
+			}
+		});
+
+	std::uint32_t readCount = 0;
+	std::uint32_t lastSequence = 0;
+	bool isConsistent = true;
+	while (readCount < READ_COUNT)
+	{
+		Snapshot snapshot = {};
+		if (!tryRead(block, snapshot))
+		{
+			continue;
+		}
+
+		++readCount;
+		const std::uint32_t value = snapshot.sequence / 2;
+		isConsistent = isConsistent && snapshot.sequence >= lastSequence &&
+			value == snapshot.processId && value == snapshot.qpcFrequency && value == snapshot.qpcTimestamp;
+		for (std::uint32_t i = 0; i < COUNTER_COUNT; ++i)
+		{
+			isConsistent = isConsistent && value == snapshot.counters[i];
+		}
+		lastSequence = snapshot.sequence;
+	}
+	isReaderDone = true;
+	writer.join();
+
+	CHECK(isConsistent);
+
+	Snapshot snapshot = {};
+	CHECK(tryRead(block, snapshot));
+	CHECK(2 * writeCount == snapshot.sequence);
+	CHECK(writeCount == snapshot.counters[0]);
+}
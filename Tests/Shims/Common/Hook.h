@@ -0,0 +1,5 @@
+#pragma once
+
+// The unit tests link against fake implementations of the hooked functions instead of the originals
+
+#define CALL_ORIG_FUNC(func) func
@@ -0,0 +1,18 @@
+#pragma once
+
+// The unit tests define g_qpcFrequency and pass explicit QPC values instead of reading a clock
+
+namespace Time
+{
+	extern long long g_qpcFrequency;
+
+	inline long long msToQpc(long long ms)
+	{
+		return ms * g_qpcFrequency / 1000;
+	}
+
+	inline long long qpcToMs(long long qpc)
+	{
+		return qpc * 1000 / g_qpcFrequency;
+	}
+}
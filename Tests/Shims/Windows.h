@@ -0,0 +1,182 @@
+#pragma once
+
+// Subset of the Windows SDK needed to build the platform independent parts of DDrawCompat for the unit tests
+
+#include <cstdint>
+
+#define FALSE 0
+#define TRUE 1
+
+#define CALLBACK
+
+#define S_OK 0
+#define E_FAIL static_cast<HRESULT>(0x80004005)
+#define E_OUTOFMEMORY static_cast<HRESULT>(0x8007000E)
+#define SUCCEEDED(hr) (static_cast<HRESULT>(hr) >= 0)
+#define FAILED(hr) (static_cast<HRESULT>(hr) < 0)
+
+typedef std::uint16_t ATOM;
+typedef int BOOL;
+typedef std::uint8_t BYTE;
+typedef std::uint32_t COLORREF;
+typedef std::uint32_t DWORD;
+typedef float FLOAT;
+typedef std::int32_t HRESULT;
+typedef std::int32_t INT;
+typedef std::int32_t LONG;
+typedef std::intptr_t LONG_PTR;
+typedef const char* LPCSTR;
+typedef std::uint32_t UINT;
+typedef std::uint16_t UINT16;
+typedef std::uintptr_t UINT_PTR;
+typedef std::uint64_t ULONGLONG;
+typedef std::uint16_t WORD;
+
+typedef LONG_PTR LPARAM;
+typedef LONG_PTR LRESULT;
+typedef UINT_PTR WPARAM;
+
+struct RECT
+{
+	LONG left;
+	LONG top;
+	LONG right;
+	LONG bottom;
+};
+
+typedef void* HANDLE;
+typedef void* HGDIOBJ;
+typedef struct HDC__* HDC;
+typedef struct HFONT__* HFONT;
+typedef struct HPALETTE__* HPALETTE;
+typedef struct HRGN__* HRGN;
+typedef struct HWND__* HWND;
+
+typedef LRESULT(CALLBACK* WNDPROC)(HWND, UINT, WPARAM, LPARAM);
+
+struct PALETTEENTRY
+{
+	BYTE peRed;
+	BYTE peGreen;
+	BYTE peBlue;
+	BYTE peFlags;
+};
+
+struct POINT
+{
+	LONG x;
+	LONG y;
+};
+
+struct RGNDATAHEADER
+{
+	DWORD dwSize;
+	DWORD iType;
+	DWORD nCount;
+	DWORD nRgnSize;
+	RECT rcBound;
+};
+
+struct RGNDATA
+{
+	RGNDATAHEADER rdh;
+	char Buffer[1];
+};
+
+struct SIZE
+{
+	LONG cx;
+	LONG cy;
+};
+
+struct XFORM
+{
+	FLOAT eM11;
+	FLOAT eM12;
+	FLOAT eM21;
+	FLOAT eM22;
+	FLOAT eDx;
+	FLOAT eDy;
+};
+
+#define RDH_RECTANGLES 1
+
+#define RGN_AND 1
+#define RGN_OR 2
+#define RGN_XOR 3
+#define RGN_DIFF 4
+#define RGN_COPY 5
+
+#define SYSRGN 4
+
+#define GM_COMPATIBLE 1
+#define GM_ADVANCED 2
+
+#define MM_TEXT 1
+#define MM_ANISOTROPIC 8
+
+#define MWT_IDENTITY 1
+
+#define OBJ_PEN 1
+#define OBJ_BRUSH 2
+#define OBJ_PAL 5
+#define OBJ_FONT 6
+
+// GDI functions below are not implemented by the shim; tests that need them provide fakes
+
+HRGN CreateRectRgn(int left, int top, int right, int bottom);
+HRGN CreateRectRgnIndirect(const RECT* rect);
+BOOL DeleteObject(HGDIOBJ obj);
+HRGN ExtCreateRegion(const XFORM* xform, DWORD count, const RGNDATA* data);
+int GetArcDirection(HDC dc);
+COLORREF GetBkColor(HDC dc);
+int GetBkMode(HDC dc);
+BOOL GetBrushOrgEx(HDC dc, POINT* point);
+HGDIOBJ GetCurrentObject(HDC dc, UINT type);
+BOOL GetCurrentPositionEx(HDC dc, POINT* point);
+COLORREF GetDCBrushColor(HDC dc);
+COLORREF GetDCPenColor(HDC dc);
+int GetGraphicsMode(HDC dc);
+DWORD GetLayout(HDC dc);
+int GetMapMode(HDC dc);
+int GetPolyFillMode(HDC dc);
+int GetRandomRgn(HDC dc, HRGN rgn, INT num);
+DWORD GetRegionData(HRGN rgn, DWORD count, RGNDATA* data);
+int GetROP2(HDC dc);
+int GetStretchBltMode(HDC dc);
+UINT GetTextAlign(HDC dc);
+int GetTextCharacterExtra(HDC dc);
+COLORREF GetTextColor(HDC dc);
+BOOL GetViewportExtEx(HDC dc, SIZE* size);
+BOOL GetViewportOrgEx(HDC dc, POINT* point);
+HDC GetWindowDC(HWND hwnd);
+BOOL GetWindowExtEx(HDC dc, SIZE* size);
+BOOL GetWindowOrgEx(HDC dc, POINT* point);
+BOOL GetWorldTransform(HDC dc, XFORM* xform);
+BOOL IntersectRect(RECT* dst, const RECT* src1, const RECT* src2);
+BOOL ModifyWorldTransform(HDC dc, const XFORM* xform, DWORD mode);
+BOOL MoveToEx(HDC dc, int x, int y, POINT* point);
+BOOL OffsetRect(RECT* rect, int dx, int dy);
+int ReleaseDC(HWND hwnd, HDC dc);
+HGDIOBJ SelectObject(HDC dc, HGDIOBJ obj);
+HPALETTE SelectPalette(HDC dc, HPALETTE palette, BOOL forceBackground);
+int SetArcDirection(HDC dc, int direction);
+COLORREF SetBkColor(HDC dc, COLORREF color);
+int SetBkMode(HDC dc, int mode);
+BOOL SetBrushOrgEx(HDC dc, int x, int y, POINT* point);
+COLORREF SetDCBrushColor(HDC dc, COLORREF color);
+COLORREF SetDCPenColor(HDC dc, COLORREF color);
+int SetGraphicsMode(HDC dc, int mode);
+DWORD SetLayout(HDC dc, DWORD layout);
+int SetMapMode(HDC dc, int mode);
+int SetPolyFillMode(HDC dc, int mode);
+int SetROP2(HDC dc, int rop2);
+int SetStretchBltMode(HDC dc, int mode);
+UINT SetTextAlign(HDC dc, UINT align);
+int SetTextCharacterExtra(HDC dc, int extra);
+COLORREF SetTextColor(HDC dc, COLORREF color);
+BOOL SetViewportExtEx(HDC dc, int x, int y, SIZE* size);
+BOOL SetViewportOrgEx(HDC dc, int x, int y, POINT* point);
+BOOL SetWindowExtEx(HDC dc, int x, int y, SIZE* size);
+BOOL SetWindowOrgEx(HDC dc, int x, int y, POINT* point);
+BOOL SetWorldTransform(HDC dc, const XFORM* xform);
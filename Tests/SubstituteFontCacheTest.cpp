@@ -0,0 +1,185 @@
+#include <map>
+#include <set>
+
+#include <Gdi/SubstituteFontCache.h>
+#include <Test.h>
+
+namespace
+{
+	enum Quality
+	{
+		DEFAULT,
+		NONANTIALIASED,
+		INVALID
+	};
+
+	// Stand-in for GetObject, CreateFontIndirect and DeleteObject
+	struct FakeFontFactory
+	{
+		static bool createSubstitute(HFONT origFont, HFONT& substituteFont)
+		{
+			++createCount;
+			auto it = fonts.find(origFont);
+			if (it == fonts.end() || INVALID == it->second)
+			{
+				return false;
+			}
+			substituteFont = DEFAULT == it->second ? createFont(NONANTIALIASED) : nullptr;
+			return true;
+		}
+
+		static void deleteFont(HFONT font)
+		{
+			deletedFonts.insert(font);
+			fonts.erase(font);
+		}
+
+		static HFONT createFont(Quality quality, UINT_PTR handle = 0)
+		{
+			HFONT font = reinterpret_cast<HFONT>(handle ? handle : nextHandle += 4);
+			fonts[font] = quality;
+			return font;
+		}
+
+		static void reset()
+		{
+			fonts.clear();
+			deletedFonts.clear();
+			createCount = 0;
+		}
+
+		static inline std::map<HFONT, Quality> fonts;
+		static inline std::set<HFONT> deletedFonts;
+		static inline unsigned createCount = 0;
+		static inline UINT_PTR nextHandle = 0x1000;
+	};
+
+	typedef Gdi::SubstituteFontCache<FakeFontFactory> Cache;
+
+	bool isDeleted(HFONT font)
+	{
+		return FakeFontFactory::deletedFonts.count(font) != 0;
+	}
+}
+
+TEST_CASE(substituteIsCreatedOnceAndShared)
+{
+	FakeFontFactory::reset();
+	Cache cache;
+	const HFONT origFont = FakeFontFactory::createFont(DEFAULT);
+	const HFONT substituteFont = cache.acquire(origFont);
+	CHECK(substituteFont && substituteFont != origFont);
+	CHECK(NONANTIALIASED == FakeFontFactory::fonts[substituteFont]);
+	CHECK(substituteFont == cache.acquire(origFont));
+	CHECK(1 == FakeFontFactory::createCount);
+
+	cache.release(origFont, substituteFont);
+	cache.release(origFont, substituteFont);
+	CHECK(!isDeleted(substituteFont));
+	CHECK(substituteFont == cache.acquire(origFont));
+	CHECK(1 == FakeFontFactory::createCount);
+}
+
+TEST_CASE(fontWithoutSubstituteIsCached)
+{
+	FakeFontFactory::reset();
+	Cache cache;
+	const HFONT origFont = FakeFontFactory::createFont(NONANTIALIASED);
+	CHECK(!cache.acquire(origFont));
+	CHECK(!cache.acquire(origFont));
+	CHECK(1 == FakeFontFactory::createCount);
+}
+
+TEST_CASE(failureIsNotCached)
+{
+	FakeFontFactory::reset();
+	Cache cache;
+	const HFONT origFont = FakeFontFactory::createFont(INVALID);
+	CHECK(!cache.acquire(origFont));
+	FakeFontFactory::fonts[origFont] = DEFAULT;
+	CHECK(cache.acquire(origFont));
+	CHECK(2 == FakeFontFactory::createCount);
+}
+
+TEST_CASE(unusedSubstituteIsDeletedWithOriginal)
+{
+	FakeFontFactory::reset();
+	Cache cache;
+	const HFONT origFont = FakeFontFactory::createFont(DEFAULT);
+	const HFONT substituteFont = cache.acquire(origFont);
+	cache.release(origFont, substituteFont);
+	cache.onDeleteFont(origFont);
+	CHECK(isDeleted(substituteFont));
+}
+
+TEST_CASE(substituteInUseIsDeletedOnLastRelease)
+{
+	FakeFontFactory::reset();
+	Cache cache;
+	const HFONT origFont = FakeFontFactory::createFont(DEFAULT);
+	const HFONT substituteFont = cache.acquire(origFont);
+	cache.acquire(origFont);
+	cache.onDeleteFont(origFont);
+	CHECK(!isDeleted(substituteFont));
+
+	cache.release(origFont, substituteFont);
+	CHECK(!isDeleted(substituteFont));
+	cache.release(origFont, substituteFont);
+	CHECK(isDeleted(substituteFont));
+}
+
+TEST_CASE(recycledOriginalGetsNewSubstitute)
+{
+	FakeFontFactory::reset();
+	Cache cache;
+	const HFONT origFont = FakeFontFactory::createFont(DEFAULT);
+	const HFONT substituteFont1 = cache.acquire(origFont);
+	cache.onDeleteFont(origFont);
+
+	FakeFontFactory::createFont(DEFAULT, reinterpret_cast<UINT_PTR>(origFont));
+	const HFONT substituteFont2 = cache.acquire(origFont);
+	CHECK(substituteFont2 && substituteFont2 != substituteFont1);
+	CHECK(2 == FakeFontFactory::createCount);
+
+	cache.release(origFont, substituteFont1);
+	CHECK(isDeleted(substituteFont1));
+	CHECK(!isDeleted(substituteFont2));
+	CHECK(substituteFont2 == cache.acquire(origFont));
+}
+
+TEST_CASE(nestedMappingOfSubstituteIsNotCached)
+{
+	FakeFontFactory::reset();
+	Cache cache;
+	const HFONT origFont = FakeFontFactory::createFont(DEFAULT);
+	const HFONT substituteFont = cache.acquire(origFont);
+
+	// A nested mapper sees the substitute selected into the DC
+	CHECK(!cache.acquire(substituteFont));
+	CHECK(1 == FakeFontFactory::createCount);
+
+	cache.release(origFont, substituteFont);
+	cache.onDeleteFont(origFont);
+	CHECK(isDeleted(substituteFont));
+
+	// The substitute handle is recycled by the application for a font that needs a substitute
+	FakeFontFactory::createFont(DEFAULT, reinterpret_cast<UINT_PTR>(substituteFont));
+	const HFONT newSubstituteFont = cache.acquire(substituteFont);
+	CHECK(newSubstituteFont && newSubstituteFont != substituteFont);
+}
+
+TEST_CASE(deletingSubstituteKeepsOtherEntries)
+{
+	FakeFontFactory::reset();
+	Cache cache;
+	const HFONT origFont1 = FakeFontFactory::createFont(DEFAULT);
+	const HFONT origFont2 = FakeFontFactory::createFont(DEFAULT);
+	const HFONT substituteFont1 = cache.acquire(origFont1);
+	const HFONT substituteFont2 = cache.acquire(origFont2);
+	cache.release(origFont1, substituteFont1);
+	cache.onDeleteFont(origFont1);
+	CHECK(isDeleted(substituteFont1));
+
+	CHECK(substituteFont2 == cache.acquire(origFont2));
+	CHECK(2 == FakeFontFactory::createCount);
+}
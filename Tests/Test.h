@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+
+namespace Test
+{
+	struct TestCase
+	{
+		const char* name;
+		void (*func)();
+	};
+
+	class Registrar
+	{
+	public:
+		Registrar(const char* name, void (*func)());
+	};
+
+	void fail(const char* file, int line, const char* expression);
+	std::vector<TestCase>& getTestCases();
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static Test::Registrar name##Registrar(#name, &name); \
+	static void name()
+
+#define CHECK(expression) \
+	do \
+	{ \
+		if (!(expression)) \
+		{ \
+			Test::fail(__FILE__, __LINE__, #expression); \
+		} \
+	} while (false)
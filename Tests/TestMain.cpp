@@ -0,0 +1,44 @@
+#include <cstdio>
+
+#include <Test.h>
+
+namespace
+{
+	unsigned g_failureCount = 0;
+}
+
+namespace Test
+{
+	Registrar::Registrar(const char* name, void (*func)())
+	{
+		getTestCases().push_back({ name, func });
+	}
+
+	void fail(const char* file, int line, const char* expression)
+	{
+		std::printf("%s(%d): check failed: %s\n", file, line, expression);
+		++g_failureCount;
+	}
+
+	std::vector<TestCase>& getTestCases()
+	{
+		static std::vector<TestCase> testCases;
+		return testCases;
+	}
+}
+
+int main()
+{
+	unsigned failedTestCount = 0;
+	for (const auto& testCase : Test::getTestCases())
+	{
+		const unsigned prevFailureCount = g_failureCount;
+		testCase.func();
+		const bool isPassed = prevFailureCount == g_failureCount;
+		std::printf("[%s] %s\n", isPassed ? "PASS" : "FAIL", testCase.name);
+		failedTestCount += isPassed ? 0 : 1;
+	}
+
+	std::printf("%u of %u test cases failed\n", failedTestCount, static_cast<unsigned>(Test::getTestCases().size()));
+	return 0 == failedTestCount ? 0 : 1;
+}
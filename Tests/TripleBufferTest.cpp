@@ -0,0 +1,99 @@
+#include <atomic>
+#include <set>
+#include <thread>
+
+#include <Common/TripleBuffer.h>
+#include <Test.h>
+
+TEST_CASE(slotsAreDistinct)
+{
+	Compat::TripleBuffer buffer;
+	for (int i = 0; i < 10; ++i)
+	{
+		CHECK(buffer.getReadSlot() != buffer.getWriteSlot());
+		CHECK(buffer.getReadSlot() < Compat::TripleBuffer::SLOT_COUNT);
+		CHECK(buffer.getWriteSlot() < Compat::TripleBuffer::SLOT_COUNT);
+		buffer.publish();
+		if (0 == i % 3)
+		{
+			buffer.acquire();
+		}
+	}
+}
+
+TEST_CASE(acquireReturnsLatestPublishedSlot)
+{
+	Compat::TripleBuffer buffer;
+	int frames[Compat::TripleBuffer::SLOT_COUNT] = {};
+	CHECK(!buffer.acquire());
+
+	frames[buffer.getWriteSlot()] = 1;
+	CHECK(!buffer.publish());
+	CHECK(buffer.hasPublishedSlot());
+	CHECK(buffer.acquire());
+	CHECK(1 == frames[buffer.getReadSlot()]);
+	CHECK(!buffer.hasPublishedSlot());
+	CHECK(!buffer.acquire());
+	CHECK(1 == frames[buffer.getReadSlot()]);
+}
+
+TEST_CASE(replacedSlotIsReportedAsDropped)
+{
+	Compat::TripleBuffer buffer;
+	int frames[Compat::TripleBuffer::SLOT_COUNT] = {};
+
+	frames[buffer.getWriteSlot()] = 1;
+	CHECK(!buffer.publish());
+	frames[buffer.getWriteSlot()] = 2;
+	CHECK(buffer.publish());
+	CHECK(1 == frames[buffer.getWriteSlot()]);
+
+	CHECK(buffer.acquire());
+	CHECK(2 == frames[buffer.getReadSlot()]);
+}
+
+TEST_CASE(concurrentHandoffKeepsOrderAndAccountsForEveryFrame)
+{
+	const int FRAME_COUNT = 200000;
+	Compat::TripleBuffer buffer;
+	int frames[Compat::TripleBuffer::SLOT_COUNT] = {};
+	std::atomic<bool> isProducerDone(false);
+	int droppedCount = 0;
+
+	std::thread producer([&]()
+		{
+			for (int frame = 1; frame <= FRAME_COUNT; ++frame)
+			{
+				frames[buffer.getWriteSlot()] = frame;
+				if (buffer.publish())
+				{
+					++droppedCount;
+				}
+			}
+			isProducerDone = true;
+		});
+
+	int presentedCount = 0;
+	int lastFrame = 0;
+	bool isOrdered = true;
+	while (true)
+	{
+		const bool isDone = isProducerDone;
+		if (buffer.acquire())
+		{
+			const int frame = frames[buffer.getReadSlot()];
+			isOrdered = isOrdered && frame > lastFrame;
+			lastFrame = frame;
+			++presentedCount;
+		}
+		else if (isDone)
+		{
+			break;
+		}
+	}
+	producer.join();
+
+	CHECK(isOrdered);
+	CHECK(FRAME_COUNT == lastFrame);
+	CHECK(FRAME_COUNT == presentedCount + droppedCount);
+}
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include <DDraw/UpdateScheduler.h>
+#include <Test.h>
+
+namespace
+{
+	const long long FREQUENCY = 1000000;
+	const long long VBLANK_PERIOD = FREQUENCY / 60;
+	const DWORD IDLE_POLL_INTERVAL = 50;
+	const DWORD PRESENT_DEADLINE_MARGIN = 2;
+	const long long QPC_MARGIN = PRESENT_DEADLINE_MARGIN * FREQUENCY / 1000;
+
+	// Fake clock in microseconds with a vblank at every multiple of VBLANK_PERIOD. Waits advance the clock, and
+	// update requests scheduled by the test become pending once the clock reaches them.
+	class FakeEnv
+	{
+	public:
+		long long qpc = 1;
+		long long qpcFlipEnd = -FREQUENCY;
+		UINT presentEndVsyncCount = 0;
+		bool isUpdateRequested = false;
+		bool isPrimaryLocked = false;
+		std::deque<long long> requests;
+		std::vector<long long> updates;
+		UINT sleepCount = 0;
+		UINT updateWaitCount = 0;
+		UINT vsyncWaitCount = 0;
+
+		long long getFrequency() const { return FREQUENCY; }
+		UINT getPresentEndVsyncCount() const { return presentEndVsyncCount; }
+		long long getQpcFlipEnd() const { return qpcFlipEnd; }
+
+		long long getQpcUntilScanoutDeadline(long long qpcMargin) const
+		{
+			long long qpcDeadline = getNextVblank(qpc) - qpcMargin;
+			while (qpcDeadline < qpc)
+			{
+				qpcDeadline += VBLANK_PERIOD;
+			}
+			return qpcDeadline - qpc;
+		}
+
+		UINT getVsyncCounter() const { return static_cast<UINT>(qpc / VBLANK_PERIOD); }
+
+		bool isPresentPending() const
+		{
+			return static_cast<INT>(getVsyncCounter() - presentEndVsyncCount) < 0;
+		}
+
+		bool isUpdatePending()
+		{
+			while (!requests.empty() && requests.front() <= qpc)
+			{
+				requests.pop_front();
+				isUpdateRequested = true;
+			}
+			return isUpdateRequested;
+		}
+
+		bool isWaitingForPrimaryUnlock() const { return isPrimaryLocked; }
+		long long now() const { return qpc; }
+
+		void sleep(DWORD ms)
+		{
+			++sleepCount;
+			qpc += ms * FREQUENCY / 1000;
+		}
+
+		void update()
+		{
+			isUpdateRequested = false;
+			updates.push_back(qpc);
+			presentEndVsyncCount = getVsyncCounter() + 1;
+		}
+
+		void waitForUpdate(DWORD timeoutMs)
+		{
+			++updateWaitCount;
+			const long long qpcTimeout = qpc + timeoutMs * FREQUENCY / 1000;
+			qpc = requests.empty() ? qpcTimeout : std::max(qpc, std::min(requests.front(), qpcTimeout));
+		}
+
+		void waitForVsyncCounter(UINT count)
+		{
+			++vsyncWaitCount;
+			qpc = std::max<long long>(qpc, count * VBLANK_PERIOD);
+		}
+
+		static long long getNextVblank(long long qpcAfter)
+		{
+			return (qpcAfter / VBLANK_PERIOD + 1) * VBLANK_PERIOD;
+		}
+	};
+
+	typedef DDraw::UpdateScheduler<FakeEnv> Scheduler;
+
+	void runUntil(FakeEnv& env, long long qpcEnd)
+	{
+		Scheduler scheduler(env, IDLE_POLL_INTERVAL, PRESENT_DEADLINE_MARGIN);
+		while (env.qpc < qpcEnd)
+		{
+			scheduler.runOnce();
+		}
+	}
+
+	bool isBeforeDeadline(long long qpcUpdate)
+	{
+		const long long qpcDeadline = FakeEnv::getNextVblank(qpcUpdate) - QPC_MARGIN;
+		return qpcUpdate <= qpcDeadline && qpcDeadline - qpcUpdate < FREQUENCY / 1000;
+	}
+}
+
+TEST_CASE(idleDoesNoWork)
+{
+	FakeEnv env;
+	runUntil(env, FREQUENCY);
+	CHECK(env.updates.empty());
+	CHECK(0 == env.sleepCount && 0 == env.vsyncWaitCount);
+	CHECK(1000 / IDLE_POLL_INTERVAL == env.updateWaitCount);
+}
+
+TEST_CASE(requestWakesIdleWait)
+{
+	FakeEnv env;
+	env.requests = { 12345 };
+	Scheduler scheduler(env, IDLE_POLL_INTERVAL, PRESENT_DEADLINE_MARGIN);
+	scheduler.runOnce();
+	CHECK(12345 == env.qpc);
+	CHECK(env.isUpdatePending());
+}
+
+TEST_CASE(updateTargetsDeadlineBeforeVblank)
+{
+	FakeEnv env;
+	env.requests = { 1000 };
+	runUntil(env, VBLANK_PERIOD * 3);
+	CHECK(1 == env.updates.size());
+	CHECK(isBeforeDeadline(env.updates[0]));
+	CHECK(env.updates[0] < VBLANK_PERIOD);
+}
+
+TEST_CASE(requestPastDeadlineTargetsNextVblank)
+{
+	FakeEnv env;
+	env.requests = { VBLANK_PERIOD - QPC_MARGIN / 2 };
+	runUntil(env, VBLANK_PERIOD * 3);
+	CHECK(1 == env.updates.size());
+	CHECK(isBeforeDeadline(env.updates[0]));
+	CHECK(env.updates[0] > VBLANK_PERIOD && env.updates[0] < 2 * VBLANK_PERIOD);
+}
+
+TEST_CASE(pendingPresentWaitsForVblank)
+{
+	FakeEnv env;
+	env.requests = { 1000, 5000 };
+	runUntil(env, VBLANK_PERIOD * 4);
+	CHECK(2 == env.updates.size());
+	CHECK(1 == env.vsyncWaitCount);
+	CHECK(env.updates[1] / VBLANK_PERIOD == env.updates[0] / VBLANK_PERIOD + 1);
+	CHECK(isBeforeDeadline(env.updates[1]));
+}
+
+TEST_CASE(recentFlipDelaysUpdate)
+{
+	FakeEnv env;
+	env.qpcFlipEnd = 1000;
+	env.requests = { 1000 };
+	env.qpc = 1000;
+	Scheduler scheduler(env, IDLE_POLL_INTERVAL, PRESENT_DEADLINE_MARGIN);
+	scheduler.runOnce();
+	CHECK(1 == env.sleepCount);
+	CHECK(2000 == env.qpc);
+	CHECK(env.updates.empty());
+}
+
+TEST_CASE(lockedPrimaryWaitsForUpdate)
+{
+	FakeEnv env;
+	env.isPrimaryLocked = true;
+	env.requests = { 1000 };
+	runUntil(env, FREQUENCY / 10);
+	CHECK(env.updates.empty());
+	CHECK(0 == env.sleepCount);
+
+	env.isPrimaryLocked = false;
+	runUntil(env, FREQUENCY / 5);
+	CHECK(1 == env.updates.size());
+}
+
+TEST_CASE(continuousRequestsPresentOncePerVblank)
+{
+	FakeEnv env;
+	for (long long qpc = 500; qpc < FREQUENCY; qpc += 3700)
+	{
+		env.requests.push_back(qpc);
+	}
+	const auto requests = env.requests;
+	runUntil(env, FREQUENCY + VBLANK_PERIOD);
+
+	CHECK(!env.updates.empty());
+	for (std::size_t i = 0; i < env.updates.size(); ++i)
+	{
+		CHECK(isBeforeDeadline(env.updates[i]));
+		CHECK(0 == i || env.updates[i] / VBLANK_PERIOD > env.updates[i - 1] / VBLANK_PERIOD);
+	}
+
+	// Every request is presented within two vblank periods
+	for (long long qpcRequest : requests)
+	{
+		auto it = std::lower_bound(env.updates.begin(), env.updates.end(), qpcRequest);
+		CHECK(it != env.updates.end() && *it - qpcRequest < 2 * VBLANK_PERIOD);
+	}
+}
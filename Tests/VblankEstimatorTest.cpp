@@ -0,0 +1,123 @@
+#include <cmath>
+#include <random>
+
+#include <D3dDdi/VblankEstimator.h>
+#include <Test.h>
+
+namespace
+{
+	const double QPC_FREQUENCY = 10000000;
+	const double PERIOD_60HZ = QPC_FREQUENCY / 60;
+	const double PERIOD_75HZ = QPC_FREQUENCY / 75;
+	const long long START_QPC = 123456789;
+
+	long long getVblank(double period, long long index)
+	{
+		return START_QPC + std::llround(index * period);
+	}
+
+	bool isNear(double value, double expected, double tolerance)
+	{
+		return std::abs(value - expected) <= tolerance;
+	}
+}
+
+TEST_CASE(emptyEstimatorUsesNominalPeriod)
+{
+	D3dDdi::VblankEstimator estimator(PERIOD_60HZ);
+	CHECK(estimator.getNextVblank(START_QPC) == START_QPC + std::llround(PERIOD_60HZ));
+	CHECK(estimator.getPeriod() == PERIOD_60HZ);
+}
+
+TEST_CASE(convergesToActualPeriod)
+{
+	const double actualPeriod = PERIOD_60HZ * 1.01;
+	D3dDdi::VblankEstimator estimator(PERIOD_60HZ);
+	for (long long i = 0; i < 100; ++i)
+	{
+		estimator.addVblank(getVblank(actualPeriod, i));
+	}
+
+	CHECK(isNear(estimator.getPeriod(), actualPeriod, actualPeriod * 0.0001));
+	const long long qpc = getVblank(actualPeriod, 99) + std::llround(actualPeriod / 3);
+	CHECK(isNear(static_cast<double>(estimator.getNextVblank(qpc)), static_cast<double>(getVblank(actualPeriod, 100)), 2));
+}
+
+TEST_CASE(predictsThroughJitter)
+{
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<double> jitter(-0.03 * PERIOD_60HZ, 0.03 * PERIOD_60HZ);
+	D3dDdi::VblankEstimator estimator(PERIOD_60HZ);
+	for (long long i = 0; i < 200; ++i)
+	{
+		estimator.addVblank(getVblank(PERIOD_60HZ, i) + std::llround(jitter(rng)));
+	}
+
+	CHECK(isNear(estimator.getPeriod(), PERIOD_60HZ, PERIOD_60HZ * 0.005));
+	const long long qpc = getVblank(PERIOD_60HZ, 199) + std::llround(PERIOD_60HZ / 2);
+	CHECK(isNear(static_cast<double>(estimator.getNextVblank(qpc)), static_cast<double>(getVblank(PERIOD_60HZ, 200)),
+		PERIOD_60HZ * 0.02));
+}
+
+TEST_CASE(countsMissedVblanks)
+{
+	D3dDdi::VblankEstimator estimator(PERIOD_60HZ);
+	for (long long i = 0; i < 120; i += 1 + i % 3)
+	{
+		estimator.addVblank(getVblank(PERIOD_60HZ, i));
+	}
+
+	CHECK(isNear(estimator.getPeriod(), PERIOD_60HZ, PERIOD_60HZ * 0.0001));
+	const long long qpc = getVblank(PERIOD_60HZ, 130) + 1;
+	CHECK(isNear(static_cast<double>(estimator.getNextVblank(qpc)), static_cast<double>(getVblank(PERIOD_60HZ, 131)), 2));
+}
+
+TEST_CASE(rejectsSpuriousSamples)
+{
+	D3dDdi::VblankEstimator estimator(PERIOD_60HZ);
+	for (long long i = 0; i < 50; ++i)
+	{
+		estimator.addVblank(getVblank(PERIOD_60HZ, i));
+		if (0 == i % 10)
+		{
+			estimator.addVblank(getVblank(PERIOD_60HZ, i) + std::llround(PERIOD_60HZ / 2));
+		}
+	}
+
+	CHECK(isNear(estimator.getPeriod(), PERIOD_60HZ, PERIOD_60HZ * 0.0001));
+	const long long qpc = getVblank(PERIOD_60HZ, 49) + 1;
+	CHECK(isNear(static_cast<double>(estimator.getNextVblank(qpc)), static_cast<double>(getVblank(PERIOD_60HZ, 50)), 2));
+}
+
+TEST_CASE(adaptsToRefreshRateChange)
+{
+	D3dDdi::VblankEstimator estimator(PERIOD_60HZ);
+	for (long long i = 0; i < 60; ++i)
+	{
+		estimator.addVblank(getVblank(PERIOD_60HZ, i));
+	}
+
+	const long long qpcSwitch = getVblank(PERIOD_60HZ, 60);
+	for (long long i = 0; i < 100; ++i)
+	{
+		estimator.addVblank(qpcSwitch + std::llround(i * PERIOD_75HZ));
+	}
+
+	CHECK(isNear(estimator.getPeriod(), PERIOD_75HZ, PERIOD_75HZ * 0.001));
+	const long long qpc = qpcSwitch + std::llround(99.5 * PERIOD_75HZ);
+	CHECK(isNear(static_cast<double>(estimator.getNextVblank(qpc)),
+		static_cast<double>(qpcSwitch + std::llround(100 * PERIOD_75HZ)), PERIOD_75HZ * 0.01));
+}
+
+TEST_CASE(resetRestoresNominalPeriod)
+{
+	D3dDdi::VblankEstimator estimator(PERIOD_60HZ);
+	for (long long i = 0; i < 100; ++i)
+	{
+		estimator.addVblank(getVblank(PERIOD_60HZ * 1.01, i));
+	}
+
+	estimator.reset(PERIOD_75HZ);
+	CHECK(estimator.getPeriod() == PERIOD_75HZ);
+	CHECK(estimator.getNextVblank(START_QPC) == START_QPC + std::llround(PERIOD_75HZ));
+}
@@ -0,0 +1,44 @@
+#include <random>
+#include <vector>
+
+#include <D3dDdi/VertexCompactor.h>
+#include <Benchmark.h>
+
+namespace
+{
+	const UINT INDEX_COUNT = 3000;
+
+	std::vector<UINT16> createIndices(UINT vertexCount)
+	{
+		std::mt19937 rng(9);
+		std::uniform_int_distribution<UINT> dist(0, vertexCount - 1);
+		std::vector<UINT16> indices(INDEX_COUNT);
+		for (auto& index : indices)
+		{
+			index = static_cast<UINT16>(dist(rng));
+		}
+		return indices;
+	}
+
+	void compact(unsigned iterationCount, UINT vertexCount)
+	{
+		const auto indices(createIndices(vertexCount));
+		std::vector<UINT16> remapped(INDEX_COUNT);
+		D3dDdi::VertexCompactor compactor;
+		for (unsigned i = 0; i < iterationCount; ++i)
+		{
+			compactor.compact(indices.data(), INDEX_COUNT, 0, vertexCount, 0, remapped.data());
+			Benchmark::doNotOptimize(remapped.data());
+		}
+	}
+}
+
+BENCHMARK(compact3000IndicesFrom1000Vertices)
+{
+	compact(iterationCount, 1000);
+}
+
+BENCHMARK(compact3000IndicesFrom60000Vertices)
+{
+	compact(iterationCount, 60000);
+}
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <D3dDdi/VertexCompactor.h>
+#include <Test.h>
+
+namespace
+{
+	struct Batch
+	{
+		std::vector<UINT16> indices;
+		UINT minIndex;
+		UINT maxIndex;
+	};
+
+	Batch createBatch(std::mt19937& rng)
+	{
+		std::uniform_int_distribution<UINT> countDist(1, 300);
+		std::uniform_int_distribution<UINT> minDist(0, 60000);
+		std::uniform_int_distribution<UINT> spanDist(0, 500);
+		const UINT min = minDist(rng);
+		const UINT max = std::min<UINT>(min + spanDist(rng), 0xFFFF);
+		std::uniform_int_distribution<UINT> indexDist(min, max);
+
+		Batch batch = {};
+		batch.indices.resize(countDist(rng));
+		for (auto& index : batch.indices)
+		{
+			index = static_cast<UINT16>(indexDist(rng));
+		}
+		const auto [minIt, maxIt] = std::minmax_element(batch.indices.begin(), batch.indices.end());
+		batch.minIndex = *minIt;
+		batch.maxIndex = *maxIt;
+		return batch;
+	}
+
+	bool isCompactedCorrectly(D3dDdi::VertexCompactor& compactor, const Batch& batch, UINT16 baseIndex)
+	{
+		std::vector<UINT16> remapped(batch.indices.size());
+		compactor.compact(batch.indices.data(), batch.indices.size(), batch.minIndex,
+			batch.maxIndex - batch.minIndex + 1, baseIndex, remapped.data());
+
+		std::vector<UINT16> expectedUnique;
+		std::map<UINT16, UINT16> expectedRemap;
+		for (auto index : batch.indices)
+		{
+			if (expectedRemap.emplace(index, static_cast<UINT16>(baseIndex + expectedUnique.size())).second)
+			{
+				expectedUnique.push_back(index);
+			}
+		}
+
+		bool isCorrect = compactor.getUniqueIndices() == expectedUnique;
+		for (std::size_t i = 0; i < batch.indices.size(); ++i)
+		{
+			isCorrect = isCorrect && expectedRemap[batch.indices[i]] == remapped[i];
+		}
+		return isCorrect;
+	}
+}
+
+TEST_CASE(compactMatchesReference)
+{
+	std::mt19937 rng(8);
+	D3dDdi::VertexCompactor compactor;
+	for (int i = 0; i < 2000; ++i)
+	{
+		CHECK(isCompactedCorrectly(compactor, createBatch(rng), static_cast<UINT16>(i % 1000)));
+	}
+}
+
+TEST_CASE(repeatedRangesDoNotReuseStaleEntries)
+{
+	D3dDdi::VertexCompactor compactor;
+	const Batch batch1 = { { 10, 11, 12, 10 }, 10, 12 };
+	const Batch batch2 = { { 12, 12, 11 }, 10, 12 };
+	CHECK(isCompactedCorrectly(compactor, batch1, 0));
+	CHECK(isCompactedCorrectly(compactor, batch2, 4));
+	CHECK(2 == compactor.getUniqueIndices().size());
+}
+
+TEST_CASE(compactorsOnSeparateThreadsDoNotInterfere)
+{
+	bool isCorrect[4] = {};
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t)
+	{
+		threads.emplace_back([t, &isCorrect]()
+			{
+				std::mt19937 rng(100 + t);
+				D3dDdi::VertexCompactor compactor;
+				isCorrect[t] = true;
+				for (int i = 0; i < 5000; ++i)
+				{
+					isCorrect[t] = isCompactedCorrectly(compactor, createBatch(rng), 0) && isCorrect[t];
+				}
+			});
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	for (bool isThreadCorrect : isCorrect)
+	{
+		CHECK(isThreadCorrect);
+	}
+}
+
+TEST_CASE(rangeCopyThreshold)
+{
+	CHECK(D3dDdi::VertexCompactor::isRangeCopyPreferred(100, 100));
+	CHECK(D3dDdi::VertexCompactor::isRangeCopyPreferred(100, 150));
+	CHECK(!D3dDdi::VertexCompactor::isRangeCopyPreferred(100, 151));
+	CHECK(!D3dDdi::VertexCompactor::isRangeCopyPreferred(6, 1000));
+}
@@ -0,0 +1,37 @@
+#include <thread>
+
+#include <Common/WaitableCounter.h>
+#include <ConditionVariableWait.h>
+#include <Benchmark.h>
+
+// Measures the wake latency as a round trip between two threads, each waiting for the other's counter
+BENCHMARK(wakeRoundTrip)
+{
+	Compat::WaitableCounter<ConditionVariableWait> ping;
+	Compat::WaitableCounter<ConditionVariableWait> pong;
+	std::thread responder([&]()
+		{
+			for (unsigned i = 1; i <= iterationCount; ++i)
+			{
+				ping.waitFor(i);
+				pong.increment();
+			}
+		});
+
+	for (unsigned i = 1; i <= iterationCount; ++i)
+	{
+		ping.increment();
+		pong.waitFor(i);
+	}
+	responder.join();
+}
+
+BENCHMARK(waitForReachedCounter)
+{
+	Compat::WaitableCounter<ConditionVariableWait> counter(1);
+	for (unsigned i = 0; i < iterationCount; ++i)
+	{
+		bool result = counter.waitFor(1);
+		Benchmark::doNotOptimize(&result);
+	}
+}
@@ -0,0 +1,123 @@
+#include <atomic>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include <Common/WaitableCounter.h>
+#include <ConditionVariableWait.h>
+#include <Test.h>
+
+namespace
+{
+	const unsigned WAITER_COUNT = 8;
+	const unsigned WAITS_PER_WAITER = 2000;
+
+	// Returns immediately, as if every wait was woken spuriously
+	struct SpuriousWait
+	{
+		static void wait(std::atomic<UINT>& /*value*/, UINT /*expected*/)
+		{
+			std::this_thread::yield();
+		}
+
+		static void wakeAll(std::atomic<UINT>& /*value*/)
+		{
+		}
+	};
+
+	template <typename Wait>
+	void stress(UINT initialValue)
+	{
+		Compat::WaitableCounter<Wait> counter(initialValue);
+		std::atomic<unsigned> doneCount = 0;
+		std::atomic<bool> isValid = true;
+
+		std::vector<std::thread> waiters;
+		for (unsigned i = 0; i < WAITER_COUNT; ++i)
+		{
+			waiters.emplace_back([&, i]()
+				{
+					for (unsigned j = 0; j < WAITS_PER_WAITER; ++j)
+					{
+						const UINT target = counter.get() + 1 + (i + j) % 3;
+						counter.waitFor(target);
+						if (!Compat::WaitableCounter<Wait>::isReached(counter.get(), target))
+						{
+							isValid = false;
+						}
+					}
+					++doneCount;
+				});
+		}
+
+		while (doneCount < WAITER_COUNT)
+		{
+			counter.increment();
+			std::this_thread::yield();
+		}
+
+		for (auto& waiter : waiters)
+		{
+			waiter.join();
+		}
+		CHECK(isValid);
+	}
+}
+
+TEST_CASE(reachedTargetDoesNotWait)
+{
+	Compat::WaitableCounter<ConditionVariableWait> counter(5);
+	CHECK(!counter.waitFor(5));
+	CHECK(!counter.waitFor(4));
+	CHECK(5 == counter.get());
+}
+
+TEST_CASE(targetsAreComparedWithWrapAround)
+{
+	const UINT max = std::numeric_limits<UINT>::max();
+	CHECK(Compat::WaitableCounter<SpuriousWait>::isReached(0, max));
+	CHECK(Compat::WaitableCounter<SpuriousWait>::isReached(1, max - 1));
+	CHECK(!Compat::WaitableCounter<SpuriousWait>::isReached(max, 0));
+	CHECK(!Compat::WaitableCounter<SpuriousWait>::isReached(max - 1, 1));
+
+	Compat::WaitableCounter<SpuriousWait> counter(max);
+	counter.increment();
+	CHECK(0 == counter.get());
+	CHECK(!counter.waitFor(max));
+}
+
+TEST_CASE(waiterIsReleasedByIncrement)
+{
+	Compat::WaitableCounter<ConditionVariableWait> counter;
+	std::atomic<bool> isReleased = false;
+	std::thread waiter([&]()
+		{
+			counter.waitFor(3);
+			CHECK(3 == counter.get());
+			isReleased = true;
+		});
+
+	for (int i = 0; i < 3; ++i)
+	{
+		CHECK(!isReleased);
+		counter.increment();
+	}
+	waiter.join();
+	CHECK(isReleased);
+	CHECK(3 == counter.get());
+}
+
+TEST_CASE(stressWithConditionVariable)
+{
+	stress<ConditionVariableWait>(0);
+}
+
+TEST_CASE(stressWithConditionVariableAcrossWrapAround)
+{
+	stress<ConditionVariableWait>(std::numeric_limits<UINT>::max() - WAITS_PER_WAITER);
+}
+
+TEST_CASE(stressWithSpuriousWakeups)
+{
+	stress<SpuriousWait>(std::numeric_limits<UINT>::max() - WAITS_PER_WAITER);
+}
@@ -0,0 +1,344 @@
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <Windows.h>
+
+#include <Gdi/WindowZOrder.h>
+#include <Test.h>
+
+namespace
+{
+	const LONG GRID_SIZE = 32;
+
+	// Region model: one flag per pixel of a small screen
+	typedef std::vector<bool> Mask;
+
+	struct Window
+	{
+		RECT rect;
+		bool isVisible;
+		bool isOpaque;
+		Mask visibleRegion;
+		Mask obscuredRegion;
+		Window* above;
+		Window* below;
+		int id;
+	};
+
+	struct Context
+	{
+		Mask obscuredRegion = Mask(GRID_SIZE * GRID_SIZE);
+	};
+
+	typedef Gdi::WindowZOrder<int, Window> WindowZOrder;
+
+	Mask getVisibleRegion(const RECT& rect, bool isVisible, const Mask& obscuredRegion)
+	{
+		Mask visibleRegion(GRID_SIZE * GRID_SIZE);
+		if (isVisible)
+		{
+			for (LONG y = rect.top; y < rect.bottom; ++y)
+			{
+				for (LONG x = rect.left; x < rect.right; ++x)
+				{
+					visibleRegion[y * GRID_SIZE + x] = !obscuredRegion[y * GRID_SIZE + x];
+				}
+			}
+		}
+		return visibleRegion;
+	}
+
+	void addOpaqueRegion(Mask& obscuredRegion, const Mask& visibleRegion, bool isOpaque)
+	{
+		if (isOpaque)
+		{
+			for (std::size_t i = 0; i < visibleRegion.size(); ++i)
+			{
+				obscuredRegion[i] = obscuredRegion[i] || visibleRegion[i];
+			}
+		}
+	}
+
+	// Simulated windowing system: the true z-order and window state, with a tracker kept up to date
+	// incrementally from synthetic events
+	class Simulation
+	{
+	public:
+		Simulation(unsigned seed)
+			: m_random(seed)
+			, m_nextId(1)
+			, m_updateCount(0)
+		{
+		}
+
+		void createWindow()
+		{
+			const int id = m_nextId++;
+			const std::size_t pos = m_random() % (m_order.size() + 1);
+			m_order.insert(m_order.begin() + pos, id);
+			m_windows[id] = createProperties(id);
+
+			auto& window = m_zOrder.insert(id, m_windows[id], findAbove(id));
+			update(&window, &window);
+		}
+
+		void destroyWindow()
+		{
+			if (m_order.empty())
+			{
+				return;
+			}
+			const int id = m_order[m_random() % m_order.size()];
+			m_order.erase(std::find(m_order.begin(), m_order.end(), id));
+			m_windows.erase(id);
+
+			auto below = m_zOrder.remove(id);
+			if (below)
+			{
+				update(below, below);
+			}
+		}
+
+		void changeWindow()
+		{
+			if (m_order.empty())
+			{
+				return;
+			}
+			auto window = m_zOrder.find(m_order[m_random() % m_order.size()]);
+			changeProperties(*window);
+			update(window, window);
+		}
+
+		void changeZOrder()
+		{
+			if (m_order.empty())
+			{
+				return;
+			}
+			const int id = m_order[m_random() % m_order.size()];
+			m_order.erase(std::find(m_order.begin(), m_order.end(), id));
+			m_order.insert(m_order.begin() + m_random() % (m_order.size() + 1), id);
+
+			auto window = m_zOrder.find(id);
+			if (0 == m_random() % 2)
+			{
+				changeProperties(*window);
+			}
+			const auto change = m_zOrder.move(*window, findAbove(id));
+			update(change.start, change.lowestChanged);
+		}
+
+		void resync()
+		{
+			std::shuffle(m_order.begin(), m_order.end(), m_random);
+			if (!m_order.empty())
+			{
+				const int id = m_order.back();
+				m_order.pop_back();
+				m_windows.erase(id);
+			}
+			const int id = m_nextId++;
+			m_order.insert(m_order.begin() + m_random() % (m_order.size() + 1), id);
+			m_windows[id] = createProperties(id);
+
+			std::vector<int> destroyed;
+			m_zOrder.reset(m_order, [&](int key) { return m_windows[key]; },
+				[&](Window& window) { destroyed.push_back(window.id); });
+			CHECK(destroyed.size() <= 1);
+			update(m_zOrder.getTop(), nullptr);
+		}
+
+		// Checks the tracker against the true z-order and a full visibility recompute
+		bool isConsistent()
+		{
+			Window* prev = nullptr;
+			auto window = m_zOrder.getTop();
+			Mask obscuredRegion(GRID_SIZE * GRID_SIZE);
+			for (int id : m_order)
+			{
+				if (!window || window->id != id || window->above != prev || window != m_zOrder.find(id))
+				{
+					return false;
+				}
+
+				const Mask visibleRegion = getVisibleRegion(window->rect, window->isVisible, obscuredRegion);
+				addOpaqueRegion(obscuredRegion, visibleRegion, window->isOpaque);
+				if (window->visibleRegion != visibleRegion || window->obscuredRegion != obscuredRegion)
+				{
+					return false;
+				}
+
+				prev = window;
+				window = window->below;
+			}
+			return !window && m_zOrder.getBottom() == prev;
+		}
+
+		std::size_t getWindowCount() const { return m_order.size(); }
+		unsigned getUpdateCount() const { return m_updateCount; }
+
+	private:
+		void changeProperties(Window& window)
+		{
+			const Window changed = createProperties(window.id);
+			switch (m_random() % 4)
+			{
+			case 0:
+				window.rect = changed.rect;
+				break;
+			case 1:
+				window.rect = { changed.rect.left, changed.rect.top,
+					std::min(changed.rect.left + window.rect.right - window.rect.left, GRID_SIZE),
+					std::min(changed.rect.top + window.rect.bottom - window.rect.top, GRID_SIZE) };
+				break;
+			case 2:
+				window.isVisible = !window.isVisible;
+				break;
+			case 3:
+				window.isOpaque = !window.isOpaque;
+				break;
+			}
+		}
+
+		Window createProperties(int id)
+		{
+			std::uniform_int_distribution<LONG> dist(0, GRID_SIZE);
+			const LONG x1 = dist(m_random);
+			const LONG x2 = dist(m_random);
+			const LONG y1 = dist(m_random);
+			const LONG y2 = dist(m_random);
+
+			Window window = {};
+			window.rect = { std::min(x1, x2), std::min(y1, y2), std::max(x1, x2), std::max(y1, y2) };
+			window.isVisible = 0 != m_random() % 5;
+			window.isOpaque = 0 != m_random() % 4;
+			window.id = id;
+			return window;
+		}
+
+		Window* findAbove(int id)
+		{
+			auto it = std::find(m_order.begin(), m_order.end(), id);
+			return it == m_order.begin() ? nullptr : m_zOrder.find(*(it - 1));
+		}
+
+		void update(Window* start, Window* lowestChanged)
+		{
+			Context context;
+			m_zOrder.update(start, lowestChanged, context, [&](Window& window, Context& ctx)
+				{
+					window.visibleRegion = getVisibleRegion(window.rect, window.isVisible, ctx.obscuredRegion);
+					addOpaqueRegion(ctx.obscuredRegion, window.visibleRegion, window.isOpaque);
+					++m_updateCount;
+				});
+		}
+
+		std::mt19937 m_random;
+		std::vector<int> m_order;
+		std::map<int, Window> m_windows;
+		WindowZOrder m_zOrder;
+		int m_nextId;
+		unsigned m_updateCount;
+	};
+}
+
+TEST_CASE(insertAndRemoveKeepLinks)
+{
+	Simulation simulation(1);
+	for (unsigned i = 0; i < 20; ++i)
+	{
+		simulation.createWindow();
+		CHECK(simulation.isConsistent());
+	}
+	while (0 != simulation.getWindowCount())
+	{
+		simulation.destroyWindow();
+		CHECK(simulation.isConsistent());
+	}
+}
+
+TEST_CASE(randomEventsMatchFullRecompute)
+{
+	for (unsigned seed = 0; seed < 50; ++seed)
+	{
+		Simulation simulation(seed);
+		std::mt19937 random(seed);
+		bool isConsistent = true;
+		for (unsigned i = 0; i < 500 && isConsistent; ++i)
+		{
+			const unsigned event = random() % 100;
+			if (event < 15 || simulation.getWindowCount() < 3)
+			{
+				simulation.createWindow();
+			}
+			else if (event < 25)
+			{
+				simulation.destroyWindow();
+			}
+			else if (event < 60)
+			{
+				simulation.changeWindow();
+			}
+			else if (event < 98)
+			{
+				simulation.changeZOrder();
+			}
+			else
+			{
+				simulation.resync();
+			}
+			isConsistent = simulation.isConsistent();
+		}
+		CHECK(isConsistent);
+	}
+}
+
+TEST_CASE(updatesStopWhenObscuredRegionIsUnchanged)
+{
+	Simulation simulation(7);
+	for (unsigned i = 0; i < 40; ++i)
+	{
+		simulation.createWindow();
+	}
+
+	std::size_t fullUpdateCount = 0;
+	const unsigned startCount = simulation.getUpdateCount();
+	for (unsigned i = 0; i < 200; ++i)
+	{
+		simulation.changeWindow();
+		fullUpdateCount += simulation.getWindowCount();
+	}
+	CHECK(simulation.isConsistent());
+	CHECK(simulation.getUpdateCount() - startCount < fullUpdateCount / 2);
+}
+
+TEST_CASE(moveReturnsChangedRange)
+{
+	WindowZOrder zOrder;
+	Context context;
+	auto ignore = [](Window&, Context&) {};
+	Window* windows[4] = {};
+	for (int i = 0; i < 4; ++i)
+	{
+		Window window = {};
+		window.id = i;
+		windows[i] = &zOrder.insert(i, window, i > 0 ? windows[i - 1] : nullptr);
+	}
+	zOrder.update(zOrder.getTop(), nullptr, context, ignore);
+
+	auto change = zOrder.move(*windows[1], windows[1]->above);
+	CHECK(windows[1] == change.start && windows[1] == change.lowestChanged);
+
+	change = zOrder.move(*windows[0], windows[2]);
+	CHECK(windows[1] == change.start && windows[0] == change.lowestChanged);
+
+	change = zOrder.move(*windows[0], nullptr);
+	CHECK(windows[0] == change.start && windows[3] == change.lowestChanged);
+
+	change = zOrder.move(*windows[3], nullptr);
+	CHECK(windows[3] == change.start && nullptr == change.lowestChanged);
+	CHECK(windows[3] == zOrder.getTop() && windows[2] == zOrder.getBottom());
+}